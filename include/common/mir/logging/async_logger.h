@@ -0,0 +1,94 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_LOGGING_ASYNC_LOGGER_H_
+#define MIR_LOGGING_ASYNC_LOGGER_H_
+
+#include "mir/logging/logger.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mir
+{
+namespace logging
+{
+/**
+ * A Logger that hands records to a background thread, which writes them to another Logger
+ *
+ * Each thread that logs gets its own fixed-size ring of records, so logging
+ * takes no locks and (once a record's strings have grown to fit) does no
+ * allocation or I/O on the caller's thread. Errors are the exception: they
+ * briefly lock to wake the writer. If the writer falls behind and a ring fills
+ * up, further records from that thread are dropped and counted, and the writer
+ * logs how many were lost. A ring is freed once its thread has exited and the
+ * writer has drained it.
+ *
+ * Records from different threads are written in the order they were logged.
+ * Any records still queued are written before the destructor returns.
+ */
+class AsyncLogger : public Logger
+{
+public:
+    explicit AsyncLogger(std::shared_ptr<Logger> const& downstream);
+    ~AsyncLogger();
+
+    void log(Severity severity, std::string const& message, std::string const& component) override;
+    void log(char const* component, Severity severity, char const* format, ...) override
+        __attribute__ ((format (printf, 4, 5)));
+
+    /// Write everything logged so far before returning
+    void flush();
+
+    /// The number of records dropped because their thread's ring was full
+    auto dropped() const -> uint64_t;
+
+private:
+    struct Ring;
+
+    auto ring_for_this_thread() -> Ring&;
+    void enqueue(Severity severity, char const* message, size_t message_size, char const* component);
+    void write_pending();
+    void run_writer();
+
+    std::shared_ptr<Logger> const downstream;
+    uint64_t const id;
+    std::atomic<uint64_t> next_sequence{0};
+
+    std::mutex mutable rings_mutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+    /// Records dropped by rings that have since been freed
+    uint64_t retired_dropped{0};
+
+    std::mutex writer_mutex;
+    std::condition_variable writer_wakeup;
+    uint64_t flush_requests{0};
+    uint64_t flushes_completed{0};
+    /// Something has been logged that shouldn't wait for the write interval
+    bool urgent{false};
+    bool stopping{false};
+    std::thread writer;
+};
+}
+}
+
+#endif // MIR_LOGGING_ASYNC_LOGGER_H_
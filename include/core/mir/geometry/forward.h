@@ -87,6 +87,8 @@ using PointF = generic::Point<float>;
 using SizeF = generic::Size<float>;
 using DisplacementF = generic::Displacement<float>;
 using RectangleF = generic::Rectangle<int>;
+
+class Rectangles;
 }
 }
 
@@ -0,0 +1,94 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GEOMETRY_REGION_H_
+#define MIR_GEOMETRY_REGION_H_
+
+#include "mir/geometry/point.h"
+#include "mir/geometry/rectangle.h"
+
+#include <initializer_list>
+#include <iosfwd>
+#include <utility>
+#include <vector>
+
+namespace mir
+{
+namespace geometry
+{
+
+/**
+ * An arbitrary set of points, supporting union, subtraction and intersection.
+ *
+ * Stored (like a pixman region) as horizontal bands, each holding a sorted
+ * list of non-overlapping spans. The representation is kept canonical, so
+ * equal sets of points compare equal.
+ */
+class Region
+{
+public:
+    Region();
+    Region(Rectangle const& rect);
+    /// The union of rects
+    Region(std::initializer_list<Rectangle> const& rects);
+    /* We want to keep implicit copy and move methods */
+
+    /// Adds the points of rect (union)
+    void add(Rectangle const& rect);
+    void add(Region const& region);
+    /// Removes the points of rect (difference)
+    void subtract(Rectangle const& rect);
+    void subtract(Region const& region);
+    /// Removes the points not in rect (intersection)
+    void intersect(Rectangle const& rect);
+    void intersect(Region const& region);
+    void clear();
+
+    auto empty() const -> bool;
+    auto contains(Point const& point) const -> bool;
+    /// Whether every point of rect is in the region
+    auto contains(Rectangle const& rect) const -> bool;
+    /// Whether any point of rect is in the region
+    auto overlaps(Rectangle const& rect) const -> bool;
+    auto bounding_rectangle() const -> Rectangle;
+    /// The region as non-overlapping rectangles, sorted top-to-bottom then left-to-right
+    auto rectangles() const -> std::vector<Rectangle>;
+
+    auto operator==(Region const& other) const -> bool;
+    auto operator!=(Region const& other) const -> bool;
+
+private:
+    struct Band
+    {
+        int top;
+        int bottom;
+        std::vector<std::pair<int, int>> spans;  ///< [left, right) pairs
+    };
+
+    static auto combine(
+        std::vector<Band> const& a,
+        std::vector<Band> const& b,
+        bool (*keep)(bool in_a, bool in_b)) -> std::vector<Band>;
+
+    std::vector<Band> bands;
+};
+
+std::ostream& operator<<(std::ostream& out, Region const& value);
+
+}
+}
+
+#endif /* MIR_GEOMETRY_REGION_H_ */
@@ -106,6 +106,12 @@ public:
     /// Zero if this output is not part of a logical group
     auto logical_group_id() const -> int;
 
+    /// Whether the output can vary its refresh rate to match when frames are posted (VRR, aka adaptive sync)
+    auto vrr_capable() const -> bool;
+
+    /// Whether the output's refresh rate varies to match when frames are posted
+    auto vrr_enabled() const -> bool;
+
 private:
     std::shared_ptr<mir::graphics::DisplayConfigurationOutput> self;
 };
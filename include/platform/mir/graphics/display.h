@@ -22,6 +22,7 @@
 #include <memory>
 #include <functional>
 #include <chrono>
+#include <vector>
 
 namespace mir
 {
@@ -75,6 +76,17 @@ public:
      */
     virtual std::chrono::milliseconds recommended_sleep() const = 0;
 
+    /**
+     * Whether the last post() had to leave its frame off screen (say, because
+     * the hardware turned down the overlay planes it had accepted). The
+     * compositor should then composite another frame straight away, even if
+     * the scene hasn't changed.
+     */
+    virtual bool needs_recomposite() const
+    {
+        return false;
+    }
+
     virtual ~DisplaySyncGroup() = default;
 protected:
     DisplaySyncGroup() = default;
@@ -126,6 +138,31 @@ public:
      */
     virtual void configure(DisplayConfiguration const& conf) = 0;
 
+    /**
+     * Sets a new output configuration, invalidating only the DisplaySyncGroups whose outputs it changes.
+     *
+     * If the set of DisplaySyncGroups changes, \p retire is called before any is invalidated with all of those
+     * that will be (which may be none, when groups are only added) and once it has returned they must not be used
+     * again. All other DisplaySyncGroups (and their DisplayBuffers) remain valid, and may go on being used from
+     * other threads throughout. \p retire must not call into the Display.
+     *
+     * If an exception is thrown after \p retire has been called, configure() is needed to recover.
+     *
+     * The default implementation never applies the configuration.
+     *
+     * \param conf   [in] Configuration to possibly apply.
+     * \param retire [in] Called with the DisplaySyncGroups about to be invalidated.
+     * \return       \c true if \p conf has been applied as the new output configuration (including when it
+     *               changes nothing); \c false if it has not been applied (and \p retire has not been called), in
+     *               which case configure() is needed.
+     */
+    virtual bool configure_changed_sync_groups(
+        DisplayConfiguration const& /*conf*/,
+        std::function<void(std::vector<DisplaySyncGroup*> const& retiring)> const& /*retire*/)
+    {
+        return false;
+    }
+
     /**
      * Registers a handler for display configuration changes.
      *
@@ -19,10 +19,12 @@
 
 #include <mir/geometry/rectangle.h>
 #include <mir/graphics/renderable.h>
+#include <mir/graphics/frame.h>
 #include <mir_toolkit/common.h>
 #include <glm/glm.hpp>
 
 #include <memory>
+#include <optional>
 
 namespace mir
 {
@@ -66,6 +68,20 @@ public:
     **/
     virtual bool overlay(RenderableList const& renderlist) = 0;
 
+    /** Used when overlay() can't show the whole list: takes over as many of
+     *  the topmost renderables as the hardware can show on its own (such as
+     *  on overlay planes) for the next frame.
+     *  \param [in] renderlist
+     *      The renderables that should appear on the screen, bottom to top.
+     *  \returns
+     *      The renderables the caller still needs to render, bottom to top.
+     *      By default this is all of them.
+    **/
+    virtual auto overlay_topmost(RenderableList const& renderlist) -> RenderableList
+    {
+        return renderlist;
+    }
+
     /**
      * Returns a transformation that the renderer must apply to all rendering.
      * There is usually no transformation required (just the identity matrix)
@@ -83,6 +99,18 @@ public:
      */
     virtual NativeDisplayBuffer* native_display_buffer() = 0;
 
+    /** How the frame most recently posted by DisplaySyncGroup::post() was
+     *  shown, for clients that want precise presentation feedback.
+     *  \returns
+     *      std::nullopt if the platform doesn't know (for example, because
+     *      the frame is still waiting for its page flip), in which case the
+     *      caller should assume it was shown when post() returned.
+    **/
+    virtual auto last_presentation() const -> std::optional<FramePresentation>
+    {
+        return std::nullopt;
+    }
+
 protected:
     DisplayBuffer() = default;
     DisplayBuffer(DisplayBuffer const& c) = delete;
@@ -141,6 +141,11 @@ struct DisplayConfigurationOutput
 
     mir::optional_value<geometry::Size> custom_logical_size;
 
+    /** Whether the output can vary its refresh rate to match when frames are posted (VRR, aka adaptive sync) */
+    bool vrr_capable{false};
+    /** Whether to vary the refresh rate; only takes effect if the output is vrr_capable */
+    bool vrr_enabled{false};
+
     /** The logical rectangle occupied by the output, based on its position,
         current mode and orientation (rotation) */
     geometry::Rectangle extents() const;
@@ -185,6 +190,8 @@ struct UserDisplayConfigurationOutput
     MirOutputGammaSupported const& gamma_supported;
     std::vector<uint8_t const> const& edid;
     mir::optional_value<geometry::Size>& custom_logical_size;
+    bool const& vrr_capable;
+    bool& vrr_enabled;
 
     UserDisplayConfigurationOutput(DisplayConfigurationOutput& main);
     geometry::Rectangle extents() const;
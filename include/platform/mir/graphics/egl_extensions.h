@@ -183,6 +183,11 @@ typedef EGLBoolean (EGLAPIENTRYP PFNEGLQUERYDMABUFFORMATSEXTPROC) (EGLDisplay dp
 typedef EGLBoolean (EGLAPIENTRYP PFNEGLQUERYDMABUFMODIFIERSEXTPROC) (EGLDisplay dpy, EGLint format, EGLint max_modifiers, EGLuint64KHR *modifiers, EGLBoolean *external_only, EGLint *num_modifiers);
 #endif /* EGL_EXT_image_dma_buf_import_modifiers */
 
+#ifndef EGL_EXT_device_drm_render_node
+#define EGL_EXT_device_drm_render_node 1
+#define EGL_DRM_RENDER_NODE_FILE_EXT      0x3377
+#endif /* EGL_EXT_device_drm_render_node */
+
 /*
  * Just enough polyfill for rawhide headers...
  */
@@ -315,6 +320,22 @@ struct EGLExtensions
         PFNEGLQUERYDMABUFFORMATSEXTPROC const eglQueryDmaBufFormatsExt;
         PFNEGLQUERYDMABUFMODIFIERSEXTPROC const eglQueryDmaBufModifiersExt;
     };
+
+    /// EGL_EXT_device_query and EGL_EXT_device_drm, to find the DRM device behind a display
+    struct EXTDeviceDRM
+    {
+        EXTDeviceDRM(EGLDisplay dpy);
+
+        /// The primary node of the device (such as /dev/dri/card0)
+        auto device_file() const -> char const*;
+
+        /// The render node of the device (such as /dev/dri/renderD128), or nullptr if it isn't known
+        auto render_node_file() const -> char const*;
+
+        PFNEGLQUERYDISPLAYATTRIBEXTPROC const eglQueryDisplayAttribEXT;
+        PFNEGLQUERYDEVICESTRINGEXTPROC const eglQueryDeviceStringEXT;
+        EGLDeviceEXT device;
+    };
 };
 
 }
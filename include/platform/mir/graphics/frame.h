@@ -18,6 +18,7 @@
 #define MIR_GRAPHICS_FRAME_H_
 
 #include "mir/time/posix_timestamp.h"
+#include <chrono>
 #include <cstdint>
 
 namespace mir { namespace graphics {
@@ -40,6 +41,18 @@ struct Frame
     Timestamp ust;     /**< Unadjusted System Time */
 };
 
+/**
+ * How a posted frame was shown on an output
+ */
+struct FramePresentation
+{
+    Frame frame;                          /**< The refresh it was first shown at */
+    std::chrono::nanoseconds refresh{0};  /**< The output's refresh interval, or zero if it isn't fixed */
+    bool vsync = false;                   /**< It was shown at a vertical refresh, so couldn't tear */
+    bool hw_clock = false;                /**< frame came from the display hardware, rather than a clock read later */
+    bool zero_copy = false;               /**< A client buffer was scanned out, without being composited */
+};
+
 }} // namespace mir::graphics
 
 #endif // MIR_GRAPHICS_FRAME_H_
@@ -0,0 +1,67 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_INCREMENTAL_BUFFER_H_
+#define MIR_GRAPHICS_INCREMENTAL_BUFFER_H_
+
+#include "mir/geometry/rectangles.h"
+
+namespace mir
+{
+namespace graphics
+{
+class Buffer;
+
+/**
+ * A buffer that needs copying before it can be used, such as one a client renders in software
+ *
+ * Such buffers usually differ from their predecessor only in a small area.
+ * Telling the buffer what it replaces lets it copy just that area, and telling
+ * it to prepare lets the copy happen before the compositor needs it.
+ *
+ * This is reached by a dynamic_cast of Buffer::native_buffer_base().
+ */
+class IncrementalBuffer
+{
+public:
+    virtual ~IncrementalBuffer() = default;
+
+    /**
+     * Declare that this buffer replaces previous, and differs from it only in damage
+     *
+     * \param [in] previous The buffer this replaces. Buffers of a different
+     *                      type, size or format are ignored.
+     * \param [in] damage   In buffer coordinates
+     */
+    virtual void replaces(Buffer& previous, geometry::Rectangles const& damage) = 0;
+
+    /**
+     * Start copying this buffer, without waiting for the copy to complete
+     *
+     * Using the buffer before the copy completes is safe; it just waits for
+     * (or does) the copy then.
+     */
+    virtual void prepare() = 0;
+
+protected:
+    IncrementalBuffer() = default;
+    IncrementalBuffer(IncrementalBuffer const&) = delete;
+    IncrementalBuffer& operator=(IncrementalBuffer const&) = delete;
+};
+}
+}
+
+#endif //MIR_GRAPHICS_INCREMENTAL_BUFFER_H_
@@ -22,6 +22,14 @@
 
 #include <EGL/egl.h>
 
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
 #include "mir/graphics/buffer.h"
 #include "mir/graphics/egl_extensions.h"
 
@@ -44,15 +52,31 @@ class EGLContextExecutor;
 }
 
 class DmaBufFormatDescriptors;
+class DmaBufFeedback;
 
 class LinuxDmaBufUnstable : public mir::wayland::LinuxDmabufV1::Global
 {
 public:
+    /// The DRM format and modifier pairs a KMS device can scan out
+    struct ScanoutFormats
+    {
+        dev_t device;
+        std::vector<std::pair<uint32_t, uint64_t>> formats;
+    };
+
+    /**
+     * \param [in] scanout   What buffers of fullscreen surfaces should be, so
+     *                       that they can bypass composition. Pairs that dpy
+     *                       can't import are ignored.
+     */
     LinuxDmaBufUnstable(
         wl_display* display,
         EGLDisplay dpy,
         std::shared_ptr<EGLExtensions> egl_extensions,
-        EGLExtensions::EXTImageDmaBufImportModifiers const& dmabuf_ext);
+        EGLExtensions::EXTImageDmaBufImportModifiers const& dmabuf_ext,
+        std::optional<ScanoutFormats> const& scanout = std::nullopt);
+
+    ~LinuxDmaBufUnstable();
 
     std::shared_ptr<Buffer> buffer_from_resource(
         wl_resource* buffer,
@@ -60,6 +84,15 @@ public:
         std::function<void()>&& on_release,
         std::shared_ptr<common::EGLContextExecutor> egl_delegate);
 
+    struct TextureCacheCounts
+    {
+        uint64_t hits;      ///< Commits that reused the texture imported for an earlier commit
+        uint64_t misses;    ///< Commits that had to import a new texture
+    };
+
+    /// The textures imported for each wl_buffer are reused by its later commits
+    auto texture_cache_counts() const -> TextureCacheCounts;
+
 private:
     class Instance;
     void bind(wl_resource* new_resource) override;
@@ -67,6 +100,11 @@ private:
     EGLDisplay const dpy;
     std::shared_ptr<EGLExtensions> const egl_extensions;
     std::shared_ptr<DmaBufFormatDescriptors> const formats;
+    std::shared_ptr<DmaBufFeedback const> const feedback;
+    /// Stands in for the contexts buffer_from_resource() is called in, which are our owner's
+    std::shared_ptr<void const> const import_contexts;
+    std::atomic<uint64_t> texture_cache_hits{0};
+    std::atomic<uint64_t> texture_cache_misses{0};
 };
 
 }
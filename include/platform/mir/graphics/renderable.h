@@ -69,6 +69,29 @@ public:
     virtual glm::mat4 transformation() const = 0;
 
     virtual bool shaped() const = 0;  // meaning the pixel format has alpha
+
+    /**
+     * The parts of a shaped() renderable that are nevertheless fully opaque,
+     * in the same coordinates as screen_position().
+     *
+     * This is only a hint (e.g. for occlusion culling); the default is that
+     * no part is known to be opaque.
+     */
+    virtual std::vector<geometry::Rectangle> opaque_region() const
+    {
+        return {};
+    }
+
+    /**
+     * Whether the content may be shown with tearing, if that gets it on
+     * screen sooner (e.g. by an asynchronous page flip).
+     *
+     * Like opaque_region(), this is a hint; by default content shouldn't tear.
+     */
+    virtual bool allow_tearing() const
+    {
+        return false;
+    }
 protected:
     Renderable() = default;
     Renderable(Renderable const&) = delete;
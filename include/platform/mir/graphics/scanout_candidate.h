@@ -0,0 +1,55 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_SCANOUT_CANDIDATE_H_
+#define MIR_GRAPHICS_SCANOUT_CANDIDATE_H_
+
+#include <functional>
+
+namespace mir
+{
+namespace graphics
+{
+/**
+ * A surface whose buffers could be scanned out without compositing, such as a fullscreen window
+ *
+ * The frontend's wl_surfaces implement this, so that platform code that only
+ * has a wl_surface resource can reach it by a dynamic_cast of
+ * wayland::Surface::from().
+ *
+ * This may only be used from the Wayland thread.
+ */
+class ScanoutCandidate
+{
+public:
+    virtual ~ScanoutCandidate() = default;
+
+    /// Whether the surface covers an output, so that its buffers could bypass composition
+    virtual auto is_scanout_candidate() const -> bool = 0;
+
+    /// Call on_change whenever is_scanout_candidate() changes, until removed
+    virtual void add_scanout_candidate_listener(void const* key, std::function<void()> const& on_change) = 0;
+    virtual void remove_scanout_candidate_listener(void const* key) = 0;
+
+protected:
+    ScanoutCandidate() = default;
+    ScanoutCandidate(ScanoutCandidate const&) = delete;
+    ScanoutCandidate& operator=(ScanoutCandidate const&) = delete;
+};
+}
+}
+
+#endif //MIR_GRAPHICS_SCANOUT_CANDIDATE_H_
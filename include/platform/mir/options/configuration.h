@@ -46,11 +46,13 @@ extern char const* const wayland_extensions_opt;
 extern char const* const add_wayland_extensions_opt;
 extern char const* const drop_wayland_extensions_opt;
 extern char const* const idle_timeout_opt;
+extern char const* const max_pointer_motion_rate_opt;
 
 extern char const* const enable_key_repeat_opt;
 
 extern char const* const off_opt_value;
 extern char const* const log_opt_value;
+extern char const* const async_log_opt_value;
 extern char const* const lttng_opt_value;
 
 extern char const* const platform_display_libs;
@@ -18,6 +18,7 @@
 #define MIR_RENDERER_RENDERER_H_
 
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/graphics/renderable.h"
 #include "mir_toolkit/common.h"
 #include <glm/glm.hpp>
@@ -34,6 +35,12 @@ public:
 
     virtual void set_viewport(geometry::Rectangle const& rect) = 0;
     virtual void set_output_transform(glm::mat2 const&) = 0;
+    /**
+     * Limits the next render() to the given regions (in the same coordinates
+     * as the viewport); the rest of the output is unchanged from the
+     * previous frame. Without a call to set_damage() everything is redrawn.
+     */
+    virtual void set_damage(geometry::Rectangles const& damage) = 0;
     virtual void render(graphics::RenderableList const&) const = 0;
     virtual void suspend() = 0; // called when render() is skipped
 
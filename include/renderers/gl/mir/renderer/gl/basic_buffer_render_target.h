@@ -19,7 +19,9 @@
 
 #include "buffer_render_target.h"
 
+#include <deque>
 #include <optional>
+#include <vector>
 #include <GLES2/gl2.h>
 
 namespace mir
@@ -35,13 +37,19 @@ class BasicBufferRenderTarget: public BufferRenderTarget
 {
 public:
     BasicBufferRenderTarget(std::shared_ptr<Context> const& ctx);
+    ~BasicBufferRenderTarget();
 
     void set_buffer(std::shared_ptr<software::WriteMappableBuffer> const& buffer) override;
+    void set_dmabuf(std::shared_ptr<graphics::DMABufBuffer> const& buffer) override;
+    void finish_copy() override;
 
     auto size() const -> geometry::Size override;
     void make_current() override;
     void release_current() override;
     void swap_buffers() override;
+    /// Only reads back the damaged part of the frame; the rest is kept from previous frames
+    void swap_buffers_with_damage(geometry::Rectangles const& damage) override;
+    auto buffer_age() const -> int override;
     void bind() override;
 
 private:
@@ -50,10 +58,13 @@ private:
     public:
         Framebuffer(geometry::Size const& size);
         ~Framebuffer();
-        void copy_to(software::WriteMappableBuffer& buffer);
+        void copy_to(software::WriteMappableBuffer& buffer) const;
         void bind();
 
         geometry::Size const size;
+        /// The frames read back so far, bottom row first as glReadPixels() gives them
+        std::vector<unsigned char> pixels;
+        bool has_frame{false};
 
     private:
         Framebuffer(Framebuffer const&) = delete;
@@ -63,10 +74,33 @@ private:
         GLuint fbo;
     };
 
+    class PixelPackBuffers;
+    class DMABufFramebuffer;
+
+    /// Part of a frame read back from the framebuffer, on its way to a buffer
+    struct Copy
+    {
+        std::shared_ptr<software::WriteMappableBuffer> buffer;
+        GLint x, y;                         ///< In GL framebuffer coordinates
+        GLsizei width, height;
+        std::optional<int> pixel_pack_buffer;
+        std::vector<unsigned char> pixels;  ///< If read back without a pixel pack buffer
+        std::shared_ptr<DMABufFramebuffer> dmabuf; ///< If rendered straight into a dmabuf
+        bool done{false};
+    };
+
+    void start_copy(GLint x, GLint y, GLsizei width, GLsizei height);
+    void complete(Copy& copy);
+
     std::shared_ptr<Context> const ctx;
 
     std::shared_ptr<software::WriteMappableBuffer> buffer{nullptr};
     std::optional<Framebuffer> framebuffer;
+    /// Rendered into instead of framebuffer, if set
+    std::shared_ptr<DMABufFramebuffer> dmabuf_framebuffer;
+    bool pixel_pack_buffers_probed{false};
+    std::unique_ptr<PixelPackBuffers> pixel_pack_buffers;
+    std::deque<Copy> copies;
 };
 
 }
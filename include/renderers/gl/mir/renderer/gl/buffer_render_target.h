@@ -24,6 +24,10 @@
 
 namespace mir
 {
+namespace graphics
+{
+class DMABufBuffer;
+}
 namespace renderer
 {
 namespace software
@@ -38,6 +42,23 @@ class BufferRenderTarget: public RenderTarget
 {
 public:
     virtual void set_buffer(std::shared_ptr<software::WriteMappableBuffer> const& buffer) = 0;
+
+    /**
+     * Render straight into a dmabuf, rather than copying into a CPU buffer
+     *
+     * \throws  if buffer can't be imported as a render target
+     */
+    virtual void set_dmabuf(std::shared_ptr<graphics::DMABufBuffer> const& buffer) = 0;
+
+    /**
+     * Complete the oldest copy started by swap_buffers()
+     *
+     * swap_buffers() only starts copying the frame to the buffer, so that the
+     * copy can overlap rendering the next frame. Copies complete in the order
+     * they were started. For a dmabuf this just waits for the rendering to
+     * complete. This must be called with the target current.
+     */
+    virtual void finish_copy() = 0;
 };
 
 }
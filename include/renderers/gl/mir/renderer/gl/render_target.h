@@ -43,6 +43,29 @@ public:
      * free GL-related resources such as textures and buffers.
      */
     virtual void swap_buffers() = 0;
+    /**
+     * Swap buffers, hinting that only \a damage has changed since the last swap.
+     *
+     * \param [in] damage The changed regions, in buffer pixels relative to the
+     *                    top-left of the render target.
+     *
+     * The default implementation ignores the hint.
+     */
+    virtual void swap_buffers_with_damage(geometry::Rectangles const& /*damage*/)
+    {
+        swap_buffers();
+    }
+    /**
+     * The number of frames ago the current back buffer was last presented,
+     * as per EGL_EXT_buffer_age.
+     *
+     * Only valid after bind(); 0 means the buffer contents are undefined and
+     * must be redrawn in full.
+     */
+    virtual auto buffer_age() const -> int
+    {
+        return 0;
+    }
     /** Binds any necessary resources (fbos, textures if any)
      * in preparation for drawing.
      */
@@ -0,0 +1,278 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/logging/async_logger.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+namespace ml = mir::logging;
+
+namespace
+{
+/// How long the writer leaves records queued before writing them, unless something urgent is logged
+auto const write_interval = std::chrono::milliseconds{10};
+
+std::atomic<uint64_t> next_logger_id{0};
+
+struct QueuedRecord
+{
+    uint64_t sequence;
+    ml::Severity severity;
+    std::string message;
+    std::string component;
+};
+}
+
+/// A single-producer, single-consumer ring of records logged by one thread
+struct ml::AsyncLogger::Ring
+{
+    static size_t constexpr capacity = 256;
+
+    Ring()
+    {
+        for (auto& record : records)
+        {
+            record.message.reserve(128);
+        }
+    }
+
+    std::array<QueuedRecord, capacity> records;
+
+    /// Written only by the logging thread
+    alignas(64) std::atomic<uint64_t> head{0};
+    /// Written only by the writer thread
+    alignas(64) std::atomic<uint64_t> tail{0};
+
+    std::atomic<uint64_t> dropped{0};
+    /// Only accessed by the writer thread
+    uint64_t dropped_reported{0};
+
+    /// Set when the logging thread exits, after its last record
+    std::atomic<bool> thread_exited{false};
+};
+
+ml::AsyncLogger::AsyncLogger(std::shared_ptr<Logger> const& downstream)
+    : downstream{downstream},
+      id{next_logger_id.fetch_add(1, std::memory_order_relaxed)},
+      writer{[this] { run_writer(); }}
+{
+}
+
+ml::AsyncLogger::~AsyncLogger()
+{
+    {
+        std::lock_guard lock{writer_mutex};
+        stopping = true;
+    }
+    writer_wakeup.notify_all();
+    writer.join();
+}
+
+void ml::AsyncLogger::log(Severity severity, std::string const& message, std::string const& component)
+{
+    enqueue(severity, message.data(), message.size(), component.c_str());
+}
+
+void ml::AsyncLogger::log(char const* component, Severity severity, char const* format, ...)
+{
+    char message[4096];
+    va_list va;
+    va_start(va, format);
+    auto const length = vsnprintf(message, sizeof message, format, va);
+    va_end(va);
+
+    if (length < 0)
+        return;
+
+    enqueue(severity, message, std::min(static_cast<size_t>(length), sizeof message - 1), component);
+}
+
+void ml::AsyncLogger::flush()
+{
+    std::unique_lock lock{writer_mutex};
+    auto const request = ++flush_requests;
+    writer_wakeup.notify_all();
+    writer_wakeup.wait(lock, [&] { return flushes_completed >= request; });
+}
+
+auto ml::AsyncLogger::dropped() const -> uint64_t
+{
+    std::lock_guard lock{rings_mutex};
+
+    auto total = retired_dropped;
+    for (auto const& ring : rings)
+    {
+        total += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+auto ml::AsyncLogger::ring_for_this_thread() -> Ring&
+{
+    /// Tells the writers of this thread's rings when it has exited, so they can free them
+    struct ThreadRings
+    {
+        ~ThreadRings()
+        {
+            for (auto const& [logger_id, ring] : rings)
+            {
+                ring->thread_exited.store(true, std::memory_order_release);
+            }
+        }
+
+        // Logger ids are never reused, so stale entries left by destroyed loggers are harmless
+        std::vector<std::pair<uint64_t, std::shared_ptr<Ring>>> rings;
+    };
+    thread_local ThreadRings thread_rings;
+
+    for (auto const& [logger_id, ring] : thread_rings.rings)
+    {
+        if (logger_id == id)
+            return *ring;
+    }
+
+    std::lock_guard lock{rings_mutex};
+    rings.push_back(std::make_shared<Ring>());
+    thread_rings.rings.emplace_back(id, rings.back());
+    return *rings.back();
+}
+
+void ml::AsyncLogger::enqueue(Severity severity, char const* message, size_t message_size, char const* component)
+{
+    auto& ring = ring_for_this_thread();
+
+    auto const head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) == Ring::capacity)
+    {
+        // Only this thread writes the count, so there's no need for a read-modify-write
+        ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto& record = ring.records[head % Ring::capacity];
+    record.sequence = next_sequence.fetch_add(1, std::memory_order_relaxed);
+    record.severity = severity;
+    record.message.assign(message, message_size);
+    record.component.assign(component);
+    ring.head.store(head + 1, std::memory_order_release);
+
+    if (severity <= Severity::error)
+    {
+        // Don't leave the record queued if the process is about to go down
+        {
+            std::lock_guard lock{writer_mutex};
+            urgent = true;
+        }
+        writer_wakeup.notify_all();
+    }
+}
+
+void ml::AsyncLogger::write_pending()
+{
+    std::vector<std::shared_ptr<Ring>> current_rings;
+    {
+        std::lock_guard lock{rings_mutex};
+        current_rings = rings;
+    }
+
+    std::vector<QueuedRecord> batch;
+    uint64_t newly_dropped{0};
+    std::vector<Ring*> drained_for_good;
+    for (auto const& ring : current_rings)
+    {
+        // Checked before reading head, so that an exited thread's last records are seen
+        auto const thread_exited = ring->thread_exited.load(std::memory_order_acquire);
+        auto const tail = ring->tail.load(std::memory_order_relaxed);
+        auto const head = ring->head.load(std::memory_order_acquire);
+        for (auto i = tail; i != head; ++i)
+        {
+            batch.push_back(ring->records[i % Ring::capacity]);
+        }
+        ring->tail.store(head, std::memory_order_release);
+
+        auto const dropped = ring->dropped.load(std::memory_order_relaxed);
+        newly_dropped += dropped - ring->dropped_reported;
+        ring->dropped_reported = dropped;
+
+        if (thread_exited)
+        {
+            drained_for_good.push_back(ring.get());
+        }
+    }
+
+    if (!drained_for_good.empty())
+    {
+        std::lock_guard lock{rings_mutex};
+        std::erase_if(
+            rings,
+            [&](auto const& ring)
+            {
+                if (std::find(begin(drained_for_good), end(drained_for_good), ring.get()) == end(drained_for_good))
+                    return false;
+
+                retired_dropped += ring->dropped_reported;
+                return true;
+            });
+    }
+
+    std::sort(begin(batch), end(batch), [](auto const& a, auto const& b) { return a.sequence < b.sequence; });
+
+    for (auto const& record : batch)
+    {
+        downstream->log(record.severity, record.message, record.component);
+    }
+
+    if (newly_dropped)
+    {
+        downstream->log(
+            Severity::warning,
+            std::to_string(newly_dropped) + " log messages dropped because the log writer fell behind",
+            "logging");
+    }
+}
+
+void ml::AsyncLogger::run_writer()
+{
+    std::unique_lock lock{writer_mutex};
+
+    for (;;)
+    {
+        writer_wakeup.wait_for(
+            lock,
+            write_interval,
+            [this] { return stopping || urgent || flush_requests != flushes_completed; });
+
+        auto const stop = stopping;
+        auto const request = flush_requests;
+        // Anything urgent logged before this is written below
+        urgent = false;
+
+        lock.unlock();
+        write_pending();
+        lock.lock();
+
+        flushes_completed = request;
+        writer_wakeup.notify_all();
+
+        if (stop)
+            return;
+    }
+}
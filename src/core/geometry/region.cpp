@@ -0,0 +1,276 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+
+#include <algorithm>
+#include <ostream>
+
+namespace geom = mir::geometry;
+
+namespace
+{
+using Spans = std::vector<std::pair<int, int>>;
+
+bool in_either(bool in_a, bool in_b) { return in_a || in_b; }
+bool in_first_only(bool in_a, bool in_b) { return in_a && !in_b; }
+bool in_both(bool in_a, bool in_b) { return in_a && in_b; }
+
+/// Sorted, de-duplicated edges of two lists of [first, second) intervals
+template<typename Intervals, typename Edges>
+auto edges_of(Intervals const& a, Intervals const& b, Edges edges) -> std::vector<int>
+{
+    std::vector<int> result;
+    result.reserve(2 * (a.size() + b.size()));
+    for (auto const& i : a)
+    {
+        auto const [first, second] = edges(i);
+        result.push_back(first);
+        result.push_back(second);
+    }
+    for (auto const& i : b)
+    {
+        auto const [first, second] = edges(i);
+        result.push_back(first);
+        result.push_back(second);
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+auto combine_spans(Spans const& a, Spans const& b, bool (*keep)(bool, bool)) -> Spans
+{
+    auto const xs = edges_of(a, b, [](auto const& span) { return span; });
+
+    Spans result;
+    auto span_a = a.begin();
+    auto span_b = b.begin();
+    for (size_t i = 0; i + 1 < xs.size(); ++i)
+    {
+        auto const left = xs[i];
+        auto const right = xs[i + 1];
+
+        while (span_a != a.end() && span_a->second <= left)
+            ++span_a;
+        while (span_b != b.end() && span_b->second <= left)
+            ++span_b;
+
+        bool const in_a = span_a != a.end() && span_a->first <= left;
+        bool const in_b = span_b != b.end() && span_b->first <= left;
+
+        if (keep(in_a, in_b))
+        {
+            if (!result.empty() && result.back().second == left)
+                result.back().second = right;
+            else
+                result.emplace_back(left, right);
+        }
+    }
+    return result;
+}
+}
+
+auto geom::Region::combine(
+    std::vector<Band> const& a,
+    std::vector<Band> const& b,
+    bool (*keep)(bool in_a, bool in_b)) -> std::vector<Band>
+{
+    static Spans const no_spans;
+    auto const ys = edges_of(a, b, [](Band const& band) { return std::make_pair(band.top, band.bottom); });
+
+    std::vector<Band> result;
+    auto band_a = a.begin();
+    auto band_b = b.begin();
+    for (size_t i = 0; i + 1 < ys.size(); ++i)
+    {
+        auto const top = ys[i];
+        auto const bottom = ys[i + 1];
+
+        while (band_a != a.end() && band_a->bottom <= top)
+            ++band_a;
+        while (band_b != b.end() && band_b->bottom <= top)
+            ++band_b;
+
+        // As top..bottom lies between consecutive edges, any band that starts
+        // at or above top covers all of it
+        auto const& spans_a = (band_a != a.end() && band_a->top <= top) ? band_a->spans : no_spans;
+        auto const& spans_b = (band_b != b.end() && band_b->top <= top) ? band_b->spans : no_spans;
+
+        auto spans = combine_spans(spans_a, spans_b, keep);
+        if (spans.empty())
+            continue;
+
+        // Coalesce with the band above where possible, keeping the representation canonical
+        if (!result.empty() && result.back().bottom == top && result.back().spans == spans)
+            result.back().bottom = bottom;
+        else
+            result.push_back(Band{top, bottom, std::move(spans)});
+    }
+    return result;
+}
+
+geom::Region::Region()
+{
+}
+
+geom::Region::Region(Rectangle const& rect)
+{
+    if (rect.size.width > Width{0} && rect.size.height > Height{0})
+    {
+        bands.push_back(Band{
+            rect.top().as_int(),
+            rect.bottom().as_int(),
+            {{rect.left().as_int(), rect.right().as_int()}}});
+    }
+}
+
+geom::Region::Region(std::initializer_list<Rectangle> const& rects)
+{
+    for (auto const& rect : rects)
+        add(rect);
+}
+
+void geom::Region::add(Rectangle const& rect)
+{
+    add(Region(rect));
+}
+
+void geom::Region::add(Region const& region)
+{
+    bands = combine(bands, region.bands, &in_either);
+}
+
+void geom::Region::subtract(Rectangle const& rect)
+{
+    subtract(Region(rect));
+}
+
+void geom::Region::subtract(Region const& region)
+{
+    bands = combine(bands, region.bands, &in_first_only);
+}
+
+void geom::Region::intersect(Rectangle const& rect)
+{
+    intersect(Region(rect));
+}
+
+void geom::Region::intersect(Region const& region)
+{
+    bands = combine(bands, region.bands, &in_both);
+}
+
+void geom::Region::clear()
+{
+    bands.clear();
+}
+
+auto geom::Region::empty() const -> bool
+{
+    return bands.empty();
+}
+
+auto geom::Region::contains(Point const& point) const -> bool
+{
+    auto const x = point.x.as_int();
+    auto const y = point.y.as_int();
+
+    for (auto const& band : bands)
+    {
+        if (band.top > y)
+            break;
+
+        if (y < band.bottom)
+        {
+            for (auto const& span : band.spans)
+            {
+                if (span.first <= x && x < span.second)
+                    return true;
+            }
+            return false;
+        }
+    }
+    return false;
+}
+
+auto geom::Region::contains(Rectangle const& rect) const -> bool
+{
+    return combine(Region(rect).bands, bands, &in_first_only).empty();
+}
+
+auto geom::Region::overlaps(Rectangle const& rect) const -> bool
+{
+    return !combine(bands, Region(rect).bands, &in_both).empty();
+}
+
+auto geom::Region::bounding_rectangle() const -> Rectangle
+{
+    if (bands.empty())
+        return {};
+
+    auto left = bands.front().spans.front().first;
+    auto right = bands.front().spans.back().second;
+    for (auto const& band : bands)
+    {
+        left = std::min(left, band.spans.front().first);
+        right = std::max(right, band.spans.back().second);
+    }
+
+    auto const top = bands.front().top;
+    auto const bottom = bands.back().bottom;
+    return {{left, top}, {right - left, bottom - top}};
+}
+
+auto geom::Region::rectangles() const -> std::vector<Rectangle>
+{
+    std::vector<Rectangle> result;
+    for (auto const& band : bands)
+    {
+        for (auto const& span : band.spans)
+            result.push_back({{span.first, band.top}, {span.second - span.first, band.bottom - band.top}});
+    }
+    return result;
+}
+
+auto geom::Region::operator==(Region const& other) const -> bool
+{
+    return std::equal(
+        bands.begin(), bands.end(),
+        other.bands.begin(), other.bands.end(),
+        [](Band const& lhs, Band const& rhs)
+        {
+            return lhs.top == rhs.top && lhs.bottom == rhs.bottom && lhs.spans == rhs.spans;
+        });
+}
+
+auto geom::Region::operator!=(Region const& other) const -> bool
+{
+    return !(*this == other);
+}
+
+std::ostream& geom::operator<<(std::ostream& out, Region const& value)
+{
+    out << '(';
+    auto first = true;
+    for (auto const& rect : value.rectangles())
+    {
+        out << (first ? "" : ", ") << rect;
+        first = false;
+    }
+    out << ')';
+    return out;
+}
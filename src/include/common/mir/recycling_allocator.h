@@ -0,0 +1,148 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RECYCLING_ALLOCATOR_H_
+#define MIR_RECYCLING_ALLOCATOR_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace mir
+{
+/**
+ * Keeps freed memory blocks for reuse instead of returning them to the heap.
+ *
+ * This suits objects that are created and destroyed at a steady rate (such as
+ * the per-frame objects the compositor uses): once enough blocks have been
+ * allocated to cover the peak demand there are no further heap allocations.
+ *
+ * Blocks may be allocated and freed on any thread.
+ */
+class RecyclingPool
+{
+public:
+    RecyclingPool() = default;
+
+    ~RecyclingPool()
+    {
+        for (auto const& size_class : size_classes)
+        {
+            for (auto const block : size_class.free_blocks)
+                ::operator delete(block);
+        }
+    }
+
+    auto allocate(std::size_t size) -> void*
+    {
+        std::lock_guard lock{mutex};
+
+        auto& size_class = size_class_for(size);
+        if (!size_class.free_blocks.empty())
+        {
+            auto const block = size_class.free_blocks.back();
+            size_class.free_blocks.pop_back();
+            return block;
+        }
+
+        // Make sure deallocate() never needs to grow the free list
+        size_class.free_blocks.reserve(++size_class.total_blocks);
+        return ::operator new(size);
+    }
+
+    void deallocate(void* block, std::size_t size) noexcept
+    {
+        std::lock_guard lock{mutex};
+        size_class_for(size).free_blocks.push_back(block);
+    }
+
+private:
+    RecyclingPool(RecyclingPool const&) = delete;
+    RecyclingPool& operator=(RecyclingPool const&) = delete;
+
+    struct SizeClass
+    {
+        std::size_t size;
+        std::size_t total_blocks;
+        std::vector<void*> free_blocks;
+    };
+
+    // There are only ever a handful of sizes, so a linear search is fine
+    auto size_class_for(std::size_t size) -> SizeClass&
+    {
+        for (auto& size_class : size_classes)
+        {
+            if (size_class.size == size)
+                return size_class;
+        }
+
+        return size_classes.emplace_back(SizeClass{size, 0, {}});
+    }
+
+    std::mutex mutex;
+    std::vector<SizeClass> size_classes;
+};
+
+/**
+ * An allocator drawing from a RecyclingPool, for use with std::allocate_shared()
+ *
+ * Each allocation keeps the pool alive, so objects may outlive whoever created the pool.
+ */
+template<typename Type>
+class RecyclingAllocator
+{
+public:
+    using value_type = Type;
+
+    explicit RecyclingAllocator(std::shared_ptr<RecyclingPool> pool) :
+        pool{std::move(pool)}
+    {
+    }
+
+    template<typename Other>
+    RecyclingAllocator(RecyclingAllocator<Other> const& other) :
+        pool{other.pool}
+    {
+    }
+
+    auto allocate(std::size_t n) -> Type*
+    {
+        static_assert(alignof(Type) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Over-aligned types are not supported");
+        return static_cast<Type*>(pool->allocate(n * sizeof(Type)));
+    }
+
+    void deallocate(Type* block, std::size_t n) noexcept
+    {
+        pool->deallocate(block, n * sizeof(Type));
+    }
+
+    template<typename Other>
+    auto operator==(RecyclingAllocator<Other> const& other) const -> bool
+    {
+        return pool == other.pool;
+    }
+
+private:
+    template<typename Other>
+    friend class RecyclingAllocator;
+
+    std::shared_ptr<RecyclingPool> pool;
+};
+}
+
+#endif // MIR_RECYCLING_ALLOCATOR_H_
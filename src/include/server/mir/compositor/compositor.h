@@ -17,8 +17,14 @@
 #ifndef MIR_COMPOSITOR_COMPOSITOR_H_
 #define MIR_COMPOSITOR_COMPOSITOR_H_
 
+#include <vector>
+
 namespace mir
 {
+namespace graphics
+{
+class DisplaySyncGroup;
+}
 namespace compositor
 {
 
@@ -30,10 +36,40 @@ public:
     virtual void start() = 0;
     virtual void stop() = 0;
 
+    /**
+     * Stops compositing to \p groups (which are about to be invalidated), if it was started.
+     *
+     * Called when the display's DisplaySyncGroups change, so \p groups is empty if some are only being added.
+     * Compositing to other DisplaySyncGroups may carry on. By default all compositing stops, for
+     * start_new_sync_groups() to restart.
+     */
+    virtual void stop_sync_groups(std::vector<graphics::DisplaySyncGroup*> const& /*groups*/)
+    {
+        stop();
+        restart_pending = true;
+    }
+
+    /**
+     * Starts compositing to the display's DisplaySyncGroups that aren't yet being composited.
+     *
+     * By default this restarts compositing only if stop_sync_groups() stopped it.
+     */
+    virtual void start_new_sync_groups()
+    {
+        if (restart_pending)
+        {
+            restart_pending = false;
+            start();
+        }
+    }
+
 protected:
     Compositor() = default;
     Compositor(Compositor const&) = delete;
     Compositor& operator=(Compositor const&) = delete;
+
+private:
+    bool restart_pending{false};
 };
 
 }
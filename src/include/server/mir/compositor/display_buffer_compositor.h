@@ -18,6 +18,8 @@
 #define MIR_COMPOSITOR_DISPLAY_BUFFER_COMPOSITOR_H_
 
 #include "mir/compositor/scene.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/graphics/renderable.h"
 
 namespace mir
 {
@@ -31,6 +33,16 @@ public:
 
     virtual void composite(SceneElementSequence&& scene_sequence) = 0;
 
+    /**
+     * Notes regions (in global coordinates) whose content has changed since
+     * the last composite() because the renderables identified by source have
+     * new content.
+     *
+     * This is only a hint; compositors that always redraw everything can
+     * ignore it.
+     */
+    virtual void add_damage(graphics::Renderable::ID /*source*/, geometry::Rectangles const& /*damage*/) {}
+
 protected:
     DisplayBufferCompositor() = default;
     DisplayBufferCompositor& operator=(DisplayBufferCompositor const&) = delete;
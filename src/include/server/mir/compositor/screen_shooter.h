@@ -26,6 +26,10 @@
 
 namespace mir
 {
+namespace graphics
+{
+class DMABufBuffer;
+}
 namespace renderer
 {
 namespace software
@@ -49,6 +53,20 @@ public:
         mir::geometry::Rectangle const& area,
         std::function<void(std::optional<time::Timestamp>)>&& callback) = 0;
 
+    /// As above, for a caller that has captured area before and knows what has changed since. Only the damaged part
+    /// of area (in the same coordinates) may need redrawing, but the whole of buffer is written.
+    virtual void capture(
+        std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
+        mir::geometry::Rectangle const& area,
+        mir::geometry::Rectangle const& damage,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) = 0;
+
+    /// As above, rendering straight into a dmabuf rather than copying the capture into a CPU buffer
+    virtual void capture(
+        std::shared_ptr<graphics::DMABufBuffer> const& buffer,
+        mir::geometry::Rectangle const& area,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) = 0;
+
 private:
     ScreenShooter(ScreenShooter const&) = delete;
     ScreenShooter& operator=(ScreenShooter const&) = delete;
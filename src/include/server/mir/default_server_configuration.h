@@ -53,6 +53,7 @@ class Scene;
 class DisplayBufferCompositorFactory;
 class Compositor;
 class CompositorReport;
+class PresentationNotifier;
 }
 namespace frontend
 {
@@ -234,6 +235,7 @@ public:
      * configurable interfaces for modifying compositor
      *  @{ */
     virtual std::shared_ptr<compositor::CompositorReport> the_compositor_report();
+    virtual std::shared_ptr<compositor::PresentationNotifier> the_presentation_notifier();
     virtual std::shared_ptr<compositor::DisplayBufferCompositorFactory> the_display_buffer_compositor_factory();
     virtual std::shared_ptr<compositor::DisplayBufferCompositorFactory> wrap_display_buffer_compositor_factory(
         std::shared_ptr<compositor::DisplayBufferCompositorFactory> const& wrapped);
@@ -329,6 +331,8 @@ public:
      * configurable interfaces for modifying logging
      *  @{ */
     virtual std::shared_ptr<logging::Logger> the_logger();
+    /// the_logger(), written to from a background thread. Used by reports set to "async-log".
+    auto the_async_logger() -> std::shared_ptr<logging::Logger>;
     /** @} */
 
     virtual std::shared_ptr<time::Clock> the_clock();
@@ -402,8 +406,10 @@ protected:
     CachedPtr<compositor::DisplayBufferCompositorFactory> display_buffer_compositor_factory;
     CachedPtr<compositor::Compositor> compositor;
     CachedPtr<compositor::CompositorReport> compositor_report;
+    CachedPtr<compositor::PresentationNotifier> presentation_notifier;
     CachedPtr<compositor::ScreenShooter> screen_shooter;
     CachedPtr<logging::Logger> logger;
+    CachedPtr<logging::Logger> async_logger;
     CachedPtr<graphics::DisplayReport> display_report;
     CachedPtr<time::Clock> clock;
     CachedPtr<MainLoop> main_loop;
@@ -19,9 +19,12 @@
 
 #include <mir_toolkit/common.h>
 #include "mir/graphics/buffer_id.h"
+#include "mir/graphics/frame.h"
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangles.h"
 #include <functional>
 #include <memory>
+#include <optional>
 
 namespace mir
 {
@@ -39,10 +42,28 @@ class BufferStream
 public:
     virtual ~BufferStream() = default;
 
+    /// Submits a buffer with its entire area damaged
     virtual void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer) = 0;
 
+    /// Submits a buffer where only the given region has changed since the previous buffer
+    /// damage is given in stream-local logical coordinates
+    virtual void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Rectangles const& damage) = 0;
+
+    /// The callback is given the buffer size and the damage in stream-local logical coordinates
     virtual void set_frame_posted_callback(
-        std::function<void(geometry::Size const&)> const& callback) = 0;
+        std::function<void(geometry::Size const&, geometry::Rectangles const&)> const& callback) = 0;
+
+    /// Runs the callback once the next frame showing this stream has been presented
+    /// Returns false (and doesn't run the callback) if the stream isn't being shown
+    virtual auto when_presented(std::function<void()> const& callback) -> bool = 0;
+
+    /// Runs the callback with how the buffer last submitted was shown once it has been presented, or with
+    /// std::nullopt if it never will be (because a later buffer replaced it, or its output went away)
+    /// If that buffer has already been taken by an output, the callback waits for that output's next frame
+    virtual void when_buffer_presented(
+        std::function<void(std::optional<graphics::FramePresentation> const&)> const& callback) = 0;
 
     virtual void with_most_recent_buffer_do(
         std::function<void(graphics::Buffer&)> const& exec) = 0;
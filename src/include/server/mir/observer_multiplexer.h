@@ -18,11 +18,11 @@
 #define MIR_OBSERVER_MULTIPLEXER_H_
 
 #include "mir/observer_registrar.h"
-#include "mir/posix_rw_mutex.h"
 #include "mir/executor.h"
 #include "mir/raii.h"
 #include "mir/synchronised.h"
 
+#include <memory>
 #include <vector>
 #include <algorithm>
 #include <mutex>
@@ -45,6 +45,10 @@ namespace mir
  * When an observer is removed a WeakObserver is marked as reset and removed from the observers list.
  * ObserverMultiplexer::unregister_interest() does not return until the related WeakObserver has been reset. This
  * happens once all in-flight observations have either completed, or are on threads that have removed the observer.
+ *
+ * The observers list is copy-on-write: registering and unregistering publish a new list, so notifications iterate a
+ * snapshot of it without copying it. Taking the snapshot only locks for as long as it takes to copy a shared_ptr.
+ * Observers on the immediate executor are called directly, rather than through a std::function.
  */
 template<class Observer>
 class ObserverMultiplexer : public ObserverRegistrar<Observer>, public Observer
@@ -100,8 +104,15 @@ private:
     public:
         explicit WeakObserver(std::weak_ptr<Observer> observer, Executor& executor)
             : executor{&executor},
-              observer{observer}
+              observer{observer},
+              immediate{&executor == &immediate_executor}
+        {
+        }
+
+        /// Observations can be made by invoke() on the notifying thread, rather than through spawn()
+        auto runs_immediately() const -> bool
         {
+            return immediate;
         }
 
         void spawn(std::function<void()>&& work)
@@ -216,6 +227,8 @@ private:
 
         std::weak_ptr<Observer> const observer;
 
+        bool const immediate;
+
         enum class Status
         {
             /// Can receive observations.
@@ -244,10 +257,38 @@ private:
         std::condition_variable reset_cv;
     };
 
-    PosixRWMutex observer_mutex;
-    std::vector<std::shared_ptr<WeakObserver>> observers;
+    using ObserverList = std::vector<std::shared_ptr<WeakObserver>>;
+
+    /// The current observers, which can be iterated while others are published
+    auto snapshot() -> std::shared_ptr<ObserverList const>;
+    /// Replace the observers. Must be called with observer_mutex held.
+    void publish(std::shared_ptr<ObserverList const> updated);
+
+    /// Serialises changes to observers, but isn't needed to read it
+    std::mutex observer_mutex;
+    /// Guards only the observers pointer, never anything done with the list
+    std::mutex observers_ptr_mutex;
+    /// Never modified once published, so notifications can iterate whichever list they take
+    std::shared_ptr<ObserverList const> observers{std::make_shared<ObserverList const>()};
 };
 
+template<class Observer>
+auto ObserverMultiplexer<Observer>::snapshot() -> std::shared_ptr<ObserverList const>
+{
+    std::lock_guard lock{observers_ptr_mutex};
+    return observers;
+}
+
+template<class Observer>
+void ObserverMultiplexer<Observer>::publish(std::shared_ptr<ObserverList const> updated)
+{
+    {
+        std::lock_guard lock{observers_ptr_mutex};
+        observers.swap(updated);
+    }
+    // updated now holds the old list, which is released outside the lock
+}
+
 template<class Observer>
 void ObserverMultiplexer<Observer>::register_interest(std::weak_ptr<Observer> const& observer)
 {
@@ -261,31 +302,35 @@ void ObserverMultiplexer<Observer>::register_interest(
 {
     std::lock_guard lock{observer_mutex};
 
-    observers.emplace_back(std::make_shared<WeakObserver>(observer, executor));
+    auto updated = std::make_shared<ObserverList>(*observers);
+    updated->emplace_back(std::make_shared<WeakObserver>(observer, executor));
+    publish(std::move(updated));
 }
 
 template<class Observer>
 void ObserverMultiplexer<Observer>::unregister_interest(Observer const& observer)
 {
     std::lock_guard lock{observer_mutex};
-    observers.erase(
+
+    auto updated = std::make_shared<ObserverList>(*observers);
+    updated->erase(
         std::remove_if(
-            observers.begin(),
-            observers.end(),
+            updated->begin(),
+            updated->end(),
             [&observer](auto& candidate)
             {
                 // This will wait for any (other) thread to finish with the candidate observer, then reset it
                 // (preventing future notifications from being sent) if it is the same as the unregistered observer.
                 return candidate->maybe_reset(&observer);
             }),
-        observers.end());
+        updated->end());
+    publish(std::move(updated));
 }
 
 template<class Observer>
 auto ObserverMultiplexer<Observer>::empty() -> bool
 {
-    std::lock_guard lock{observer_mutex};
-    return observers.empty();
+    return snapshot()->empty();
 }
 
 template<class Observer>
@@ -295,18 +340,22 @@ void ObserverMultiplexer<Observer>::for_each_observer(MemberFn f, Args&&... args
     static_assert(
         std::is_member_function_pointer<MemberFn>::value,
         "f must be of type (Observer::*)(Args...), a pointer to an Observer member function.");
-    decltype(observers) local_observers;
-    {
-        std::lock_guard lock{observer_mutex};
-        local_observers = observers;
-    }
-    for (auto& weak_observer: local_observers)
+    auto const local_observers = snapshot();
+    for (auto const& weak_observer: *local_observers)
     {
-        weak_observer->spawn(
-            [f, weak_observer = std::move(weak_observer), args...]() mutable
-            {
-                weak_observer->invoke(f, std::forward<Args>(args)...);
-            });
+        if (weak_observer->runs_immediately())
+        {
+            // The snapshot keeps weak_observer alive for the observation, so there's nothing to capture
+            weak_observer->invoke(f, args...);
+        }
+        else
+        {
+            weak_observer->spawn(
+                [f, weak_observer, args...]() mutable
+                {
+                    weak_observer->invoke(f, std::forward<Args>(args)...);
+                });
+        }
     }
 }
 
@@ -317,15 +366,11 @@ void ObserverMultiplexer<Observer>::for_single_observer(Observer const& target_o
     static_assert(
         std::is_member_function_pointer<MemberFn>::value,
         "f must be of type (Observer::*)(Args...), a pointer to an Observer member function.");
-    decltype(observers) local_observers;
-    {
-        std::lock_guard lock{observer_mutex};
-        local_observers = observers;
-    }
-    for (auto& weak_observer: local_observers)
+    auto const local_observers = snapshot();
+    for (auto const& weak_observer: *local_observers)
     {
         weak_observer->spawn_if_eq(target_observer,
-            [f, weak_observer = std::move(weak_observer), args...]() mutable
+            [f, weak_observer, args...]() mutable
             {
                 weak_observer->invoke(f, std::forward<Args>(args)...);
             });
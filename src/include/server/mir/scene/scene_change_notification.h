@@ -19,6 +19,7 @@
 
 #include "mir/scene/observer.h"
 #include "mir/geometry/forward.h"
+#include "mir/graphics/renderable.h"
 
 #include <functional>
 #include <map>
@@ -38,7 +39,7 @@ class SceneChangeNotification : public Observer
 public:
     SceneChangeNotification(
         std::function<void()> const& scene_notify_change,
-        std::function<void(int frames, mir::geometry::Rectangle const& damage)> const& damage_notify_change);
+        std::function<void(int frames, graphics::Renderable::ID source, geometry::Rectangles const& damage)> const& damage_notify_change);
 
     ~SceneChangeNotification();
 
@@ -53,7 +54,7 @@ public:
 
 private:
     std::function<void()> const scene_notify_change;
-    std::function<void(int frames, mir::geometry::Rectangle const& damage)> const damage_notify_change;
+    std::function<void(int frames, graphics::Renderable::ID source, geometry::Rectangles const& damage)> const damage_notify_change;
 
     std::mutex surface_observers_guard;
     std::map<Surface*, std::shared_ptr<SurfaceObserver>> surface_observers;
@@ -40,6 +40,10 @@ struct StreamInfo
     std::shared_ptr<compositor::BufferStream> stream;
     geometry::Displacement displacement;
     optional_value<geometry::Size> size;
+    /// The opaque parts of the stream, relative to its top-left (nullopt if not known)
+    std::optional<std::vector<geometry::Rectangle>> opaque_region{};
+    /// Whether the stream's content may tear, to be shown sooner
+    bool allow_tearing{false};
 };
 
 class SurfaceObserver;
@@ -65,6 +69,8 @@ public:
     virtual geometry::Size window_size() const = 0;
 
     virtual graphics::RenderableList generate_renderables(compositor::CompositorID id) const = 0; 
+    /// As generate_renderables(), but appends to a list the caller can reuse between frames
+    virtual void append_renderables(graphics::RenderableList& renderables, compositor::CompositorID id) const = 0;
     virtual int buffers_ready_for_compositor(void const* compositor_id) const = 0;
 
     virtual MirWindowType type() const = 0;
@@ -22,6 +22,8 @@
 
 #include "mir/input/input_reception_mode.h"
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/graphics/renderable.h"
 
 #include <glm/glm.hpp>
 #include <string>
@@ -47,8 +49,13 @@ public:
     virtual void content_resized_to(Surface const* surf, geometry::Size const& content_size) = 0;
     virtual void moved_to(Surface const* surf, geometry::Point const& top_left) = 0;
     virtual void hidden_set_to(Surface const* surf, bool hide) = 0;
+    /// source is the ID of the renderables showing the posted frame;
     /// damage is given in surface-local logical coordinates
-    virtual void frame_posted(Surface const* surf, int frames_available, geometry::Rectangle const& damage) = 0;
+    virtual void frame_posted(
+        Surface const* surf,
+        int frames_available,
+        graphics::Renderable::ID source,
+        geometry::Rectangles const& damage) = 0;
     virtual void alpha_set_to(Surface const* surf, float alpha) = 0;
     virtual void orientation_set_to(Surface const* surf, MirOrientation orientation) = 0;
     virtual void transformation_set_to(Surface const* surf, glm::mat4 const& t) = 0;
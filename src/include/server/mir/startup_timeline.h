@@ -0,0 +1,42 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_STARTUP_TIMELINE_H_
+#define MIR_STARTUP_TIMELINE_H_
+
+namespace mir
+{
+/**
+ * Records how long server startup spends in each phase.
+ *
+ * The timeline is logged, one line per phase, when the first frame is posted.
+ * Until begin() is called (and after the timeline has been logged) the other
+ * calls do nothing, so they are cheap to leave on paths that run repeatedly.
+ */
+namespace startup_timeline
+{
+/// Start (or restart) timing from now
+void begin();
+
+/// Note that the named phase has just finished. Only the first completion of each phase is recorded.
+void phase_completed(char const* phase);
+
+/// Note that a frame has been posted; the first one ends the timeline, which is then logged
+void frame_posted();
+}
+}
+
+#endif /* MIR_STARTUP_TIMELINE_H_ */
@@ -103,6 +103,16 @@ auto miral::Output::logical_group_id() const -> int
     return self->logical_group_id.as_value();
 }
 
+auto miral::Output::vrr_capable() const -> bool
+{
+    return self->vrr_capable;
+}
+
+auto miral::Output::vrr_enabled() const -> bool
+{
+    return self->vrr_capable && self->vrr_enabled;
+}
+
 bool miral::operator==(Output::PhysicalSizeMM const& lhs, Output::PhysicalSizeMM const& rhs)
 {
     return lhs.width == rhs.width && lhs.height == rhs.height;
@@ -41,6 +41,7 @@ char const* const mode = "mode";
 char const* const orientation = "orientation";
 char const* const scale = "scale";
 char const* const group = "group";
+char const* const vrr = "vrr";
 char const* const orientation_value[] = { "normal", "left", "inverted", "right" };
 
 auto as_string(MirOrientation orientation) -> char const*
@@ -240,6 +241,11 @@ try
                         output_config.scale = s.as<float>();
                     }
 
+                    if (auto const v = port_config[vrr])
+                    {
+                        output_config.vrr = v.as<bool>();
+                    }
+
                     layout_config[output_id] = output_config;
                 }
             }
@@ -361,6 +367,8 @@ void miral::StaticDisplayConfig::apply_to(mg::DisplayConfiguration& conf)
                 {
                     conf_output.logical_group_id = mg::DisplayConfigurationLogicalGroupId{};
                 }
+
+                conf_output.vrr_enabled = conf.vrr.is_set() && conf.vrr.value();
             }
             else
             {
@@ -401,6 +409,12 @@ void miral::StaticDisplayConfig::apply_to(mg::DisplayConfiguration& conf)
                            "\n        # scale: " << conf_output.scale
                         << "\n        # group: " << conf_output.logical_group_id.as_value()
                         << "\t# Outputs with the same non-zero value are treated as a single display";
+
+                    if (conf_output.vrr_capable)
+                    {
+                        out << "\n        # vrr: " << (conf_output.vrr_enabled ? "true" : "false")
+                            << "\t# Variable refresh rate, defaults to false";
+                    }
                 }
             }
             else
@@ -40,7 +40,8 @@ public:
   void depth_layer_set_to(mir::scene::Surface const *surf,
                           MirDepthLayer depth_layer) override;
   void frame_posted(mir::scene::Surface const *surf, int frames_available,
-                    mir::geometry::Rectangle const& area) override;
+                    mir::graphics::Renderable::ID source,
+                    mir::geometry::Rectangles const& damage) override;
   void hidden_set_to(mir::scene::Surface const *surf, bool hide) override;
   void input_consumed(mir::scene::Surface const *surf,
                       std::shared_ptr<MirEvent const> const& event) override;
@@ -115,9 +116,14 @@ void miroil::SurfaceObserverImpl::depth_layer_set_to(mir::scene::Surface const*
     listener->depth_layer_set_to(surf, depth_layer);
 }
 
-void miroil::SurfaceObserverImpl::frame_posted(mir::scene::Surface const* surf, int frames_available, mir::geometry::Rectangle const& area)
+void miroil::SurfaceObserverImpl::frame_posted(
+    mir::scene::Surface const* surf,
+    int frames_available,
+    mir::graphics::Renderable::ID,
+    mir::geometry::Rectangles const&)
 {
-    listener->frame_posted(surf, frames_available, area.size);
+    // miroil::SurfaceObserver has always been given the size of the whole surface, not of the damage
+    listener->frame_posted(surf, frames_available, surf->content_size());
 }
 
 void miroil::SurfaceObserverImpl::hidden_set_to(mir::scene::Surface const* surf, bool hide)
@@ -0,0 +1,75 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "context_textures.h"
+#include "mir/graphics/egl_context_executor.h"
+
+#include <algorithm>
+
+namespace mg = mir::graphics;
+namespace mgc = mir::graphics::common;
+
+namespace
+{
+auto generate_texture() -> GLuint
+{
+    GLuint tex;
+    glGenTextures(1, &tex);
+    return tex;
+}
+}
+
+mg::ContextTextures::Texture::Texture(std::shared_ptr<mgc::EGLContextExecutor> egl_delegate)
+    : tex{generate_texture()},
+      egl_delegate{std::move(egl_delegate)}
+{
+}
+
+mg::ContextTextures::Texture::~Texture()
+{
+    egl_delegate->spawn(
+        [tex = tex]()
+        {
+            glDeleteTextures(1, &tex);
+        });
+}
+
+auto mg::ContextTextures::for_current_context(
+    std::shared_ptr<void const> const& contexts_owner,
+    std::shared_ptr<mgc::EGLContextExecutor> const& egl_delegate)
+    -> std::pair<std::shared_ptr<Texture>, bool>
+{
+    // The textures of contexts that have been destroyed are no use to anyone
+    std::erase_if(textures, [](Entry const& entry) { return entry.contexts_owner.expired(); });
+
+    auto const context = eglGetCurrentContext();
+    auto const existing = std::find_if(
+        textures.begin(),
+        textures.end(),
+        [&](Entry const& entry)
+        {
+            return entry.context == context && entry.contexts_owner.lock() == contexts_owner;
+        });
+
+    if (existing != textures.end())
+    {
+        return {existing->texture, true};
+    }
+
+    auto texture = std::make_shared<Texture>(egl_delegate);
+    textures.push_back(Entry{context, contexts_owner, texture});
+    return {std::move(texture), false};
+}
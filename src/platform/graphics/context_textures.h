@@ -0,0 +1,92 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_CONTEXT_TEXTURES_H_
+#define MIR_GRAPHICS_CONTEXT_TEXTURES_H_
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace common
+{
+class EGLContextExecutor;
+}
+
+/**
+ * The GL textures something is imported into, one for each EGL context it's used in
+ *
+ * A destroyed context's handle can be reused by a new context, so textures are
+ * cached against the owner of the contexts as well as the EGLContext. Once the
+ * owner is gone, so are its contexts: their textures are dropped the next time
+ * a texture is asked for.
+ *
+ * \note This is not threadsafe
+ */
+class ContextTextures
+{
+public:
+    /// A texture that is deleted once none of its users need it
+    class Texture
+    {
+    public:
+        /// \note This must be called with a current EGL context
+        explicit Texture(std::shared_ptr<common::EGLContextExecutor> egl_delegate);
+        ~Texture();
+
+        GLuint const tex;
+
+    private:
+        Texture(Texture const&) = delete;
+        Texture& operator=(Texture const&) = delete;
+
+        std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
+    };
+
+    /**
+     * The texture for the current EGL context, creating it if there isn't one yet
+     *
+     * \param [in] contexts_owner   Lives as long as the contexts this is called in
+     * \param [in] egl_delegate     Where the texture is deleted
+     * \note   This must be called with a current EGL context
+     * \return The texture, and whether it already existed
+     */
+    auto for_current_context(
+        std::shared_ptr<void const> const& contexts_owner,
+        std::shared_ptr<common::EGLContextExecutor> const& egl_delegate)
+        -> std::pair<std::shared_ptr<Texture>, bool>;
+
+private:
+    struct Entry
+    {
+        EGLContext context;
+        std::weak_ptr<void const> contexts_owner;
+        std::shared_ptr<Texture> texture;
+    };
+
+    std::vector<Entry> textures;
+};
+}
+}
+
+#endif /* MIR_GRAPHICS_CONTEXT_TEXTURES_H_ */
@@ -0,0 +1,122 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dmabuf_feedback.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <limits>
+#include <map>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mg = mir::graphics;
+
+static_assert(sizeof(mg::DmaBufFeedback::TableEntry) == 16);
+
+mg::DmaBufFeedback::DmaBufFeedback(
+    dev_t main_device,
+    std::vector<FormatModifier> const& importable,
+    dev_t scanout_device,
+    std::vector<FormatModifier> const& scanout_formats)
+    : main_device_{main_device},
+      render{main_device, {}, false}
+{
+    std::vector<TableEntry> entries;
+    std::map<FormatModifier, uint16_t> index_of;
+    for (auto const& [format, modifier] : importable)
+    {
+        // Tranches index the table with 16 bits
+        if (entries.size() > std::numeric_limits<uint16_t>::max())
+        {
+            break;
+        }
+        auto const index = static_cast<uint16_t>(entries.size());
+        entries.push_back({format, 0, modifier});
+        index_of.emplace(FormatModifier{format, modifier}, index);
+        render.indices.push_back(index);
+    }
+
+    Tranche tranche{scanout_device, {}, true};
+    for (auto const& format_modifier : scanout_formats)
+    {
+        if (auto const entry = index_of.find(format_modifier); entry != index_of.end())
+        {
+            tranche.indices.push_back(entry->second);
+        }
+    }
+    if (!tranche.indices.empty())
+    {
+        scanout = std::move(tranche);
+    }
+
+    table_size = entries.size() * sizeof(TableEntry);
+    table = mir::Fd{memfd_create("mir-dmabuf-format-table", MFD_CLOEXEC | MFD_ALLOW_SEALING)};
+    if (table == mir::Fd::invalid)
+    {
+        BOOST_THROW_EXCEPTION((
+            std::system_error{errno, std::system_category(), "Failed to create dma-buf format table"}));
+    }
+    for (size_t written = 0; written < table_size;)
+    {
+        auto const result = write(
+            table,
+            reinterpret_cast<char const*>(entries.data()) + written,
+            table_size - written);
+        if (result < 0)
+        {
+            BOOST_THROW_EXCEPTION((
+                std::system_error{errno, std::system_category(), "Failed to write dma-buf format table"}));
+        }
+        written += result;
+    }
+    // Clients map the table, so it must never change
+    if (fcntl(table, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0)
+    {
+        BOOST_THROW_EXCEPTION((
+            std::system_error{errno, std::system_category(), "Failed to seal dma-buf format table"}));
+    }
+}
+
+auto mg::DmaBufFeedback::main_device() const -> dev_t const&
+{
+    return main_device_;
+}
+
+auto mg::DmaBufFeedback::format_table() const -> mir::Fd const&
+{
+    return table;
+}
+
+auto mg::DmaBufFeedback::format_table_size() const -> size_t
+{
+    return table_size;
+}
+
+auto mg::DmaBufFeedback::tranches(bool scanout_candidate) const
+    -> std::vector<std::reference_wrapper<Tranche const>>
+{
+    std::vector<std::reference_wrapper<Tranche const>> result;
+    if (scanout_candidate && scanout)
+    {
+        result.push_back(std::cref(*scanout));
+    }
+    result.push_back(std::cref(render));
+    return result;
+}
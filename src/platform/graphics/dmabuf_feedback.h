@@ -0,0 +1,91 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_DMABUF_FEEDBACK_H_
+#define MIR_GRAPHICS_DMABUF_FEEDBACK_H_
+
+#include "mir/fd.h"
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+/**
+ * The parameters sent to zwp_linux_dmabuf_feedback_v1 objects
+ *
+ * These don't change, so the format table is written once and the same
+ * (sealed) file is sent to every client.
+ */
+class DmaBufFeedback
+{
+public:
+    using FormatModifier = std::pair<uint32_t, uint64_t>;
+
+    /// An entry of the format table, as clients read it
+    struct TableEntry
+    {
+        uint32_t format;
+        uint32_t padding;
+        uint64_t modifier;
+    };
+
+    struct Tranche
+    {
+        dev_t device;
+        std::vector<uint16_t> indices;  ///< Into the format table
+        bool scanout;
+    };
+
+    /**
+     * \param [in] main_device      The device the EGL display renders with
+     * \param [in] importable       What the EGL display can import. These make up the format table.
+     * \param [in] scanout_device   The KMS device that scanout_formats are for
+     * \param [in] scanout_formats  What buffers of fullscreen surfaces should be, so that they can
+     *                              bypass composition. Pairs that are not importable are ignored.
+     * \throws std::system_error if the format table can't be written
+     */
+    DmaBufFeedback(
+        dev_t main_device,
+        std::vector<FormatModifier> const& importable,
+        dev_t scanout_device,
+        std::vector<FormatModifier> const& scanout_formats);
+
+    auto main_device() const -> dev_t const&;
+    auto format_table() const -> mir::Fd const&;
+    auto format_table_size() const -> size_t;
+
+    /// The tranches to send, most preferred first
+    auto tranches(bool scanout_candidate) const -> std::vector<std::reference_wrapper<Tranche const>>;
+
+private:
+    dev_t const main_device_;
+    Tranche render;
+    std::optional<Tranche> scanout;
+    mir::Fd table;
+    size_t table_size;
+};
+}
+}
+
+#endif /* MIR_GRAPHICS_DMABUF_FEEDBACK_H_ */
@@ -51,15 +51,23 @@ void mgc::EGLContextExecutor::process_loop(mgc::EGLContextExecutor* const me)
     me->ctx->make_current();
 
     std::unique_lock lock{me->mutex};
+    std::vector<std::function<void()>> current_work;
     while (!me->shutdown_requested)
     {
-        for (auto& work : me->work_queue)
+        // Work can take a while (uploading textures, say), so don't block spawn() meanwhile
+        swap(current_work, me->work_queue);
+        lock.unlock();
+        for (auto& work : current_work)
         {
             work();
         }
-        me->work_queue.clear();
+        current_work.clear();
+        lock.lock();
 
-        me->new_work.wait(lock);
+        if (me->work_queue.empty() && !me->shutdown_requested)
+        {
+            me->new_work.wait(lock);
+        }
     }
 
     // Drain the work-queue
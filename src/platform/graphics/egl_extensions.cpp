@@ -15,6 +15,7 @@
  */
 
 #include "mir/graphics/egl_extensions.h"
+#include "mir/graphics/egl_error.h"
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
 #include <cstring>
@@ -201,3 +202,47 @@ mg::EGLExtensions::EXTImageDmaBufImportModifiers::EXTImageDmaBufImportModifiers(
             std::runtime_error{"EGL_EXT_image_dma_buf_import_modifiers not supported"}));
     }
 }
+
+mg::EGLExtensions::EXTDeviceDRM::EXTDeviceDRM(EGLDisplay dpy)
+    : eglQueryDisplayAttribEXT{
+        reinterpret_cast<PFNEGLQUERYDISPLAYATTRIBEXTPROC>(eglGetProcAddress("eglQueryDisplayAttribEXT"))},
+      eglQueryDeviceStringEXT{
+        reinterpret_cast<PFNEGLQUERYDEVICESTRINGEXTPROC>(eglGetProcAddress("eglQueryDeviceStringEXT"))}
+{
+    auto const* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (!client_extensions ||
+        !(strstr(client_extensions, "EGL_EXT_device_query") || strstr(client_extensions, "EGL_EXT_device_base")) ||
+        !eglQueryDisplayAttribEXT ||
+        !eglQueryDeviceStringEXT)
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"EGL implementation doesn't support EGL_EXT_device_query"}));
+    }
+
+    EGLAttrib attrib;
+    if (eglQueryDisplayAttribEXT(dpy, EGL_DEVICE_EXT, &attrib) != EGL_TRUE)
+    {
+        BOOST_THROW_EXCEPTION((mg::egl_error("Failed to query EGL device of display")));
+    }
+    device = reinterpret_cast<EGLDeviceEXT>(attrib);
+
+    auto const device_extensions = eglQueryDeviceStringEXT(device, EGL_EXTENSIONS);
+    if (!device_extensions || !strstr(device_extensions, "EGL_EXT_device_drm") || !device_file())
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"EGL device doesn't support EGL_EXT_device_drm"}));
+    }
+}
+
+auto mg::EGLExtensions::EXTDeviceDRM::device_file() const -> char const*
+{
+    return eglQueryDeviceStringEXT(device, EGL_DRM_DEVICE_FILE_EXT);
+}
+
+auto mg::EGLExtensions::EXTDeviceDRM::render_node_file() const -> char const*
+{
+    auto const device_extensions = eglQueryDeviceStringEXT(device, EGL_EXTENSIONS);
+    if (!device_extensions || !strstr(device_extensions, "EGL_EXT_device_drm_render_node"))
+    {
+        return nullptr;
+    }
+    return eglQueryDeviceStringEXT(device, EGL_DRM_RENDER_NODE_FILE_EXT);
+}
@@ -30,6 +30,10 @@
 #include "mir/graphics/buffer_basic.h"
 #include "mir/graphics/dmabuf_buffer.h"
 #include "mir/graphics/egl_context_executor.h"
+#include "mir/graphics/scanout_candidate.h"
+#include "context_textures.h"
+#include "dmabuf_feedback.h"
+#include "mir/fd.h"
 
 #define MIR_LOG_COMPONENT "linux-dmabuf-import"
 #include "mir/log.h"
@@ -41,9 +45,12 @@
 #include <mutex>
 #include <vector>
 #include <optional>
+#include <system_error>
 #include <drm_fourcc.h>
 #include <wayland-server.h>
 
+#include <sys/stat.h>
+
 namespace mg = mir::graphics;
 namespace mgc = mg::common;
 namespace mw = mir::wayland;
@@ -194,6 +201,64 @@ private:
     std::vector<std::vector<EGLBoolean>> external_only_for_format;
 };
 
+namespace
+{
+auto device_of(char const* node) -> std::optional<dev_t>
+{
+    struct stat info;
+    if (node && stat(node, &info) == 0)
+    {
+        return info.st_rdev;
+    }
+    return std::nullopt;
+}
+
+/// The device clients should allocate buffers on: the one the EGL display renders with
+auto main_device_for(EGLDisplay dpy) -> dev_t
+{
+    try
+    {
+        mg::EGLExtensions::EXTDeviceDRM const device_ext{dpy};
+        if (auto const device = device_of(device_ext.render_node_file()))
+        {
+            return *device;
+        }
+        if (auto const device = device_of(device_ext.device_file()))
+        {
+            return *device;
+        }
+    }
+    catch (std::runtime_error const& error)
+    {
+        mir::log_debug("Cannot query the DRM device of the EGL display: %s", error.what());
+    }
+
+    mir::log_warning("Cannot find the DRM device of the EGL display; linux-dmabuf feedback will not name one");
+    return 0;
+}
+
+/// Every format and modifier pair dpy can import
+auto importable_formats(mg::DmaBufFormatDescriptors const& formats) -> std::vector<mg::DmaBufFeedback::FormatModifier>
+{
+    std::vector<mg::DmaBufFeedback::FormatModifier> importable;
+    for (auto i = 0u; i < formats.num_formats(); ++i)
+    {
+        auto const descriptor = formats[i];
+        for (auto const modifier : descriptor.modifiers)
+        {
+            importable.emplace_back(static_cast<uint32_t>(descriptor.format), modifier);
+        }
+    }
+    return importable;
+}
+
+/// A wl_array of data, which must outlive it
+auto as_wl_array(void const* data, size_t size) -> wl_array
+{
+    return wl_array{size, size, const_cast<void*>(data)};
+}
+}
+
 namespace
 {
 using PlaneInfo = mg::DMABufBuffer::PlaneDescriptor;
@@ -227,6 +292,8 @@ BufferGLDescription const ExternalOES = {
     "}\n"
 };
 
+using ImportedTexture = mg::ContextTextures::Texture;
+
 /**
  * Holds on to all imported dmabuf buffers, and allows looking up by wl_buffer
  *
@@ -258,7 +325,7 @@ public:
               planes_{std::move(plane_params)},
               image{EGL_NO_IMAGE_KHR}
     {
-        reimport_egl_image();
+        import_egl_image();
     }
 
     ~WlDmaBufBuffer()
@@ -301,15 +368,54 @@ public:
         return desc;
     }
     /**
-     * Reimport dmabufs into EGL
+     * The texture of this buffer in the current EGL context, importing it there if needed
      *
-     * This is necessary to call each time the buffer is re-submitted by the client,
-     * to ensure any state is properly synchronised.
+     * Clients cycle through the same few buffers, so after the first commit of each
+     * this just rebinds the EGLImage to the texture. That is still needed on each
+     * commit to ensure any state is properly synchronised, but is much cheaper than
+     * importing again.
+     *
+     * \param [in] contexts_owner   Lives as long as the current EGL context
+     * \note   This must be called with a current EGL context
+     * \return The texture, and whether it had already been imported
+     */
+    auto texture_for_current_context(
+        std::shared_ptr<void const> const& contexts_owner,
+        std::shared_ptr<mgc::EGLContextExecutor> const& egl_delegate)
+        -> std::pair<std::shared_ptr<ImportedTexture>, bool>
+    {
+        auto const [texture, reused] = textures.for_current_context(contexts_owner, egl_delegate);
+
+        glBindTexture(desc.target, texture->tex);
+        egl_extensions->base(dpy).glEGLImageTargetTexture2DOES(desc.target, image);
+
+        if (!reused)
+        {
+            glTexParameteri(desc.target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(desc.target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(desc.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(desc.target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+
+        return {texture, reused};
+    }
+
+    auto modifier() -> uint64_t
+    {
+        return modifier_;
+    }
+
+    auto planes() -> std::vector<PlaneInfo> const&
+    {
+        return planes_;
+    }
+private:
+    /**
+     * Import the dmabufs into EGL
      *
-     * \return  An EGLImageKHR handle to the imported
      * \throws  A std::system_error containing the EGL error on failure.
      */
-    auto reimport_egl_image() -> EGLImageKHR
+    void import_egl_image()
     {
         std::vector<EGLint> attributes;
 
@@ -340,10 +446,6 @@ public:
             }
         }
         attributes.push_back(EGL_NONE);
-        if (image != EGL_NO_IMAGE_KHR)
-        {
-            egl_extensions->base(dpy).eglDestroyImageKHR(dpy, image);
-        }
         image = egl_extensions->base(dpy).eglCreateImageKHR(
             dpy,
             EGL_NO_CONTEXT,
@@ -358,20 +460,8 @@ public:
                 "Failed to import supplied dmabuf";
             BOOST_THROW_EXCEPTION((mg::egl_error(msg)));
         }
-
-        return image;
     }
 
-    auto modifier() -> uint64_t
-    {
-        return modifier_;
-    }
-
-    auto planes() -> std::vector<PlaneInfo> const&
-    {
-        return planes_;
-    }
-private:
     EGLDisplay const dpy;
     std::shared_ptr<mg::EGLExtensions> const egl_extensions;
     BufferGLDescription const& desc;
@@ -381,6 +471,8 @@ private:
     uint64_t const modifier_;
     std::vector<PlaneInfo> const planes_;
     EGLImageKHR image;
+    /// The EGLImage is shared by all contexts, but each has its own texture
+    mg::ContextTextures textures;
 
     struct EGLPlaneAttribs
     {
@@ -430,7 +522,7 @@ public:
         EGLDisplay dpy,
         std::shared_ptr<mg::EGLExtensions> egl_extensions,
         std::shared_ptr<mg::DmaBufFormatDescriptors const> formats)
-        : mir::wayland::LinuxBufferParamsV1(new_resource, Version<3>{}),
+        : mir::wayland::LinuxBufferParamsV1(new_resource, Version<4>{}),
           consumed{false},
           dpy{dpy},
           egl_extensions{std::move(egl_extensions)},
@@ -716,13 +808,6 @@ private:
     }
 };
 
-GLuint get_tex_id()
-{
-    GLuint tex;
-    glGenTextures(1, &tex);
-    return tex;
-}
-
 bool drm_format_has_alpha(uint32_t format)
 {
     /* TODO: We should really have something like libweston/pixel-formats.h
@@ -755,15 +840,12 @@ class WaylandDmabufTexBuffer :
     public mg::DMABufBuffer
 {
 public:
-    // Note: Must be called with a current EGL context
     WaylandDmabufTexBuffer(
         WlDmaBufBuffer& source,
-        mg::EGLExtensions const& extensions,
-        EGLDisplay dpy,
-        std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
+        std::shared_ptr<ImportedTexture> texture,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release)
-        : tex{get_tex_id()},
+        : texture{std::move(texture)},
           desc{source.descriptor()},
           on_consumed{std::move(on_consumed)},
           on_release{std::move(on_release)},
@@ -772,32 +854,12 @@ public:
           has_alpha{drm_format_has_alpha(source.format())},
           planes_{source.planes()},
           modifier_{source.modifier()},
-          fourcc{source.format()},
-          egl_delegate{std::move(egl_delegate)}
+          fourcc{source.format()}
     {
-        eglBindAPI(EGL_OPENGL_ES_API);
-
-        auto const target = source.descriptor().target;
-
-        glBindTexture(target, tex);
-        extensions.base(dpy).glEGLImageTargetTexture2DOES(target, source.reimport_egl_image());
-        // tex is now an EGLImage sibling, so we can free the EGLImage without
-        // freeing the backing data.
-
-        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     }
 
     ~WaylandDmabufTexBuffer() override
     {
-        egl_delegate->spawn(
-            [tex = tex]()
-            {
-              glDeleteTextures(1, &tex);
-            });
-
         on_release();
     }
 
@@ -843,7 +905,7 @@ public:
 
     void bind() override
     {
-        glBindTexture(desc.target, tex);
+        glBindTexture(desc.target, texture->tex);
 
         std::lock_guard lock(consumed_mutex);
         on_consumed();
@@ -870,7 +932,7 @@ public:
     }
 
 private:
-    GLuint const tex;
+    std::shared_ptr<ImportedTexture> const texture;
     BufferGLDescription const& desc;
 
     std::mutex consumed_mutex;
@@ -884,11 +946,68 @@ private:
     std::vector<mg::DMABufBuffer::PlaneDescriptor> const planes_;
     std::optional<uint64_t> const modifier_;
     uint32_t const fourcc;
-
-    std::shared_ptr<mgc::EGLContextExecutor> const egl_delegate;
 };
 
 
+class LinuxDmaBufFeedback : public mw::LinuxDmabufFeedbackV1
+{
+public:
+    LinuxDmaBufFeedback(
+        wl_resource* new_resource,
+        std::shared_ptr<mg::DmaBufFeedback const> feedback,
+        std::optional<wl_resource*> surface)
+        : mw::LinuxDmabufFeedbackV1(new_resource, Version<4>{}),
+          feedback{std::move(feedback)},
+          surface{surface ? mw::Surface::from(*surface) : nullptr},
+          candidate{dynamic_cast<mg::ScanoutCandidate*>(as_nullable_ptr(this->surface))}
+    {
+        if (candidate)
+        {
+            candidate->add_scanout_candidate_listener(
+                this,
+                [this]()
+                {
+                    send(candidate->is_scanout_candidate());
+                });
+        }
+        send(candidate && candidate->is_scanout_candidate());
+    }
+
+    ~LinuxDmaBufFeedback()
+    {
+        // Once the surface is destroyed this is inert, and there is nothing to remove
+        if (candidate && surface)
+        {
+            candidate->remove_scanout_candidate_listener(this);
+        }
+    }
+
+private:
+    /// Send the feedback, preferring buffers that can be scanned out if scanout_candidate
+    void send(bool scanout_candidate)
+    {
+        send_format_table_event(feedback->format_table(), feedback->format_table_size());
+
+        auto main_device = as_wl_array(&feedback->main_device(), sizeof(dev_t));
+        send_main_device_event(&main_device);
+
+        for (mg::DmaBufFeedback::Tranche const& tranche : feedback->tranches(scanout_candidate))
+        {
+            auto device = as_wl_array(&tranche.device, sizeof(tranche.device));
+            send_tranche_target_device_event(&device);
+            send_tranche_flags_event(tranche.scanout ? TrancheFlags::scanout : 0);
+            auto indices = as_wl_array(tranche.indices.data(), tranche.indices.size() * sizeof(uint16_t));
+            send_tranche_formats_event(&indices);
+            send_tranche_done_event();
+        }
+
+        send_done_event();
+    }
+
+    std::shared_ptr<mg::DmaBufFeedback const> const feedback;
+    mw::Weak<mw::Surface> const surface;
+    mg::ScanoutCandidate* const candidate;
+};
 }
 
 class mg::LinuxDmaBufUnstable::Instance : public mir::wayland::LinuxDmabufV1
@@ -898,12 +1017,20 @@ public:
         wl_resource* new_resource,
         EGLDisplay dpy,
         std::shared_ptr<EGLExtensions> egl_extensions,
-        std::shared_ptr<DmaBufFormatDescriptors const> formats)
-        : mir::wayland::LinuxDmabufV1(new_resource, Version<3>{}),
+        std::shared_ptr<DmaBufFormatDescriptors const> formats,
+        std::shared_ptr<DmaBufFeedback const> feedback)
+        : mir::wayland::LinuxDmabufV1(new_resource, Version<4>{}),
           dpy{dpy},
           egl_extensions{std::move(egl_extensions)},
-          formats{std::move(formats)}
+          formats{std::move(formats)},
+          feedback{std::move(feedback)}
     {
+        // From version 4 clients get the formats from feedback objects instead
+        if (version_supports_get_default_feedback())
+        {
+            return;
+        }
+
         for (auto i = 0u; i < this->formats->num_formats(); ++i)
         {
             auto [format, modifiers, external_only] = (*(this->formats))[i];
@@ -925,21 +1052,48 @@ private:
         new LinuxDmaBufParams{params_id, dpy, egl_extensions, formats};
     }
 
+    void get_default_feedback(struct wl_resource* id) override
+    {
+        new LinuxDmaBufFeedback{id, feedback, std::nullopt};
+    }
+
+    void get_surface_feedback(struct wl_resource* id, struct wl_resource* surface) override
+    {
+        new LinuxDmaBufFeedback{id, feedback, surface};
+    }
+
     EGLDisplay const dpy;
     std::shared_ptr<EGLExtensions> const egl_extensions;
     std::shared_ptr<DmaBufFormatDescriptors const> const formats;
+    std::shared_ptr<DmaBufFeedback const> const feedback;
 };
 
 mg::LinuxDmaBufUnstable::LinuxDmaBufUnstable(
     wl_display* display,
     EGLDisplay dpy,
     std::shared_ptr<EGLExtensions> egl_extensions,
-    EGLExtensions::EXTImageDmaBufImportModifiers const& dmabuf_ext)
-    : mir::wayland::LinuxDmabufV1::Global(display, Version<3>{}),
+    EGLExtensions::EXTImageDmaBufImportModifiers const& dmabuf_ext,
+    std::optional<ScanoutFormats> const& scanout)
+    : mir::wayland::LinuxDmabufV1::Global(display, Version<4>{}),
       dpy{dpy},
       egl_extensions{std::move(egl_extensions)},
-      formats{std::make_shared<DmaBufFormatDescriptors>(dpy, dmabuf_ext)}
+      formats{std::make_shared<DmaBufFormatDescriptors>(dpy, dmabuf_ext)},
+      feedback{std::make_shared<DmaBufFeedback>(
+          main_device_for(dpy),
+          importable_formats(*formats),
+          scanout ? scanout->device : 0,
+          scanout ? scanout->formats : std::vector<DmaBufFeedback::FormatModifier>{})},
+      import_contexts{std::make_shared<int>()}
+{
+}
+
+mg::LinuxDmaBufUnstable::~LinuxDmaBufUnstable()
 {
+    auto const counts = texture_cache_counts();
+    mir::log_debug(
+        "dmabuf texture cache: %llu hits, %llu misses",
+        static_cast<unsigned long long>(counts.hits),
+        static_cast<unsigned long long>(counts.misses));
 }
 
 auto mg::LinuxDmaBufUnstable::buffer_from_resource(
@@ -951,11 +1105,14 @@ auto mg::LinuxDmaBufUnstable::buffer_from_resource(
 {
     if (auto dmabuf = WlDmaBufBuffer::maybe_dmabuf_from_wl_buffer(buffer))
     {
+        eglBindAPI(EGL_OPENGL_ES_API);
+
+        auto [texture, reused] = dmabuf->texture_for_current_context(import_contexts, egl_delegate);
+        ++(reused ? texture_cache_hits : texture_cache_misses);
+
         return std::make_shared<WaylandDmabufTexBuffer>(
             *dmabuf,
-            *egl_extensions,
-            dpy,
-            std::move(egl_delegate),
+            std::move(texture),
             std::move(on_consumed),
             std::move(on_release));
     }
@@ -964,5 +1121,10 @@ auto mg::LinuxDmaBufUnstable::buffer_from_resource(
 
 void mg::LinuxDmaBufUnstable::bind(wl_resource* new_resource)
 {
-    new LinuxDmaBufUnstable::Instance{new_resource, dpy, egl_extensions, formats};
+    new LinuxDmaBufUnstable::Instance{new_resource, dpy, egl_extensions, formats, feedback};
+}
+
+auto mg::LinuxDmaBufUnstable::texture_cache_counts() const -> TextureCacheCounts
+{
+    return {texture_cache_hits, texture_cache_misses};
 }
@@ -44,9 +44,11 @@ char const* const mo::wayland_extensions_opt      = "wayland-extensions";
 char const* const mo::add_wayland_extensions_opt  = "add-wayland-extensions";
 char const* const mo::drop_wayland_extensions_opt = "drop-wayland-extensions";
 char const* const mo::idle_timeout_opt            = "idle-timeout";
+char const* const mo::max_pointer_motion_rate_opt = "max-pointer-motion-rate";
 
 char const* const mo::off_opt_value = "off";
 char const* const mo::log_opt_value = "log";
+char const* const mo::async_log_opt_value = "async-log";
 char const* const mo::lttng_opt_value = "lttng";
 
 char const* const mo::platform_display_libs = "platform-display-libs";
@@ -151,19 +153,19 @@ mo::DefaultConfiguration::DefaultConfiguration(
         (enable_input_opt, po::value<bool>()->default_value(enable_input_default),
             "Enable input.")
         (compositor_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "Compositor reporting [{log,lttng,off}]")
+            "Compositor reporting [{log,async-log,lttng,off}]")
         (display_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "How to handle the Display report. [{log,lttng,off}]")
+            "How to handle the Display report. [{log,async-log,lttng,off}]")
         (input_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "How to handle to Input report. [{log,lttng,off}]")
+            "How to handle to Input report. [{log,async-log,lttng,off}]")
         (seat_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "How to handle to Seat report. [{log,off}]")
+            "How to handle to Seat report. [{log,async-log,off}]")
         (scene_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "How to handle the scene report. [{log,lttng,off}]")
+            "How to handle the scene report. [{log,async-log,lttng,off}]")
         (shared_library_prober_report_opt, po::value<std::string>()->default_value(log_opt_value),
-            "How to handle the SharedLibraryProber report. [{log,lttng,off}]")
+            "How to handle the SharedLibraryProber report. [{log,async-log,lttng,off}]")
         (shell_report_opt, po::value<std::string>()->default_value(off_opt_value),
-         "How to handle the Shell report. [{log,off}]")
+         "How to handle the Shell report. [{log,async-log,off}]")
         (composite_delay_opt, po::value<int>()->default_value(0),
             "Compositor frame delay in milliseconds (how long to wait for new "
             "frames from clients before compositing). Higher values result in "
@@ -176,6 +178,10 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "Cursor (mouse pointer) to use [{auto,null,software}]")
         (enable_key_repeat_opt, po::value<bool>()->default_value(true),
              "Enable server generated key repeat")
+        (max_pointer_motion_rate_opt, po::value<int>()->default_value(0),
+            "Maximum rate (in Hz) at which pointer motion is delivered. Faster motion "
+            "from high polling rate mice is merged, keeping the total relative motion. "
+            "0 delivers every motion event.")
         (idle_timeout_opt, po::value<int>()->default_value(0),
             "Time (in seconds) Mir will remain idle before turning off the display, "
             "or 0 to keep display on forever.")
@@ -24,11 +24,14 @@
 #define MIR_LOG_COMPONENT "gfx-common"
 #include "mir/log.h"
 
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
 #include <string.h>
 #include <endian.h>
 
@@ -97,8 +100,10 @@ mgc::ShmBuffer::ShmBuffer(
     std::shared_ptr<EGLContextExecutor> egl_delegate)
     : size_{size},
       pixel_format_{format},
-      egl_delegate{std::move(egl_delegate)}
+      egl_delegate{std::move(egl_delegate)},
+      prepare_target{std::make_shared<PrepareTarget>()}
 {
+    prepare_target->buffer = this;
 }
 
 mgc::MemoryBackedShmBuffer::MemoryBackedShmBuffer(
@@ -111,16 +116,297 @@ mgc::MemoryBackedShmBuffer::MemoryBackedShmBuffer(
 {
 }
 
-mgc::ShmBuffer::~ShmBuffer() noexcept
+mgc::MemoryBackedShmBuffer::~MemoryBackedShmBuffer()
+{
+    abandon_prepare();
+}
+
+namespace
 {
-    if (tex_id != 0)
+/**
+ * EGL_KHR_fence_sync (and EGL_KHR_wait_sync, if present)
+ *
+ * Textures are shared between the GL contexts of the outputs; these let an
+ * upload in one context be waited for in another without stalling either.
+ */
+struct FenceSync
+{
+    PFNEGLCREATESYNCKHRPROC eglCreateSyncKHR;
+    PFNEGLDESTROYSYNCKHRPROC eglDestroySyncKHR;
+    PFNEGLCLIENTWAITSYNCKHRPROC eglClientWaitSyncKHR;
+    PFNEGLWAITSYNCKHRPROC eglWaitSyncKHR;      ///< Can be null
+
+    /// \note This must be called with a current EGL context
+    static auto load() -> std::optional<FenceSync>
     {
-        egl_delegate->spawn(
-            [id = tex_id]()
+        auto const extensions = eglQueryString(eglGetCurrentDisplay(), EGL_EXTENSIONS);
+        auto const has_extension = [extensions](char const* name)
             {
-                glDeleteTextures(1, &id);
+                if (!extensions)
+                    return false;
+                auto const length = strlen(name);
+                for (auto found = strstr(extensions, name); found; found = strstr(found + length, name))
+                {
+                    if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+                        return true;
+                }
+                return false;
+            };
+
+        if (!has_extension("EGL_KHR_fence_sync"))
+        {
+            return std::nullopt;
+        }
+
+        return FenceSync{
+            reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(eglGetProcAddress("eglCreateSyncKHR")),
+            reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(eglGetProcAddress("eglDestroySyncKHR")),
+            reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(eglGetProcAddress("eglClientWaitSyncKHR")),
+            has_extension("EGL_KHR_wait_sync") ?
+                reinterpret_cast<PFNEGLWAITSYNCKHRPROC>(eglGetProcAddress("eglWaitSyncKHR")) : nullptr};
+    }
+};
+}
+
+class mgc::ShmBuffer::SharedTexture
+{
+public:
+    SharedTexture(std::shared_ptr<EGLContextExecutor> egl_delegate)
+        : egl_delegate{std::move(egl_delegate)}
+    {
+    }
+
+    ~SharedTexture()
+    {
+        std::vector<EGLSyncKHR> fences;
+        if (upload_fence != EGL_NO_SYNC_KHR)
+            fences.push_back(upload_fence);
+        for (auto const& draw : draws)
+        {
+            if (draw.fence != EGL_NO_SYNC_KHR)
+                fences.push_back(draw.fence);
+        }
+
+        if (tex_id != 0 || !fences.empty())
+        {
+            auto const destroy_sync = fence_sync ? fence_sync->eglDestroySyncKHR : nullptr;
+            egl_delegate->spawn(
+                [id = tex_id, display = fence_display, fences = std::move(fences), destroy_sync]()
+                {
+                    if (id != 0)
+                        glDeleteTextures(1, &id);
+                    for (auto const fence : fences)
+                        destroy_sync(display, fence);
+                });
+        }
+    }
+
+    /// \note This must be called with mutex held and a current GL context
+    void bind()
+    {
+        bool const needs_initialisation = tex_id == 0;
+        if (needs_initialisation)
+        {
+            glGenTextures(1, &tex_id);
+        }
+        glBindTexture(GL_TEXTURE_2D, tex_id);
+        if (needs_initialisation)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+
+        // Uploads made in our own context are already ordered before anything we draw
+        if (upload_fence != EGL_NO_SYNC_KHR && upload_context != eglGetCurrentContext())
+        {
+            wait_for(upload_fence);
+        }
+    }
+
+    /**
+     * Whether the texture can be updated in the current context without
+     * changing it under draws from it in other contexts
+     *
+     * \note This must be called with mutex held and a current GL context
+     */
+    auto can_update() -> bool
+    {
+        if (!contents)
+        {
+            // Nothing has been drawn from it yet
+            return true;
+        }
+
+        // Without fences we can't tell when other contexts have finished with it
+        load_fence_sync();
+        if (!fence_sync)
+        {
+            return false;
+        }
+
+        // Nor can we wait for a draw that hasn't been fenced yet
+        auto const current_context = eglGetCurrentContext();
+        return std::none_of(
+            draws.begin(),
+            draws.end(),
+            [current_context](Draw const& draw)
+            {
+                return draw.context != current_context && draw.fence == EGL_NO_SYNC_KHR;
             });
     }
+
+    /**
+     * Waits for the draws from the texture in other contexts to finish
+     *
+     * \note This must be called with mutex held and a current GL context, after can_update()
+     */
+    void wait_for_draws()
+    {
+        auto const current_context = eglGetCurrentContext();
+        for (auto const& draw : draws)
+        {
+            if (draw.fence == EGL_NO_SYNC_KHR)
+                continue;
+
+            // Draws in our own context are already ordered before the update
+            if (draw.context != current_context)
+                wait_for(draw.fence);
+            fence_sync->eglDestroySyncKHR(fence_display, draw.fence);
+        }
+        draws.clear();
+    }
+
+    /// \note This must be called with mutex held, with the context about to draw from the texture current
+    void start_draw()
+    {
+        auto& draw = draw_in(eglGetCurrentContext());
+        if (draw.fence != EGL_NO_SYNC_KHR)
+        {
+            // The draw we're starting will finish after the one fenced
+            fence_sync->eglDestroySyncKHR(fence_display, draw.fence);
+            draw.fence = EGL_NO_SYNC_KHR;
+        }
+    }
+
+    /// \note This must be called with mutex held, with the context that drew from the texture current
+    void finish_draw()
+    {
+        load_fence_sync();
+        if (!fence_sync)
+        {
+            return;
+        }
+
+        auto& draw = draw_in(eglGetCurrentContext());
+        if (draw.fence != EGL_NO_SYNC_KHR)
+        {
+            fence_sync->eglDestroySyncKHR(fence_display, draw.fence);
+        }
+        fence_display = eglGetCurrentDisplay();
+        draw.fence = fence_sync->eglCreateSyncKHR(fence_display, EGL_SYNC_FENCE_KHR, nullptr);
+
+        /*
+         * A fence that's never flushed never signals. The frame gets flushed
+         * soon enough, but a client wait could be what's holding it up.
+         */
+        if (draw.fence != EGL_NO_SYNC_KHR && !fence_sync->eglWaitSyncKHR)
+        {
+            glFlush();
+        }
+    }
+
+    /// \note This must be called with mutex held, with the context used for the upload current
+    void finish_upload(BufferID buffer)
+    {
+        contents = buffer;
+
+        load_fence_sync();
+        if (fence_sync)
+        {
+            if (upload_fence != EGL_NO_SYNC_KHR)
+                fence_sync->eglDestroySyncKHR(fence_display, upload_fence);
+
+            fence_display = eglGetCurrentDisplay();
+            upload_context = eglGetCurrentContext();
+            upload_fence = fence_sync->eglCreateSyncKHR(fence_display, EGL_SYNC_FENCE_KHR, nullptr);
+            glFlush();
+        }
+
+        if (upload_fence == EGL_NO_SYNC_KHR)
+        {
+            // Without fences we can only make sure the upload is visible to other contexts by waiting for it
+            glFinish();
+        }
+    }
+
+    std::mutex mutex;
+    /// The buffer whose pixels the texture holds
+    std::optional<BufferID> contents;
+    /// The newest buffer sharing the texture; no other may update it
+    std::optional<BufferID> latest;
+
+private:
+    /// The last draw from the texture in a context; it's still in progress while it has no fence
+    struct Draw
+    {
+        EGLContext context;
+        EGLSyncKHR fence;
+    };
+
+    auto draw_in(EGLContext context) -> Draw&
+    {
+        auto const found = std::find_if(
+            draws.begin(),
+            draws.end(),
+            [context](Draw const& draw) { return draw.context == context; });
+
+        return found != draws.end() ? *found : draws.emplace_back(Draw{context, EGL_NO_SYNC_KHR});
+    }
+
+    /// \note This must be called with a current GL context
+    void load_fence_sync()
+    {
+        if (!fence_sync_loaded)
+        {
+            fence_sync = FenceSync::load();
+            fence_sync_loaded = true;
+        }
+    }
+
+    /// \note This must be called with a current GL context
+    void wait_for(EGLSyncKHR fence)
+    {
+        if (fence_sync->eglWaitSyncKHR)
+        {
+            fence_sync->eglWaitSyncKHR(fence_display, fence, 0);
+        }
+        else
+        {
+            fence_sync->eglClientWaitSyncKHR(fence_display, fence, 0, EGL_FOREVER_KHR);
+        }
+    }
+
+    std::shared_ptr<EGLContextExecutor> const egl_delegate;
+    GLuint tex_id{0};
+    bool fence_sync_loaded{false};
+    std::optional<FenceSync> fence_sync;
+    EGLDisplay fence_display{EGL_NO_DISPLAY};
+    EGLContext upload_context{EGL_NO_CONTEXT};
+    EGLSyncKHR upload_fence{EGL_NO_SYNC_KHR};
+    std::vector<Draw> draws;
+};
+
+mgc::ShmBuffer::~ShmBuffer() noexcept
+{
+    abandon_prepare();
+}
+
+void mgc::ShmBuffer::abandon_prepare()
+{
+    std::lock_guard lock{prepare_target->mutex};
+    prepare_target->buffer = nullptr;
 }
 
 geom::Size mgc::ShmBuffer::size() const
@@ -166,7 +452,6 @@ void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& s
         // Be nice to other users of the GL context by reverting our changes to shared state
         glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);     // 0 is default, meaning “use width”
         glPixelStorei(GL_UNPACK_ALIGNMENT, 4);          // 4 is default; word alignment.
-        glFinish();
     }
     else
     {
@@ -177,41 +462,212 @@ void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& s
     }
 }
 
+void mgc::ShmBuffer::upload_damage_to_texture(
+    void const* pixels,
+    geom::Stride const& stride,
+    geom::Rectangles const& damage)
+{
+    GLenum format, type;
+
+    if (!mg::get_gl_pixel_format(pixel_format_, format, type))
+    {
+        return;
+    }
+
+    // Past a handful of rectangles the per-call overhead outweighs uploading a little more
+    static size_t const max_rectangles{8};
+    geom::Rectangles to_upload;
+    geom::Rectangle const buffer_area{{0, 0}, size()};
+    for (auto const& rect : damage)
+    {
+        auto const clipped = intersection_of(rect, buffer_area);
+        if (clipped.size.width.as_int() > 0 && clipped.size.height.as_int() > 0)
+            to_upload.add(clipped);
+    }
+    if (to_upload.size() > max_rectangles)
+    {
+        to_upload = geom::Rectangles{to_upload.bounding_rectangle()};
+    }
+
+    auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(pixel_format());
+    glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride.as_int() / bytes_per_pixel);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for (auto const& rect : to_upload)
+    {
+        auto const first_pixel =
+            static_cast<unsigned char const*>(pixels) +
+            rect.top_left.y.as_int() * stride.as_int() +
+            rect.top_left.x.as_int() * bytes_per_pixel;
+
+        glTexSubImage2D(
+            GL_TEXTURE_2D,
+            0,
+            rect.top_left.x.as_int(), rect.top_left.y.as_int(),
+            rect.size.width.as_int(), rect.size.height.as_int(),
+            format,
+            type,
+            first_pixel);
+    }
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
 mg::NativeBufferBase* mgc::ShmBuffer::native_buffer_base()
 {
     return this;
 }
 
-void mgc::ShmBuffer::bind()
+auto mgc::ShmBuffer::shared_texture() -> SharedTexture&
 {
-    std::lock_guard lock{tex_id_mutex};
-    bool const needs_initialisation = tex_id == 0;
-    if (needs_initialisation)
+    if (!texture)
     {
-        glGenTextures(1, &tex_id);
+        texture = std::make_shared<SharedTexture>(egl_delegate);
+        std::lock_guard texture_lock{texture->mutex};
+        texture->latest = id();
     }
-    glBindTexture(GL_TEXTURE_2D, tex_id);
-    if (needs_initialisation)
+    return *texture;
+}
+
+void mgc::ShmBuffer::upload_changes(SharedTexture& texture)
+{
+    if (texture.contents == id())
     {
-        // The ShmBuffer *should* be immutable, so we can just upload once.
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return;
     }
+
+    // If the texture holds a buffer we replace we only need to upload what has changed since
+    auto const base = std::find_if(
+        bases.begin(),
+        bases.end(),
+        [&texture](auto const& candidate) { return texture.contents == candidate.first; });
+
+    read_pixels(
+        [&](void const* pixels, geom::Stride const& stride)
+        {
+            if (base != bases.end())
+            {
+                upload_damage_to_texture(pixels, stride, base->second);
+            }
+            else
+            {
+                upload_to_texture(pixels, stride);
+            }
+        });
+
+    texture.finish_upload(id());
+}
+
+auto mgc::ShmBuffer::own_texture() -> SharedTexture&
+{
+    texture = std::make_shared<SharedTexture>(egl_delegate);
+    bases.clear();
+    std::lock_guard texture_lock{texture->mutex};
+    texture->latest = id();
+    return *texture;
 }
 
-void mgc::MemoryBackedShmBuffer::bind()
+void mgc::ShmBuffer::bind()
 {
-    mgc::ShmBuffer::bind();
-    std::lock_guard lock{uploaded_mutex};
-    if (!uploaded)
+    std::lock_guard lock{texture_mutex};
+    {
+        auto& texture = shared_texture();
+
+        std::lock_guard texture_lock{texture.mutex};
+        if (texture.contents == id() || (texture.latest == id() && texture.can_update()))
+        {
+            texture.bind();
+            if (texture.contents != id())
+            {
+                texture.wait_for_draws();
+                upload_changes(texture);
+            }
+            texture.start_draw();
+            return;
+        }
+    }
+
+    /*
+     * Either the texture is a newer buffer's to update, or it can't be updated
+     * under the contexts drawing from it. Either way, we need one of our own.
+     */
+    auto& texture = own_texture();
+
+    std::lock_guard texture_lock{texture.mutex};
+    texture.bind();
+    upload_changes(texture);
+    texture.start_draw();
+}
+
+void mgc::ShmBuffer::prepare()
+{
+    /*
+     * The upload is fenced, so the compositor's bind() only waits for it if it's
+     * still in progress. The upload waits in turn for frames still drawing from
+     * the texture; if it can't, bind() is left to deal with it.
+     */
+    egl_delegate->spawn(
+        [target = prepare_target]()
+        {
+            std::lock_guard target_lock{target->mutex};
+            if (auto const buffer = target->buffer)
+            {
+                std::lock_guard lock{buffer->texture_mutex};
+                auto& texture = buffer->shared_texture();
+
+                std::lock_guard texture_lock{texture.mutex};
+                if (texture.latest == buffer->id() && texture.contents != buffer->id() && texture.can_update())
+                {
+                    texture.bind();
+                    texture.wait_for_draws();
+                    buffer->upload_changes(texture);
+                }
+            }
+        });
+}
+
+void mgc::ShmBuffer::replaces(Buffer& previous, geom::Rectangles const& damage)
+{
+    auto const previous_shm = dynamic_cast<ShmBuffer*>(previous.native_buffer_base());
+    if (!previous_shm ||
+        previous_shm == this ||
+        previous_shm->size() != size() ||
+        previous_shm->pixel_format() != pixel_format())
+    {
+        return;
+    }
+
+    std::scoped_lock lock{texture_mutex, previous_shm->texture_mutex};
+
+    previous_shm->shared_texture();
+    texture = previous_shm->texture;
+    {
+        std::lock_guard texture_lock{texture->mutex};
+        texture->latest = id();
+    }
+
+    // The previous buffer might not reach the texture before we do, so keep a few generations
+    static size_t const max_bases{3};
+    bases.clear();
+    bases.emplace_back(previous_shm->id(), damage);
+    for (auto const& [base, base_damage] : previous_shm->bases)
     {
-        upload_to_texture(pixels.get(), stride_);
-        uploaded = true;
+        if (bases.size() == max_bases)
+            break;
+
+        geom::Rectangles combined{base_damage};
+        for (auto const& rect : damage)
+            combined.add(rect);
+        bases.emplace_back(base, std::move(combined));
     }
 }
 
+void mgc::MemoryBackedShmBuffer::read_pixels(PixelConsumer const& consume)
+{
+    consume(pixels.get(), stride_);
+}
+
 template<typename T>
 class mgc::MemoryBackedShmBuffer::Mapping : public mir::renderer::software::Mapping<T>
 {
@@ -285,6 +741,12 @@ auto mgc::ShmBuffer::layout() const -> Layout
 
 void mgc::ShmBuffer::add_syncpoint()
 {
+    std::lock_guard lock{texture_mutex};
+    if (texture)
+    {
+        std::lock_guard texture_lock{texture->mutex};
+        texture->finish_draw();
+    }
 }
 
 mgc::MappableBackedShmBuffer::MappableBackedShmBuffer(
@@ -295,6 +757,11 @@ mgc::MappableBackedShmBuffer::MappableBackedShmBuffer(
 {
 }
 
+mgc::MappableBackedShmBuffer::~MappableBackedShmBuffer()
+{
+    abandon_prepare();
+}
+
 auto mgc::MappableBackedShmBuffer::map_writeable() -> std::unique_ptr<mrs::Mapping<unsigned char>>
 {
     return data->map_writeable();
@@ -310,16 +777,10 @@ auto mgc::MappableBackedShmBuffer::map_rw() -> std::unique_ptr<mrs::Mapping<unsi
     return data->map_rw();
 }
 
-void mgc::MappableBackedShmBuffer::bind()
+void mgc::MappableBackedShmBuffer::read_pixels(PixelConsumer const& consume)
 {
-    mgc::ShmBuffer::bind();
-    std::lock_guard lock{uploaded_mutex};
-    if (!uploaded)
-    {
-        auto mapping = data->map_readable();
-        upload_to_texture(mapping->data(), mapping->stride());
-        uploaded = true;
-    }
+    auto mapping = data->map_readable();
+    consume(mapping->data(), mapping->stride());
 }
 
 auto mgc::MappableBackedShmBuffer::format() const -> MirPixelFormat
@@ -350,6 +811,8 @@ mgc::NotifyingMappableBackedShmBuffer::NotifyingMappableBackedShmBuffer(
 
 mgc::NotifyingMappableBackedShmBuffer::~NotifyingMappableBackedShmBuffer()
 {
+    // The client may reuse the buffer once it's released, so no upload may still be reading it
+    abandon_prepare();
     on_release();
 }
 
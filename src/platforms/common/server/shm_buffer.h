@@ -24,10 +24,15 @@
 #include "mir_toolkit/mir_native_buffer.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/graphics/texture.h"
+#include "mir/graphics/incremental_buffer.h"
+#include "mir/geometry/rectangles.h"
 
 #include <GLES2/gl2.h>
 
+#include <functional>
 #include <mutex>
+#include <optional>
+#include <vector>
 
 namespace mir
 {
@@ -42,7 +47,8 @@ class EGLContextExecutor;
 class ShmBuffer :
     public BufferBasic,
     public NativeBufferBase,
-    public graphics::gl::Texture
+    public graphics::gl::Texture,
+    public graphics::IncrementalBuffer
 {
 public:
     ~ShmBuffer() noexcept override;
@@ -53,24 +59,76 @@ public:
     MirPixelFormat pixel_format() const override;
     NativeBufferBase* native_buffer_base() override;
 
+    /**
+     * Binds the texture, first uploading whatever part of this buffer it doesn't hold
+     *
+     * Only the newest of the buffers sharing a texture updates it, and only
+     * once draws from it in other contexts are done. Other buffers upload to
+     * a texture of their own instead.
+     *
+     * \note This must be called with a current GL context
+     */
     void bind() override;
     gl::Program const& shader(gl::ProgramFactory& cache) const override;
     Layout layout() const override;
+    /// Fences the draw from the texture, so it can be updated once that's done
     void add_syncpoint() override;
+
+    void replaces(Buffer& previous, geometry::Rectangles const& damage) override;
+    /// Uploads this buffer on the thread of egl_delegate
+    void prepare() override;
 protected:
     ShmBuffer(
         geometry::Size const& size,
         MirPixelFormat const& format,
         std::shared_ptr<EGLContextExecutor> egl_delegate);
 
-    /// \note This must be called with a current GL context
-    void upload_to_texture(void const* pixels, geometry::Stride const& stride);
+    using PixelConsumer = std::function<void(void const* pixels, geometry::Stride const& stride)>;
+
+    /// Calls consume with the pixels of this buffer
+    virtual void read_pixels(PixelConsumer const& consume) = 0;
+
+    /**
+     * Stops any upload started by prepare() using this buffer, waiting for one in progress
+     *
+     * \note Derived classes must call this before destroying anything read_pixels() needs
+     */
+    void abandon_prepare();
 private:
+    /// \note These must be called with a current GL context
+    void upload_to_texture(void const* pixels, geometry::Stride const& stride);
+    void upload_damage_to_texture(
+        void const* pixels,
+        geometry::Stride const& stride,
+        geometry::Rectangles const& damage);
+
+    /// A texture shared by a buffer and those that replace it
+    class SharedTexture;
+
+    /// \note This must be called with texture_mutex held
+    auto shared_texture() -> SharedTexture&;
+    /// Stops sharing a texture, for when we mustn't update the shared one
+    /// \note This must be called with texture_mutex held
+    auto own_texture() -> SharedTexture&;
+    /// \note This must be called with the texture's mutex held and a current GL context
+    void upload_changes(SharedTexture& texture);
+
     geometry::Size const size_;
     MirPixelFormat const pixel_format_;
     std::shared_ptr<EGLContextExecutor> const egl_delegate;
-    std::mutex tex_id_mutex;
-    GLuint tex_id{0};
+
+    std::mutex texture_mutex;
+    std::shared_ptr<SharedTexture> texture;
+    /// Buffers whose pixels differ from ours only in the given damage, newest first
+    std::vector<std::pair<BufferID, geometry::Rectangles>> bases;
+
+    /// Lets uploads queued by prepare() find out whether this buffer still exists
+    struct PrepareTarget
+    {
+        std::mutex mutex;
+        ShmBuffer* buffer;
+    };
+    std::shared_ptr<PrepareTarget> const prepare_target;
 };
 
 class MemoryBackedShmBuffer :
@@ -82,20 +140,21 @@ public:
         geometry::Size const& size,
         MirPixelFormat const& pixel_format,
         std::shared_ptr<EGLContextExecutor> egl_delegate);
+    ~MemoryBackedShmBuffer() override;
 
     auto map_writeable() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
     auto map_readable() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> override;
 
     auto map_rw() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
 
-    void bind() override;
-
     auto format() const -> MirPixelFormat override { return ShmBuffer::pixel_format(); }
     auto stride() const -> geometry::Stride override { return stride_; }
     auto size() const -> geometry::Size override { return ShmBuffer::size(); }
 
     MemoryBackedShmBuffer(MemoryBackedShmBuffer const&) = delete;
     MemoryBackedShmBuffer& operator=(MemoryBackedShmBuffer const&) = delete;
+protected:
+    void read_pixels(PixelConsumer const& consume) override;
 private:
     template<typename T>
     class Mapping;
@@ -105,8 +164,6 @@ private:
 
     geometry::Stride const stride_;
     std::unique_ptr<unsigned char[]> const pixels;
-    std::mutex uploaded_mutex;
-    bool uploaded{false};
 };
 
 class MappableBackedShmBuffer :
@@ -117,23 +174,22 @@ public:
     MappableBackedShmBuffer(
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
         std::shared_ptr<EGLContextExecutor> egl_delegate);
+    ~MappableBackedShmBuffer() override;
 
     auto map_writeable() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
     auto map_readable() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> override;
     auto map_rw() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
 
-    void bind() override;
-
     auto format() const -> MirPixelFormat override;
     auto stride() const -> geometry::Stride override;
     auto size() const -> geometry::Size override;
 
     MappableBackedShmBuffer(MappableBackedShmBuffer const&) = delete;
     MappableBackedShmBuffer& operator=(MappableBackedShmBuffer const&) = delete;
+protected:
+    void read_pixels(PixelConsumer const& consume) override;
 private:
     std::shared_ptr<renderer::software::RWMappableBuffer> const data;
-    std::mutex uploaded_mutex;
-    bool uploaded{false};
 };
 
 class NotifyingMappableBackedShmBuffer : public MappableBackedShmBuffer
@@ -30,6 +30,8 @@
 #include "mir/renderer/gl/context_source.h"
 #include "mir/graphics/egl_wayland_allocator.h"
 #include "mir/executor.h"
+#include "mir/fd.h"
+#include "kms-utils/drm_mode_resources.h"
 
 #include <boost/throw_exception.hpp>
 #include <boost/exception/errinfo_errno.hpp>
@@ -40,12 +42,16 @@
 #include <GLES2/gl2ext.h>
 
 #include <algorithm>
+#include <iterator>
 #include <stdexcept>
 #include <system_error>
 #include <gbm.h>
 #include <cassert>
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <xf86drm.h>
+#include <xf86drmMode.h>
+#include <drm_fourcc.h>
 
 #include <wayland-server.h>
 
@@ -56,6 +62,7 @@
 namespace mg  = mir::graphics;
 namespace mgg = mg::gbm;
 namespace mgc = mg::common;
+namespace mgk = mg::kms;
 namespace geom = mir::geometry;
 
 namespace
@@ -88,13 +95,131 @@ std::unique_ptr<mir::renderer::gl::Context> context_for_output(mg::Display const
                 << boost::throw_file(__FILE__));
     }
 }
+
+using FormatModifier = std::pair<uint32_t, uint64_t>;
+
+/// The format and modifier pairs plane can scan out
+auto formats_for_plane(int drm_fd, mgk::DRMModePlaneUPtr const& plane) -> std::vector<FormatModifier>
+{
+    std::vector<FormatModifier> formats;
+
+    mgk::ObjectProperties const properties{drm_fd, plane};
+    if (properties.has_property("IN_FORMATS"))
+    {
+        std::unique_ptr<drmModePropertyBlobRes, void(*)(drmModePropertyBlobPtr)> const blob{
+            drmModeGetPropertyBlob(drm_fd, properties["IN_FORMATS"]),
+            &drmModeFreePropertyBlob};
+        if (blob)
+        {
+            auto const header = static_cast<drm_format_modifier_blob const*>(blob->data);
+            auto const base = static_cast<char const*>(blob->data);
+            auto const plane_formats = reinterpret_cast<uint32_t const*>(base + header->formats_offset);
+            auto const modifiers = reinterpret_cast<drm_format_modifier const*>(base + header->modifiers_offset);
+
+            for (auto i = 0u; i != header->count_modifiers; ++i)
+            {
+                // Each modifier applies to (up to) 64 formats, starting at offset
+                for (auto bit = 0u; bit != 64; ++bit)
+                {
+                    if (modifiers[i].formats & (uint64_t{1} << bit))
+                    {
+                        formats.emplace_back(plane_formats[modifiers[i].offset + bit], modifiers[i].modifier);
+                    }
+                }
+            }
+            return formats;
+        }
+    }
+
+    // Without IN_FORMATS the plane only takes buffers with the implicit modifier
+    for (auto i = 0u; i != plane->count_formats; ++i)
+    {
+        formats.emplace_back(plane->formats[i], DRM_FORMAT_MOD_INVALID);
+    }
+    return formats;
+}
+
+/**
+ * What every primary plane of the KMS device drm_fd can scan out
+ *
+ * Fullscreen surfaces are offered these, so their buffers can bypass composition
+ * on whichever output they are on. That's only possible when the clients' buffers
+ * are imported on the same device, behind dpy.
+ */
+auto scanout_formats_for(EGLDisplay dpy, mir::Fd const& drm_fd)
+    -> std::optional<mg::LinuxDmaBufUnstable::ScanoutFormats>
+{
+    try
+    {
+        if (drm_fd == mir::Fd::invalid)
+        {
+            return std::nullopt;
+        }
+
+        struct stat info;
+        if (fstat(drm_fd, &info) != 0)
+        {
+            BOOST_THROW_EXCEPTION((
+                std::system_error{errno, std::system_category(), "Failed to query the KMS device"}));
+        }
+
+        // Compare device numbers, rather than open the EGL device's node ourselves
+        mg::EGLExtensions::EXTDeviceDRM const device_ext{dpy};
+        struct stat egl_device_info;
+        if (stat(device_ext.device_file(), &egl_device_info) != 0 || egl_device_info.st_rdev != info.st_rdev)
+        {
+            mir::log_info("Cannot offer clients buffers for direct scanout: they are imported on another device");
+            return std::nullopt;
+        }
+
+        // The primary planes are listed as DRMHelper enabled universal planes on opening the device
+        mgk::PlaneResources const plane_resources{drm_fd};
+        std::optional<std::vector<FormatModifier>> common_formats;
+        for (auto const& plane : plane_resources.planes())
+        {
+            mgk::ObjectProperties const properties{drm_fd, plane};
+            if (properties["type"] != DRM_PLANE_TYPE_PRIMARY)
+            {
+                continue;
+            }
+
+            auto formats = formats_for_plane(drm_fd, plane);
+            std::sort(formats.begin(), formats.end());
+            if (common_formats)
+            {
+                std::vector<FormatModifier> intersection;
+                std::set_intersection(
+                    common_formats->begin(), common_formats->end(),
+                    formats.begin(), formats.end(),
+                    std::back_inserter(intersection));
+                common_formats = std::move(intersection);
+            }
+            else
+            {
+                common_formats = std::move(formats);
+            }
+        }
+
+        if (!common_formats || common_formats->empty())
+        {
+            return std::nullopt;
+        }
+        return mg::LinuxDmaBufUnstable::ScanoutFormats{info.st_rdev, std::move(*common_formats)};
+    }
+    catch (std::exception const& error)
+    {
+        mir::log_info("Cannot offer clients buffers for direct scanout: %s", error.what());
+        return std::nullopt;
+    }
+}
 }
 
-mgg::BufferAllocator::BufferAllocator(mg::Display const& output)
+mgg::BufferAllocator::BufferAllocator(mg::Display const& output, mir::Fd kms_drm_fd)
     : ctx{context_for_output(output)},
       egl_delegate{
           std::make_shared<mgc::EGLContextExecutor>(context_for_output(output))},
-      egl_extensions(std::make_shared<mg::EGLExtensions>())
+      egl_extensions(std::make_shared<mg::EGLExtensions>()),
+      kms_drm_fd{std::move(kms_drm_fd)}
 {
 }
 
@@ -168,6 +293,7 @@ void mgg::BufferAllocator::bind_display(wl_display* display, std::shared_ptr<Exe
                     dpy,
                     egl_extensions,
                     modifier_ext,
+                    scanout_formats_for(dpy, kms_drm_fd),
                 },
                 [wayland_executor](LinuxDmaBufUnstable* global)
                 {
@@ -22,6 +22,7 @@
 #include "mir/graphics/buffer_id.h"
 #include "mir_toolkit/mir_native_buffer.h"
 #include "mir/graphics/linux_dmabuf.h"
+#include "mir/fd.h"
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic warning "-Wall"
@@ -59,7 +60,11 @@ class BufferAllocator:
     public graphics::GraphicBufferAllocator
 {
 public:
-    explicit BufferAllocator(Display const& output);
+    /**
+     * \param output        The display whose GL context the allocator shares
+     * \param kms_drm_fd    The platform's KMS device, which scanout formats are queried from (or invalid)
+     */
+    BufferAllocator(Display const& output, mir::Fd kms_drm_fd);
 
     std::shared_ptr<Buffer> alloc_software_buffer(geometry::Size size, MirPixelFormat) override;
     std::vector<MirPixelFormat> supported_pixel_formats() override;
@@ -80,6 +85,7 @@ private:
     std::shared_ptr<Executor> wayland_executor;
     std::unique_ptr<LinuxDmaBufUnstable, std::function<void(LinuxDmaBufUnstable*)>> dmabuf_extension;
     std::shared_ptr<EGLExtensions> const egl_extensions;
+    mir::Fd const kms_drm_fd;
     bool egl_display_bound{false};
 };
 
@@ -48,6 +48,33 @@ namespace mgmh = mir::graphics::gbm::helpers;
  * DRMHelper *
  *************/
 
+namespace
+{
+/**
+ * Sets the client capabilities the KMS code relies on, once, before anything else uses the device
+ *
+ * Client capabilities change what the kernel exposes to every later call on the fd, so they are
+ * not for the code driving individual outputs to set.
+ *
+ * \return Whether atomic modesetting is available
+ */
+bool set_client_caps(int drm_fd, char const* devnode)
+{
+    // Lets the primary planes be queried, with or without atomic modesetting
+    if (drmSetClientCap(drm_fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1) != 0)
+    {
+        mir::log_info("DRM device %s does not expose universal planes", devnode);
+    }
+
+    if (drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1) != 0)
+    {
+        mir::log_info("DRM device %s does not support atomic modesetting", devnode);
+        return false;
+    }
+    return true;
+}
+}
+
 std::vector<std::shared_ptr<mgmh::DRMHelper>>
 mgmh::DRMHelper::open_all_devices(
     std::shared_ptr<mir::udev::Context> const& udev,
@@ -156,12 +183,15 @@ mgmh::DRMHelper::open_all_devices(
             }
         }
 
+        auto const atomic_modesetting = set_client_caps(tmp_fd, device.devnode());
+
         // Can't use make_shared with the private constructor.
         opened_devices.push_back(
             std::shared_ptr<DRMHelper>{
                 new DRMHelper{
                     std::move(tmp_fd),
-                    std::move(device_handle)}});
+                    std::move(device_handle),
+                    atomic_modesetting}});
         mir::log_info("Using DRM device %s", device.devnode());
     }
 
@@ -209,11 +239,12 @@ std::unique_ptr<mgmh::DRMHelper> mgmh::DRMHelper::open_any_render_node(
     }
 
     return std::unique_ptr<mgmh::DRMHelper>{
-        new mgmh::DRMHelper{std::move(tmp_fd), nullptr}};
+        new mgmh::DRMHelper{std::move(tmp_fd), nullptr, false}};
 }
 
-mgmh::DRMHelper::DRMHelper(mir::Fd&& fd, std::unique_ptr<mir::Device> device)
+mgmh::DRMHelper::DRMHelper(mir::Fd&& fd, std::unique_ptr<mir::Device> device, bool atomic_modesetting)
     : fd{std::move(fd)},
+      atomic_modesetting{atomic_modesetting},
       device_handle{std::move(device)}
 {
 }
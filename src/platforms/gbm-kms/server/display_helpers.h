@@ -64,10 +64,12 @@ public:
         std::shared_ptr<mir::udev::Context> const& udev);
 
     mir::Fd fd;
+    /// Whether the driver has accepted DRM_CLIENT_CAP_ATOMIC on fd
+    bool const atomic_modesetting;
 private:
     std::unique_ptr<Device> const device_handle;
 
-    explicit DRMHelper(mir::Fd&& fd, std::unique_ptr<mir::Device> device);
+    DRMHelper(mir::Fd&& fd, std::unique_ptr<mir::Device> device, bool atomic_modesetting);
 };
 
 class GBMHelper
@@ -32,5 +32,5 @@ mgg::GBMPlatform::GBMPlatform(
 mir::UniqueModulePtr<mg::GraphicBufferAllocator> mgg::GBMPlatform::create_buffer_allocator(
     Display const& output)
 {
-    return make_module_ptr<mgg::BufferAllocator>(output);
+    return make_module_ptr<mgg::BufferAllocator>(output, drm->fd);
 }
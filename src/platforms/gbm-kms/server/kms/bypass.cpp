@@ -17,6 +17,8 @@
 #include "bypass.h"
 
 #include "mir/graphics/renderable.h"
+#include "mir/graphics/buffer.h"
+#include "mir/graphics/dmabuf_buffer.h"
 
 using namespace mir;
 namespace mgg = mir::graphics::gbm;
@@ -44,3 +46,31 @@ bool mgg::BypassMatch::operator()(std::shared_ptr<graphics::Renderable> const& r
     bypass_is_feasible = (is_opaque && fits && is_orthogonal);
     return bypass_is_feasible;
 }
+
+auto mgg::overlay_buffer_for(graphics::Renderable const& renderable, geometry::Rectangle const& view_area)
+    -> std::shared_ptr<graphics::Buffer>
+{
+    static glm::mat4 const identity(1);
+
+    auto const& position = renderable.screen_position();
+    auto const clip = renderable.clip_area();
+
+    if (renderable.alpha() != 1.0f ||
+        renderable.shaped() ||
+        renderable.transformation() != identity ||
+        !view_area.contains(position) ||
+        (clip && !clip->contains(position)))
+    {
+        return nullptr;
+    }
+
+    auto buffer = renderable.buffer();
+    if (!buffer ||
+        buffer->size() != position.size ||
+        !dynamic_cast<graphics::DMABufBuffer*>(buffer->native_buffer_base()))
+    {
+        return nullptr;
+    }
+
+    return buffer;
+}
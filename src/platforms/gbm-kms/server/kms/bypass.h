@@ -37,6 +37,16 @@ private:
     glm::mat4 const identity;
 };
 
+/**
+ * The buffer of renderable, if it can be shown exactly as it is on a hardware
+ * plane of an output showing view_area.
+ *
+ * That requires an untransformed, unscaled, fully opaque dmabuf that is
+ * entirely within view_area.
+ */
+auto overlay_buffer_for(graphics::Renderable const& renderable, geometry::Rectangle const& view_area)
+    -> std::shared_ptr<graphics::Buffer>;
+
 } // namespace gbm-kms
 } // namespace graphics
 } // namespace mir
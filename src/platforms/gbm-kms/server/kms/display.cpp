@@ -44,6 +44,7 @@
 
 #include <stdexcept>
 #include <algorithm>
+#include <optional>
 #include <unordered_map>
 
 namespace mgg = mir::graphics::gbm;
@@ -78,17 +79,6 @@ private:
     mgg::helpers::EGLHelper egl;
 };
 
-std::vector<int> drm_fds_from_drm_helpers(
-    std::vector<std::shared_ptr<mgg::helpers::DRMHelper>> const& helpers)
-{
-    std::vector<int> fds;
-    for (auto const& helper: helpers)
-    {
-        fds.push_back(helper->fd);
-    }
-    return fds;
-}
-
 double calculate_vrefresh_hz(drmModeModeInfo const& mode)
 {
     if (mode.htotal == 0 || mode.vtotal == 0)
@@ -186,7 +176,7 @@ mgg::Display::Display(std::vector<std::shared_ptr<helpers::DRMHelper>> const& dr
       shared_egl{*gl_config},
       output_container{
           std::make_shared<RealKMSOutputContainer>(
-              drm_fds_from_drm_helpers(drm),
+              drm,
               [
                   listener,
                   flippers = std::unordered_map<int, std::shared_ptr<KMSPageFlipper>>{}
@@ -505,6 +495,15 @@ auto make_surface_with_egl_context(
 
 }
 
+struct mgg::Display::SyncGroupLayout
+{
+    std::vector<std::shared_ptr<KMSOutput>> outputs;
+    std::vector<DisplayConfigurationOutput> conf_outputs;   ///< Matching outputs
+    geom::Rectangle area;
+    glm::mat2 transformation;
+    geom::Size resolution;
+};
+
 void mgg::Display::configure_locked(
     mgg::RealKMSDisplayConfiguration const& kms_conf,
     std::lock_guard<std::mutex> const&)
@@ -564,6 +563,7 @@ void mgg::Display::configure_locked(
                     {
                         kms_output->set_power_mode(conf_output.power_mode);
                         kms_output->set_gamma(conf_output.gamma);
+                        kms_output->set_vrr_enabled(conf_output.vrr_enabled);
                         add_to_drm_device_group(kms_output_groups, std::move(kms_output));
                     }
 
@@ -583,42 +583,10 @@ void mgg::Display::configure_locked(
             }
             else
             {
-                uint32_t const width  = current_mode_resolution.width.as_uint32_t();
-                uint32_t const height = current_mode_resolution.height.as_uint32_t();
-
                 for (auto const& group : kms_output_groups)
                 {
-                    // TODO: Pull this out of the configuration
-                    // TODO: Actually query available formats!
-                    mg::DRMFormat format{GBM_FORMAT_XRGB8888};
-                    /*
-                     * In a hybrid setup a scanout surface needs to be allocated differently if it
-                     * needs to be able to be shared across GPUs. This likely reduces performance.
-                     *
-                     * As a first cut, assume every scanout buffer in a hybrid setup might need
-                     * to be shared.
-                     */
-                    auto [surface, egl] = make_surface_with_egl_context(
-                        current_mode_resolution,
-                        format,
-                        *gbm,
-                        *gl_config,
-                        shared_egl.context(),
-                        drm.size() != 1);
-                    auto db = std::make_unique<DisplayBuffer>(
-                        bypass_option,
-                        listener,
-                        group,
-                        GBMOutputSurface{
-                            group.front()->drm_fd(),
-                            std::move(surface),
-                            width, height,
-                            std::move(egl)
-                        },
-                        bounding_rect,
-                        transformation);
-
-                    display_buffers_new.push_back(std::move(db));
+                    display_buffers_new.push_back(create_display_buffer(
+                        {group, {}, bounding_rect, transformation, current_mode_resolution}));
                 }
             }
         });
@@ -633,3 +601,239 @@ void mgg::Display::configure_locked(
         /* Clear connected but unused outputs */
         clear_connected_unused_outputs();
 }
+
+auto mgg::Display::sync_group_layouts(RealKMSDisplayConfiguration const& kms_conf) const
+    -> std::vector<SyncGroupLayout>
+{
+    // As configure_locked() lays them out: one for each GPU in each group of overlapping outputs
+    std::vector<SyncGroupLayout> layouts;
+
+    OverlappingOutputGrouping grouping{kms_conf};
+    grouping.for_each_group(
+        [&](OverlappingOutputGroup const& group)
+        {
+            auto const first_in_group = layouts.size();
+            auto const bounding_rect = group.bounding_rectangle();
+
+            group.for_each_output(
+                [&](DisplayConfigurationOutput const& conf_output)
+                {
+                    auto kms_output = current_display_configuration.get_output_for(conf_output.id);
+
+                    auto const same_gpu = std::find_if(
+                        layouts.begin() + first_in_group,
+                        layouts.end(),
+                        [&](SyncGroupLayout const& layout)
+                        {
+                            return layout.outputs.front()->drm_fd() == kms_output->drm_fd();
+                        });
+
+                    auto& layout = same_gpu != layouts.end() ?
+                        *same_gpu :
+                        layouts.emplace_back(SyncGroupLayout{{}, {}, bounding_rect, conf_output.transformation(), {}});
+
+                    layout.outputs.push_back(std::move(kms_output));
+                    layout.conf_outputs.push_back(conf_output);
+                    if (conf_output.current_mode_index < conf_output.modes.size())
+                        layout.resolution = conf_output.modes[conf_output.current_mode_index].size;
+                });
+        });
+
+    return layouts;
+}
+
+auto mgg::Display::create_display_buffer(SyncGroupLayout const& layout) const -> std::unique_ptr<DisplayBuffer>
+{
+    // TODO: Pull this out of the configuration
+    // TODO: Actually query available formats!
+    mg::DRMFormat format{GBM_FORMAT_XRGB8888};
+    /*
+     * In a hybrid setup a scanout surface needs to be allocated differently if it
+     * needs to be able to be shared across GPUs. This likely reduces performance.
+     *
+     * As a first cut, assume every scanout buffer in a hybrid setup might need
+     * to be shared.
+     */
+    auto [surface, egl] = make_surface_with_egl_context(
+        layout.resolution,
+        format,
+        *gbm,
+        *gl_config,
+        shared_egl.context(),
+        drm.size() != 1);
+
+    return std::make_unique<DisplayBuffer>(
+        bypass_option,
+        listener,
+        layout.outputs,
+        GBMOutputSurface{
+            layout.outputs.front()->drm_fd(),
+            std::move(surface),
+            layout.resolution.width.as_uint32_t(),
+            layout.resolution.height.as_uint32_t(),
+            std::move(egl)
+        },
+        layout.area,
+        layout.transformation);
+}
+
+bool mgg::Display::configure_changed_sync_groups(
+    mg::DisplayConfiguration const& conf,
+    std::function<void(std::vector<DisplaySyncGroup*> const&)> const& retire)
+{
+    if (!conf.valid())
+    {
+        BOOST_THROW_EXCEPTION(
+            std::logic_error("Invalid or inconsistent display configuration"));
+    }
+
+    bool result = false;
+    auto const& new_kms_conf = dynamic_cast<RealKMSDisplayConfiguration const&>(conf);
+
+    // As with pause() and resume(), the cursor is off the outputs while they are reconfigured
+    auto const c = cursor.lock();
+    if (c) c->suspend();
+
+    try
+    {
+        std::lock_guard lock{configuration_mutex};
+        result = configure_changed_sync_groups_locked(new_kms_conf, retire, lock);
+    }
+    catch (...)
+    {
+        if (c) c->resume();
+        throw;
+    }
+
+    if (c) c->resume();
+    return result;
+}
+
+bool mgg::Display::configure_changed_sync_groups_locked(
+    RealKMSDisplayConfiguration const& kms_conf,
+    std::function<void(std::vector<DisplaySyncGroup*> const&)> const& retire,
+    std::lock_guard<std::mutex> const&)
+{
+    auto const unchanged = [this](DisplayConfigurationOutput const& conf_output)
+        {
+            bool result = false;
+            current_display_configuration.for_each_output([&](DisplayConfigurationOutput const& current_output)
+                {
+                    if (current_output.id == conf_output.id)
+                        result = current_output == conf_output;
+                });
+            return result;
+        };
+
+    auto const layouts = sync_group_layouts(kms_conf);
+
+    /*
+     * A DisplayBuffer can carry on as it is if the new configuration has it
+     * driving the same outputs, none of which have changed.
+     */
+    std::vector<std::optional<size_t>> kept_buffer(layouts.size());
+    std::vector<bool> buffer_kept(display_buffers.size(), false);
+    std::vector<std::shared_ptr<KMSOutput>> kept_outputs;
+    for (size_t i = 0; i != layouts.size(); ++i)
+    {
+        auto const& layout = layouts[i];
+        if (!std::all_of(layout.conf_outputs.begin(), layout.conf_outputs.end(), unchanged))
+            continue;
+
+        for (size_t j = 0; j != display_buffers.size(); ++j)
+        {
+            auto const& db = display_buffers[j];
+            if (!buffer_kept[j] && db->drives(layout.outputs) && db->view_area() == layout.area)
+            {
+                kept_buffer[i] = j;
+                buffer_kept[j] = true;
+                kept_outputs.insert(kept_outputs.end(), layout.outputs.begin(), layout.outputs.end());
+                break;
+            }
+        }
+    }
+
+    // If nothing can be kept configure() might as well start afresh
+    if (std::none_of(buffer_kept.begin(), buffer_kept.end(), [](bool kept) { return kept; }))
+        return false;
+
+    /*
+     * From retire() on, resetting and configuring the outputs and creating the new DisplayBuffers can all throw,
+     * leaving the retired groups stopped (and configure() needed). Until the new DisplayBuffers are all created
+     * display_buffers is left as it is, and the splice after that can't throw, so it never holds a mixture.
+     */
+    auto applied_configuration = kms_conf;
+    std::vector<std::unique_ptr<DisplayBuffer>> display_buffers_new;
+    display_buffers_new.reserve(layouts.size());
+    std::vector<std::unique_ptr<DisplayBuffer>> created(layouts.size());
+
+    std::vector<DisplaySyncGroup*> retiring;
+    for (size_t j = 0; j != display_buffers.size(); ++j)
+    {
+        if (!buffer_kept[j])
+            retiring.push_back(display_buffers[j].get());
+    }
+
+    bool const adding = std::any_of(kept_buffer.begin(), kept_buffer.end(), [](auto const& kept) { return !kept; });
+    if (!retiring.empty() || adding)
+        retire(retiring);
+
+    // As in configure_locked(), but the kept DisplayBuffers go on flipping undisturbed
+    for (size_t j = 0; j != display_buffers.size(); ++j)
+    {
+        if (!buffer_kept[j])
+            display_buffers[j]->wait_for_page_flip();
+    }
+
+    /* Reset the state of the outputs that aren't kept as they are */
+    kms_conf.for_each_output(
+        [&](DisplayConfigurationOutput const& conf_output)
+        {
+            auto kms_output = current_display_configuration.get_output_for(conf_output.id);
+            if (std::find(kept_outputs.begin(), kept_outputs.end(), kms_output) == kept_outputs.end())
+            {
+                kms_output->clear_cursor();
+                kms_output->reset();
+            }
+        });
+
+    /* Set up the changed outputs */
+    for (size_t i = 0; i != layouts.size(); ++i)
+    {
+        auto const& layout = layouts[i];
+        if (kept_buffer[i])
+            continue;
+
+        for (size_t k = 0; k != layout.outputs.size(); ++k)
+        {
+            auto const& kms_output = layout.outputs[k];
+            auto const& conf_output = layout.conf_outputs[k];
+
+            auto const mode_index = kms_conf.get_kms_mode_index(conf_output.id, conf_output.current_mode_index);
+            kms_output->configure(conf_output.top_left - layout.area.top_left, mode_index);
+            kms_output->set_power_mode(conf_output.power_mode);
+            kms_output->set_gamma(conf_output.gamma);
+            kms_output->set_vrr_enabled(conf_output.vrr_enabled);
+        }
+
+        created[i] = create_display_buffer(layout);
+    }
+
+    /* Splice the kept and created DisplayBuffers into the order configure_locked() would have */
+    for (size_t i = 0; i != layouts.size(); ++i)
+    {
+        display_buffers_new.push_back(
+            kept_buffer[i] ? std::move(display_buffers[*kept_buffer[i]]) : std::move(created[i]));
+    }
+
+    // The retired DisplayBuffers are destroyed once the new ones have taken over their outputs
+    display_buffers.swap(display_buffers_new);
+
+    /* Store applied configuration */
+    current_display_configuration = std::move(applied_configuration);
+
+    /* Clear connected but unused outputs */
+    clear_connected_unused_outputs();
+
+    return true;
+}
@@ -73,6 +73,9 @@ public:
     std::unique_ptr<DisplayConfiguration> configuration() const override;
     bool apply_if_configuration_preserves_display_buffers(DisplayConfiguration const& conf) override;
     void configure(DisplayConfiguration const& conf) override;
+    bool configure_changed_sync_groups(
+        DisplayConfiguration const& conf,
+        std::function<void(std::vector<DisplaySyncGroup*> const& retiring)> const& retire) override;
 
     void register_configuration_change_handler(
         EventHandlerRegister& handlers,
@@ -111,6 +114,15 @@ private:
         RealKMSDisplayConfiguration const& conf,
         std::lock_guard<decltype(configuration_mutex)> const&);
 
+    /// The outputs one DisplayBuffer drives, and how
+    struct SyncGroupLayout;
+    auto sync_group_layouts(RealKMSDisplayConfiguration const& conf) const -> std::vector<SyncGroupLayout>;
+    auto create_display_buffer(SyncGroupLayout const& layout) const -> std::unique_ptr<DisplayBuffer>;
+    bool configure_changed_sync_groups_locked(
+        RealKMSDisplayConfiguration const& conf,
+        std::function<void(std::vector<DisplaySyncGroup*> const& retiring)> const& retire,
+        std::lock_guard<decltype(configuration_mutex)> const&);
+
     BypassOption bypass_option;
     std::weak_ptr<Cursor> cursor;
     std::shared_ptr<GLConfig> const gl_config;
@@ -27,6 +27,7 @@
 #include "mir/graphics/egl_error.h"
 #include "mir/graphics/gl_config.h"
 #include "mir/graphics/dmabuf_buffer.h"
+#include "mir/geometry/rectangles.h"
 
 #include <boost/throw_exception.hpp>
 #include <EGL/egl.h>
@@ -436,6 +437,8 @@ mgg::DisplayBuffer::DisplayBuffer(
       area(area),
       transform{transformation},
       needs_set_crtc{false},
+      composited_render_time{std::chrono::milliseconds{50}},
+      bypass_render_time{std::chrono::milliseconds{5}},
       page_flips_pending{false}
 {
     listener->report_successful_setup_of_native_resources();
@@ -522,12 +525,18 @@ void mgg::DisplayBuffer::set_transformation(glm::mat2 const& t, geometry::Rectan
 
 bool mgg::DisplayBuffer::overlay(RenderableList const& renderable_list)
 {
+    // This is the first thing the compositor asks of each frame
+    frame_started = std::chrono::steady_clock::now();
+
     glm::mat2 static const no_transformation(1);
     if (transform == no_transformation &&
        (bypass_option == mgg::BypassOption::allowed))
     {
+        // The topmost renderables might go on overlay planes, and what's below them on the primary
+        auto const below_overlays = assign_overlay_planes(renderable_list);
+
         mgg::BypassMatch bypass_match(area);
-        auto bypass_it = std::find_if(renderable_list.rbegin(), renderable_list.rend(), bypass_match);
+        auto bypass_it = std::find_if(below_overlays, renderable_list.rend(), bypass_match);
         if (bypass_it != renderable_list.rend())
         {
             auto bypass_buffer = (*bypass_it)->buffer();
@@ -537,19 +546,100 @@ bool mgg::DisplayBuffer::overlay(RenderableList const& renderable_list)
             {
                 if (auto bufobj = outputs.front()->fb_for(*dmabuf_image))
                 {
-                    bypass_buf = bypass_buffer;
-                    bypass_bufobj = bufobj;
-                    return true;
+                    if (overlay_layers.empty() || outputs.front()->test_overlays(*bufobj, overlay_layers))
+                    {
+                        bypass_buf = bypass_buffer;
+                        bypass_bufobj = bufobj;
+                        bypass_tearing = (*bypass_it)->allow_tearing();
+                        return true;
+                    }
                 }
             }
         }
     }
 
+    clear_overlay_planes();
     bypass_buf = nullptr;
     bypass_bufobj = nullptr;
     return false;
 }
 
+auto mgg::DisplayBuffer::overlay_topmost(RenderableList const& renderable_list) -> RenderableList
+{
+    glm::mat2 static const no_transformation(1);
+    if (transform != no_transformation ||
+        bypass_option != mgg::BypassOption::allowed ||
+        !visible_fb)
+    {
+        clear_overlay_planes();
+        return renderable_list;
+    }
+
+    auto const below_overlays = assign_overlay_planes(renderable_list);
+
+    /*
+     * We can't test with the frame we're about to render, so test with the
+     * last one: it is the same format and size.
+     */
+    if (overlay_layers.empty() || !outputs.front()->test_overlays(*visible_fb, overlay_layers))
+    {
+        clear_overlay_planes();
+        return renderable_list;
+    }
+
+    return RenderableList{renderable_list.begin(), below_overlays.base()};
+}
+
+auto mgg::DisplayBuffer::assign_overlay_planes(RenderableList const& renderable_list)
+    -> RenderableList::const_reverse_iterator
+{
+    clear_overlay_planes();
+
+    /*
+     * Planes can't be shared between the outputs of a clone group, and SetCrtc
+     * shows only the primary plane: anything we'd put on an overlay plane of a
+     * frame that needs it would be missing.
+     */
+    auto const planes = outputs.size() == 1 && !needs_set_crtc && !overlay_planes_failed ?
+        outputs.front()->overlay_plane_count() : 0;
+
+    auto it = renderable_list.rbegin();
+    for (; it != renderable_list.rend() && overlay_layers.size() < planes; ++it)
+    {
+        auto const& renderable = **it;
+        auto const& position = renderable.screen_position();
+
+        // Offscreen renderables don't need a plane
+        if (!area.overlaps(position))
+            continue;
+
+        // Leave anything covering the whole output for the primary plane
+        if (position == area)
+            break;
+
+        auto buffer = mgg::overlay_buffer_for(renderable, area);
+        if (!buffer)
+            break;
+
+        auto const fb = outputs.front()->fb_for(*dynamic_cast<mg::DMABufBuffer*>(buffer->native_buffer_base()));
+        if (!fb)
+            break;
+
+        overlay_layers.insert(
+            overlay_layers.begin(),
+            OverlayLayer{fb, position.size, as_point(position.top_left - area.top_left)});
+        overlay_bufs.push_back(std::move(buffer));
+    }
+
+    return it;
+}
+
+void mgg::DisplayBuffer::clear_overlay_planes()
+{
+    overlay_layers.clear();
+    overlay_bufs.clear();
+}
+
 void mgg::DisplayBuffer::for_each_display_buffer(
     std::function<void(graphics::DisplayBuffer&)> const& f)
 {
@@ -563,6 +653,18 @@ void mgg::DisplayBuffer::swap_buffers()
     bypass_bufobj = nullptr;
 }
 
+void mgg::DisplayBuffer::swap_buffers_with_damage(geom::Rectangles const& damage)
+{
+    surface.swap_buffers_with_damage(damage);
+    bypass_buf = nullptr;
+    bypass_bufobj = nullptr;
+}
+
+auto mgg::DisplayBuffer::buffer_age() const -> int
+{
+    return surface.buffer_age();
+}
+
 void mgg::DisplayBuffer::set_crtc(FBHandle const& forced_frame)
 {
     for (auto& output : outputs)
@@ -583,6 +685,27 @@ void mgg::DisplayBuffer::set_crtc(FBHandle const& forced_frame)
 
 void mgg::DisplayBuffer::post()
 {
+    recomposite_needed = false;
+
+    // It's very likely the next frame will be bypassed (or not) like this one
+    auto& render_time = bypass_buf ? bypass_render_time : composited_render_time;
+
+    /*
+     * Measure how long the frame took to be ready to flip. For composited
+     * frames that is until the GPU has finished drawing it, and waiting for
+     * that blocks this thread: otherwise the GPU would still be drawing while
+     * we get on with the flip. So only measure where the estimate is used,
+     * which is for recommending a sleep on a single output.
+     */
+    bool const measure_render_time = outputs.size() == 1;
+    if (measure_render_time && !bypass_buf)
+        surface.wait_for_rendering();
+    bool const started_on_schedule =
+        frame_started && next_frame_deadline && *frame_started <= next_frame_deadline->start_by;
+    if (measure_render_time && frame_started)
+        render_time.frame_rendered(std::chrono::steady_clock::now() - *frame_started);
+    frame_started = std::nullopt;
+
     /*
      * We might not have waited for the previous frame to page flip yet.
      * This is good because it maximizes the time available to spend rendering
@@ -606,16 +729,48 @@ void mgg::DisplayBuffer::post()
 
     scheduled_fb = std::move(bufobj);
     /*
-     * Try to schedule a page flip as first preference to avoid tearing.
-     * [will complete in a background thread]
+     * A bypassed client that asked for it gets its frame flipped straight
+     * away, tearing or not. Otherwise try to schedule a page flip as first
+     * preference to avoid tearing. [will complete in a background thread]
      */
-    if (!needs_set_crtc && !schedule_page_flip(*scheduled_fb))
+    bool const tearing = bypass_buf && bypass_tearing && !needs_set_crtc && schedule_async_page_flip(*scheduled_fb);
+    if (!tearing && !needs_set_crtc && !schedule_page_flip(*scheduled_fb))
+    {
+        if (!overlay_layers.empty())
+        {
+            /*
+             * SetCrtc would show this frame without what's on the overlay planes.
+             * Leave the last frame on screen instead, and have the compositor
+             * draw those renderables into a new one (and all that follow).
+             */
+            mir::log_warning("Failed to flip to KMS overlay planes; compositing them from now on");
+            overlay_planes_failed = true;
+            recomposite_needed = true;
+
+            scheduled_fb = nullptr;
+            scheduled_composite_frame = nullptr;
+            clear_overlay_planes();
+            bypass_buf = nullptr;
+            bypass_bufobj = nullptr;
+            bypass_tearing = false;
+            last_presentation_ = std::nullopt;
+            recommend_sleep = std::chrono::milliseconds::zero();
+            next_frame_deadline = std::nullopt;
+            return;
+        }
+
         needs_set_crtc = true;
+    }
+
+    // The overlay buffers need to live as long as the frame they are part of
+    scheduled_overlay_bufs = std::move(overlay_bufs);
+    clear_overlay_planes();
 
     /*
      * Fallback blitting: Not pretty, since it may tear. VirtualBox seems
      * to need to do this on every frame. [will complete in this thread]
      */
+    bool const shown_by_set_crtc = needs_set_crtc;
     if (needs_set_crtc)
     {
         set_crtc(*scheduled_fb);
@@ -626,11 +781,6 @@ void mgg::DisplayBuffer::post()
         needs_set_crtc = false;
     }
 
-    using namespace std::chrono_literals;  // For operator""ms()
-
-    // Predicted worst case render time for the next frame...
-    auto predicted_render_time = 50ms;
-
     if (bypass_buf)
     {
         /*
@@ -641,13 +791,14 @@ void mgg::DisplayBuffer::post()
          * unless we allocate more buffers (which I'm trying to avoid).
          * Also, bypass does not need the deferred page flip because it has
          * no compositing/rendering step for which to save time for.
+         *
+         * An async flip completes as soon as the hardware takes the buffer,
+         * so waiting for it costs next to nothing and releases the frame it
+         * replaced straight away (a client with only two buffers needs that
+         * one back to draw its next frame).
          */
         scheduled_bypass_frame = bypass_buf;
         wait_for_page_flip();
-
-        // It's very likely the next frame will be bypassed like this one so
-        // we only need time for kernel page flip scheduling...
-        predicted_render_time = 5ms;
     }
     else
     {
@@ -658,27 +809,64 @@ void mgg::DisplayBuffer::post()
          */
         if (outputs.size() == 1)
             wait_for_page_flip();
+    }
 
-        /*
-         * TODO: If you're optimistic about your GPU performance and/or
-         *       measure it carefully you may wish to set predicted_render_time
-         *       to a lower value here for lower latency.
-         *
-         *predicted_render_time = 9ms; // e.g. about the same as Weston
-         */
+    /*
+     * Once the page flip has completed its event tells us exactly when the
+     * frame was shown. In clone mode the flip is still pending, and SetCrtc
+     * isn't synchronised to a refresh, so then we don't know.
+     */
+    if (shown_by_set_crtc || page_flips_pending)
+    {
+        last_presentation_ = std::nullopt;
+    }
+    else
+    {
+        auto const& output = outputs.front();
+        last_presentation_ = FramePresentation{
+            output->last_frame(),
+            output->vrr_enabled() ? std::chrono::nanoseconds::zero() : output->refresh_interval(),
+            !tearing,
+            true,
+            bypass_buf != nullptr};
+
+        // A frame started in time that still missed its refresh means we're cutting it too fine
+        if (started_on_schedule && last_presentation_->frame.msc > next_frame_deadline->target_msc)
+            render_time.deadline_missed();
     }
 
     // Buffer lifetimes are managed exclusively by scheduled*/visible* now
     bypass_buf = nullptr;
     bypass_bufobj = nullptr;
+    bypass_tearing = false;
 
-    recommend_sleep = 0ms;
-    if (outputs.size() == 1)
+    /*
+     * Having waited for the flip we're at the start of a refresh, so sleeping
+     * for all of it but the time the next frame needs gets the freshest scene
+     * on screen at the next refresh.
+     */
+    recommend_sleep = std::chrono::milliseconds::zero();
+    next_frame_deadline = std::nullopt;
+    /*
+     * ...unless the output has variable refresh: then it refreshes when we
+     * flip, so a frame (from a fullscreen game, say) should be flipped the
+     * moment it arrives rather than held back for a refresh that isn't coming.
+     * Likewise a client that asked to tear wants its frames shown on arrival.
+     */
+    if (outputs.size() == 1 && !outputs.front()->vrr_enabled() && !tearing)
     {
         auto const& output = outputs.front();
-        auto const min_frame_interval = 1000ms / output->max_refresh_rate();
+        auto const min_frame_interval = std::chrono::nanoseconds{std::chrono::seconds{1}} / output->max_refresh_rate();
+        auto const predicted_render_time = render_time.estimate();
         if (predicted_render_time < min_frame_interval)
-            recommend_sleep = min_frame_interval - predicted_render_time;
+        {
+            auto const slack = min_frame_interval - predicted_render_time;
+            recommend_sleep = std::chrono::duration_cast<std::chrono::milliseconds>(slack);
+            if (last_presentation_)
+            {
+                next_frame_deadline = Deadline{std::chrono::steady_clock::now() + slack, last_presentation_->frame.msc + 1};
+            }
+        }
     }
 }
 
@@ -687,6 +875,16 @@ std::chrono::milliseconds mgg::DisplayBuffer::recommended_sleep() const
     return recommend_sleep;
 }
 
+bool mgg::DisplayBuffer::needs_recomposite() const
+{
+    return recomposite_needed;
+}
+
+auto mgg::DisplayBuffer::last_presentation() const -> std::optional<FramePresentation>
+{
+    return last_presentation_;
+}
+
 bool mgg::DisplayBuffer::schedule_page_flip(FBHandle const& bufobj)
 {
     /*
@@ -695,13 +893,32 @@ bool mgg::DisplayBuffer::schedule_page_flip(FBHandle const& bufobj)
      */
     for (auto& output : outputs)
     {
-        if (output->schedule_page_flip(bufobj))
+        auto const scheduled = overlay_layers.empty() ?
+            output->schedule_page_flip(bufobj) :
+            output->schedule_page_flip_with_overlays(bufobj, overlay_layers);
+
+        if (scheduled)
             page_flips_pending = true;
     }
 
     return page_flips_pending;
 }
 
+bool mgg::DisplayBuffer::schedule_async_page_flip(FBHandle const& bufobj)
+{
+    /*
+     * An async flip can't change the overlay planes, and cloned outputs
+     * flipping whenever they like would no longer show the same frame.
+     */
+    if (outputs.size() != 1 || !overlay_layers.empty())
+        return false;
+
+    if (outputs.front()->schedule_async_page_flip(bufobj))
+        page_flips_pending = true;
+
+    return page_flips_pending;
+}
+
 void mgg::DisplayBuffer::wait_for_page_flip()
 {
     if (page_flips_pending)
@@ -726,6 +943,9 @@ void mgg::DisplayBuffer::wait_for_page_flip()
 
         visible_composite_frame = std::move(scheduled_composite_frame);
         scheduled_composite_frame = nullptr;
+
+        visible_overlay_bufs = std::move(scheduled_overlay_bufs);
+        scheduled_overlay_bufs.clear();
     }
 }
 
@@ -749,6 +969,12 @@ void mgg::DisplayBuffer::release_current()
     surface.release_current();
 }
 
+bool mgg::DisplayBuffer::drives(std::vector<std::shared_ptr<KMSOutput>> const& other_outputs) const
+{
+    return other_outputs.size() == outputs.size() &&
+        std::is_permutation(outputs.begin(), outputs.end(), other_outputs.begin());
+}
+
 void mgg::DisplayBuffer::schedule_set_crtc()
 {
     needs_set_crtc = true;
@@ -806,6 +1032,28 @@ void mgg::GBMOutputSurface::swap_buffers()
         fatal_error("Failed to perform buffer swap");
 }
 
+void mgg::GBMOutputSurface::swap_buffers_with_damage(geom::Rectangles const& damage)
+{
+    // EGL wants {x, y, width, height} relative to the *bottom*-left of the surface
+    std::vector<EGLint> rects;
+    rects.reserve(damage.size() * 4);
+    for (auto const& rect : damage)
+    {
+        rects.push_back(rect.left().as_int());
+        rects.push_back(static_cast<EGLint>(height) - rect.bottom().as_int());
+        rects.push_back(rect.size.width.as_int());
+        rects.push_back(rect.size.height.as_int());
+    }
+
+    if (!egl.swap_buffers_with_damage(rects.data(), static_cast<EGLint>(damage.size())))
+        fatal_error("Failed to perform buffer swap");
+}
+
+auto mgg::GBMOutputSurface::buffer_age() const -> int
+{
+    return egl.buffer_age();
+}
+
 void mgg::GBMOutputSurface::bind()
 {
 
@@ -816,6 +1064,11 @@ auto mgg::GBMOutputSurface::lock_front() -> FrontBuffer
     return FrontBuffer{surface.get()};
 }
 
+void mgg::GBMOutputSurface::wait_for_rendering()
+{
+    egl.wait_for_rendering();
+}
+
 void mgg::GBMOutputSurface::report_egl_configuration(
     std::function<void(EGLDisplay, EGLConfig)> const& to)
 {
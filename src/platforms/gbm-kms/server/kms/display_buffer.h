@@ -22,11 +22,15 @@
 #include "mir/renderer/gl/render_target.h"
 #include "display_helpers.h"
 #include "egl_helper.h"
+#include "kms_output.h"
 #include "platform_common.h"
+#include "render_time_estimator.h"
 
 #include <vector>
 #include <memory>
 #include <atomic>
+#include <chrono>
+#include <optional>
 
 namespace mir
 {
@@ -80,9 +84,13 @@ public:
     void make_current() override;
     void release_current() override;
     void swap_buffers() override;
+    void swap_buffers_with_damage(geometry::Rectangles const& damage) override;
+    auto buffer_age() const -> int override;
     void bind() override;
 
     FrontBuffer lock_front();
+    /// Wait for the GPU to finish drawing the buffer last swapped
+    void wait_for_rendering();
     void report_egl_configuration(std::function<void(EGLDisplay, EGLConfig)> const& to);
 private:
     int const drm_fd;
@@ -110,28 +118,49 @@ public:
     void make_current() override;
     void release_current() override;
     void swap_buffers() override;
+    void swap_buffers_with_damage(geometry::Rectangles const& damage) override;
+    auto buffer_age() const -> int override;
     bool overlay(RenderableList const& renderlist) override;
+    auto overlay_topmost(RenderableList const& renderlist) -> RenderableList override;
     void bind() override;
 
     void for_each_display_buffer(
         std::function<void(graphics::DisplayBuffer&)> const& f) override;
     void post() override;
     std::chrono::milliseconds recommended_sleep() const override;
+    bool needs_recomposite() const override;
 
     glm::mat2 transformation() const override;
     NativeDisplayBuffer* native_display_buffer() override;
+    auto last_presentation() const -> std::optional<FramePresentation> override;
 
     void set_transformation(glm::mat2 const& t, geometry::Rectangle const& a);
     void schedule_set_crtc();
     void wait_for_page_flip();
 
+    /// Whether this drives exactly the given outputs, in any order
+    bool drives(std::vector<std::shared_ptr<KMSOutput>> const& outputs) const;
+
 private:
     bool schedule_page_flip(FBHandle const& bufobj);
+    bool schedule_async_page_flip(FBHandle const& bufobj);
     void set_crtc(FBHandle const&);
+    auto assign_overlay_planes(RenderableList const& renderlist) -> RenderableList::const_reverse_iterator;
+    void clear_overlay_planes();
 
     std::shared_ptr<graphics::Buffer> visible_bypass_frame, scheduled_bypass_frame;
     std::shared_ptr<Buffer> bypass_buf{nullptr};
     std::shared_ptr<FBHandle const> bypass_bufobj{nullptr};
+    // Whether the client of bypass_buf would rather it were shown sooner than without tearing
+    bool bypass_tearing{false};
+
+    // Shown on the overlay planes by the next post(), bottom to top
+    std::vector<OverlayLayer> overlay_layers;
+    std::vector<std::shared_ptr<Buffer>> overlay_bufs;
+    std::vector<std::shared_ptr<Buffer>> visible_overlay_bufs, scheduled_overlay_bufs;
+    // Set once the hardware turns down overlay planes that passed their test
+    bool overlay_planes_failed{false};
+    bool recomposite_needed{false};
     std::shared_ptr<DisplayReport> const listener;
     BypassOption bypass_option;
 
@@ -156,7 +185,20 @@ private:
     glm::mat2 transform;
     std::atomic<bool> needs_set_crtc;
     std::chrono::milliseconds recommend_sleep{0};
+
+    // When the frame being composited was started (by overlay()), if it has been
+    std::optional<std::chrono::steady_clock::time_point> frame_started;
+    RenderTimeEstimator composited_render_time;
+    RenderTimeEstimator bypass_render_time;
+    // If the compositor starts the next frame by this time, it should make the refresh after the last
+    struct Deadline
+    {
+        std::chrono::steady_clock::time_point start_by;
+        int64_t target_msc;
+    };
+    std::optional<Deadline> next_frame_deadline;
     bool page_flips_pending;
+    std::optional<FramePresentation> last_presentation_;
 };
 
 }
@@ -21,6 +21,8 @@
 #include <boost/throw_exception.hpp>
 #include <gbm.h>
 
+#include <cstring>
+
 #define MIR_LOG_COMPONENT "EGL"
 #include "mir/log.h"
 
@@ -32,7 +34,13 @@ mgmh::EGLHelper::EGLHelper(GLConfig const& gl_config)
       stencil_buffer_bits{gl_config.stencil_buffer_bits()},
       egl_display{EGL_NO_DISPLAY}, egl_config{0},
       egl_context{EGL_NO_CONTEXT}, egl_surface{EGL_NO_SURFACE},
-      should_terminate_egl{false}
+      should_terminate_egl{false},
+      has_buffer_age{false},
+      swap_buffers_with_damage_fn{nullptr},
+      create_sync_fn{nullptr},
+      destroy_sync_fn{nullptr},
+      client_wait_sync_fn{nullptr},
+      rendering_fence{EGL_NO_SYNC_KHR}
 {
 }
 
@@ -54,12 +62,19 @@ mgmh::EGLHelper::EGLHelper(EGLHelper&& from)
       egl_config{from.egl_config},
       egl_context{from.egl_context},
       egl_surface{from.egl_surface},
-      should_terminate_egl{from.should_terminate_egl}
+      should_terminate_egl{from.should_terminate_egl},
+      has_buffer_age{from.has_buffer_age},
+      swap_buffers_with_damage_fn{from.swap_buffers_with_damage_fn},
+      create_sync_fn{from.create_sync_fn},
+      destroy_sync_fn{from.destroy_sync_fn},
+      client_wait_sync_fn{from.client_wait_sync_fn},
+      rendering_fence{from.rendering_fence}
 {
     from.should_terminate_egl = false;
     from.egl_display = EGL_NO_DISPLAY;
     from.egl_context = EGL_NO_CONTEXT;
     from.egl_surface = EGL_NO_SURFACE;
+    from.rendering_fence = EGL_NO_SYNC_KHR;
 }
 
 namespace
@@ -102,6 +117,22 @@ std::vector<EGLConfig> get_matching_configs(EGLDisplay dpy, EGLint const attr[])
     return matching_configs;
 }
 
+bool has_extension(EGLDisplay dpy, char const* extension)
+{
+    auto const extensions = eglQueryString(dpy, EGL_EXTENSIONS);
+    if (!extensions)
+        return false;
+
+    auto const length = strlen(extension);
+    for (auto found = strstr(extensions, extension); found; found = strstr(found + length, extension))
+    {
+        // Make sure we've not matched a prefix of some longer extension name
+        if ((found == extensions || found[-1] == ' ') && (found[length] == '\0' || found[length] == ' '))
+            return true;
+    }
+    return false;
+}
+
 }
 
 void mgmh::EGLHelper::setup(GBMHelper const& gbm)
@@ -189,11 +220,37 @@ void mgmh::EGLHelper::setup(
     egl_context = eglCreateContext(egl_display, egl_config, shared_context, context_attr);
     if (egl_context == EGL_NO_CONTEXT)
         BOOST_THROW_EXCEPTION(mg::egl_error("Failed to create EGL context"));
+
+    // EGL_KHR_partial_update provides the same (identically valued) query as EGL_EXT_buffer_age
+    has_buffer_age =
+        has_extension(egl_display, "EGL_EXT_buffer_age") ||
+        has_extension(egl_display, "EGL_KHR_partial_update");
+
+    if (has_extension(egl_display, "EGL_KHR_swap_buffers_with_damage"))
+    {
+        swap_buffers_with_damage_fn = reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+            eglGetProcAddress("eglSwapBuffersWithDamageKHR"));
+    }
+    else if (has_extension(egl_display, "EGL_EXT_swap_buffers_with_damage"))
+    {
+        // The EXT and KHR entrypoints have identical signatures
+        swap_buffers_with_damage_fn = reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+            eglGetProcAddress("eglSwapBuffersWithDamageEXT"));
+    }
+
+    if (has_extension(egl_display, "EGL_KHR_fence_sync"))
+    {
+        create_sync_fn = reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(eglGetProcAddress("eglCreateSyncKHR"));
+        destroy_sync_fn = reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(eglGetProcAddress("eglDestroySyncKHR"));
+        client_wait_sync_fn = reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(eglGetProcAddress("eglClientWaitSyncKHR"));
+    }
 }
 
 mgmh::EGLHelper::~EGLHelper() noexcept
 {
     if (egl_display != EGL_NO_DISPLAY) {
+        if (rendering_fence != EGL_NO_SYNC_KHR)
+            destroy_sync_fn(egl_display, rendering_fence);
         if (egl_context != EGL_NO_CONTEXT)
         {
             eglBindAPI(EGL_OPENGL_ES_API);
@@ -210,10 +267,55 @@ mgmh::EGLHelper::~EGLHelper() noexcept
 
 bool mgmh::EGLHelper::swap_buffers()
 {
+    fence_rendering();
     auto ret = eglSwapBuffers(egl_display, egl_surface);
     return (ret == EGL_TRUE);
 }
 
+bool mgmh::EGLHelper::swap_buffers_with_damage(EGLint* rects, EGLint n_rects)
+{
+    if (!swap_buffers_with_damage_fn)
+        return swap_buffers();
+
+    fence_rendering();
+    auto ret = swap_buffers_with_damage_fn(egl_display, egl_surface, rects, n_rects);
+    return (ret == EGL_TRUE);
+}
+
+void mgmh::EGLHelper::fence_rendering()
+{
+    if (!create_sync_fn)
+        return;
+
+    if (rendering_fence != EGL_NO_SYNC_KHR)
+        destroy_sync_fn(egl_display, rendering_fence);
+
+    // The swap that follows flushes the fence along with the rendering
+    rendering_fence = create_sync_fn(egl_display, EGL_SYNC_FENCE_KHR, nullptr);
+}
+
+void mgmh::EGLHelper::wait_for_rendering()
+{
+    if (rendering_fence == EGL_NO_SYNC_KHR)
+        return;
+
+    client_wait_sync_fn(egl_display, rendering_fence, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, EGL_FOREVER_KHR);
+    destroy_sync_fn(egl_display, rendering_fence);
+    rendering_fence = EGL_NO_SYNC_KHR;
+}
+
+auto mgmh::EGLHelper::buffer_age() const -> int
+{
+    if (!has_buffer_age)
+        return 0;
+
+    EGLint age;
+    if (eglQuerySurface(egl_display, egl_surface, EGL_BUFFER_AGE_EXT, &age) == EGL_FALSE)
+        return 0;
+
+    return age;
+}
+
 bool mgmh::EGLHelper::make_current() const
 {
     auto ret = eglMakeCurrent(egl_display, egl_surface, egl_surface, egl_context);
@@ -21,6 +21,7 @@
 #include "mir/graphics/egl_extensions.h"
 #include <stdexcept>
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 
 namespace mir
 {
@@ -52,6 +53,33 @@ public:
     void setup(GBMHelper const& gbm, gbm_surface* surface_gbm, uint32_t gbm_format, EGLContext shared_context, bool owns_egl);
 
     bool swap_buffers();
+    /**
+     * Swap buffers, telling EGL only the listed rects have changed.
+     *
+     * \param [in] rects   EGL-style {x, y, width, height} quadruples, relative
+     *                      to the bottom-left of the surface
+     * \param [in] n_rects The number of quadruples in rects
+     *
+     * Falls back to a plain swap_buffers() if the driver does not support
+     * EGL_{KHR,EXT}_swap_buffers_with_damage.
+     */
+    bool swap_buffers_with_damage(EGLint* rects, EGLint n_rects);
+    /**
+     * The age of the current back buffer, as per EGL_EXT_buffer_age.
+     *
+     * \return The number of frames since the back buffer was last swapped,
+     *         or 0 if its contents are unknown (including when the driver
+     *         does not support buffer age).
+     */
+    auto buffer_age() const -> int;
+
+    /**
+     * Wait for the GPU to finish the rendering submitted before the last swap.
+     *
+     * Does nothing if the driver does not support EGL_KHR_fence_sync, or if
+     * the rendering has already been waited for.
+     */
+    void wait_for_rendering();
     bool make_current() const;
     bool release_current() const;
 
@@ -77,6 +105,15 @@ private:
     EGLSurface egl_surface;
     bool should_terminate_egl;
     EGLExtensions::PlatformBaseEXT platform_base;
+    bool has_buffer_age;
+    PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC swap_buffers_with_damage_fn;
+
+    void fence_rendering();
+
+    PFNEGLCREATESYNCKHRPROC create_sync_fn;
+    PFNEGLDESTROYSYNCKHRPROC destroy_sync_fn;
+    PFNEGLCLIENTWAITSYNCKHRPROC client_wait_sync_fn;
+    EGLSyncKHR rendering_fence;
 };
 }
 }
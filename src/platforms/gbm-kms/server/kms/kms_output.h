@@ -29,6 +29,10 @@
 
 #include <gbm.h>
 
+#include <chrono>
+#include <memory>
+#include <vector>
+
 namespace mir
 {
 namespace graphics
@@ -40,6 +44,16 @@ namespace gbm
 
 class FBHandle;
 
+/**
+ * A framebuffer to show, unscaled, on an overlay plane
+ */
+struct OverlayLayer
+{
+    std::shared_ptr<FBHandle const> fb;
+    geometry::Size size;            ///< Of the framebuffer
+    geometry::Point top_left;       ///< Relative to the top-left of the output
+};
+
 class KMSOutput
 {
 public:
@@ -63,11 +77,47 @@ public:
      */
     virtual int max_refresh_rate() const = 0;
 
+    /**
+     * The exact time between refreshes of the current mode, calculated from its
+     * timings rather than the rounded refresh rate; zero if there is no mode.
+     */
+    virtual auto refresh_interval() const -> std::chrono::nanoseconds = 0;
+
     virtual bool set_crtc(FBHandle const& fb) = 0;
     virtual void clear_crtc() = 0;
     virtual bool schedule_page_flip(FBHandle const& fb) = 0;
+
+    /**
+     * As schedule_page_flip(), but without waiting for the vertical blank, so
+     * fb is shown sooner but may tear.
+     *
+     * \return false if the output can't do that now (e.g. the driver doesn't
+     *         support it, or overlay planes are in use), in which case nothing
+     *         has been scheduled.
+     */
+    virtual bool schedule_async_page_flip(FBHandle const& fb) = 0;
     virtual void wait_for_page_flip() = 0;
 
+    /**
+     * The number of overlay planes available to schedule_page_flip_with_overlays()
+     *
+     * This is zero unless the driver supports atomic modesetting.
+     */
+    virtual auto overlay_plane_count() const -> size_t = 0;
+
+    /**
+     * Check (without changing anything on screen) whether the hardware can
+     * show fb on the primary plane with the overlays (bottom to top) above it.
+     */
+    virtual bool test_overlays(FBHandle const& fb, std::vector<OverlayLayer> const& overlays) = 0;
+
+    /**
+     * As schedule_page_flip(), but also replaces what is shown on the overlay
+     * planes with overlays (bottom to top), atomically. Overlay planes that
+     * aren't needed are disabled.
+     */
+    virtual bool schedule_page_flip_with_overlays(FBHandle const& fb, std::vector<OverlayLayer> const& overlays) = 0;
+
     virtual bool set_cursor(gbm_bo* buffer) = 0;
     virtual void move_cursor(geometry::Point destination) = 0;
     virtual bool clear_cursor() = 0;
@@ -75,6 +125,22 @@ public:
 
     virtual void set_power_mode(MirPowerMode mode) = 0;
     virtual void set_gamma(GammaCurves const& gamma) = 0;
+
+    /**
+     * Enable or disable variable refresh (VRR, aka adaptive sync) on this output.
+     *
+     * Requests to enable it are ignored unless both the monitor and the
+     * driver support it.
+     */
+    virtual void set_vrr_enabled(bool enabled) = 0;
+
+    /**
+     * Whether variable refresh is in effect, so the output refreshes as soon
+     * as a page flip is scheduled (up to max_refresh_rate()) rather than at a
+     * fixed rate.
+     */
+    virtual bool vrr_enabled() const = 0;
+
     virtual Frame last_frame() const = 0;
 
     /**
@@ -62,6 +62,23 @@ mgg::KMSPageFlipper::KMSPageFlipper(
 bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
                                         uint32_t fb_id,
                                         uint32_t connector_id)
+{
+    return schedule_legacy_flip(crtc_id, fb_id, connector_id, DRM_MODE_PAGE_FLIP_EVENT);
+}
+
+bool mgg::KMSPageFlipper::schedule_async_flip(uint32_t crtc_id,
+                                              uint32_t fb_id,
+                                              uint32_t connector_id)
+{
+    // The completion event still arrives, as soon as the new buffer is being scanned out
+    return schedule_legacy_flip(crtc_id, fb_id, connector_id, DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_PAGE_FLIP_ASYNC);
+}
+
+bool mgg::KMSPageFlipper::schedule_legacy_flip(
+    uint32_t crtc_id,
+    uint32_t fb_id,
+    uint32_t connector_id,
+    uint32_t flags)
 {
     std::unique_lock lock{pf_mutex};
 
@@ -77,7 +94,7 @@ bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
      * apparently valid.
      */
     auto ret = drmModePageFlip(drm_fd, crtc_id, fb_id,
-                               DRM_MODE_PAGE_FLIP_EVENT,
+                               flags,
                                &pending_page_flips[crtc_id]);
 
     if (ret)
@@ -86,6 +103,29 @@ bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
     return (ret == 0);
 }
 
+bool mgg::KMSPageFlipper::schedule_atomic_flip(
+    uint32_t crtc_id,
+    drmModeAtomicReq* request,
+    uint32_t connector_id)
+{
+    std::unique_lock lock{pf_mutex};
+
+    if (pending_page_flips.find(crtc_id) != pending_page_flips.end())
+        BOOST_THROW_EXCEPTION(std::logic_error("Page flip for crtc_id is already scheduled"));
+
+    pending_page_flips[crtc_id] = PageFlipEventData{crtc_id, connector_id, this};
+
+    // The completion event is delivered to page_flip_handler() just like a legacy flip's
+    auto ret = drmModeAtomicCommit(drm_fd, request,
+                                   DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK,
+                                   &pending_page_flips[crtc_id]);
+
+    if (ret)
+        pending_page_flips.erase(crtc_id);
+
+    return (ret == 0);
+}
+
 mg::Frame mgg::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
 {
     drmEventContext evctx;
@@ -51,12 +51,15 @@ public:
     KMSPageFlipper(int drm_fd, std::shared_ptr<DisplayReport> const& report);
 
     bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) override;
+    bool schedule_async_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) override;
+    bool schedule_atomic_flip(uint32_t crtc_id, drmModeAtomicReq* request, uint32_t connector_id) override;
     Frame wait_for_flip(uint32_t crtc_id) override;
 
     std::thread::id debug_get_worker_tid();
 
     void notify_page_flip(uint32_t crtc_id, int64_t msc, std::chrono::nanoseconds ust);
 private:
+    bool schedule_legacy_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id, uint32_t flags);
     bool page_flip_is_done(uint32_t crtc_id);
 
     int const drm_fd;
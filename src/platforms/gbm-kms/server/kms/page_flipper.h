@@ -19,6 +19,7 @@
 
 #include "mir/graphics/frame.h"
 #include <cstdint>
+#include <xf86drmMode.h>
 
 namespace mir
 {
@@ -33,6 +34,10 @@ public:
     virtual ~PageFlipper() {}
 
     virtual bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
+    /// As schedule_flip(), but the flip happens as soon as possible rather than at the next vblank, so may tear
+    virtual bool schedule_async_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
+    /// As schedule_flip(), but commits an atomic request (which updates the CRTC's planes) instead
+    virtual bool schedule_atomic_flip(uint32_t crtc_id, drmModeAtomicReq* request, uint32_t connector_id) = 0;
     virtual Frame wait_for_flip(uint32_t crtc_id) = 0;
 
 protected:
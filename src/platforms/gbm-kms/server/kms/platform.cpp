@@ -48,16 +48,33 @@ mgg::Platform::Platform(std::shared_ptr<DisplayReport> const& listener,
 {
 }
 
+namespace
+{
+/// The KMS device of the first gbm-kms display platform, if there is one
+auto kms_drm_fd_of(std::vector<std::shared_ptr<mg::DisplayPlatform>> const& displays) -> mir::Fd
+{
+    for (auto const& display : displays)
+    {
+        if (auto const platform = std::dynamic_pointer_cast<mgg::Platform>(display))
+        {
+            return platform->drm.front()->fd;
+        }
+    }
+    return mir::Fd{};
+}
+}
+
 mgg::RenderingPlatform::RenderingPlatform(
     mir::udev::Device const&,
-    std::vector<std::shared_ptr<mg::DisplayPlatform>> const&)
+    std::vector<std::shared_ptr<mg::DisplayPlatform>> const& displays)
+    : kms_drm_fd{kms_drm_fd_of(displays)}
 {
 }
 
 mir::UniqueModulePtr<mg::GraphicBufferAllocator> mgg::RenderingPlatform::create_buffer_allocator(
     mg::Display const& output)
 {
-    return make_module_ptr<mgg::BufferAllocator>(output);
+    return make_module_ptr<mgg::BufferAllocator>(output, kms_drm_fd);
 }
 
 mir::UniqueModulePtr<mg::Display> mgg::Platform::create_display(
@@ -66,6 +66,9 @@ public:
 
     auto create_buffer_allocator(
         graphics::Display const& output) -> UniqueModulePtr<graphics::GraphicBufferAllocator> override;
+
+private:
+    mir::Fd const kms_drm_fd;
 };
 
 }
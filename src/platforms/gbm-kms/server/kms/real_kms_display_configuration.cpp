@@ -62,6 +62,19 @@ mgg::RealKMSDisplayConfiguration& mgg::RealKMSDisplayConfiguration::operator=(
     return *this;
 }
 
+mgg::RealKMSDisplayConfiguration& mgg::RealKMSDisplayConfiguration::operator=(
+    RealKMSDisplayConfiguration&& conf) noexcept
+{
+    if (&conf != this)
+    {
+        displays = std::move(conf.displays);
+        card = conf.card;
+        outputs = std::move(conf.outputs);
+    }
+
+    return *this;
+}
+
 void mgg::RealKMSDisplayConfiguration::for_each_output(
     std::function<void(DisplayConfigurationOutput const&)> f) const
 {
@@ -39,6 +39,7 @@ public:
     RealKMSDisplayConfiguration(std::shared_ptr<KMSOutputContainer> const& displays);
     RealKMSDisplayConfiguration(RealKMSDisplayConfiguration const& conf);
     RealKMSDisplayConfiguration& operator=(RealKMSDisplayConfiguration const& conf);
+    RealKMSDisplayConfiguration& operator=(RealKMSDisplayConfiguration&& conf) noexcept;
 
     void for_each_output(std::function<void(DisplayConfigurationOutput const&)> f) const override;
     void for_each_output(std::function<void(UserDisplayConfigurationOutput&)> f) override;
@@ -23,6 +23,7 @@
 #include <string.h> // strcmp
 
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 #include <system_error>
 #include <xf86drm.h>
 
@@ -56,19 +57,34 @@ private:
 };
 
 
+namespace
+{
+bool supports_async_page_flips(int drm_fd)
+{
+    uint64_t supported{0};
+    return drmGetCap(drm_fd, DRM_CAP_ASYNC_PAGE_FLIP, &supported) == 0 && supported;
+}
+}
+
 mgg::RealKMSOutput::RealKMSOutput(
     int drm_fd,
     kms::DRMModeConnectorUPtr&& connector,
-    std::shared_ptr<PageFlipper> const& page_flipper)
+    std::shared_ptr<PageFlipper> const& page_flipper,
+    bool atomic_modesetting)
     : drm_fd_{drm_fd},
       page_flipper{page_flipper},
       connector{std::move(connector)},
       mode_index{0},
       current_crtc(),
+      planes_crtc_id{0},
+      overlays_in_use{0},
       saved_crtc(),
       using_saved_crtc{true},
       has_cursor_{false},
-      power_mode(mir_power_mode_on)
+      async_flips_supported{supports_async_page_flips(drm_fd)},
+      atomic_modesetting{atomic_modesetting},
+      power_mode(mir_power_mode_on),
+      vrr_enabled_{false}
 {
     reset();
 
@@ -146,6 +162,28 @@ int mgg::RealKMSOutput::max_refresh_rate() const
     return current_mode.vrefresh;
 }
 
+auto mgg::RealKMSOutput::refresh_interval() const -> std::chrono::nanoseconds
+{
+    if (connector->connection == DRM_MODE_DISCONNECTED || !connector->modes)
+        return std::chrono::nanoseconds::zero();
+
+    drmModeModeInfo const& current_mode = connector->modes[mode_index];
+    if (current_mode.clock == 0)
+        return std::chrono::nanoseconds::zero();
+
+    // The pixel clock is in kHz
+    int64_t scanlines = current_mode.vtotal;
+    if (current_mode.flags & DRM_MODE_FLAG_DBLSCAN)
+        scanlines *= 2;
+    if (current_mode.vscan > 1)
+        scanlines *= current_mode.vscan;
+    auto interval = int64_t{current_mode.htotal} * scanlines * 1000000 / current_mode.clock;
+    if (current_mode.flags & DRM_MODE_FLAG_INTERLACE)
+        interval /= 2;
+
+    return std::chrono::nanoseconds{interval};
+}
+
 void mgg::RealKMSOutput::configure(geom::Displacement offset, size_t kms_mode_index)
 {
     fb_offset = offset;
@@ -171,6 +209,9 @@ bool mgg::RealKMSOutput::set_crtc(FBHandle const& fb)
         return false;
     }
 
+    // The legacy API only knows about the primary plane
+    disable_overlays();
+
     using_saved_crtc = false;
     return true;
 }
@@ -192,6 +233,8 @@ void mgg::RealKMSOutput::clear_crtc()
         return;
     }
 
+    disable_overlays();
+
     auto result = drmModeSetCrtc(drm_fd_, current_crtc->crtc_id,
                                  0, 0, 0, nullptr, 0, nullptr);
     if (result)
@@ -231,12 +274,34 @@ bool mgg::RealKMSOutput::schedule_page_flip(FBHandle const& fb)
                        mgk::connector_name(connector).c_str());
         return false;
     }
+    if (overlays_in_use)
+    {
+        // A legacy flip would leave the overlays showing
+        lg.unlock();
+        return schedule_page_flip_with_overlays(fb, {});
+    }
     return page_flipper->schedule_flip(
         current_crtc->crtc_id,
         fb.get_drm_fb_id(),
         connector->connector_id);
 }
 
+bool mgg::RealKMSOutput::schedule_async_page_flip(FBHandle const& fb)
+{
+    std::unique_lock lg(power_mutex);
+    if (power_mode != mir_power_mode_on)
+        return true;
+
+    // A legacy flip would leave the overlays showing, and atomic commits can't be async
+    if (!async_flips_supported || !current_crtc || overlays_in_use)
+        return false;
+
+    return page_flipper->schedule_async_flip(
+        current_crtc->crtc_id,
+        fb.get_drm_fb_id(),
+        connector->connector_id);
+}
+
 void mgg::RealKMSOutput::wait_for_page_flip()
 {
     std::unique_lock lg(power_mutex);
@@ -251,6 +316,45 @@ void mgg::RealKMSOutput::wait_for_page_flip()
     last_frame_.store(page_flipper->wait_for_flip(current_crtc->crtc_id));
 }
 
+auto mgg::RealKMSOutput::overlay_plane_count() const -> size_t
+{
+    return overlay_planes.size();
+}
+
+bool mgg::RealKMSOutput::test_overlays(FBHandle const& fb, std::vector<OverlayLayer> const& overlays)
+{
+    auto const request = overlay_request(fb, overlays);
+    if (!request)
+        return false;
+
+    return drmModeAtomicCommit(drm_fd_, request.get(), DRM_MODE_ATOMIC_TEST_ONLY, nullptr) == 0;
+}
+
+bool mgg::RealKMSOutput::schedule_page_flip_with_overlays(
+    FBHandle const& fb,
+    std::vector<OverlayLayer> const& overlays)
+{
+    std::unique_lock lg(power_mutex);
+    if (power_mode != mir_power_mode_on)
+        return true;
+    if (!current_crtc)
+    {
+        mir::log_error("Output %s has no associated CRTC to schedule page flips on",
+                       mgk::connector_name(connector).c_str());
+        return false;
+    }
+
+    auto const request = overlay_request(fb, overlays);
+    if (!request)
+        return false;
+
+    if (!page_flipper->schedule_atomic_flip(current_crtc->crtc_id, request.get(), connector->connector_id))
+        return false;
+
+    overlays_in_use = overlays.size();
+    return true;
+}
+
 mg::Frame mgg::RealKMSOutput::last_frame() const
 {
     return last_frame_.load();
@@ -328,9 +432,188 @@ bool mgg::RealKMSOutput::ensure_crtc()
     connector = kms::get_connector(drm_fd_, connector->connector_id);
     current_crtc = mgk::find_crtc_for_connector(drm_fd_, connector);
 
+    if (current_crtc)
+        probe_planes();
+
     return (current_crtc != nullptr);
 }
 
+void mgg::RealKMSOutput::probe_planes()
+{
+    if (planes_crtc_id == current_crtc->crtc_id)
+        return;
+
+    disable_overlays();
+    planes_crtc_id = current_crtc->crtc_id;
+    primary_plane.reset();
+    overlay_planes.clear();
+
+    // Without atomic modesetting we can't drive overlay planes; everything goes through the primary
+    if (!atomic_modesetting)
+        return;
+
+    try
+    {
+        kms::DRMModeResources resources{drm_fd_};
+        int crtc_index{0};
+        for (auto& crtc : resources.crtcs())
+        {
+            if (crtc->crtc_id == current_crtc->crtc_id)
+                break;
+            ++crtc_index;
+        }
+        uint32_t const crtc_bit = 1u << crtc_index;
+
+        kms::PlaneResources plane_resources{drm_fd_};
+        for (auto& plane : plane_resources.planes())
+        {
+            if (!(plane->possible_crtcs & crtc_bit))
+                continue;
+
+            auto properties = std::make_unique<kms::ObjectProperties const>(drm_fd_, plane);
+            auto const type = (*properties)["type"];
+            if (type == DRM_PLANE_TYPE_PRIMARY && !primary_plane)
+            {
+                primary_plane = std::make_unique<Plane>(Plane{plane->plane_id, std::move(properties)});
+            }
+            else if (type == DRM_PLANE_TYPE_OVERLAY && !(plane->possible_crtcs & (crtc_bit - 1)))
+            {
+                /* Overlays that could be used with several CRTCs are only used by the
+                 * first of them, so outputs never contend for a plane.
+                 */
+                overlay_planes.push_back(Plane{plane->plane_id, std::move(properties)});
+            }
+        }
+    }
+    catch (std::exception const& error)
+    {
+        mir::log_info("Not using overlay planes for output %s: %s",
+                      mgk::connector_name(connector).c_str(), error.what());
+        primary_plane.reset();
+        overlay_planes.clear();
+    }
+
+    if (!primary_plane)
+    {
+        overlay_planes.clear();
+        return;
+    }
+
+    auto const zpos = [](Plane const& plane)
+        { return plane.properties->has_property("zpos") ? (*plane.properties)["zpos"] : 0; };
+
+    /* Some drivers stack "overlay" planes beneath the primary. We draw the layers
+     * over what's on the primary, so those planes are no use to us.
+     */
+    if (primary_plane->properties->has_property("zpos"))
+    {
+        auto const primary_zpos = zpos(*primary_plane);
+        std::erase_if(
+            overlay_planes,
+            [&](Plane const& plane)
+            {
+                return plane.properties->has_property("zpos") && zpos(plane) <= primary_zpos;
+            });
+    }
+
+    // We don't set zpos, so stack the layers in the order the driver stacks the planes
+    std::stable_sort(
+        overlay_planes.begin(),
+        overlay_planes.end(),
+        [&](Plane const& lhs, Plane const& rhs) { return zpos(lhs) < zpos(rhs); });
+}
+
+namespace
+{
+bool connector_is_vrr_capable(int drm_fd, uint32_t connector_id)
+{
+    mgk::ObjectProperties const connector_props{drm_fd, connector_id, DRM_MODE_OBJECT_CONNECTOR};
+
+    // Older kernels don't have the property at all
+    return connector_props.has_property("vrr_capable") && connector_props["vrr_capable"];
+}
+
+void add_plane_properties(
+    drmModeAtomicReq* request,
+    uint32_t plane_id,
+    mgk::ObjectProperties const& properties,
+    uint32_t crtc_id,
+    uint32_t fb_id,
+    geom::Point src_top_left,
+    geom::Rectangle const& dest)
+{
+    // Source coordinates are 16.16 fixed point
+    drmModeAtomicAddProperty(request, plane_id, properties.id_for("FB_ID"), fb_id);
+    drmModeAtomicAddProperty(request, plane_id, properties.id_for("CRTC_ID"), crtc_id);
+    drmModeAtomicAddProperty(request, plane_id, properties.id_for("SRC_X"), uint64_t(src_top_left.x.as_int()) << 16);
+    drmModeAtomicAddProperty(request, plane_id, properties.id_for("SRC_Y"), uint64_t(src_top_left.y.as_int()) << 16);
+    drmModeAtomicAddProperty(request, plane_id, properties.id_for("SRC_W"), uint64_t(dest.size.width.as_int()) << 16);
+    drmModeAtomicAddProperty(request, plane_id, properties.id_for("SRC_H"), uint64_t(dest.size.height.as_int()) << 16);
+    drmModeAtomicAddProperty(request, plane_id, properties.id_for("CRTC_X"), dest.top_left.x.as_int());
+    drmModeAtomicAddProperty(request, plane_id, properties.id_for("CRTC_Y"), dest.top_left.y.as_int());
+    drmModeAtomicAddProperty(request, plane_id, properties.id_for("CRTC_W"), dest.size.width.as_int());
+    drmModeAtomicAddProperty(request, plane_id, properties.id_for("CRTC_H"), dest.size.height.as_int());
+}
+}
+
+auto mgg::RealKMSOutput::overlay_request(FBHandle const& fb, std::vector<OverlayLayer> const& overlays) const
+    -> AtomicRequestUPtr
+{
+    AtomicRequestUPtr request{nullptr, &drmModeAtomicFree};
+
+    if (!current_crtc || !primary_plane || overlays.size() > overlay_planes.size())
+        return request;
+
+    request.reset(drmModeAtomicAlloc());
+    if (!request)
+        return request;
+
+    auto const crtc_id = current_crtc->crtc_id;
+
+    add_plane_properties(
+        request.get(), primary_plane->id, *primary_plane->properties, crtc_id, fb.get_drm_fb_id(),
+        geom::Point{} + fb_offset, geom::Rectangle{{}, size()});
+
+    for (size_t i = 0; i != overlays.size(); ++i)
+    {
+        auto const& plane = overlay_planes[i];
+        auto const& overlay = overlays[i];
+        add_plane_properties(
+            request.get(), plane.id, *plane.properties, crtc_id, overlay.fb->get_drm_fb_id(),
+            geom::Point{}, geom::Rectangle{overlay.top_left, overlay.size});
+    }
+
+    for (auto i = overlays.size(); i < overlays_in_use; ++i)
+    {
+        auto const& plane = overlay_planes[i];
+        drmModeAtomicAddProperty(request.get(), plane.id, plane.properties->id_for("FB_ID"), 0);
+        drmModeAtomicAddProperty(request.get(), plane.id, plane.properties->id_for("CRTC_ID"), 0);
+    }
+
+    return request;
+}
+
+void mgg::RealKMSOutput::disable_overlays()
+{
+    if (!overlays_in_use)
+        return;
+
+    AtomicRequestUPtr const request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+    for (size_t i = 0; i != overlays_in_use; ++i)
+    {
+        auto const& plane = overlay_planes[i];
+        drmModeAtomicAddProperty(request.get(), plane.id, plane.properties->id_for("FB_ID"), 0);
+        drmModeAtomicAddProperty(request.get(), plane.id, plane.properties->id_for("CRTC_ID"), 0);
+    }
+
+    if (auto const result = drmModeAtomicCommit(drm_fd_, request.get(), 0, nullptr))
+    {
+        mir::log_warning("Failed to disable overlay planes of output %s: %s",
+                         mgk::connector_name(connector).c_str(), strerror(-result));
+    }
+    overlays_in_use = 0;
+}
+
 void mgg::RealKMSOutput::restore_saved_crtc()
 {
     if (!using_saved_crtc)
@@ -389,6 +672,60 @@ void mgg::RealKMSOutput::set_gamma(mg::GammaCurves const& gamma)
     // TODO: return bool in future? Then do what with it?
 }
 
+void mgg::RealKMSOutput::set_vrr_enabled(bool enabled)
+{
+    vrr_enabled_ = false;
+
+    if (!ensure_crtc())
+        return;
+
+    mgk::ObjectProperties const crtc_props{drm_fd_, current_crtc};
+    if (!crtc_props.has_property("VRR_ENABLED"))
+    {
+        if (enabled)
+            mir::log_info("Output %s: driver does not support variable refresh",
+                          mgk::connector_name(connector).c_str());
+        return;
+    }
+
+    /* The driver accepts VRR_ENABLED whether or not the monitor can follow it,
+     * so check first or we'd stop pacing frames for nothing.
+     */
+    if (enabled && !connector_is_vrr_capable(drm_fd_, connector->connector_id))
+    {
+        mir::log_info("Output %s: monitor does not support variable refresh",
+                      mgk::connector_name(connector).c_str());
+        enabled = false;
+    }
+
+    if (crtc_props["VRR_ENABLED"] != enabled)
+    {
+        // The property can only be set through the atomic API
+        int result = atomic_modesetting ? 0 : -EOPNOTSUPP;
+        if (!result)
+        {
+            AtomicRequestUPtr const request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+            drmModeAtomicAddProperty(request.get(), current_crtc->crtc_id, crtc_props.id_for("VRR_ENABLED"), enabled);
+            result = drmModeAtomicCommit(drm_fd_, request.get(), DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr);
+        }
+
+        if (result)
+        {
+            mir::log_warning("Failed to %s variable refresh on output %s: %s",
+                             enabled ? "enable" : "disable",
+                             mgk::connector_name(connector).c_str(), strerror(-result));
+            return;
+        }
+    }
+
+    vrr_enabled_ = enabled;
+}
+
+bool mgg::RealKMSOutput::vrr_enabled() const
+{
+    return vrr_enabled_;
+}
+
 void mgg::RealKMSOutput::refresh_hardware_state()
 {
     connector = kms::get_connector(drm_fd_, connector->connector_id);
@@ -554,11 +891,13 @@ void mgg::RealKMSOutput::update_from_hardware_state(
                                         mir_pixel_format_xrgb_8888};
 
     std::vector<uint8_t> edid;
+    bool vrr_capable{false};
     if (connected) {
         /* Only ask for the EDID on connected outputs. There's obviously no monitor EDID
          * when there is no monitor connected!
          */
         edid = edid_for_connector(drm_fd_, connector->connector_id);
+        vrr_capable = connector_is_vrr_capable(drm_fd_, connector->connector_id);
     }
 
     drmModeModeInfo current_mode_info = drmModeModeInfo();
@@ -615,6 +954,7 @@ void mgg::RealKMSOutput::update_from_hardware_state(
     output.subpixel_arrangement = kms_subpixel_to_mir_subpixel(connector->subpixel);
     output.gamma = gamma;
     output.edid = edid;
+    output.vrr_capable = vrr_capable;
 }
 
 namespace
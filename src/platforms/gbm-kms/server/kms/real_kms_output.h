@@ -21,8 +21,10 @@
 #include "kms_output.h"
 #include "kms-utils/drm_mode_resources.h"
 
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 namespace mir
 {
@@ -39,7 +41,8 @@ public:
     RealKMSOutput(
         int drm_fd,
         kms::DRMModeConnectorUPtr&& connector,
-        std::shared_ptr<PageFlipper> const& page_flipper);
+        std::shared_ptr<PageFlipper> const& page_flipper,
+        bool atomic_modesetting);
     ~RealKMSOutput();
 
     uint32_t id() const override;
@@ -48,12 +51,18 @@ public:
     void configure(geometry::Displacement fb_offset, size_t kms_mode_index) override;
     geometry::Size size() const override;
     int max_refresh_rate() const override;
+    auto refresh_interval() const -> std::chrono::nanoseconds override;
 
     bool set_crtc(FBHandle const& fb) override;
     void clear_crtc() override;
     bool schedule_page_flip(FBHandle const& fb) override;
+    bool schedule_async_page_flip(FBHandle const& fb) override;
     void wait_for_page_flip() override;
 
+    auto overlay_plane_count() const -> size_t override;
+    bool test_overlays(FBHandle const& fb, std::vector<OverlayLayer> const& overlays) override;
+    bool schedule_page_flip_with_overlays(FBHandle const& fb, std::vector<OverlayLayer> const& overlays) override;
+
     bool set_cursor(gbm_bo* buffer) override;
     void move_cursor(geometry::Point destination) override;
     bool clear_cursor() override;
@@ -61,6 +70,8 @@ public:
 
     void set_power_mode(MirPowerMode mode) override;
     void set_gamma(GammaCurves const& gamma) override;
+    void set_vrr_enabled(bool enabled) override;
+    bool vrr_enabled() const override;
 
     Frame last_frame() const override;
 
@@ -77,6 +88,18 @@ private:
     bool ensure_crtc();
     void restore_saved_crtc();
 
+    /// A plane that can be used with current_crtc, and the properties needed to drive it
+    struct Plane
+    {
+        uint32_t id;
+        std::unique_ptr<kms::ObjectProperties const> properties;
+    };
+    using AtomicRequestUPtr = std::unique_ptr<drmModeAtomicReq, void(*)(drmModeAtomicReq*)>;
+
+    void probe_planes();
+    auto overlay_request(FBHandle const& fb, std::vector<OverlayLayer> const& overlays) const -> AtomicRequestUPtr;
+    void disable_overlays();
+
     int const drm_fd_;
     std::shared_ptr<PageFlipper> const page_flipper;
 
@@ -99,13 +122,21 @@ private:
     size_t mode_index;
     geometry::Displacement fb_offset;
     kms::DRMModeCrtcUPtr current_crtc;
+    uint32_t planes_crtc_id;                ///< The CRTC that primary_plane & overlay_planes belong to
+    std::unique_ptr<Plane> primary_plane;
+    std::vector<Plane> overlay_planes;      ///< Bottom to top
+    size_t overlays_in_use;
     drmModeCrtc saved_crtc;
     bool using_saved_crtc;
     bool has_cursor_;
+    bool const async_flips_supported;
+    bool const atomic_modesetting;      ///< Enabled on drm_fd_ when the device was opened
 
     MirPowerMode power_mode;
     int dpms_enum_id;
 
+    std::atomic<bool> vrr_enabled_;     ///< Read by the compositor thread
+
     std::mutex power_mutex;
 
     AtomicFrame last_frame_;
@@ -17,14 +17,15 @@
 #include <algorithm>
 #include "real_kms_output_container.h"
 #include "real_kms_output.h"
+#include "display_helpers.h"
 #include "kms-utils/drm_mode_resources.h"
 
 namespace mgg = mir::graphics::gbm;
 
 mgg::RealKMSOutputContainer::RealKMSOutputContainer(
-    std::vector<int> const& drm_fds,
+    std::vector<std::shared_ptr<helpers::DRMHelper>> const& drm,
     std::function<std::shared_ptr<PageFlipper>(int)> const& construct_page_flipper)
-    : drm_fds{drm_fds},
+    : drm{drm},
       construct_page_flipper{construct_page_flipper}
 {
 }
@@ -42,8 +43,9 @@ void mgg::RealKMSOutputContainer::update_from_hardware_state()
     // TODO: Accumulate errors and present them all.
     std::exception_ptr last_error;
 
-    for (auto drm_fd : drm_fds)
+    for (auto const& device : drm)
     {
+        int const drm_fd = device->fd;
         std::unique_ptr<kms::DRMModeResources> resources;
         try
         {
@@ -83,7 +85,8 @@ void mgg::RealKMSOutputContainer::update_from_hardware_state()
                 new_outputs.push_back(std::make_shared<RealKMSOutput>(
                     drm_fd,
                     std::move(connector),
-                    construct_page_flipper(drm_fd)));
+                    construct_page_flipper(drm_fd),
+                    device->atomic_modesetting));
             }
         }
 
@@ -28,19 +28,23 @@ namespace gbm
 {
 
 class PageFlipper;
+namespace helpers
+{
+class DRMHelper;
+}
 
 class RealKMSOutputContainer : public KMSOutputContainer
 {
 public:
     RealKMSOutputContainer(
-        std::vector<int> const& drm_fds,
+        std::vector<std::shared_ptr<helpers::DRMHelper>> const& drm,
         std::function<std::shared_ptr<PageFlipper>(int drm_fd)> const& construct_page_flipper);
 
     void for_each_output(std::function<void(std::shared_ptr<KMSOutput> const&)> functor) const override;
 
     void update_from_hardware_state() override;
 private:
-    std::vector<int> const drm_fds;
+    std::vector<std::shared_ptr<helpers::DRMHelper>> const drm;
     std::vector<std::shared_ptr<KMSOutput>> outputs;
     std::function<std::shared_ptr<PageFlipper>(int drm_fd)> const construct_page_flipper;
 };
@@ -0,0 +1,77 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "render_time_estimator.h"
+
+#include <algorithm>
+
+namespace mgg = mir::graphics::gbm;
+
+using namespace std::chrono_literals;
+
+namespace
+{
+auto constexpr min_margin = std::chrono::nanoseconds{1ms};
+auto constexpr max_margin = std::chrono::nanoseconds{8ms};
+}
+
+mgg::RenderTimeEstimator::RenderTimeEstimator(Duration initial_estimate)
+    : initial_estimate{initial_estimate},
+      margin{min_margin},
+      current_estimate{initial_estimate}
+{
+}
+
+void mgg::RenderTimeEstimator::frame_rendered(Duration render_time)
+{
+    samples[next_sample] = render_time;
+    next_sample = (next_sample + 1) % window;
+    sample_count = std::min(sample_count + 1, window);
+
+    // Frames are making their refresh, so slowly win back the time the margin costs
+    margin = std::max(min_margin, margin - margin / 32);
+
+    update_estimate();
+}
+
+void mgg::RenderTimeEstimator::deadline_missed()
+{
+    margin = std::min(max_margin, margin * 2);
+
+    update_estimate();
+}
+
+auto mgg::RenderTimeEstimator::estimate() const -> Duration
+{
+    return current_estimate;
+}
+
+void mgg::RenderTimeEstimator::update_estimate()
+{
+    if (sample_count < warm_up)
+    {
+        current_estimate = initial_estimate;
+        return;
+    }
+
+    // The 95th percentile: an occasional slow frame shouldn't cost every frame latency, but a regular one should
+    auto sorted = samples;
+    auto const end = sorted.begin() + sample_count;
+    auto const percentile = sorted.begin() + (sample_count * 95 + 99) / 100 - 1;
+    std::nth_element(sorted.begin(), percentile, end);
+
+    current_estimate = *percentile + margin;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_RENDER_TIME_ESTIMATOR_H_
+#define MIR_GRAPHICS_GBM_RENDER_TIME_ESTIMATOR_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+namespace mir
+{
+namespace graphics
+{
+namespace gbm
+{
+
+/**
+ * Predicts how long the next frame will take to be ready to flip, from how long recent frames took
+ *
+ * The estimate is a high percentile of the recent render times plus a safety
+ * margin. The margin doubles whenever a frame started on the estimate's
+ * schedule still misses its refresh, and shrinks back slowly while frames
+ * make it. Until enough frames have been measured the initial estimate is used.
+ */
+class RenderTimeEstimator
+{
+public:
+    using Duration = std::chrono::nanoseconds;
+
+    explicit RenderTimeEstimator(Duration initial_estimate);
+
+    /// Add the time from a frame starting to be composited to it being ready to flip
+    void frame_rendered(Duration render_time);
+
+    /// Note that a frame started the estimate ahead of its refresh did not make it
+    void deadline_missed();
+
+    auto estimate() const -> Duration;
+
+private:
+    static std::size_t constexpr window{64};
+    static std::size_t constexpr warm_up{8};
+
+    void update_estimate();
+
+    Duration const initial_estimate;
+    std::array<Duration, window> samples{};
+    std::size_t sample_count{0};
+    std::size_t next_sample{0};
+    Duration margin;
+    Duration current_estimate;
+};
+
+}
+}
+}
+
+#endif // MIR_GRAPHICS_GBM_RENDER_TIME_ESTIMATOR_H_
@@ -18,9 +18,17 @@
 #include "mir/renderer/gl/context.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/graphics/egl_error.h"
+#include "mir/graphics/dmabuf_buffer.h"
+#include "mir/geometry/rectangles.h"
 
 #include <boost/throw_exception.hpp>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES2/gl2ext.h>
+#include <GLES3/gl3.h>
+
+#include <algorithm>
+#include <cstring>
 
 namespace mg = mir::graphics;
 namespace mrg = mir::renderer::gl;
@@ -32,6 +40,8 @@ mrg::BasicBufferRenderTarget::Framebuffer::Framebuffer(geometry::Size const& siz
     glGenRenderbuffers(1, &colour_buffer);
     glGenFramebuffers(1, &fbo);
 
+    pixels.resize(size.width.as_int() * size.height.as_int() * 4);
+
     glBindRenderbuffer(GL_RENDERBUFFER, colour_buffer);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8_OES, size.width.as_int(), size.height.as_int());
 
@@ -81,26 +91,42 @@ mrg::BasicBufferRenderTarget::Framebuffer::~Framebuffer()
     glDeleteRenderbuffers(1, &colour_buffer);
 }
 
-void mrg::BasicBufferRenderTarget::Framebuffer::copy_to(software::WriteMappableBuffer& buffer)
+void mrg::BasicBufferRenderTarget::Framebuffer::copy_to(software::WriteMappableBuffer& buffer) const
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
     auto mapping = buffer.map_writeable();
-    if (mapping->size() != size)
-    {
-        BOOST_THROW_EXCEPTION(std::logic_error("given size does not match buffer size"));
-    }
-    if (mapping->stride() != geometry::Stride{size.width.as_int() * 4})
-    {
-        BOOST_THROW_EXCEPTION(std::logic_error("invalid buffer stride " + std::to_string(mapping->stride().as_int())));
-    }
-    if (mapping->format() != mir_pixel_format_argb_8888)
+    auto const row_size = size.width.as_int() * 4;
+
+    switch (mapping->format())
     {
-        BOOST_THROW_EXCEPTION(std::logic_error("invalid pixel format " + std::to_string(mapping->format())));
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888:
+        if (mapping->stride() == geometry::Stride{row_size})
+        {
+            std::memcpy(mapping->data(), pixels.data(), pixels.size());
+            return;
+        }
+
+        for (auto row = 0; row != size.height.as_int(); ++row)
+        {
+            std::memcpy(mapping->data() + row * mapping->stride().as_int(), pixels.data() + row * row_size, row_size);
+        }
+        break;
+
+    default:
+        // We read back BGRA bytes, so the other formats we accept just have red and blue swapped
+        for (auto row = 0; row != size.height.as_int(); ++row)
+        {
+            auto const source = pixels.data() + row * row_size;
+            auto const destination = mapping->data() + row * mapping->stride().as_int();
+            for (auto i = 0; i != row_size; i += 4)
+            {
+                destination[i] = source[i + 2];
+                destination[i + 1] = source[i + 1];
+                destination[i + 2] = source[i];
+                destination[i + 3] = source[i + 3];
+            }
+        }
     }
-    glReadPixels(
-        0, 0,
-        size.width.as_int(), size.height.as_int(),
-        GL_BGRA_EXT, GL_UNSIGNED_BYTE, mapping->data());
 }
 
 void mrg::BasicBufferRenderTarget::Framebuffer::bind()
@@ -108,25 +134,349 @@ void mrg::BasicBufferRenderTarget::Framebuffer::bind()
     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
 }
 
+/**
+ * Two GLES 3 pixel pack buffers to read frames back into
+ *
+ * glReadPixels() into a pixel pack buffer returns without waiting for the
+ * GPU, so the copy out of it can wait until the next frame is being rendered.
+ */
+class mrg::BasicBufferRenderTarget::PixelPackBuffers
+{
+public:
+    /// \note This must be called with a current context
+    static auto load() -> std::unique_ptr<PixelPackBuffers>
+    {
+        // Pixel pack buffers and fences are core in GLES 3, which reports its version as "OpenGL ES 3.x ..."
+        auto const version = reinterpret_cast<char const*>(glGetString(GL_VERSION));
+        if (!version || strncmp(version, "OpenGL ES ", 10) != 0 || version[10] < '3')
+        {
+            return nullptr;
+        }
+
+        auto result = std::make_unique<PixelPackBuffers>();
+        result->glMapBufferRange = reinterpret_cast<PFNGLMAPBUFFERRANGEPROC>(eglGetProcAddress("glMapBufferRange"));
+        result->glUnmapBuffer = reinterpret_cast<PFNGLUNMAPBUFFERPROC>(eglGetProcAddress("glUnmapBuffer"));
+        result->glFenceSync = reinterpret_cast<PFNGLFENCESYNCPROC>(eglGetProcAddress("glFenceSync"));
+        result->glClientWaitSync = reinterpret_cast<PFNGLCLIENTWAITSYNCPROC>(eglGetProcAddress("glClientWaitSync"));
+        result->glDeleteSync = reinterpret_cast<PFNGLDELETESYNCPROC>(eglGetProcAddress("glDeleteSync"));
+        if (!result->glMapBufferRange || !result->glUnmapBuffer ||
+            !result->glFenceSync || !result->glClientWaitSync || !result->glDeleteSync)
+        {
+            return nullptr;
+        }
+
+        glGenBuffers(buffer_count, result->ids);
+        return result;
+    }
+
+    ~PixelPackBuffers()
+    {
+        for (auto const fence : fences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+        }
+        glDeleteBuffers(buffer_count, ids);
+    }
+
+    /// \return the buffer read into, or nullopt if both are waiting to be copied out of
+    auto read(GLint x, GLint y, GLsizei width, GLsizei height) -> std::optional<int>
+    {
+        auto const index = std::find(std::begin(fences), std::end(fences), nullptr) - std::begin(fences);
+        if (index == buffer_count)
+        {
+            return std::nullopt;
+        }
+
+        GLsizeiptr const length = width * height * 4;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, ids[index]);
+        if (capacity[index] < length)
+        {
+            glBufferData(GL_PIXEL_PACK_BUFFER, length, nullptr, GL_STREAM_READ);
+            capacity[index] = length;
+        }
+        glReadPixels(x, y, width, height, GL_BGRA_EXT, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        return index;
+    }
+
+    /// Waits for the read into buffer index, and copies it out into pixels at (x, y)
+    void copy_out(int index, GLint x, GLint y, GLsizei width, GLsizei height, Framebuffer& framebuffer)
+    {
+        // One second is far longer than any frame, so the GPU has hung
+        auto const status = glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000);
+        glDeleteSync(fences[index]);
+        fences[index] = nullptr;
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error("timed out waiting for frame read back"));
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, ids[index]);
+        auto const mapped = static_cast<unsigned char const*>(
+            glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, width * height * 4, GL_MAP_READ_BIT));
+        if (mapped)
+        {
+            copy_rows(mapped, x, y, width, height, framebuffer);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (!mapped)
+        {
+            BOOST_THROW_EXCEPTION(mg::gl_error("failed to map pixel pack buffer"));
+        }
+    }
+
+    static void copy_rows(
+        unsigned char const* source,
+        GLint x, GLint y, GLsizei width, GLsizei height,
+        Framebuffer& framebuffer)
+    {
+        auto const stride = framebuffer.size.width.as_int() * 4;
+        for (auto row = 0; row != height; ++row)
+        {
+            std::memcpy(
+                framebuffer.pixels.data() + (y + row) * stride + x * 4,
+                source + row * width * 4,
+                width * 4);
+        }
+    }
+
+private:
+    static int const buffer_count{2};
+
+    PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
+    PFNGLUNMAPBUFFERPROC glUnmapBuffer;
+    PFNGLFENCESYNCPROC glFenceSync;
+    PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+    PFNGLDELETESYNCPROC glDeleteSync;
+
+    GLuint ids[buffer_count]{};
+    GLsizeiptr capacity[buffer_count]{};
+    GLsync fences[buffer_count]{};
+};
+
+/// A dmabuf imported as an EGLImage, and rendered into through a framebuffer object
+class mrg::BasicBufferRenderTarget::DMABufFramebuffer
+{
+public:
+    /// \note This must be called with a current context
+    DMABufFramebuffer(std::shared_ptr<mg::DMABufBuffer> const& buffer)
+        : buffer{buffer},
+          size{buffer->size()},
+          dpy{eglGetCurrentDisplay()},
+          eglCreateImageKHR{reinterpret_cast<PFNEGLCREATEIMAGEKHRPROC>(eglGetProcAddress("eglCreateImageKHR"))},
+          eglDestroyImageKHR{reinterpret_cast<PFNEGLDESTROYIMAGEKHRPROC>(eglGetProcAddress("eglDestroyImageKHR"))}
+    {
+        auto const glEGLImageTargetRenderbufferStorageOES =
+            reinterpret_cast<PFNGLEGLIMAGETARGETRENDERBUFFERSTORAGEOESPROC>(
+                eglGetProcAddress("glEGLImageTargetRenderbufferStorageOES"));
+        if (!eglCreateImageKHR || !eglDestroyImageKHR || !glEGLImageTargetRenderbufferStorageOES)
+        {
+            BOOST_THROW_EXCEPTION((std::runtime_error{"EGL implementation can't render into dmabufs"}));
+        }
+
+        image = eglCreateImageKHR(dpy, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, nullptr, attributes().data());
+        if (image == EGL_NO_IMAGE_KHR)
+        {
+            BOOST_THROW_EXCEPTION((mg::egl_error("Failed to import dmabuf to render into")));
+        }
+
+        glGenRenderbuffers(1, &colour_buffer);
+        glGenFramebuffers(1, &fbo);
+
+        glBindRenderbuffer(GL_RENDERBUFFER, colour_buffer);
+        glEGLImageTargetRenderbufferStorageOES(GL_RENDERBUFFER, image);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colour_buffer);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            destroy();
+            BOOST_THROW_EXCEPTION((std::runtime_error{"dmabuf format can't be rendered into"}));
+        }
+
+        glViewport(0, 0, size.width.as_int(), size.height.as_int());
+    }
+
+    ~DMABufFramebuffer()
+    {
+        destroy();
+    }
+
+    void bind()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    }
+
+    std::shared_ptr<mg::DMABufBuffer> const buffer;
+    geometry::Size const size;
+
+private:
+    DMABufFramebuffer(DMABufFramebuffer const&) = delete;
+    DMABufFramebuffer& operator=(DMABufFramebuffer const&) = delete;
+
+    auto attributes() const -> std::vector<EGLint>
+    {
+        struct PlaneAttributes
+        {
+            EGLint fd, offset, pitch, modifier_lo, modifier_hi;
+        };
+        static PlaneAttributes const plane_attributes[] = {
+            {EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT, EGL_DMA_BUF_PLANE0_PITCH_EXT,
+                EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT},
+            {EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT, EGL_DMA_BUF_PLANE1_PITCH_EXT,
+                EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT},
+            {EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT, EGL_DMA_BUF_PLANE2_PITCH_EXT,
+                EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT},
+            {EGL_DMA_BUF_PLANE3_FD_EXT, EGL_DMA_BUF_PLANE3_OFFSET_EXT, EGL_DMA_BUF_PLANE3_PITCH_EXT,
+                EGL_DMA_BUF_PLANE3_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE3_MODIFIER_HI_EXT}};
+        // DRM_FORMAT_MOD_INVALID, which means the modifier is implicit
+        uint64_t const invalid_modifier{0x00ffffffffffffffULL};
+
+        auto const& planes = buffer->planes();
+        if (planes.empty() || planes.size() > std::size(plane_attributes))
+        {
+            BOOST_THROW_EXCEPTION((std::runtime_error{"unsupported number of dmabuf planes"}));
+        }
+
+        std::vector<EGLint> attributes{
+            EGL_WIDTH, size.width.as_int(),
+            EGL_HEIGHT, size.height.as_int(),
+            EGL_LINUX_DRM_FOURCC_EXT, static_cast<EGLint>(buffer->drm_fourcc())};
+        auto const modifier = buffer->modifier();
+        for (auto i = 0u; i != planes.size(); ++i)
+        {
+            attributes.insert(attributes.end(), {
+                plane_attributes[i].fd, static_cast<int>(planes[i].dma_buf),
+                plane_attributes[i].offset, static_cast<EGLint>(planes[i].offset),
+                plane_attributes[i].pitch, static_cast<EGLint>(planes[i].stride)});
+            if (modifier && *modifier != invalid_modifier)
+            {
+                attributes.insert(attributes.end(), {
+                    plane_attributes[i].modifier_lo, static_cast<EGLint>(*modifier & 0xffffffff),
+                    plane_attributes[i].modifier_hi, static_cast<EGLint>(*modifier >> 32)});
+            }
+        }
+        attributes.push_back(EGL_NONE);
+        return attributes;
+    }
+
+    void destroy()
+    {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &colour_buffer);
+        eglDestroyImageKHR(dpy, image);
+    }
+
+    EGLDisplay const dpy;
+    PFNEGLCREATEIMAGEKHRPROC const eglCreateImageKHR;
+    PFNEGLDESTROYIMAGEKHRPROC const eglDestroyImageKHR;
+    EGLImageKHR image{EGL_NO_IMAGE_KHR};
+    GLuint colour_buffer{0};
+    GLuint fbo{0};
+};
+
 mrg::BasicBufferRenderTarget::BasicBufferRenderTarget(std::shared_ptr<Context> const& ctx)
     : ctx{ctx}
 {
 }
 
+mrg::BasicBufferRenderTarget::~BasicBufferRenderTarget() = default;
+
 void mrg::BasicBufferRenderTarget::set_buffer(std::shared_ptr<software::WriteMappableBuffer> const& buffer)
 {
+    if (buffer->stride().as_int() < buffer->size().width.as_int() * 4)
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error("invalid buffer stride " + std::to_string(buffer->stride().as_int())));
+    }
+    switch (buffer->format())
+    {
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888:
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888:
+        break;
+
+    default:
+        BOOST_THROW_EXCEPTION(std::logic_error("invalid pixel format " + std::to_string(buffer->format())));
+    }
+
     this->buffer = buffer;
+    auto const was_rendering_to_dmabuf = dmabuf_framebuffer != nullptr;
+    dmabuf_framebuffer.reset();
     if (framebuffer && framebuffer->size == buffer->size())
     {
+        if (was_rendering_to_dmabuf)
+        {
+            glViewport(0, 0, framebuffer->size.width.as_int(), framebuffer->size.height.as_int());
+        }
         return;
     }
+
+    // Copies still in flight need the frames they were read back from
+    for (auto& copy : copies)
+    {
+        complete(copy);
+    }
     framebuffer.reset();
     framebuffer.emplace(buffer->size());
 }
 
+void mrg::BasicBufferRenderTarget::set_dmabuf(std::shared_ptr<mg::DMABufBuffer> const& buffer)
+{
+    dmabuf_framebuffer = std::make_shared<DMABufFramebuffer>(buffer);
+    this->buffer = nullptr;
+}
+
+void mrg::BasicBufferRenderTarget::finish_copy()
+{
+    if (copies.empty())
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error("finish_copy() called with no copy in flight"));
+    }
+
+    auto copy = std::move(copies.front());
+    copies.pop_front();
+    complete(copy);
+}
+
+void mrg::BasicBufferRenderTarget::complete(Copy& copy)
+{
+    if (copy.done)
+    {
+        return;
+    }
+    copy.done = true;
+
+    if (copy.dmabuf)
+    {
+        glFinish();
+        return;
+    }
+
+    if (copy.pixel_pack_buffer)
+    {
+        pixel_pack_buffers->copy_out(*copy.pixel_pack_buffer, copy.x, copy.y, copy.width, copy.height, *framebuffer);
+    }
+    else
+    {
+        PixelPackBuffers::copy_rows(copy.pixels.data(), copy.x, copy.y, copy.width, copy.height, *framebuffer);
+    }
+
+    // We don't know what is already in the buffer, so it gets the whole frame
+    framebuffer->copy_to(*copy.buffer);
+}
+
 auto mrg::BasicBufferRenderTarget::size() const -> geometry::Size
 {
-    if (framebuffer)
+    if (dmabuf_framebuffer)
+    {
+        return dmabuf_framebuffer->size;
+    }
+    else if (framebuffer)
     {
         return framebuffer.value().size;
     }
@@ -148,15 +498,90 @@ void mrg::BasicBufferRenderTarget::release_current()
 
 void mrg::BasicBufferRenderTarget::swap_buffers()
 {
+    if (dmabuf_framebuffer)
+    {
+        copies.push_back(Copy{nullptr, 0, 0, 0, 0, std::nullopt, {}, dmabuf_framebuffer});
+        return;
+    }
+    if (!framebuffer || !buffer)
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error("swap_buffers() called when buffer unset"));
+    }
+    start_copy(0, 0, framebuffer->size.width.as_int(), framebuffer->size.height.as_int());
+}
+
+void mrg::BasicBufferRenderTarget::swap_buffers_with_damage(geometry::Rectangles const& damage)
+{
+    if (dmabuf_framebuffer)
+    {
+        swap_buffers();
+        return;
+    }
     if (!framebuffer || !buffer)
     {
         BOOST_THROW_EXCEPTION(std::logic_error("swap_buffers() called when buffer unset"));
     }
-    framebuffer->copy_to(*buffer);
+    if (!framebuffer->has_frame)
+    {
+        swap_buffers();
+        return;
+    }
+
+    auto const height = framebuffer->size.height.as_int();
+    auto const area = intersection_of(damage.bounding_rectangle(), geometry::Rectangle{{}, framebuffer->size});
+
+    // Damage is relative to the top-left, but GL rows count up from the bottom
+    start_copy(
+        area.left().as_int(),
+        height - area.bottom().as_int(),
+        area.size.width.as_int(),
+        area.size.height.as_int());
+}
+
+auto mrg::BasicBufferRenderTarget::buffer_age() const -> int
+{
+    return !dmabuf_framebuffer && framebuffer && framebuffer->has_frame ? 1 : 0;
+}
+
+void mrg::BasicBufferRenderTarget::start_copy(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    framebuffer->bind();
+    framebuffer->has_frame = true;
+
+    if (!pixel_pack_buffers_probed)
+    {
+        pixel_pack_buffers = PixelPackBuffers::load();
+        pixel_pack_buffers_probed = true;
+    }
+
+    Copy copy{buffer, x, y, width, height, std::nullopt, {}, nullptr};
+    if (pixel_pack_buffers)
+    {
+        copy.pixel_pack_buffer = pixel_pack_buffers->read(x, y, width, height);
+
+        // Both pixel pack buffers are still waiting for older copies, so complete those first
+        for (auto i = copies.begin(); !copy.pixel_pack_buffer && i != copies.end(); ++i)
+        {
+            complete(*i);
+            copy.pixel_pack_buffer = pixel_pack_buffers->read(x, y, width, height);
+        }
+    }
+
+    if (!copy.pixel_pack_buffer)
+    {
+        copy.pixels.resize(width * height * 4);
+        glReadPixels(x, y, width, height, GL_BGRA_EXT, GL_UNSIGNED_BYTE, copy.pixels.data());
+    }
+    copies.push_back(std::move(copy));
 }
 
 void mrg::BasicBufferRenderTarget::bind()
 {
+    if (dmabuf_framebuffer)
+    {
+        dmabuf_framebuffer->bind();
+        return;
+    }
     if (!framebuffer)
     {
         BOOST_THROW_EXCEPTION(std::logic_error("bind() called without framebuffer"));
@@ -34,8 +34,10 @@
 #include <EGL/egl.h>
 
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 #include <stdexcept>
 #include <cmath>
+#include <cstddef>
 #include <sstream>
 #include <mutex>
 
@@ -76,8 +78,21 @@ void mrg::CurrentRenderTarget::swap_buffers()
     render_target->swap_buffers();
 }
 
+void mrg::CurrentRenderTarget::swap_buffers_with_damage(geom::Rectangles const& damage)
+{
+    render_target->swap_buffers_with_damage(damage);
+}
+
+auto mrg::CurrentRenderTarget::buffer_age() const -> int
+{
+    return render_target->buffer_age();
+}
+
 namespace
 {
+/// How many frames of damage we keep to repair old back buffers with
+size_t const max_tracked_buffer_age{4};
+
 template<void (* deleter)(GLuint)>
 class GLHandle
 {
@@ -361,6 +376,8 @@ mrg::Renderer::Renderer(RenderTarget& render_target)
 mrg::Renderer::~Renderer()
 {
     render_target.ensure_current();
+    if (vertex_buffer)
+        glDeleteBuffers(1, &vertex_buffer);
 }
 
 void mrg::Renderer::tessellate(std::vector<mgl::Primitive>& primitives,
@@ -374,47 +391,161 @@ void mrg::Renderer::render(mg::RenderableList const& renderables) const
 {
     render_target.bind();
 
+    auto const redraw = area_to_redraw();
+    next_frame_damage.reset();
+
+    if (redraw)
+    {
+        damage_scissor = redraw->bounding_rectangle();
+        glEnable(GL_SCISSOR_TEST);
+        set_scissor(*damage_scissor);
+    }
+
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
     glClear(GL_COLOR_BUFFER_BIT);
 
     ++frameno;
-    for (auto const& r : renderables)
+    upload_vertices(renderables);
+    for (auto const& pending : pending_draws)
     {
-        draw(*r);
+        draw(*pending.renderable);
     }
+    finish_drawing();
 
-    render_target.swap_buffers();
+    if (redraw)
+    {
+        glDisable(GL_SCISSOR_TEST);
+        damage_scissor.reset();
+
+        geom::Rectangles buffer_damage;
+        for (auto const& rect : *redraw)
+            buffer_damage.add({rect.top_left - as_displacement(viewport.top_left), rect.size});
+        render_target.swap_buffers_with_damage(buffer_damage);
+    }
+    else
+    {
+        render_target.swap_buffers();
+    }
 
     while (auto const gl_error = glGetError())
         mir::log_debug("GL error: %d", gl_error);
 }
 
-void mrg::Renderer::draw(mg::Renderable const& renderable) const
+auto mrg::Renderer::is_drawn(mg::Renderable const& renderable) const -> bool
 {
-    auto const clip_area = renderable.clip_area();
-    if (clip_area)
+    // Renderables outside the damage can't change anything
+    // (unless transformed, as then they needn't be where they say)
+    return !damage_scissor ||
+        renderable.screen_position().overlaps(*damage_scissor) ||
+        renderable.transformation() != glm::mat4{1};
+}
+
+void mrg::Renderer::upload_vertices(mg::RenderableList const& renderables) const
+{
+    // These keep their capacity, so steady-state frames don't allocate
+    frame_vertices.clear();
+    frame_primitives.clear();
+    pending_draws.clear();
+    next_draw = 0;
+
+    for (auto const& renderable : renderables)
     {
-        glEnable(GL_SCISSOR_TEST);
-        glScissor(
-            clip_area.value().top_left.x.as_int() -
-                viewport.top_left.x.as_int(),
-            viewport.top_left.y.as_int() +
-                viewport.size.height.as_int() -
-                clip_area.value().top_left.y.as_int() -
-                clip_area.value().size.height.as_int(),
-            clip_area.value().size.width.as_int(), 
-            clip_area.value().size.height.as_int()
-        );
+        if (!is_drawn(*renderable))
+            continue;
+
+        primitives.clear();
+        tessellate(primitives, *renderable);
+
+        pending_draws.push_back({renderable.get(), frame_primitives.size(), primitives.size()});
+        for (auto const& p : primitives)
+        {
+            frame_primitives.push_back({p.type, static_cast<GLint>(frame_vertices.size()), p.nvertices});
+            frame_vertices.insert(frame_vertices.end(), p.vertices, p.vertices + p.nvertices);
+        }
     }
 
+    if (!vertex_buffer)
+        glGenBuffers(1, &vertex_buffer);
+
+    // One upload for the whole frame, rather than client-side arrays read at every draw
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glBufferData(
+        GL_ARRAY_BUFFER,
+        frame_vertices.size() * sizeof(mgl::Vertex),
+        frame_vertices.data(),
+        GL_STREAM_DRAW);
+
+    // GL state may have been changed since the last frame by anyone sharing the context
+    current_program = nullptr;
+    current_blend.reset();
+}
+
+void mrg::Renderer::use_program(Program const& prog, mgl::Vertex const* vertices) const
+{
+    if (current_program == &prog && current_vertices == vertices)
+        return;
+
+    if (current_program)
+    {
+        glDisableVertexAttribArray(current_program->texcoord_attr);
+        glDisableVertexAttribArray(current_program->position_attr);
+    }
+
+    if (current_program != &prog)
+        glUseProgram(prog.id);
+
+    // With vertex_buffer bound, vertices is an offset into it; otherwise it's a client-side array
+    glEnableVertexAttribArray(prog.position_attr);
+    glEnableVertexAttribArray(prog.texcoord_attr);
+    auto const address = reinterpret_cast<uintptr_t>(vertices);
+    glVertexAttribPointer(prog.position_attr, 3, GL_FLOAT,
+                          GL_FALSE, sizeof(mgl::Vertex),
+                          reinterpret_cast<GLvoid const*>(address + offsetof(mgl::Vertex, position)));
+    glVertexAttribPointer(prog.texcoord_attr, 2, GL_FLOAT,
+                          GL_FALSE, sizeof(mgl::Vertex),
+                          reinterpret_cast<GLvoid const*>(address + offsetof(mgl::Vertex, texcoord)));
+
+    current_program = &prog;
+    current_vertices = vertices;
+}
+
+void mrg::Renderer::finish_drawing() const
+{
+    if (current_program)
+    {
+        glDisableVertexAttribArray(current_program->texcoord_attr);
+        glDisableVertexAttribArray(current_program->position_attr);
+    }
+    current_program = nullptr;
+    current_vertices = nullptr;
+
+    // Be nice to other users of the GL context, who may expect client-side arrays
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void mrg::Renderer::draw(mg::Renderable const& renderable) const
+{
+    // Normally render() has uploaded our vertices, but a subclass might draw other renderables
+    bool const uploaded =
+        next_draw < pending_draws.size() && pending_draws[next_draw].renderable == &renderable;
+
     auto const texture = std::dynamic_pointer_cast<mg::gl::Texture>(renderable.buffer());
     if (!texture)
     {
         mir::log_error("Buffer does not support GL rendering!");
+        if (uploaded)
+            ++next_draw;
         return;
     }
 
+    auto const clip_area = renderable.clip_area();
+    if (clip_area)
+    {
+        glEnable(GL_SCISSOR_TEST);
+        set_scissor(damage_scissor ? intersection_of(*clip_area, *damage_scissor) : *clip_area);
+    }
+
     auto const& prog =
         [this, &texture](bool alpha) -> Program const&
         {
@@ -426,7 +557,18 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
                 return family.opaque;
         }(renderable.alpha() < 1.0f);
 
-    glUseProgram(prog.id);
+    if (uploaded)
+    {
+        use_program(prog, nullptr);
+    }
+    else
+    {
+        primitives.clear();
+        tessellate(primitives, renderable);
+        finish_drawing();
+        use_program(prog, primitives.empty() ? nullptr : primitives.front().vertices);
+    }
+
     if (prog.last_used_frameno != frameno)
     {   // Avoid reloading the screen-global uniforms on every renderable
         // TODO: We actually only need to bind these *once*, right? Not once per frame?
@@ -472,84 +614,143 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
     if (prog.alpha_uniform >= 0)
         glUniform1f(prog.alpha_uniform, renderable.alpha());
 
-    glEnableVertexAttribArray(prog.position_attr);
-    glEnableVertexAttribArray(prog.texcoord_attr);
-
-    primitives.clear();
-    tessellate(primitives, renderable);
-
     // if we fail to load the texture, we need to carry on (part of lp:1629275)
     try
     {
-        typedef struct  // Represents parameters of glBlendFuncSeparate()
-        {
-            GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
-        } BlendSeparate;
-
-        BlendSeparate client_blend;
+        BlendState blend;
 
         // These renderable method names could be better (see LP: #1236224)
         if (renderable.shaped())  // Client is RGBA:
         {
-            client_blend = {GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
-                            GL_ONE, GL_ONE_MINUS_SRC_ALPHA};
+            blend = {true,
+                     GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                     GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                     0.0f};
         }
         else if (renderable.alpha() == 1.0f)  // RGBX and no window translucency:
         {
-            client_blend = {GL_ONE,  GL_ZERO,
-                            GL_ZERO, GL_ONE};  // Avoid using src_alpha!
+            blend = {false,
+                     GL_ONE,  GL_ZERO,
+                     GL_ZERO, GL_ONE,  // Avoid using src_alpha!
+                     0.0f};
         }
         else
         {   // Client is RGBX but we also have window translucency.
             // The texture alpha channel is possibly uninitialized so we must be
             // careful and avoid using SRC_ALPHA (LP: #1423462).
-            client_blend = {GL_ONE,  GL_ONE_MINUS_CONSTANT_ALPHA,
-                            GL_ZERO, GL_ONE};
-            glBlendColor(0.0f, 0.0f, 0.0f, renderable.alpha());
+            blend = {true,
+                     GL_ONE,  GL_ONE_MINUS_CONSTANT_ALPHA,
+                     GL_ZERO, GL_ONE,
+                     renderable.alpha()};
         }
 
-        for (auto const& p : primitives)
+        if (blend != current_blend)
         {
-            BlendSeparate blend;
-
-            blend = client_blend;
-            texture->bind();
-
-            glVertexAttribPointer(prog.position_attr, 3, GL_FLOAT,
-                                  GL_FALSE, sizeof(mgl::Vertex),
-                                  &p.vertices[0].position);
-            glVertexAttribPointer(prog.texcoord_attr, 2, GL_FLOAT,
-                                  GL_FALSE, sizeof(mgl::Vertex),
-                                  &p.vertices[0].texcoord);
-
-            if (blend.dst_rgb == GL_ZERO)
+            if (!blend.enabled)
             {
                 glDisable(GL_BLEND);
             }
             else
             {
-                glEnable(GL_BLEND);
+                if (!current_blend || !current_blend->enabled)
+                    glEnable(GL_BLEND);
                 glBlendFuncSeparate(blend.src_rgb,   blend.dst_rgb,
                                     blend.src_alpha, blend.dst_alpha);
+                if (blend.dst_rgb == GL_ONE_MINUS_CONSTANT_ALPHA)
+                    glBlendColor(0.0f, 0.0f, 0.0f, blend.constant_alpha);
             }
+            current_blend = blend;
+        }
 
-            glDrawArrays(p.type, 0, p.nvertices);
+        texture->bind();
 
-            // We're done with the texture for now
-            texture->add_syncpoint();
+        if (uploaded)
+        {
+            auto const& pending = pending_draws[next_draw];
+            for (auto i = 0u; i != pending.primitive_count; ++i)
+            {
+                auto const& p = frame_primitives[pending.first_primitive + i];
+                glDrawArrays(p.type, p.first, p.count);
+            }
+        }
+        else
+        {
+            for (auto const& p : primitives)
+            {
+                // Every primitive has its own vertices
+                use_program(prog, p.vertices);
+                glDrawArrays(p.type, 0, p.nvertices);
+            }
         }
+
+        // We're done with the texture for now
+        texture->add_syncpoint();
     }
     catch (std::exception const& ex)
     {
         report_exception();
     }
 
-    glDisableVertexAttribArray(prog.texcoord_attr);
-    glDisableVertexAttribArray(prog.position_attr);
-    if (renderable.clip_area())
+    if (uploaded)
     {
-        glDisable(GL_SCISSOR_TEST);
+        ++next_draw;
+    }
+    else
+    {
+        // Other draws read from the frame's vertex buffer
+        finish_drawing();
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    }
+
+    if (clip_area)
+    {
+        if (damage_scissor)
+        {
+            set_scissor(*damage_scissor);
+        }
+        else
+        {
+            glDisable(GL_SCISSOR_TEST);
+        }
+    }
+}
+
+void mrg::Renderer::set_scissor(geom::Rectangle const& area) const
+{
+    if (viewport.size.width.as_int() <= 0 || viewport.size.height.as_int() <= 0)
+    {
+        glScissor(0, 0, 0, 0);
+        return;
     }
+
+    /*
+     * The scissor box is in render target pixels, so area has to go where the
+     * vertex shader puts it: through GL coordinates, the display transform
+     * (which rotates or flips them) and the (letterboxed) glViewport.
+     */
+    auto const to_target = [this](geom::Point const& p)
+        {
+            glm::vec4 const gl_coords{
+                2.0f * (p.x.as_int() - viewport.top_left.x.as_int()) / viewport.size.width.as_int() - 1.0f,
+                1.0f - 2.0f * (p.y.as_int() - viewport.top_left.y.as_int()) / viewport.size.height.as_int(),
+                0.0f,
+                1.0f};
+            auto const transformed = display_transform * gl_coords;
+            return glm::vec2{
+                gl_viewport.top_left.x.as_int() + (transformed.x + 1.0f) / 2.0f * gl_viewport.size.width.as_int(),
+                gl_viewport.top_left.y.as_int() + (transformed.y + 1.0f) / 2.0f * gl_viewport.size.height.as_int()};
+        };
+
+    auto const a = to_target(area.top_left);
+    auto const b = to_target(area.bottom_right());
+
+    // A pixel is drawn if its centre is inside, so round edges to the nearest pixel boundary
+    GLint const left = std::lround(std::min(a.x, b.x));
+    GLint const bottom = std::lround(std::min(a.y, b.y));
+    GLint const right = std::lround(std::max(a.x, b.x));
+    GLint const top = std::lround(std::max(a.y, b.y));
+
+    glScissor(left, bottom, right - left, top - bottom);
 }
 
 void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
@@ -593,6 +794,9 @@ void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
 
     viewport = rect;
     update_gl_viewport();
+
+    // Damage we've recorded is relative to the old viewport
+    damage_history.clear();
 }
 
 void mrg::Renderer::update_gl_viewport()
@@ -626,6 +830,7 @@ void mrg::Renderer::update_gl_viewport()
     GLint offset_x = (buf_width - reduced_width) / 2;
     GLint offset_y = (buf_height - reduced_height) / 2;
 
+    gl_viewport = {{offset_x, offset_y}, {reduced_width, reduced_height}};
     glViewport(offset_x, offset_y, reduced_width, reduced_height);
 }
 
@@ -636,7 +841,42 @@ void mrg::Renderer::set_output_transform(glm::mat2 const& t)
     {
         display_transform = new_display_transform;
         update_gl_viewport();
+        damage_history.clear();
+    }
+}
+
+void mrg::Renderer::set_damage(geom::Rectangles const& damage)
+{
+    next_frame_damage = damage;
+}
+
+auto mrg::Renderer::area_to_redraw() const -> std::optional<geom::Rectangles>
+{
+    damage_history.push_front(next_frame_damage ? *next_frame_damage : geom::Rectangles{viewport});
+    if (damage_history.size() > max_tracked_buffer_age)
+        damage_history.pop_back();
+
+    // Only try partial redraws when viewport pixels map 1:1 onto the render target
+    if (!next_frame_damage ||
+        display_transform != glm::mat4{1} ||
+        viewport.size != render_target.size())
+    {
+        return std::nullopt;
+    }
+
+    // The back buffer holds the frame from buffer_age frames ago, so needs the
+    // damage from each frame since then (including this one) redrawing.
+    auto const age = render_target.buffer_age();
+    if (age <= 0 || static_cast<size_t>(age) > damage_history.size())
+        return std::nullopt;
+
+    geom::Rectangles redraw;
+    for (auto i = 0; i != age; ++i)
+    {
+        for (auto const& rect : damage_history[i])
+            redraw.add(rect);
     }
+    return redraw;
 }
 
 void mrg::Renderer::suspend()
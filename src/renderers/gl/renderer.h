@@ -19,12 +19,15 @@
 
 #include <mir/renderer/renderer.h>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <mir/graphics/buffer_id.h>
 #include <mir/graphics/renderable.h>
 #include <mir/gl/primitive.h>
 #include "mir/renderer/gl/render_target.h"
 
 #include <GLES2/gl2.h>
+#include <deque>
+#include <optional>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -47,6 +50,8 @@ public:
     void ensure_current();
     void bind();
     void swap_buffers();
+    void swap_buffers_with_damage(geometry::Rectangles const& damage);
+    auto buffer_age() const -> int;
 
 private:
     renderer::gl::RenderTarget* const render_target;
@@ -62,6 +67,7 @@ public:
     // These are called with a valid GL context:
     void set_viewport(geometry::Rectangle const& rect) override;
     void set_output_transform(glm::mat2 const&) override;
+    void set_damage(geometry::Rectangles const& damage) override;
     void render(graphics::RenderableList const&) const override;
 
     // This is called _without_ a GL context:
@@ -117,13 +123,67 @@ protected:
 
 private:
     void update_gl_viewport();
+    /// Whether renderable can change anything this frame
+    auto is_drawn(graphics::Renderable const& renderable) const -> bool;
+    /// Tessellates the renderables to be drawn, uploading all their vertices at once
+    void upload_vertices(graphics::RenderableList const& renderables) const;
+    /// Makes prog current (if it isn't already), with its attributes reading the given vertices
+    void use_program(Program const& prog, mir::gl::Vertex const* vertices) const;
+    /// Resets the GL state draw() has changed this frame
+    void finish_drawing() const;
+    /// The part of the viewport to redraw this frame, or nullopt for everything
+    auto area_to_redraw() const -> std::optional<geometry::Rectangles>;
+    /// Scissor to area, given in the same coordinates as the viewport
+    /// (and mapped onto the render target as the display transform and scaling dictate)
+    void set_scissor(geometry::Rectangle const& area) const;
 
     class ProgramFactory;
     std::unique_ptr<ProgramFactory> const program_factory;
     geometry::Rectangle viewport;
     glm::mat4 screen_to_gl_coords;
     glm::mat4 display_transform;
+    /// Where the viewport ends up on the render target (as last given to glViewport)
+    geometry::Rectangle gl_viewport;
     std::vector<mir::gl::Primitive> mutable primitives;
+
+    /// Vertices of this frame's renderables, in the order they're drawn
+    std::vector<mir::gl::Vertex> mutable frame_vertices;
+    struct VertexRange
+    {
+        GLenum type;
+        GLint first;
+        GLsizei count;
+    };
+    std::vector<VertexRange> mutable frame_primitives;
+    /// The renderables render() is about to draw, and where their primitives are
+    struct PendingDraw
+    {
+        graphics::Renderable const* renderable;
+        size_t first_primitive;
+        size_t primitive_count;
+    };
+    std::vector<PendingDraw> mutable pending_draws;
+    size_t mutable next_draw{0};
+    GLuint mutable vertex_buffer{0};
+
+    /// What draw() last set this frame, so that it only changes what differs
+    struct BlendState
+    {
+        bool enabled;
+        GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
+        GLfloat constant_alpha;
+
+        auto operator==(BlendState const& other) const -> bool = default;
+    };
+    Program const mutable* current_program{nullptr};
+    mir::gl::Vertex const mutable* current_vertices{nullptr};
+    std::optional<BlendState> mutable current_blend;
+
+    std::optional<geometry::Rectangles> mutable next_frame_damage;
+    /// Damage of the frames most recently rendered, newest first
+    std::deque<geometry::Rectangles> mutable damage_history;
+    /// Set while rendering only part of the viewport
+    std::optional<geometry::Rectangle> mutable damage_scissor;
 };
 
 }
@@ -22,6 +22,7 @@
 #include "mir/compositor/scene.h"
 #include "mir/log.h"
 #include "mir/executor.h"
+#include "mir/geometry/rectangles.h"
 
 namespace mc = mir::compositor;
 namespace mr = mir::renderer;
@@ -42,9 +43,19 @@ mc::BasicScreenShooter::Self::Self(
 {
 }
 
-auto mc::BasicScreenShooter::Self::render(
-    std::shared_ptr<mrs::WriteMappableBuffer> const& buffer,
-    geom::Rectangle const& area) -> time::Timestamp
+mc::BasicScreenShooter::Self::~Self()
+{
+    for (auto const& capture : pending)
+    {
+        capture.callback(std::nullopt);
+    }
+}
+
+void mc::BasicScreenShooter::Self::render(
+    std::function<void(mrg::BufferRenderTarget&)> const& set_target,
+    geom::Rectangle const& area,
+    std::optional<geom::Rectangle> const& damage,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
 {
     std::lock_guard lock{mutex};
 
@@ -59,16 +70,55 @@ auto mc::BasicScreenShooter::Self::render(
     scene_elements.clear();
 
     render_target->make_current();
-    render_target->set_buffer(buffer);
+    set_target(*render_target);
 
     render_target->bind();
     renderer->set_viewport(area);
+    // The render target still holds the last frame, so if that was of this area only the damage has to be redrawn
+    if (damage && last_area == area)
+    {
+        renderer->set_damage(geom::Rectangles{*damage});
+    }
+    last_area.reset();
     renderer->render(renderable_list);
+    if (damage)
+    {
+        last_area = area;
+    }
 
     render_target->release_current();
     renderable_list.clear();
 
-    return captured_time;
+    pending.push_back({captured_time, std::move(callback)});
+}
+
+void mc::BasicScreenShooter::Self::finish()
+{
+    std::unique_lock lock{mutex};
+
+    auto const capture = std::move(pending.front());
+    pending.pop_front();
+
+    std::optional<time::Timestamp> result;
+    try
+    {
+        render_target->make_current();
+        render_target->finish_copy();
+        render_target->release_current();
+        result = capture.captured_time;
+    }
+    catch (...)
+    {
+        mir::log(
+            ::mir::logging::Severity::error,
+            "BasicScreenShooter",
+            std::current_exception(),
+            "failed to capture screen");
+    }
+
+    lock.unlock();
+    captures_in_flight--;
+    capture.callback(result);
 }
 
 mc::BasicScreenShooter::BasicScreenShooter(
@@ -87,15 +137,69 @@ void mc::BasicScreenShooter::capture(
     geom::Rectangle const& area,
     std::function<void(std::optional<time::Timestamp>)>&& callback)
 {
-    // TODO: use an atomic to keep track of number of in-flight captures, and error if it's too many
+    capture(buffer, area, area, std::move(callback));
+}
+
+void mc::BasicScreenShooter::capture(
+    std::shared_ptr<mrs::WriteMappableBuffer> const& buffer,
+    geom::Rectangle const& area,
+    geom::Rectangle const& damage,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    spawn_capture(
+        [buffer](mrg::BufferRenderTarget& render_target) { render_target.set_buffer(buffer); },
+        area,
+        damage,
+        std::move(callback));
+}
+
+void mc::BasicScreenShooter::capture(
+    std::shared_ptr<mg::DMABufBuffer> const& buffer,
+    geom::Rectangle const& area,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    spawn_capture(
+        [buffer](mrg::BufferRenderTarget& render_target) { render_target.set_dmabuf(buffer); },
+        area,
+        std::nullopt,
+        std::move(callback));
+}
 
-    executor.spawn([weak_self=std::weak_ptr<Self>{self}, buffer, area, callback=std::move(callback)]
+void mc::BasicScreenShooter::spawn_capture(
+    std::function<void(mrg::BufferRenderTarget&)>&& set_target,
+    geom::Rectangle const& area,
+    std::optional<geom::Rectangle> const& damage,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    if (self->captures_in_flight++ >= max_captures_in_flight)
+    {
+        self->captures_in_flight--;
+        log_warning("Failed to capture screen because %d captures are already in progress", max_captures_in_flight);
+        executor.spawn([callback=std::move(callback)]
+            {
+                callback(std::nullopt);
+            });
+        return;
+    }
+
+    executor.spawn(
+        [weak_self=std::weak_ptr<Self>{self}, &executor=executor, set_target=std::move(set_target), area, damage,
+            callback=std::move(callback)]() mutable
         {
             if (auto const self = weak_self.lock())
             {
                 try
                 {
-                    callback(self->render(buffer, area));
+                    self->render(set_target, area, damage, std::move(callback));
+
+                    // Copying the capture to the buffer can overlap rendering the next one
+                    executor.spawn([weak_self]
+                        {
+                            if (auto const self = weak_self.lock())
+                            {
+                                self->finish();
+                            }
+                        });
                     return;
                 }
                 catch (...)
@@ -106,6 +210,7 @@ void mc::BasicScreenShooter::capture(
                         std::current_exception(),
                         "failed to capture screen");
                 }
+                self->captures_in_flight--;
             }
 
             callback(std::nullopt);
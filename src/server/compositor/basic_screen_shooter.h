@@ -20,6 +20,8 @@
 #include "mir/compositor/screen_shooter.h"
 #include "mir/time/clock.h"
 
+#include <atomic>
+#include <deque>
 #include <mutex>
 
 namespace mir
@@ -52,6 +54,20 @@ public:
         geometry::Rectangle const& area,
         std::function<void(std::optional<time::Timestamp>)>&& callback) override;
 
+    void capture(
+        std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
+        geometry::Rectangle const& area,
+        geometry::Rectangle const& damage,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) override;
+
+    void capture(
+        std::shared_ptr<graphics::DMABufBuffer> const& buffer,
+        geometry::Rectangle const& area,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) override;
+
+    /// Captures requested while this many are still in progress fail
+    static int const max_captures_in_flight{4};
+
 private:
     struct Self
     {
@@ -60,17 +76,41 @@ private:
             std::shared_ptr<time::Clock> const& clock,
             std::unique_ptr<renderer::gl::BufferRenderTarget>&& render_target,
             std::unique_ptr<renderer::Renderer>&& renderer);
+        ~Self();
+
+        /// Renders the capture and starts copying it to the target. On success callback is taken to be called by
+        /// finish(). Without damage the render target's framebuffer isn't drawn to.
+        void render(
+            std::function<void(renderer::gl::BufferRenderTarget&)> const& set_target,
+            geometry::Rectangle const& area,
+            std::optional<geometry::Rectangle> const& damage,
+            std::function<void(std::optional<time::Timestamp>)>&& callback);
 
-        auto render(
-            std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
-            geometry::Rectangle const& area) -> time::Timestamp;
+        /// Completes the oldest capture rendered
+        void finish();
+
+        struct PendingCapture
+        {
+            time::Timestamp captured_time;
+            std::function<void(std::optional<time::Timestamp>)> callback;
+        };
 
         std::mutex mutex;
         std::shared_ptr<Scene> const scene;
         std::unique_ptr<renderer::gl::BufferRenderTarget> const render_target;
         std::unique_ptr<renderer::Renderer> const renderer;
         std::shared_ptr<time::Clock> const clock;
+        /// The area the render target holds the last frame of, if it holds a whole one
+        std::optional<geometry::Rectangle> last_area;
+        std::deque<PendingCapture> pending;
+        std::atomic<int> captures_in_flight{0};
     };
+    void spawn_capture(
+        std::function<void(renderer::gl::BufferRenderTarget&)>&& set_target,
+        geometry::Rectangle const& area,
+        std::optional<geometry::Rectangle> const& damage,
+        std::function<void(std::optional<time::Timestamp>)>&& callback);
+
     std::shared_ptr<Self> const self;
     Executor& executor;
 };
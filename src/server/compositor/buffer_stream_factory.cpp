@@ -26,7 +26,8 @@ namespace mg = mir::graphics;
 namespace ms = mir::scene;
 namespace mf = mir::frontend;
 
-mc::BufferStreamFactory::BufferStreamFactory()
+mc::BufferStreamFactory::BufferStreamFactory(std::shared_ptr<PresentationNotifier> const& presentation_notifier) :
+    presentation_notifier{presentation_notifier}
 {
 }
 
@@ -41,5 +42,5 @@ std::shared_ptr<mc::BufferStream> mc::BufferStreamFactory::create_buffer_stream(
     mg::BufferProperties const& buffer_properties)
 {
     return std::make_shared<mc::Stream>(
-        buffer_properties.size, buffer_properties.format);
+        buffer_properties.size, buffer_properties.format, presentation_notifier);
 }
@@ -29,11 +29,12 @@ class GraphicBufferAllocator;
 }
 namespace compositor
 {
+class PresentationNotifier;
 
 class BufferStreamFactory : public scene::BufferStreamFactory
 {
 public:
-    BufferStreamFactory();
+    explicit BufferStreamFactory(std::shared_ptr<PresentationNotifier> const& presentation_notifier);
 
     virtual ~BufferStreamFactory() {}
 
@@ -42,6 +43,9 @@ public:
         graphics::BufferProperties const& buffer_properties) override;
     virtual std::shared_ptr<BufferStream> create_buffer_stream(
         graphics::BufferProperties const&) override;
+
+private:
+    std::shared_ptr<PresentationNotifier> const presentation_notifier;
 };
 
 }
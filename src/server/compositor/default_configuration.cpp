@@ -20,6 +20,7 @@
 #include "buffer_stream_factory.h"
 #include "default_display_buffer_compositor_factory.h"
 #include "multi_threaded_compositor.h"
+#include "presentation_notifier.h"
 #include "gl/renderer_factory.h"
 #include "basic_screen_shooter.h"
 #include "null_screen_shooter.h"
@@ -42,9 +43,19 @@ std::shared_ptr<ms::BufferStreamFactory>
 mir::DefaultServerConfiguration::the_buffer_stream_factory()
 {
     return buffer_stream_factory(
+        [this]()
+        {
+            return std::make_shared<mc::BufferStreamFactory>(the_presentation_notifier());
+        });
+}
+
+std::shared_ptr<mc::PresentationNotifier>
+mir::DefaultServerConfiguration::the_presentation_notifier()
+{
+    return presentation_notifier(
         []()
         {
-            return std::make_shared<mc::BufferStreamFactory>();
+            return std::make_shared<mc::PresentationNotifier>();
         });
 }
 
@@ -80,6 +91,7 @@ mir::DefaultServerConfiguration::the_compositor()
                 the_scene(),
                 the_display_buffer_compositor_factory(),
                 the_shell(),
+                the_presentation_notifier(),
                 the_compositor_report(),
                 composite_delay,
                 true);
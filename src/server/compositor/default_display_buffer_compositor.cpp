@@ -24,8 +24,104 @@
 #include "mir/renderer/renderer.h"
 #include "occlusion.h"
 
+#include <algorithm>
+
 namespace mc = mir::compositor;
 namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// The part of the output a renderable at screen_position, clipped to clip_area, can draw to
+auto drawn_area(geom::Rectangle const& screen_position, std::optional<geom::Rectangle> const& clip_area)
+    -> geom::Rectangle
+{
+    return clip_area ? intersection_of(screen_position, *clip_area) : screen_position;
+}
+
+/// Past this many pieces, drawing the bounding rectangle of what is visible costs less than a draw per piece
+auto constexpr max_visible_pieces = 4u;
+
+auto area_of(geom::Rectangle const& rect) -> long
+{
+    return static_cast<long>(rect.size.width.as_int()) * rect.size.height.as_int();
+}
+
+/// A renderable clipped to the part of it that isn't hidden by anything above it
+class ClippedRenderable : public mg::Renderable
+{
+public:
+    ClippedRenderable(std::shared_ptr<mg::Renderable> const& renderable, geom::Rectangle const& clip) :
+        renderable{renderable},
+        clip{clip}
+    {
+    }
+
+    auto id() const -> ID override { return renderable->id(); }
+    auto buffer() const -> std::shared_ptr<mg::Buffer> override { return renderable->buffer(); }
+    auto screen_position() const -> geom::Rectangle override { return renderable->screen_position(); }
+    auto clip_area() const -> std::optional<geom::Rectangle> override { return clip; }
+    auto alpha() const -> float override { return renderable->alpha(); }
+    auto transformation() const -> glm::mat4 override { return renderable->transformation(); }
+    auto shaped() const -> bool override { return renderable->shaped(); }
+    auto opaque_region() const -> std::vector<geom::Rectangle> override { return renderable->opaque_region(); }
+    auto allow_tearing() const -> bool override { return renderable->allow_tearing(); }
+
+private:
+    std::shared_ptr<mg::Renderable> const renderable;
+    geom::Rectangle const clip;
+};
+
+/// Clips each renderable that is partly hidden so the renderer doesn't draw the hidden part
+/// (and drops those that are completely hidden)
+///
+/// A renderable whose visible part isn't a rectangle is drawn once per rectangle of it when that
+/// avoids drawing a good part (over a quarter) of it, in at most max_visible_pieces draws.
+/// Otherwise the bounding rectangle of the visible part is drawn, overdrawing what is hidden.
+auto clip_to_visible(mg::RenderableList const& renderables, geom::Rectangle const& view_area) -> mg::RenderableList
+{
+    auto const visible = mc::visible_regions_of(renderables, view_area);
+
+    mg::RenderableList clipped;
+    clipped.reserve(renderables.size());
+    for (size_t i = 0; i != renderables.size(); ++i)
+    {
+        auto const& renderable = renderables[i];
+        if (visible[i].empty())
+            continue;
+
+        auto const area = intersection_of(drawn_area(renderable->screen_position(), renderable->clip_area()), view_area);
+        auto visible_part = visible[i];
+        visible_part.intersect(area);
+
+        if (visible_part == geom::Region{area})
+        {
+            clipped.push_back(renderable);
+            continue;
+        }
+
+        auto const pieces = visible_part.rectangles();
+        auto const bounds = visible_part.bounding_rectangle();
+        long visible_area{0};
+        for (auto const& piece : pieces)
+            visible_area += area_of(piece);
+
+        if (pieces.size() > max_visible_pieces || 4 * (area_of(bounds) - visible_area) <= area_of(bounds))
+        {
+            if (bounds == area)
+                clipped.push_back(renderable);
+            else
+                clipped.push_back(std::make_shared<ClippedRenderable>(renderable, bounds));
+            continue;
+        }
+
+        for (auto const& piece : pieces)
+            clipped.push_back(std::make_shared<ClippedRenderable>(renderable, piece));
+    }
+
+    return clipped;
+}
+}
 
 mc::DefaultDisplayBufferCompositor::DefaultDisplayBufferCompositor(
     mg::DisplayBuffer& display_buffer,
@@ -69,12 +165,44 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
     {
         report->renderables_in_frame(this, renderable_list);
         renderer->suspend();
+
+        // Whatever the renderer last drew is no longer what is on screen
+        last_frame.reset();
+        pending_damage.clear();
+        pending_damage_sources.clear();
     }
     else
     {
-        renderer->set_output_transform(display_buffer.transformation());
+        auto const output_transform = display_buffer.transformation();
+
+        // Whatever the hardware can show by itself doesn't need rendering (or damage tracking)
+        auto composited_list = display_buffer.overlay_topmost(renderable_list);
+
+        std::vector<RenderedState> frame;
+        frame.reserve(composited_list.size());
+        for (auto const& renderable : composited_list)
+        {
+            auto const buffer = renderable->buffer();
+            frame.push_back(RenderedState{
+                renderable->id(),
+                renderable->screen_position(),
+                renderable->clip_area(),
+                renderable->alpha(),
+                renderable->transformation(),
+                renderable->shaped(),
+                buffer ? std::make_optional(buffer->id()) : std::nullopt});
+        }
+
+        renderer->set_output_transform(output_transform);
         renderer->set_viewport(view_area);
-        renderer->render(renderable_list);
+        renderer->set_damage(damage_since_last_frame(frame, view_area, output_transform));
+        renderer->render(clip_to_visible(composited_list, view_area));
+
+        last_frame = std::move(frame);
+        last_view_area = view_area;
+        last_output_transform = output_transform;
+        pending_damage.clear();
+        pending_damage_sources.clear();
 
         report->renderables_in_frame(this, renderable_list);
         report->rendered_frame(this);
@@ -91,7 +219,88 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
          *        acquisition calls when we composite the next frame.
          */
         renderable_list.clear();
+        composited_list.clear();
     }
 
     report->finished_frame(this);
 }
+
+void mc::DefaultDisplayBufferCompositor::add_damage(mg::Renderable::ID source, geom::Rectangles const& damage)
+{
+    pending_damage_sources.insert(source);
+    for (auto const& rect : damage)
+        pending_damage.add(rect);
+}
+
+auto mc::DefaultDisplayBufferCompositor::damage_since_last_frame(
+    std::vector<RenderedState> const& frame,
+    geom::Rectangle const& view_area,
+    glm::mat2 const& output_transform) const -> geom::Rectangles
+{
+    geom::Rectangles const everything{view_area};
+
+    if (!last_frame || view_area != last_view_area || output_transform != last_output_transform)
+        return everything;
+
+    auto const& previous = *last_frame;
+    auto const is_transformed = [](RenderedState const& state) { return state.transformation != glm::mat4{1}; };
+
+    // We don't know where a transformed renderable ends up on screen
+    if (std::any_of(frame.begin(), frame.end(), is_transformed) ||
+        std::any_of(previous.begin(), previous.end(), is_transformed))
+        return everything;
+
+    geom::Rectangles damage;
+
+    for (auto const& old : previous)
+    {
+        if (std::none_of(frame.begin(), frame.end(), [&](auto const& state) { return state.id == old.id; }))
+            damage.add(drawn_area(old.screen_position, old.clip_area));
+    }
+
+    auto last_match = previous.begin();
+    for (auto const& state : frame)
+    {
+        auto const old = std::find_if(
+            previous.begin(), previous.end(), [&](auto const& prev) { return prev.id == state.id; });
+
+        if (old == previous.end())
+        {
+            damage.add(drawn_area(state.screen_position, state.clip_area));
+            continue;
+        }
+
+        // Restacking changes what is on top wherever the restacked renderables
+        // overlap. That's rare enough not to be worth working out precisely.
+        if (old < last_match)
+            return everything;
+        last_match = old;
+
+        if (state.screen_position != old->screen_position ||
+            state.clip_area != old->clip_area ||
+            state.alpha != old->alpha ||
+            state.shaped != old->shaped)
+        {
+            damage.add(drawn_area(old->screen_position, old->clip_area));
+            damage.add(drawn_area(state.screen_position, state.clip_area));
+        }
+        else if (state.buffer_id != old->buffer_id)
+        {
+            // A new buffer usually comes with damage; if not (or it hasn't arrived yet)
+            // we have to assume it all changed
+            if (!pending_damage_sources.contains(state.id))
+                damage.add(drawn_area(state.screen_position, state.clip_area));
+        }
+    }
+
+    for (auto const& rect : pending_damage)
+        damage.add(rect);
+
+    geom::Rectangles on_output;
+    for (auto const& rect : damage)
+    {
+        if (rect.overlaps(view_area))
+            on_output.add(intersection_of(rect, view_area));
+    }
+    return on_output;
+}
@@ -19,7 +19,15 @@
 
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/compositor/compositor_report.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/graphics/buffer_id.h"
+#include "mir/graphics/renderable.h"
+
+#include <glm/glm.hpp>
 #include <memory>
+#include <optional>
+#include <unordered_set>
+#include <vector>
 
 namespace mir
 {
@@ -45,11 +53,38 @@ public:
         std::shared_ptr<CompositorReport> const& report);
 
     void composite(SceneElementSequence&& scene_sequence) override;
+    void add_damage(graphics::Renderable::ID source, geometry::Rectangles const& damage) override;
 
 private:
+    /// What we need to remember of a renderable to tell whether it changed between frames
+    struct RenderedState
+    {
+        graphics::Renderable::ID id;
+        geometry::Rectangle screen_position;
+        std::optional<geometry::Rectangle> clip_area;
+        float alpha;
+        glm::mat4 transformation;
+        bool shaped;
+        std::optional<graphics::BufferID> buffer_id;
+    };
+
+    /// The regions of the output that differ from the last frame we rendered
+    auto damage_since_last_frame(
+        std::vector<RenderedState> const& frame,
+        geometry::Rectangle const& view_area,
+        glm::mat2 const& output_transform) const -> geometry::Rectangles;
+
     graphics::DisplayBuffer& display_buffer;
     std::shared_ptr<renderer::Renderer> const renderer;
     std::shared_ptr<CompositorReport> const report;
+
+    geometry::Rectangles pending_damage;
+    /// The renderables whose new content pending_damage accounts for
+    std::unordered_set<graphics::Renderable::ID> pending_damage_sources;
+    /// The last frame rendered by renderer (nullopt if we need to redraw everything)
+    std::optional<std::vector<RenderedState>> last_frame;
+    geometry::Rectangle last_view_area;
+    glm::mat2 last_output_transform;
 };
 
 }
@@ -15,6 +15,7 @@
  */
 
 #include "multi_threaded_compositor.h"
+#include "presentation_notifier.h"
 #include "mir/graphics/display.h"
 #include "mir/graphics/display_buffer.h"
 #include "mir/compositor/display_buffer_compositor.h"
@@ -30,7 +31,11 @@
 #include "mir/unwind_helpers.h"
 #include "mir/thread_name.h"
 #include "mir/executor.h"
+#include "mir/startup_timeline.h"
 
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
 #include <thread>
 #include <chrono>
 #include <condition_variable>
@@ -55,6 +60,7 @@ public:
         mg::DisplaySyncGroup& group,
         std::shared_ptr<mc::Scene> const& scene,
         std::shared_ptr<DisplayListener> const& display_listener,
+        std::shared_ptr<PresentationNotifier> const& presentation_notifier,
         std::chrono::milliseconds fixed_composite_delay,
         std::shared_ptr<CompositorReport> const& report) :
         compositor_factory{db_compositor_factory},
@@ -64,6 +70,7 @@ public:
         frames_scheduled{0},
         force_sleep{fixed_composite_delay},
         display_listener{display_listener},
+        presentation_notifier{presentation_notifier},
         report{report},
         started_future{started.get_future()},
         stopped_future{stopped.get_future()}
@@ -114,6 +121,21 @@ public:
                     scene->unregister_compositor(std::get<1>(compositor).get());
             });
 
+        auto presentation_registration = mir::raii::paired_calls(
+            [this,&compositors]
+            {
+                for (auto& compositor : compositors)
+                {
+                    presentation_notifier->register_compositor(
+                        std::get<1>(compositor).get(),
+                        [this]{ schedule_compositing(1); });
+                }
+            },
+            [this,&compositors]{
+                for (auto& compositor : compositors)
+                    presentation_notifier->unregister_compositor(std::get<1>(compositor).get());
+            });
+
         started.set_value();
 
         try
@@ -139,14 +161,30 @@ public:
                      */
                     frames_scheduled--;
                     not_posted_yet = false;
+                    decltype(pending_damage) damage;
+                    std::swap(damage, pending_damage);
                     lock.unlock();
 
                     for (auto& tuple : compositors)
                     {
                         auto& compositor = std::get<1>(tuple);
+                        for (auto const& [source, source_damage] : damage)
+                            compositor->add_damage(source, source_damage);
                         compositor->composite(scene->scene_elements_for(compositor.get()));
                     }
                     group.post();
+                    startup_timeline::frame_posted();
+                    auto const needs_recomposite = group.needs_recomposite();
+
+                    // post() returns once the frame is on screen, so this is when clients should draw the next one
+                    auto const posted = mg::Frame::Timestamp::now(CLOCK_MONOTONIC);
+                    for (auto& tuple : compositors)
+                    {
+                        auto const presentation = std::get<0>(tuple)->last_presentation();
+                        presentation_notifier->presented(
+                            std::get<1>(tuple).get(),
+                            presentation ? *presentation : mg::FramePresentation{{0, posted}});
+                    }
 
                     /*
                      * "Predictive bypass" optimization: If the last frame was
@@ -176,6 +214,10 @@ public:
                             pending = pend;
                     }
 
+                    // ...and to make up for a frame the display couldn't show
+                    if (needs_recomposite && pending < 1)
+                        pending = 1;
+
                     if (pending > frames_scheduled)
                         frames_scheduled = pending;
                 }
@@ -203,13 +245,29 @@ public:
         }
     }
 
-    void schedule_compositing(int num_frames, geometry::Rectangle const& damage)
+    void schedule_compositing(int num_frames, mg::Renderable::ID source, geometry::Rectangles const& damage)
     {
         std::unique_lock lock{run_mutex};
         bool took_damage = not_posted_yet;
 
-        group.for_each_display_buffer([&](mg::DisplayBuffer& buffer)
-            { if (damage.overlaps(buffer.view_area())) took_damage = true; });
+        // Even damage that misses our outputs tells the compositor that source's new content is accounted for
+        auto& source_damage = pending_damage[source];
+
+        for (auto const& rect : damage)
+        {
+            bool on_our_outputs = false;
+            group.for_each_display_buffer([&](mg::DisplayBuffer& buffer)
+                {
+                    if (rect.overlaps(buffer.view_area()))
+                        on_our_outputs = true;
+                });
+
+            if (on_our_outputs)
+            {
+                took_damage = true;
+                source_damage.add(rect);
+            }
+        }
 
         if (took_damage && num_frames > frames_scheduled)
         {
@@ -245,6 +303,11 @@ public:
         stopped_future.get();
     }
 
+    bool composites(mg::DisplaySyncGroup const& other) const
+    {
+        return &group == &other;
+    }
+
 private:
     std::shared_ptr<mc::DisplayBufferCompositorFactory> const compositor_factory;
     mg::DisplaySyncGroup& group;
@@ -255,22 +318,39 @@ private:
     std::mutex run_mutex;
     std::condition_variable run_cv;
     std::shared_ptr<DisplayListener> const display_listener;
+    std::shared_ptr<PresentationNotifier> const presentation_notifier;
     std::shared_ptr<CompositorReport> const report;
     std::promise<void> started;
     std::future<void> started_future;
     std::promise<void> stopped;
     std::future<void> stopped_future;
     bool not_posted_yet = true;
+    std::unordered_map<mg::Renderable::ID, geometry::Rectangles> pending_damage;
 };
 
 }
 }
 
+namespace
+{
+void stop_all(std::vector<std::unique_ptr<mc::CompositingFunctor>>& functors)
+{
+    for (auto& f : functors)
+        f->stop();
+
+    for (auto& f : functors)
+        f->wait_until_stopped();
+
+    functors.clear();
+}
+}
+
 mc::MultiThreadedCompositor::MultiThreadedCompositor(
     std::shared_ptr<mg::Display> const& display,
     std::shared_ptr<mc::Scene> const& scene,
     std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory,
     std::shared_ptr<DisplayListener> const& display_listener,
+    std::shared_ptr<PresentationNotifier> const& presentation_notifier,
     std::shared_ptr<CompositorReport> const& compositor_report,
     std::chrono::milliseconds fixed_composite_delay,
     bool compose_on_start)
@@ -278,6 +358,7 @@ mc::MultiThreadedCompositor::MultiThreadedCompositor(
       scene{scene},
       display_buffer_compositor_factory{db_compositor_factory},
       display_listener{display_listener},
+      presentation_notifier{presentation_notifier},
       report{compositor_report},
       state{CompositorState::stopped},
       fixed_composite_delay{fixed_composite_delay},
@@ -288,9 +369,9 @@ mc::MultiThreadedCompositor::MultiThreadedCompositor(
     {
         schedule_compositing(1);
     },
-    [this](int num, geometry::Rectangle const& damage)
+    [this](int num, mg::Renderable::ID source, geometry::Rectangles const& damage)
     {
-        schedule_compositing(num, damage);
+        schedule_compositing(num, source, damage);
     });
 }
 
@@ -302,15 +383,20 @@ mc::MultiThreadedCompositor::~MultiThreadedCompositor()
 void mc::MultiThreadedCompositor::schedule_compositing(int num)
 {
     report->scheduled();
+    std::lock_guard lock{thread_functors_mutex};
     for (auto& f : thread_functors)
         f->schedule_compositing(num);
 }
 
-void mc::MultiThreadedCompositor::schedule_compositing(int num, geometry::Rectangle const& damage) const
+void mc::MultiThreadedCompositor::schedule_compositing(
+    int num,
+    mg::Renderable::ID source,
+    geometry::Rectangles const& damage) const
 {
     report->scheduled();
+    std::lock_guard lock{thread_functors_mutex};
     for (auto& f : thread_functors)
-        f->schedule_compositing(num, damage);
+        f->schedule_compositing(num, source, damage);
 }
 
 void mc::MultiThreadedCompositor::start()
@@ -368,21 +454,72 @@ void mc::MultiThreadedCompositor::stop()
     state = CompositorState::stopped;
 }
 
+void mc::MultiThreadedCompositor::stop_sync_groups(std::vector<mg::DisplaySyncGroup*> const& groups)
+{
+    if (state != CompositorState::started)
+        return;
+
+    std::vector<std::unique_ptr<CompositingFunctor>> retiring;
+    {
+        std::lock_guard lock{thread_functors_mutex};
+        auto const first_retiring = std::stable_partition(
+            thread_functors.begin(),
+            thread_functors.end(),
+            [&groups](auto const& functor)
+            {
+                return std::none_of(groups.begin(), groups.end(), [&functor](auto group)
+                    {
+                        return functor->composites(*group);
+                    });
+            });
+        std::move(first_retiring, thread_functors.end(), std::back_inserter(retiring));
+        thread_functors.erase(first_retiring, thread_functors.end());
+    }
+
+    // Not waited for under the lock: the thread might be scheduling itself
+    stop_all(retiring);
+}
+
+void mc::MultiThreadedCompositor::start_new_sync_groups()
+{
+    if (state != CompositorState::started)
+        return;
+
+    create_compositing_threads();
+
+    // Get something on the new outputs
+    schedule_compositing(1);
+}
+
 void mc::MultiThreadedCompositor::create_compositing_threads()
 {
+    std::vector<std::unique_ptr<CompositingFunctor>> new_functors;
+    auto cleanup_if_unwinding = on_unwind([&new_functors] { stop_all(new_functors); });
+
     /* Start the display buffer compositing threads */
-    display->for_each_display_sync_group([this](mg::DisplaySyncGroup& group)
+    display->for_each_display_sync_group([this, &new_functors](mg::DisplaySyncGroup& group)
     {
+        {
+            std::lock_guard lock{thread_functors_mutex};
+            if (std::any_of(
+                    thread_functors.begin(),
+                    thread_functors.end(),
+                    [&group](auto const& functor) { return functor->composites(group); }))
+            {
+                return;
+            }
+        }
+
         auto thread_functor = std::make_unique<mc::CompositingFunctor>(
             display_buffer_compositor_factory, group, scene, display_listener,
-            fixed_composite_delay, report);
+            presentation_notifier, fixed_composite_delay, report);
 
         mir::thread_pool_executor.spawn(std::ref(*thread_functor));
-        thread_functors.push_back(std::move(thread_functor));
+        new_functors.push_back(std::move(thread_functor));
     });
 
     std::exception_ptr x;
-    for (auto& functor : thread_functors)
+    for (auto& functor : new_functors)
     try
     {
         functor->wait_until_started();
@@ -396,15 +533,18 @@ void mc::MultiThreadedCompositor::create_compositing_threads()
     {
         rethrow_exception(x);
     }
+
+    std::lock_guard lock{thread_functors_mutex};
+    std::move(new_functors.begin(), new_functors.end(), std::back_inserter(thread_functors));
 }
 
 void mc::MultiThreadedCompositor::destroy_compositing_threads()
 {
-    for (auto& f : thread_functors)
-        f->stop();
-
-    for (auto& f : thread_functors)
-        f->wait_until_stopped();
+    std::vector<std::unique_ptr<CompositingFunctor>> functors;
+    {
+        std::lock_guard lock{thread_functors_mutex};
+        functors.swap(thread_functors);
+    }
 
-    thread_functors.clear();
+    stop_all(functors);
 }
@@ -19,6 +19,7 @@
 
 #include "mir/compositor/compositor.h"
 #include "mir/geometry/forward.h"
+#include "mir/graphics/renderable.h"
 
 #include <mutex>
 #include <memory>
@@ -32,6 +33,7 @@ namespace mir
 namespace graphics
 {
 class Display;
+class DisplaySyncGroup;
 }
 namespace scene
 {
@@ -46,6 +48,7 @@ class DisplayListener;
 class CompositingFunctor;
 class Scene;
 class CompositorReport;
+class PresentationNotifier;
 
 enum class CompositorState
 {
@@ -63,6 +66,7 @@ public:
         std::shared_ptr<Scene> const& scene,
         std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory,
         std::shared_ptr<DisplayListener> const& display_listener,
+        std::shared_ptr<PresentationNotifier> const& presentation_notifier,
         std::shared_ptr<CompositorReport> const& compositor_report,
         std::chrono::milliseconds fixed_composite_delay,  // -1 = automatic
         bool compose_on_start);
@@ -71,7 +75,11 @@ public:
     void start();
     void stop();
 
+    void stop_sync_groups(std::vector<graphics::DisplaySyncGroup*> const& groups) override;
+    void start_new_sync_groups() override;
+
 private:
+    /// Creates threads for the display's sync groups that don't have one
     void create_compositing_threads();
     void destroy_compositing_threads();
 
@@ -79,8 +87,11 @@ private:
     std::shared_ptr<Scene> const scene;
     std::shared_ptr<DisplayBufferCompositorFactory> const display_buffer_compositor_factory;
     std::shared_ptr<DisplayListener> const display_listener;
+    std::shared_ptr<PresentationNotifier> const presentation_notifier;
     std::shared_ptr<CompositorReport> const report;
 
+    /// Locked so that groups can be added and removed while the others go on being scheduled
+    std::mutex mutable thread_functors_mutex;
     std::vector<std::unique_ptr<CompositingFunctor>> thread_functors;
 
     std::atomic<CompositorState> state;
@@ -88,7 +99,10 @@ private:
     bool compose_on_start;
 
     void schedule_compositing(int number_composites);
-    void schedule_compositing(int number_composites, geometry::Rectangle const& damage) const;
+    void schedule_compositing(
+        int number_composites,
+        graphics::Renderable::ID source,
+        geometry::Rectangles const& damage) const;
 
     std::shared_ptr<mir::scene::Observer> observer;
 };
@@ -19,6 +19,7 @@
 #include "mir/executor.h"
 
 namespace mc = mir::compositor;
+namespace mg = mir::graphics;
 namespace mrs = mir::renderer::software;
 namespace geom = mir::geometry;
 
@@ -38,3 +39,24 @@ void mc::NullScreenShooter::capture(
             callback(std::nullopt);
         });
 }
+
+void mc::NullScreenShooter::capture(
+    std::shared_ptr<mrs::WriteMappableBuffer> const& buffer,
+    geom::Rectangle const& area,
+    geom::Rectangle const&,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    capture(buffer, area, std::move(callback));
+}
+
+void mc::NullScreenShooter::capture(
+    std::shared_ptr<mg::DMABufBuffer> const&,
+    geom::Rectangle const&,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    log_warning("Failed to capture screen because NullScreenShooter is in use");
+    executor.spawn([callback=std::move(callback)]
+        {
+            callback(std::nullopt);
+        });
+}
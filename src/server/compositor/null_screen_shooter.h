@@ -36,6 +36,17 @@ public:
         geometry::Rectangle const& area,
         std::function<void(std::optional<time::Timestamp>)>&& callback) override;
 
+    void capture(
+        std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
+        geometry::Rectangle const& area,
+        geometry::Rectangle const& damage,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) override;
+
+    void capture(
+        std::shared_ptr<graphics::DMABufBuffer> const& buffer,
+        geometry::Rectangle const& area,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) override;
+
 private:
     Executor& executor;
 };
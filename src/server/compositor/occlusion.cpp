@@ -15,6 +15,7 @@
  */
 
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/region.h"
 #include "mir/compositor/scene_element.h"
 #include "mir/graphics/renderable.h"
 #include "occlusion.h"
@@ -27,15 +28,40 @@ using namespace mir::compositor;
 
 namespace
 {
+bool is_transformed(Renderable const& renderable)
+{
+    static glm::mat4 const identity(1);
+    return renderable.transformation() != identity;
+}
+
+// Adds the parts of renderable (within clipped_window) that hide whatever is below it
+void add_opaque_area(Renderable const& renderable, Rectangle const& clipped_window, Region& coverage)
+{
+    if (renderable.alpha() != 1.0f)
+        return;
+
+    if (!renderable.shaped())
+    {
+        coverage.add(clipped_window);
+    }
+    else
+    {
+        // Translucent buffers can still have parts the client says are opaque
+        for (auto const& opaque : renderable.opaque_region())
+        {
+            coverage.add(intersection_of(opaque, clipped_window));
+        }
+    }
+}
+
 bool renderable_is_occluded(
     Renderable const& renderable, 
     Rectangle const& area,
-    std::vector<Rectangle>& coverage)
+    Region& coverage)
 {
-    static glm::mat4 const identity(1);
     static Rectangle const empty{};
 
-    if (renderable.transformation() != identity)
+    if (is_transformed(renderable))
         return false;  // Weirdly transformed. Assume never occluded.
 
     auto const& window = renderable.screen_position();
@@ -44,20 +70,12 @@ bool renderable_is_occluded(
     if (clipped_window == empty)
         return true;  // Not in the area; definitely occluded.
 
-    bool occluded = false;
-    for (auto const& r : coverage)
-    {
-        if (r.contains(clipped_window))
-        {
-            occluded = true;
-            break;
-        }
-    }
+    // Windows can be hidden by several others together, not just by one
+    if (coverage.contains(clipped_window))
+        return true;
 
-    if (!occluded && renderable.alpha() == 1.0f && !renderable.shaped())
-        coverage.push_back(clipped_window);
-
-    return occluded;
+    add_opaque_area(renderable, clipped_window, coverage);
+    return false;
 }
 }
 
@@ -66,7 +84,7 @@ SceneElementSequence mir::compositor::filter_occlusions_from(
     Rectangle const& area)
 {
     SceneElementSequence occluded;
-    std::vector<Rectangle> coverage;
+    Region coverage;
 
     auto it = elements.rbegin();
     while (it != elements.rend())
@@ -85,3 +103,32 @@ SceneElementSequence mir::compositor::filter_occlusions_from(
 
     return occluded;
 }
+
+auto mir::compositor::visible_regions_of(RenderableList const& renderables, Rectangle const& area)
+    -> std::vector<Region>
+{
+    std::vector<Region> visible(renderables.size());
+    Region coverage;
+
+    auto slot = visible.rbegin();
+    for (auto it = renderables.rbegin(); it != renderables.rend(); ++it, ++slot)
+    {
+        auto const& renderable = **it;
+        auto const clipped_window = intersection_of(renderable.screen_position(), area);
+
+        if (is_transformed(renderable))
+        {
+            // We can't describe what a transformed renderable covers, so it
+            // neither hides anything nor is clipped
+            *slot = Region(renderable.screen_position());
+            continue;
+        }
+
+        *slot = Region(clipped_window);
+        slot->subtract(coverage);
+
+        add_opaque_area(renderable, clipped_window, coverage);
+    }
+
+    return visible;
+}
@@ -18,6 +18,10 @@
 #define MIR_COMPOSITOR_OCCLUSION_H_
 
 #include "mir/compositor/scene.h"
+#include "mir/geometry/region.h"
+#include "mir/graphics/renderable.h"
+
+#include <vector>
 
 namespace mir
 {
@@ -26,6 +30,17 @@ namespace compositor
 
 SceneElementSequence filter_occlusions_from(SceneElementSequence& list, geometry::Rectangle const& area);
 
+/**
+ * The part of each renderable within area that isn't hidden by opaque
+ * renderables above it.
+ *
+ * \param [in] renderables Renderables, bottom to top
+ * \param [in] area        The area being composited
+ * \return                 The visible region of each renderable, in the same order
+ */
+auto visible_regions_of(graphics::RenderableList const& renderables, geometry::Rectangle const& area)
+    -> std::vector<geometry::Region>;
+
 } // namespace compositor
 } // namespace mir
 
@@ -0,0 +1,83 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "presentation_notifier.h"
+
+namespace mc = mir::compositor;
+
+void mc::PresentationNotifier::register_compositor(CompositorID id, std::function<void()> const& schedule_frame)
+{
+    std::lock_guard lock{mutex};
+    outputs[id].schedule_frame = schedule_frame;
+}
+
+void mc::PresentationNotifier::unregister_compositor(CompositorID id)
+{
+    std::vector<Callback> callbacks;
+    {
+        std::lock_guard lock{mutex};
+        if (auto const output = outputs.find(id); output != outputs.end())
+        {
+            callbacks = std::move(output->second.callbacks);
+            outputs.erase(output);
+        }
+    }
+
+    for (auto const& callback : callbacks)
+    {
+        callback(std::nullopt);
+    }
+}
+
+auto mc::PresentationNotifier::on_next_presentation(CompositorID id, Callback const& callback) -> bool
+{
+    std::lock_guard lock{mutex};
+    auto const output = outputs.find(id);
+    if (output == outputs.end())
+    {
+        return false;
+    }
+
+    output->second.callbacks.push_back(callback);
+    return true;
+}
+
+void mc::PresentationNotifier::schedule_frame(CompositorID id)
+{
+    // Holding the lock means the compositor can't be unregistered (and destroyed) while we call it
+    std::lock_guard lock{mutex};
+    if (auto const output = outputs.find(id); output != outputs.end())
+    {
+        output->second.schedule_frame();
+    }
+}
+
+void mc::PresentationNotifier::presented(CompositorID id, graphics::FramePresentation const& presentation)
+{
+    std::vector<Callback> callbacks;
+    {
+        std::lock_guard lock{mutex};
+        if (auto const output = outputs.find(id); output != outputs.end())
+        {
+            callbacks.swap(output->second.callbacks);
+        }
+    }
+
+    for (auto const& callback : callbacks)
+    {
+        callback(presentation);
+    }
+}
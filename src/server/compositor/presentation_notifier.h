@@ -0,0 +1,90 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_PRESENTATION_NOTIFIER_H_
+#define MIR_COMPOSITOR_PRESENTATION_NOTIFIER_H_
+
+#include "mir/compositor/compositor_id.h"
+#include "mir/graphics/frame.h"
+
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace compositor
+{
+/**
+ * Runs callbacks when the output a compositor draws to has shown its next frame
+ *
+ * The compositing threads register the compositor of each output, and report
+ * each frame once it has been posted (for KMS outputs that is when the page
+ * flip completes). This lets buffer streams tell clients when to draw at the
+ * refresh rate of the output they are on.
+ *
+ * Compositors that aren't registered (such as those of screenshots) have no
+ * presentation to wait for.
+ */
+class PresentationNotifier
+{
+public:
+    /// Given how the frame was shown, or std::nullopt if it never will be
+    using Callback = std::function<void(std::optional<graphics::FramePresentation> const&)>;
+
+    PresentationNotifier() = default;
+
+    /// \param [in] schedule_frame  Asks for a frame to be composited, even if nothing has changed.
+    ///                             It must not call back into the notifier.
+    void register_compositor(CompositorID id, std::function<void()> const& schedule_frame);
+
+    /// Runs any callbacks still waiting for id with std::nullopt, as it won't present them
+    void unregister_compositor(CompositorID id);
+
+    /**
+     * Run callback after the next frame of id has been presented
+     *
+     * This is called while compositing a frame for the frame in progress.
+     *
+     * \return false (and does nothing) if id is not a registered compositor
+     */
+    auto on_next_presentation(CompositorID id, Callback const& callback) -> bool;
+
+    /// Asks id to composite a frame, so that callbacks don't wait on an idle output
+    void schedule_frame(CompositorID id);
+
+    /// A frame of id has been presented
+    void presented(CompositorID id, graphics::FramePresentation const& presentation);
+
+private:
+    PresentationNotifier(PresentationNotifier const&) = delete;
+    PresentationNotifier& operator=(PresentationNotifier const&) = delete;
+
+    struct Output
+    {
+        std::function<void()> schedule_frame;
+        std::vector<Callback> callbacks;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<CompositorID, Output> outputs;
+};
+}
+}
+
+#endif /* MIR_COMPOSITOR_PRESENTATION_NOTIFIER_H_ */
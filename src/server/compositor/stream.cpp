@@ -17,6 +17,7 @@
 #include "stream.h"
 #include "queueing_schedule.h"
 #include "dropping_schedule.h"
+#include "presentation_notifier.h"
 #include "mir/graphics/buffer.h"
 #include <boost/throw_exception.hpp>
 #include <math.h>
@@ -35,33 +36,90 @@ enum class mc::Stream::ScheduleMode {
 
 mc::Stream::Stream(
     geom::Size size, MirPixelFormat pf) :
+    Stream(size, pf, std::make_shared<PresentationNotifier>())
+{
+}
+
+mc::Stream::Stream(
+    geom::Size size,
+    MirPixelFormat pf,
+    std::shared_ptr<PresentationNotifier> const& presentation_notifier) :
     schedule_mode(ScheduleMode::Queueing),
     schedule(std::make_shared<mc::QueueingSchedule>()),
     arbiter(std::make_shared<mc::MultiMonitorArbiter>(schedule)),
     latest_buffer_size(size),
     pf(pf),
     first_frame_posted(false),
-    frame_callback{[](auto){}}
+    frame_callback{[](auto, auto){}},
+    presentation_notifier{presentation_notifier}
 {
 }
 
-mc::Stream::~Stream() = default;
+mc::Stream::~Stream()
+{
+    for (auto const& callback : awaiting_buffer_presentation)
+    {
+        callback(std::nullopt);
+    }
+}
 
 void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer)
+{
+    submit(buffer, std::nullopt);
+}
+
+void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer, geom::Rectangles const& damage)
+{
+    submit(buffer, damage);
+}
+
+void mc::Stream::submit(std::shared_ptr<mg::Buffer> const& buffer, std::optional<geom::Rectangles> const& damage)
 {
     if (!buffer)
         BOOST_THROW_EXCEPTION(std::invalid_argument("cannot submit null buffer"));
 
+    geom::Rectangles clipped_damage;
+    bool replaces_unshown_buffers;
     {
         std::lock_guard lk(mutex);
+        replaces_unshown_buffers = schedule_mode == ScheduleMode::Dropping;
+        geom::Rectangle const logical_rect{{}, scaled_size(buffer->size())};
+        if (!damage || buffer->size() != latest_buffer_size || !first_frame_posted)
+        {
+            // The previous content can't be reused, so everything is damaged
+            clipped_damage.add(logical_rect);
+        }
+        else
+        {
+            for (auto const& rect : damage.value())
+            {
+                auto const clipped = intersection_of(rect, logical_rect);
+                if (clipped.size != geom::Size{})
+                    clipped_damage.add(clipped);
+            }
+        }
         pf = buffer->pixel_format();
         latest_buffer_size = buffer->size();
         schedule->schedule(buffer);
         first_frame_posted = true;
     }
+    std::vector<PresentationNotifier::Callback> discarded;
+    {
+        std::lock_guard lock{presentation_mutex};
+        buffer_awaiting_compositor = true;
+        if (replaces_unshown_buffers)
+        {
+            // No compositor has taken the previous buffer, and now none will
+            discarded.swap(awaiting_buffer_presentation);
+        }
+    }
+    for (auto const& callback : discarded)
+    {
+        callback(std::nullopt);
+    }
     {
         std::lock_guard lock{callback_mutex};
-        frame_callback(buffer->size());
+        frame_callback(buffer->size(), clipped_damage);
     }
 }
 
@@ -78,23 +136,114 @@ MirPixelFormat mc::Stream::pixel_format() const
 }
 
 void mc::Stream::set_frame_posted_callback(
-    std::function<void(geometry::Size const&)> const& callback)
+    std::function<void(geometry::Size const&, geometry::Rectangles const&)> const& callback)
 {
     std::lock_guard lock{callback_mutex};
     frame_callback = callback;
 }
 
+auto mc::Stream::when_presented(std::function<void()> const& callback) -> bool
+{
+    auto const on_presentation = [callback](auto const&) { callback(); };
+
+    std::unique_lock lock{presentation_mutex};
+    if (buffer_awaiting_compositor)
+    {
+        // The callback goes to whichever output shows the buffer
+        awaiting_compositor.push_back(on_presentation);
+        return true;
+    }
+    auto const id = shown_by;
+    lock.unlock();
+
+    // Nothing new to show, so the callback waits for the next frame of the output we were last shown on
+    if (id && presentation_notifier->on_next_presentation(id, on_presentation))
+    {
+        presentation_notifier->schedule_frame(id);
+        return true;
+    }
+
+    return false;
+}
+
+void mc::Stream::when_buffer_presented(
+    std::function<void(std::optional<mg::FramePresentation> const&)> const& callback)
+{
+    std::unique_lock lock{presentation_mutex};
+    if (buffer_awaiting_compositor)
+    {
+        awaiting_buffer_presentation.push_back(callback);
+        return;
+    }
+    auto const id = shown_by;
+    lock.unlock();
+
+    // The buffer has already been taken, so it is shown by the next frame of that output
+    if (id && presentation_notifier->on_next_presentation(id, callback))
+    {
+        presentation_notifier->schedule_frame(id);
+        return;
+    }
+
+    callback(std::nullopt);
+}
+
 std::shared_ptr<mg::Buffer> mc::Stream::lock_compositor_buffer(void const* id)
 {
-    return arbiter->compositor_acquire(id);
+    auto const buffer = arbiter->compositor_acquire(id);
+
+    std::vector<PresentationNotifier::Callback> callbacks;
+    std::vector<PresentationNotifier::Callback> buffer_callbacks;
+    {
+        std::lock_guard lock{presentation_mutex};
+        callbacks.swap(awaiting_compositor);
+        buffer_callbacks.swap(awaiting_buffer_presentation);
+        buffer_awaiting_compositor = false;
+        shown_by = id;
+    }
+
+    for (auto const& callback : callbacks)
+    {
+        // Users that don't present anything (such as screenshots) consume the buffer straight away
+        if (!presentation_notifier->on_next_presentation(id, callback))
+        {
+            callback(std::nullopt);
+        }
+    }
+
+    std::vector<PresentationNotifier::Callback> unpresented;
+    for (auto const& callback : buffer_callbacks)
+    {
+        if (!presentation_notifier->on_next_presentation(id, callback))
+        {
+            unpresented.push_back(callback);
+        }
+    }
+
+    if (!unpresented.empty())
+    {
+        // ...but that doesn't present the buffer, so wait for an output to take it
+        std::lock_guard lock{presentation_mutex};
+        awaiting_buffer_presentation.insert(
+            awaiting_buffer_presentation.begin(),
+            unpresented.begin(),
+            unpresented.end());
+    }
+
+    return buffer;
 }
 
 geom::Size mc::Stream::stream_size()
 {
     std::lock_guard lk(mutex);
+    return scaled_size(latest_buffer_size);
+}
+
+auto mc::Stream::scaled_size(geom::Size const& buffer_size) const -> geom::Size
+{
     return geom::Size{
-        roundf(latest_buffer_size.width.as_int() / scale_),
-        roundf(latest_buffer_size.height.as_int() / scale_)};
+        roundf(buffer_size.width.as_int() / scale_),
+        roundf(buffer_size.height.as_int() / scale_)};
 }
 
 void mc::Stream::allow_framedropping(bool dropping)
@@ -18,13 +18,17 @@
 #define MIR_COMPOSITOR_STREAM_H_
 
 #include "mir/compositor/buffer_stream.h"
+#include "mir/compositor/compositor_id.h"
 #include "mir/geometry/size.h"
 #include "multi_monitor_arbiter.h"
+#include "presentation_notifier.h"
 
 #include <atomic>
 #include <mutex>
 #include <memory>
+#include <optional>
 #include <set>
+#include <vector>
 #include <atomic>
 
 namespace mir
@@ -36,13 +40,23 @@ class Stream : public BufferStream
 {
 public:
     Stream(geometry::Size sz, MirPixelFormat format);
+    Stream(
+        geometry::Size sz,
+        MirPixelFormat format,
+        std::shared_ptr<PresentationNotifier> const& presentation_notifier);
     ~Stream();
 
     void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer) override;
+    void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Rectangles const& damage) override;
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& exec) override;
     MirPixelFormat pixel_format() const override;
     void set_frame_posted_callback(
-        std::function<void(geometry::Size const&)> const& callback) override;
+        std::function<void(geometry::Size const&, geometry::Rectangles const&)> const& callback) override;
+    auto when_presented(std::function<void()> const& callback) -> bool override;
+    void when_buffer_presented(
+        std::function<void(std::optional<graphics::FramePresentation> const&)> const& callback) override;
     std::shared_ptr<graphics::Buffer>
         lock_compositor_buffer(void const* user_id) override;
     geometry::Size stream_size() override;
@@ -56,6 +70,10 @@ public:
 private:
     enum class ScheduleMode;
     void transition_schedule(std::shared_ptr<Schedule>&& new_schedule, std::lock_guard<std::mutex> const&);
+    /// If damage is nullopt the whole buffer is damaged
+    void submit(std::shared_ptr<graphics::Buffer> const& buffer, std::optional<geometry::Rectangles> const& damage);
+    /// Requires mutex to be held
+    auto scaled_size(geometry::Size const& buffer_size) const -> geometry::Size;
 
     std::mutex mutable mutex;
     ScheduleMode schedule_mode;
@@ -67,7 +85,17 @@ private:
     std::atomic<bool> first_frame_posted;
 
     std::mutex callback_mutex;
-    std::function<void(geometry::Size const&)> frame_callback;
+    std::function<void(geometry::Size const&, geometry::Rectangles const&)> frame_callback;
+
+    std::shared_ptr<PresentationNotifier> const presentation_notifier;
+    std::mutex presentation_mutex;
+    /// Waiting for a compositor to take the latest buffer
+    std::vector<PresentationNotifier::Callback> awaiting_compositor;
+    /// Waiting for the latest buffer itself to be presented, so they are discarded if it is replaced first
+    std::vector<PresentationNotifier::Callback> awaiting_buffer_presentation;
+    bool buffer_awaiting_compositor{false};
+    /// The compositor that most recently took a buffer
+    CompositorID shown_by{nullptr};
 };
 }
 }
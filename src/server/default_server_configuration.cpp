@@ -23,6 +23,7 @@
 #include "mir/cookie/authority.h"
 #include "mir/frontend/wayland.h"
 
+#include "mir/logging/async_logger.h"
 #include "mir/logging/dumb_console_logger.h"
 #include "mir/options/program_option.h"
 #include "mir/frontend/session_credentials.h"
@@ -216,3 +217,13 @@ auto mir::DefaultServerConfiguration::the_logger()
             return std::make_shared<ml::DumbConsoleLogger>();
         });
 }
+
+auto mir::DefaultServerConfiguration::the_async_logger()
+    -> std::shared_ptr<ml::Logger>
+{
+    return async_logger(
+        [this]() -> std::shared_ptr<ml::Logger>
+        {
+            return std::make_shared<ml::AsyncLogger>(the_logger());
+        });
+}
@@ -32,7 +32,7 @@ class AlarmFactory;
 namespace frontend
 {
 
-/// Runs frame callbacks that do not have a buffer to be attached to.
+/// Runs frame callbacks of surfaces that are not on any output, so have no frame to wait for.
 class FrameExecutor : public Executor
 {
 public:
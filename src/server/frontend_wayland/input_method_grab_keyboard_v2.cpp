@@ -90,6 +90,12 @@ void mf::InputMethodGrabKeyboardV2::send_keymap_xkb_v1(mir::Fd const& fd, size_t
     send_keymap_event(mw::Keyboard::KeymapFormat::xkb_v1, fd, length);
 }
 
+auto mf::InputMethodGrabKeyboardV2::maps_keymap_privately() const -> bool
+{
+    // The protocol doesn't say how the keymap is to be mapped
+    return false;
+}
+
 void mf::InputMethodGrabKeyboardV2::send_key(std::shared_ptr<MirKeyboardEvent const> const& event)
 {
     if (!wl_client)
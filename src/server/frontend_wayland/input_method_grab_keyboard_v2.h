@@ -61,6 +61,7 @@ private:
     /// @{
     void send_repeat_info(int32_t rate, int32_t delay) override;
     void send_keymap_xkb_v1(mir::Fd const& fd, size_t length) override;
+    auto maps_keymap_privately() const -> bool override;
     void send_key(std::shared_ptr<MirKeyboardEvent const> const& event) override;
     void send_modifiers(MirXkbModifiers const& modifiers) override;
     /// @}
@@ -15,12 +15,12 @@
  */
 
 #include "keyboard_helper.h"
+#include "keymap_file_cache.h"
 
 #include "mir/anonymous_shm_file.h"
 #include "mir/input/keymap.h"
 #include "mir/events/keyboard_event.h"
 #include "mir/input/seat.h"
-#include "mir/fatal.h"
 
 #include <cstring> // memcpy
 #include <unordered_set>
@@ -32,19 +32,14 @@ namespace mi = mir::input;
 mf::KeyboardHelper::KeyboardHelper(
     KeyboardCallbacks* callbacks,
     std::shared_ptr<mi::Keymap> const& initial_keymap,
+    std::shared_ptr<KeymapFileCache> const& keymap_files,
     std::shared_ptr<input::Seat> const& seat,
     bool enable_key_repeat)
     : callbacks{callbacks},
       mir_seat{seat},
       current_keymap{nullptr}, // will be set later in the constructor by set_keymap()
-      compiled_keymap{nullptr, &xkb_keymap_unref},
-      context{xkb_context_new(XKB_CONTEXT_NO_FLAGS), &xkb_context_unref}
+      keymap_files{keymap_files}
 {
-    if (!context)
-    {
-        fatal_error("Failed to create XKB context");
-    }
-
     /* The wayland::Keyboard constructor has already run, creating the keyboard
      * resource. It is thus safe to send a keymap event to it; the client will receive
      * the keyboard object before this event.
@@ -131,19 +126,19 @@ void mf::KeyboardHelper::set_keymap(std::shared_ptr<mi::Keymap> const& new_keyma
     }
 
     current_keymap = new_keymap;
-    compiled_keymap = new_keymap->make_unique_xkb_keymap(context.get());
+    auto const file = keymap_files->file_for(new_keymap);
 
-    std::unique_ptr<char, void(*)(void*)> buffer{xkb_keymap_get_as_string(
-        compiled_keymap.get(),
-        XKB_KEYMAP_FORMAT_TEXT_V1),
-        free};
-    // so the null terminator is included
-    auto length = strlen(buffer.get()) + 1;
+    if (file->sealed_fd() != Fd::invalid && callbacks->maps_keymap_privately())
+    {
+        callbacks->send_keymap_xkb_v1(file->sealed_fd(), file->size());
+        return;
+    }
 
-    mir::AnonymousShmFile shm_buffer{length};
-    memcpy(shm_buffer.base_ptr(), buffer.get(), length);
+    // The client might map the file shared, which the kernel refuses for a sealed file, so give it its own copy
+    mir::AnonymousShmFile shm_buffer{file->size()};
+    memcpy(shm_buffer.base_ptr(), file->data(), file->size());
 
-    callbacks->send_keymap_xkb_v1(Fd{IntOwnedFd{shm_buffer.fd()}}, length);
+    callbacks->send_keymap_xkb_v1(Fd{IntOwnedFd{shm_buffer.fd()}}, file->size());
 }
 
 void mf::KeyboardHelper::set_modifiers(MirXkbModifiers const& new_modifiers)
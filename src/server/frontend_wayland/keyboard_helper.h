@@ -26,11 +26,6 @@
 struct MirEvent;
 struct MirKeyboardEvent;
 
-// from <xkbcommon/xkbcommon.h>
-struct xkb_keymap;
-struct xkb_state;
-struct xkb_context;
-
 namespace mir
 {
 namespace input
@@ -41,6 +36,8 @@ class Seat;
 
 namespace frontend
 {
+class KeymapFileCache;
+
 class KeyboardCallbacks
 {
 public:
@@ -49,6 +46,8 @@ public:
 
     virtual void send_repeat_info(int32_t rate, int32_t delay) = 0;
     virtual void send_keymap_xkb_v1(mir::Fd const& fd, size_t length) = 0;
+    /// If the client is bound to map the keymap privately, it can share a sealed keymap file with other clients
+    virtual auto maps_keymap_privately() const -> bool = 0;
     virtual void send_key(std::shared_ptr<MirKeyboardEvent const> const& event) = 0;
     virtual void send_modifiers(MirXkbModifiers const& modifiers) = 0;
 
@@ -63,6 +62,7 @@ public:
     KeyboardHelper(
         KeyboardCallbacks* keybaord_impl,
         std::shared_ptr<mir::input::Keymap> const& initial_keymap,
+        std::shared_ptr<KeymapFileCache> const& keymap_files,
         std::shared_ptr<input::Seat> const& seat,
         bool enable_key_repeat);
 
@@ -82,8 +82,7 @@ private:
     std::shared_ptr<input::Seat> const mir_seat;
     MirXkbModifiers modifiers;
     std::shared_ptr<mir::input::Keymap> current_keymap;
-    std::unique_ptr<xkb_keymap, void (*)(xkb_keymap *)> compiled_keymap;
-    std::unique_ptr<xkb_context, void (*)(xkb_context *)> const context;
+    std::shared_ptr<KeymapFileCache> const keymap_files;
 };
 }
 }
@@ -0,0 +1,116 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keymap_file_cache.h"
+
+#include "mir/input/keymap.h"
+#include "mir/fatal.h"
+
+#include <xkbcommon/xkbcommon.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mf = mir::frontend;
+namespace mi = mir::input;
+
+namespace
+{
+// Enough for a user switching between a few layouts
+size_t const max_cached_keymaps{4};
+
+auto make_sealed_file(char const* data, size_t size) -> mir::Fd
+{
+    mir::Fd fd{memfd_create("mir-keymap", MFD_CLOEXEC | MFD_ALLOW_SEALING)};
+    if (fd == mir::Fd::invalid)
+    {
+        return {};
+    }
+
+    // Written rather than mapped: the kernel won't seal against writes while there's a writable mapping
+    for (size_t written{0}; written < size;)
+    {
+        auto const result = pwrite(fd, data + written, size - written, written);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return {};
+        }
+        written += result;
+    }
+
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0)
+    {
+        return {};
+    }
+
+    return fd;
+}
+}
+
+mf::KeymapFile::KeymapFile(std::string&& text)
+    : text{std::move(text)},
+      sealed_fd_{make_sealed_file(data(), size())}
+{
+}
+
+mf::KeymapFileCache::KeymapFileCache()
+    : context{xkb_context_new(XKB_CONTEXT_NO_FLAGS), &xkb_context_unref}
+{
+    if (!context)
+    {
+        fatal_error("Failed to create XKB context");
+    }
+}
+
+mf::KeymapFileCache::~KeymapFileCache() = default;
+
+auto mf::KeymapFileCache::file_for(std::shared_ptr<mi::Keymap> const& keymap) -> std::shared_ptr<KeymapFile const>
+{
+    std::lock_guard lock{mutex};
+
+    auto const cached = std::find_if(entries.begin(), entries.end(), [&](Entry const& entry)
+        {
+            return entry.keymap->matches(*keymap);
+        });
+
+    if (cached != entries.end())
+    {
+        std::rotate(entries.begin(), cached, cached + 1);
+        return entries.front().file;
+    }
+
+    auto const compiled_keymap = keymap->make_unique_xkb_keymap(context.get());
+    std::unique_ptr<char, void(*)(void*)> buffer{xkb_keymap_get_as_string(
+        compiled_keymap.get(),
+        XKB_KEYMAP_FORMAT_TEXT_V1),
+        free};
+
+    auto const file = std::make_shared<KeymapFile const>(std::string{buffer.get()});
+    entries.insert(entries.begin(), Entry{keymap, file});
+    if (entries.size() > max_cached_keymaps)
+    {
+        entries.pop_back();
+    }
+    return file;
+}
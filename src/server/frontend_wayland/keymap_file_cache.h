@@ -0,0 +1,88 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_KEYMAP_FILE_CACHE_H_
+#define MIR_FRONTEND_KEYMAP_FILE_CACHE_H_
+
+#include "mir/fd.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// from <xkbcommon/xkbcommon.h>
+struct xkb_context;
+
+namespace mir
+{
+namespace input
+{
+class Keymap;
+}
+
+namespace frontend
+{
+/// A keymap serialised to be sent to clients
+class KeymapFile
+{
+public:
+    explicit KeymapFile(std::string&& text);
+
+    /// The keymap as text, including the null terminator
+    auto data() const -> char const* { return text.c_str(); }
+    auto size() const -> size_t { return text.size() + 1; }
+
+    /// The text in a sealed, read-only file that any number of clients can map privately. Fd::invalid if the kernel
+    /// can't seal files, in which case each client needs its own copy.
+    auto sealed_fd() const -> mir::Fd const& { return sealed_fd_; }
+
+private:
+    std::string const text;
+    mir::Fd const sealed_fd_;
+};
+
+/**
+ * Compiles and serialises each keymap once, however many keyboards it is sent to.
+ *
+ * A few of the most recently used keymaps are kept, so switching back and forth between layouts doesn't recompile.
+ */
+class KeymapFileCache
+{
+public:
+    KeymapFileCache();
+    ~KeymapFileCache();
+
+    auto file_for(std::shared_ptr<input::Keymap> const& keymap) -> std::shared_ptr<KeymapFile const>;
+
+private:
+    KeymapFileCache(KeymapFileCache const&) = delete;
+    KeymapFileCache& operator=(KeymapFileCache const&) = delete;
+
+    struct Entry
+    {
+        std::shared_ptr<input::Keymap> keymap;
+        std::shared_ptr<KeymapFile const> file;
+    };
+
+    std::mutex mutex;
+    std::unique_ptr<xkb_context, void (*)(xkb_context *)> const context;
+    std::vector<Entry> entries; ///< Most recently used first
+};
+}
+}
+
+#endif // MIR_FRONTEND_KEYMAP_FILE_CACHE_H_
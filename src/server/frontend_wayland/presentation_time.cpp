@@ -0,0 +1,120 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "presentation_time.h"
+
+#include "wl_surface.h"
+
+#include <time.h>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mw = mir::wayland;
+
+namespace
+{
+/// Timestamps are all sent in this clock
+clockid_t const presentation_clock{CLOCK_MONOTONIC};
+
+/// Converts a timestamp to the presentation clock, if the platform used another one
+auto presentation_clock_time(mg::Frame::Timestamp const& timestamp) -> std::chrono::nanoseconds
+{
+    if (timestamp.clock_id == presentation_clock)
+    {
+        return timestamp.nanoseconds;
+    }
+
+    auto const age = mg::Frame::Timestamp::now(timestamp.clock_id) - timestamp;
+    return (mg::Frame::Timestamp::now(presentation_clock) - age).nanoseconds;
+}
+
+class PresentationGlobal : public mw::Presentation::Global
+{
+public:
+    PresentationGlobal(wl_display* display)
+        : Global{display, Version<1>()}
+    {
+    }
+
+private:
+    void bind(wl_resource* new_resource) override;
+};
+
+class Presentation : public mw::Presentation
+{
+public:
+    Presentation(wl_resource* new_resource)
+        : mw::Presentation{new_resource, Version<1>()}
+    {
+        send_clock_id_event(presentation_clock);
+    }
+
+private:
+    void feedback(wl_resource* surface, wl_resource* callback) override
+    {
+        mf::WlSurface::from(surface)->add_presentation_feedback(new mf::PresentationFeedback{callback});
+    }
+};
+
+void PresentationGlobal::bind(wl_resource* new_resource)
+{
+    new Presentation{new_resource};
+}
+}
+
+mf::PresentationFeedback::PresentationFeedback(wl_resource* new_resource)
+    : mw::PresentationFeedback{new_resource, Version<1>()}
+{
+}
+
+void mf::PresentationFeedback::send(std::optional<mg::FramePresentation> const& presentation)
+{
+    if (presentation)
+    {
+        // We don't know which wl_output the frame was synchronised to, so sync_output isn't sent
+        auto const time = presentation_clock_time(presentation->frame.ust).count();
+        uint64_t const seconds = time / 1000000000;
+        uint64_t const msc = presentation->frame.msc;
+
+        uint32_t flags = 0;
+        if (presentation->vsync)
+            flags |= Kind::vsync;
+        if (presentation->hw_clock)
+            flags |= Kind::hw_clock | Kind::hw_completion;
+        if (presentation->zero_copy)
+            flags |= Kind::zero_copy;
+
+        send_presented_event(
+            seconds >> 32,
+            seconds & 0xffffffff,
+            time % 1000000000,
+            presentation->refresh.count(),
+            msc >> 32,
+            msc & 0xffffffff,
+            flags);
+    }
+    else
+    {
+        send_discarded_event();
+    }
+
+    destroy_and_delete();
+}
+
+auto mf::create_presentation_time(wl_display* display) -> std::shared_ptr<mw::Presentation::Global>
+{
+    return std::make_shared<PresentationGlobal>(display);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tearing_control_v1.h"
+
+#include "wl_surface.h"
+
+#include <boost/throw_exception.hpp>
+
+namespace mf = mir::frontend;
+namespace mw = mir::wayland;
+
+namespace
+{
+class TearingControlManagerV1Global : public mw::TearingControlManagerV1::Global
+{
+public:
+    TearingControlManagerV1Global(wl_display* display)
+        : Global{display, Version<1>()}
+    {
+    }
+
+private:
+    void bind(wl_resource* new_resource) override;
+};
+
+class TearingControlManagerV1 : public mw::TearingControlManagerV1
+{
+public:
+    TearingControlManagerV1(wl_resource* new_resource)
+        : mw::TearingControlManagerV1{new_resource, Version<1>()}
+    {
+    }
+
+private:
+    void get_tearing_control(wl_resource* id, wl_resource* surface) override;
+};
+
+/// Whether a surface's content may tear, to be shown sooner
+class TearingControlV1 : public mw::TearingControlV1
+{
+public:
+    TearingControlV1(wl_resource* new_resource, mf::WlSurface* surface)
+        : mw::TearingControlV1{new_resource, Version<1>()},
+          surface{surface}
+    {
+        surface->set_has_tearing_control(true);
+    }
+
+    ~TearingControlV1()
+    {
+        // The hint reverts to vsync on the next commit
+        if (surface)
+        {
+            surface.value().set_has_tearing_control(false);
+            surface.value().set_pending_allow_tearing(false);
+        }
+    }
+
+private:
+    void set_presentation_hint(uint32_t hint) override
+    {
+        if (surface)
+        {
+            surface.value().set_pending_allow_tearing(hint == PresentationHint::async);
+        }
+    }
+
+    mw::Weak<mf::WlSurface> const surface;
+};
+
+void TearingControlManagerV1Global::bind(wl_resource* new_resource)
+{
+    new TearingControlManagerV1{new_resource};
+}
+
+void TearingControlManagerV1::get_tearing_control(wl_resource* id, wl_resource* surface)
+{
+    auto const wl_surface = mf::WlSurface::from(surface);
+
+    if (wl_surface->has_tearing_control())
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            resource,
+            Error::tearing_control_exists,
+            "wl_surface already has a %s", mw::TearingControlV1::interface_name));
+    }
+
+    new TearingControlV1{id, wl_surface};
+}
+}
+
+auto mf::create_tearing_control_manager_v1(wl_display* display)
+    -> std::shared_ptr<mw::TearingControlManagerV1::Global>
+{
+    return std::make_shared<TearingControlManagerV1Global>(display);
+}
@@ -37,6 +37,8 @@
 #include "idle_inhibit_v1.h"
 #include "wlr_screencopy_v1.h"
 #include "primary_selection_v1.h"
+#include "presentation_time.h"
+#include "tearing_control_v1.h"
 
 #include "mir/graphics/platform.h"
 #include "mir/options/default_configuration.h"
@@ -173,6 +175,14 @@ std::vector<ExtensionBuilder> const internal_extension_builders = {
         {
             return mf::create_primary_selection_device_manager_v1(ctx.display, ctx.wayland_executor, ctx.primary_selection_clipboard);
         }),
+    make_extension_builder<mw::Presentation>([](auto const& ctx)
+        {
+            return mf::create_presentation_time(ctx.display);
+        }),
+    make_extension_builder<mw::TearingControlManagerV1>([](auto const& ctx)
+        {
+            return mf::create_tearing_control_manager_v1(ctx.display);
+        }),
 };
 
 ExtensionBuilder const xwayland_builder {
@@ -270,7 +280,9 @@ auto mf::get_standard_extensions() -> std::vector<std::string>
         mw::XdgOutputManagerV1::interface_name,
         mw::TextInputManagerV1::interface_name,
         mw::TextInputManagerV2::interface_name,
-        mw::TextInputManagerV3::interface_name};
+        mw::TextInputManagerV3::interface_name,
+        mw::Presentation::interface_name,
+        mw::TearingControlManagerV1::interface_name};
 }
 
 auto mf::get_supported_extensions() -> std::vector<std::string>
@@ -64,6 +64,7 @@ void mf::WaylandSurfaceObserver::attrib_changed(ms::Surface const*, MirWindowAtt
             [value](Impl* impl, WindowWlSurfaceRole* window)
             {
                 impl->current_state = static_cast<MirWindowState>(value);
+                window->update_scanout_candidate(impl->current_state);
                 window->handle_state_change(impl->current_state);
             });
         break;
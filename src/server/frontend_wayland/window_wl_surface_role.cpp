@@ -280,6 +280,15 @@ void mf::WindowWlSurfaceRole::remove_state_now(MirWindowState state)
     }
 }
 
+void mf::WindowWlSurfaceRole::update_scanout_candidate(MirWindowState state)
+{
+    if (surface)
+    {
+        // A fullscreen window covers its output, so the compositor can try to bypass composition
+        surface.value().set_scanout_candidate(state == mir_window_state_fullscreen);
+    }
+}
+
 auto mf::WindowWlSurfaceRole::pending_size() const -> geom::Size
 {
     auto size = current_size();
@@ -97,6 +97,9 @@ public:
     void remove_state_now(MirWindowState state);
     void create_scene_surface();
 
+    /// Lets the surface's clients know whether its buffers could be scanned out directly
+    void update_scanout_candidate(MirWindowState state);
+
     /// Gets called after the surface has committed (so current_size() may return the committed buffer size) but before
     /// the Mir window is modified (so if a pending size is set or a spec is applied those changes will take effect)
     virtual void handle_commit() = 0;
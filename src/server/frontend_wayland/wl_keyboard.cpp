@@ -99,6 +99,12 @@ void mf::WlKeyboard::send_keymap_xkb_v1(mir::Fd const& fd, size_t length)
     send_keymap_event(KeymapFormat::xkb_v1, fd, length);
 }
 
+auto mf::WlKeyboard::maps_keymap_privately() const -> bool
+{
+    // From version 7 clients must map the keymap MAP_PRIVATE
+    return wl_resource_get_version(resource) >= 7;
+}
+
 void mf::WlKeyboard::send_key(std::shared_ptr<MirKeyboardEvent const> const& event)
 {
     auto const serial = client->next_serial(event);;
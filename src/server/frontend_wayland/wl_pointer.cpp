@@ -540,7 +540,7 @@ WlSurfaceCursor::WlSurfaceCursor(mf::WlSurface* surface, geom::Displacement hots
     surface->set_role(&surface_role);
 
     stream->set_frame_posted_callback(
-        [this](auto)
+        [this](auto, auto)
         {
             this->apply_latest_buffer();
         });
@@ -552,7 +552,7 @@ WlSurfaceCursor::~WlSurfaceCursor()
     {
         surface.value().clear_role();
     }
-    stream->set_frame_posted_callback([](auto){});
+    stream->set_frame_posted_callback([](auto, auto){});
 }
 
 void WlSurfaceCursor::apply_to(mf::WlSurface* surface)
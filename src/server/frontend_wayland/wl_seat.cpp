@@ -23,6 +23,7 @@
 #include "wl_keyboard.h"
 #include "wl_pointer.h"
 #include "wl_touch.h"
+#include "keymap_file_cache.h"
 
 #include "mir/executor.h"
 #include "mir/wayland/client.h"
@@ -195,6 +196,7 @@ mf::WlSeat::WlSeat(
     bool enable_key_repeat)
     :   Global(display, Version<8>()),
         keymap{std::make_shared<input::ParameterKeymap>()},
+        keymap_files{std::make_shared<KeymapFileCache>()},
         config_observer{
             std::make_shared<ConfigObserver>(
                 keymap,
@@ -250,7 +252,7 @@ void mf::WlSeat::for_each_listener(mw::Client* client, std::function<void(WlTouc
 
 auto mf::WlSeat::make_keyboard_helper(KeyboardCallbacks* callbacks) -> std::unique_ptr<KeyboardHelper>
 {
-    return std::make_unique<KeyboardHelper>(callbacks, keymap, seat, enable_key_repeat);
+    return std::make_unique<KeyboardHelper>(callbacks, keymap, keymap_files, seat, enable_key_repeat);
 }
 
 void mf::WlSeat::bind(wl_resource* new_wl_seat)
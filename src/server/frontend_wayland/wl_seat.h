@@ -48,6 +48,7 @@ class WlTouch;
 class WlSurface;
 class KeyboardCallbacks;
 class KeyboardHelper;
+class KeymapFileCache;
 
 class WlSeat : public wayland::Seat::Global
 {
@@ -103,6 +104,7 @@ private:
     class KeyboardObserver;
 
     std::shared_ptr<mir::input::Keymap> keymap;
+    std::shared_ptr<KeymapFileCache> const keymap_files;
     std::shared_ptr<ConfigObserver> const config_observer;
     std::shared_ptr<ObserverRegistrar<input::KeyboardObserver>> const keyboard_observer_registrar;
     std::shared_ptr<KeyboardObserver> const keyboard_observer;
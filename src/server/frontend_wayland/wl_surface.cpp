@@ -22,6 +22,7 @@
 #include "wl_region.h"
 #include "shm.h"
 #include "deleted_for_resource.h"
+#include "presentation_time.h"
 
 #include "wayland_wrapper.h"
 
@@ -35,11 +36,14 @@
 #include "mir/compositor/buffer_stream.h"
 #include "mir/executor.h"
 #include "mir/graphics/graphic_buffer_allocator.h"
+#include "mir/graphics/incremental_buffer.h"
 #include "mir/scene/surface.h"
 #include "mir/shell/surface_specification.h"
 #include "mir/log.h"
 
+#include <algorithm>
 #include <chrono>
+#include <limits>
 #include <boost/throw_exception.hpp>
 #include <wayland-server-protocol.h>
 
@@ -48,6 +52,60 @@ namespace geom = mir::geometry;
 namespace mw = mir::wayland;
 namespace msh = mir::shell;
 
+namespace
+{
+/// Clients commonly damage (0, 0, INT32_MAX, INT32_MAX) to mean "everything", so clamp the far edges to avoid
+/// overflowing when they are later calculated
+auto damage_rect(int32_t x, int32_t y, int32_t width, int32_t height) -> std::optional<geom::Rectangle>
+{
+    if (width <= 0 || height <= 0)
+        return std::nullopt;
+
+    int64_t const max = std::numeric_limits<int32_t>::max();
+    auto const clamped_width = std::min<int64_t>(width, max - std::max<int64_t>(x, 0));
+    auto const clamped_height = std::min<int64_t>(height, max - std::max<int64_t>(y, 0));
+    return geom::Rectangle{{x, y}, {static_cast<int32_t>(clamped_width), static_cast<int32_t>(clamped_height)}};
+}
+
+/// Converts damage in buffer coordinates to surface coordinates, rounding outwards
+auto buffer_to_surface_damage(geom::Rectangle const& rect, int scale) -> geom::Rectangle
+{
+    if (scale <= 1)
+        return rect;
+
+    auto const floor_div = [scale](int value)
+        {
+            return value >= 0 ? value / scale : -((-value + scale - 1) / scale);
+        };
+    auto const ceil_div = [scale](int value)
+        {
+            return value >= 0 ? (value + scale - 1) / scale : -(-value / scale);
+        };
+    auto const left = floor_div(rect.left().as_int());
+    auto const top = floor_div(rect.top().as_int());
+    auto const right = ceil_div(rect.right().as_int());
+    auto const bottom = ceil_div(rect.bottom().as_int());
+    return {{left, top}, {right - left, bottom - top}};
+}
+
+/// Converts damage in surface coordinates to buffer coordinates, clipped to the buffer
+auto surface_to_buffer_damage(geom::Rectangle const& rect, int scale, geom::Size const& buffer_size) -> geom::Rectangle
+{
+    scale = std::max(scale, 1);
+
+    // Clip first, so that scaling up can't overflow
+    geom::Rectangle const surface_area{
+        {0, 0},
+        {(buffer_size.width.as_int() + scale - 1) / scale, (buffer_size.height.as_int() + scale - 1) / scale}};
+    auto const clipped = intersection_of(rect, surface_area);
+
+    geom::Rectangle const scaled{
+        {clipped.left().as_int() * scale, clipped.top().as_int() * scale},
+        {clipped.size.width.as_int() * scale, clipped.size.height.as_int() * scale}};
+    return intersection_of(scaled, geom::Rectangle{{0, 0}, buffer_size});
+}
+}
+
 mf::WlSurfaceState::Callback::Callback(wl_resource* new_resource)
     : mw::Callback{new_resource, Version<1>()}
 {
@@ -67,10 +125,26 @@ void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
     if (source.input_shape)
         input_shape = source.input_shape;
 
+    if (source.opaque_region)
+        opaque_region = source.opaque_region;
+
+    if (source.allow_tearing)
+        allow_tearing = source.allow_tearing;
+
     frame_callbacks.insert(end(frame_callbacks),
                            begin(source.frame_callbacks),
                            end(source.frame_callbacks));
 
+    presentation_feedbacks.insert(end(presentation_feedbacks),
+                                  begin(source.presentation_feedbacks),
+                                  end(source.presentation_feedbacks));
+
+    for (auto const& rect : source.surface_damage)
+        surface_damage.add(rect);
+
+    for (auto const& rect : source.buffer_damage)
+        buffer_damage.add(rect);
+
     if (source.surface_data_invalidated)
         surface_data_invalidated = true;
 }
@@ -79,6 +153,8 @@ bool mf::WlSurfaceState::surface_data_needs_refresh() const
 {
     return offset ||
            input_shape ||
+           opaque_region ||
+           allow_tearing ||
            surface_data_invalidated;
 }
 
@@ -107,6 +183,15 @@ mf::WlSurface::~WlSurface()
     // all bases and non-variant members have already been destroyed."
     try
     {
+        // Content that was never committed won't be shown
+        for (auto const& feedback : pending.presentation_feedbacks)
+        {
+            if (feedback)
+            {
+                feedback.value().send(std::nullopt);
+            }
+        }
+
         // Destroy the buffer stream first, as surface_destroyed() may throw
         session->destroy_buffer_stream(stream);
         role->surface_destroyed();
@@ -199,7 +284,7 @@ void mf::WlSurface::populate_surface_data(std::vector<shell::StreamSpecification
 {
     geometry::Displacement offset = parent_offset + offset_;
 
-    buffer_streams.push_back(msh::StreamSpecification{stream, offset, {}});
+    buffer_streams.push_back(msh::StreamSpecification{stream, offset, {}, opaque_region, allow_tearing});
     geom::Rectangle surface_rect = {geom::Point{} + offset, buffer_size_.value_or(geom::Size{})};
     if (input_shape)
     {
@@ -230,6 +315,37 @@ void mf::WlSurface::populate_surface_data(std::vector<shell::StreamSpecification
     }
 }
 
+void mf::WlSurface::set_scanout_candidate(bool candidate)
+{
+    if (candidate == scanout_candidate)
+    {
+        return;
+    }
+    scanout_candidate = candidate;
+
+    // A listener may remove itself
+    auto const listeners = scanout_candidate_listeners;
+    for (auto const& [key, on_change] : listeners)
+    {
+        on_change();
+    }
+}
+
+auto mf::WlSurface::is_scanout_candidate() const -> bool
+{
+    return scanout_candidate;
+}
+
+void mf::WlSurface::add_scanout_candidate_listener(void const* key, std::function<void()> const& on_change)
+{
+    scanout_candidate_listeners[key] = on_change;
+}
+
+void mf::WlSurface::remove_scanout_candidate_listener(void const* key)
+{
+    scanout_candidate_listeners.erase(key);
+}
+
 mf::WlSurface* mf::WlSurface::from(wl_resource* resource)
 {
     void* raw_surface = wl_resource_get_user_data(resource);
@@ -263,20 +379,18 @@ void mf::WlSurface::attach(std::optional<wl_resource*> const& buffer, int32_t x,
 
 void mf::WlSurface::damage(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    if (auto const rect = damage_rect(x, y, width, height))
+    {
+        pending.surface_damage.add(rect.value());
+    }
 }
 
 void mf::WlSurface::damage_buffer(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    if (auto const rect = damage_rect(x, y, width, height))
+    {
+        pending.buffer_damage.add(rect.value());
+    }
 }
 
 void mf::WlSurface::frame(wl_resource* new_callback)
@@ -285,10 +399,28 @@ void mf::WlSurface::frame(wl_resource* new_callback)
     pending.frame_callbacks.push_back(wayland::make_weak(callback));
 }
 
+void mf::WlSurface::add_presentation_feedback(PresentationFeedback* feedback)
+{
+    pending.presentation_feedbacks.push_back(wayland::make_weak(feedback));
+}
+
+void mf::WlSurface::set_pending_allow_tearing(bool allow)
+{
+    pending.allow_tearing = allow;
+}
+
 void mf::WlSurface::set_opaque_region(std::optional<wl_resource*> const& region)
 {
-    (void)region;
-    // This isn't essential, but could enable optimizations
+    if (region)
+    {
+        auto shape = WlRegion::from(region.value())->rectangle_vector();
+        pending.opaque_region = decltype(pending.opaque_region)::value_type{std::move(shape)};
+    }
+    else
+    {
+        // A null region means nothing is known to be opaque
+        pending.opaque_region = decltype(pending.opaque_region)::value_type{};
+    }
 }
 
 void mf::WlSurface::set_input_region(std::optional<wl_resource*> const& region)
@@ -319,8 +451,17 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     if (state.input_shape)
         input_shape = state.input_shape.value();
 
+    if (state.opaque_region)
+        opaque_region = state.opaque_region.value();
+
+    if (state.allow_tearing)
+        allow_tearing = state.allow_tearing.value();
+
     if (state.scale)
+    {
+        scale = state.scale.value();
         stream->set_scale(state.scale.value());
+    }
 
     auto const executor_send_frame_callbacks = [executor = wayland_executor, weak_self = mw::make_weak(this)]()
         {
@@ -333,6 +474,22 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                 });
         };
 
+    auto const executor_send_presentation_feedback =
+        [executor = wayland_executor, feedbacks = state.presentation_feedbacks](
+            std::optional<graphics::FramePresentation> const& presentation)
+        {
+            executor->spawn([feedbacks, presentation]()
+                {
+                    for (auto const& feedback : feedbacks)
+                    {
+                        if (feedback)
+                        {
+                            feedback.value().send(presentation);
+                        }
+                    }
+                });
+        };
+
     if (state.buffer)
     {
         wl_resource * buffer = *state.buffer;
@@ -341,7 +498,12 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
         {
             // TODO: unmap surface, and unmap all subsurfaces
             buffer_size_ = std::nullopt;
+            last_shm_buffer.reset();
             send_frame_callbacks();
+            if (!state.presentation_feedbacks.empty())
+            {
+                executor_send_presentation_feedback(std::nullopt);
+            }
         }
         else
         {
@@ -358,8 +520,34 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             {
                 mir_buffer = allocator->buffer_from_shm(
                     shm_buffer->data(),
-                    std::move(executor_send_frame_callbacks),
+                    [](){},
                     std::move(release_buffer));
+
+                // Let the new buffer reuse what was done for the last one, if only part of it has changed
+                auto const incremental = dynamic_cast<graphics::IncrementalBuffer*>(mir_buffer->native_buffer_base());
+                auto const previous = last_shm_buffer.lock();
+                if (incremental && previous &&
+                    (state.surface_damage.size() != 0 || state.buffer_damage.size() != 0))
+                {
+                    auto const buffer_size = mir_buffer->size();
+                    geom::Rectangles damage;
+                    for (auto const& rect : state.buffer_damage)
+                    {
+                        damage.add(intersection_of(rect, geom::Rectangle{{0, 0}, buffer_size}));
+                    }
+                    for (auto const& rect : state.surface_damage)
+                    {
+                        damage.add(surface_to_buffer_damage(rect, scale, buffer_size));
+                    }
+                    incremental->replaces(*previous, damage);
+                }
+                if (incremental)
+                {
+                    // Start uploading now, rather than when the compositor first renders it
+                    incremental->prepare();
+                }
+                last_shm_buffer = mir_buffer;
+
                 tracepoint(
                     mir_server_wayland,
                     sw_buffer_committed,
@@ -368,9 +556,11 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             }
             else
             {
+                // The next SHM buffer's damage is relative to this one, not to the last SHM buffer
+                last_shm_buffer.reset();
                 mir_buffer = allocator->buffer_from_resource(
                     buffer,
-                    std::move(executor_send_frame_callbacks),
+                    [](){},
                     std::move(release_buffer));
                 tracepoint(
                     mir_server_wayland,
@@ -379,7 +569,33 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                     mir_buffer->id().as_value());
             }
 
-            stream->submit_buffer(mir_buffer);
+            if (state.surface_damage.size() == 0 && state.buffer_damage.size() == 0)
+            {
+                // Some clients attach new buffers without damaging them, and expect them to be shown anyway
+                stream->submit_buffer(mir_buffer);
+            }
+            else
+            {
+                // Damage is given to the stream in logical (surface) coordinates, it is clipped to the buffer there
+                geom::Rectangles damage{state.surface_damage};
+                for (auto const& rect : state.buffer_damage)
+                {
+                    damage.add(buffer_to_surface_damage(rect, scale));
+                }
+                stream->submit_buffer(mir_buffer, damage);
+            }
+
+            // Frame callbacks are sent when the buffer is on screen, so clients draw at the rate of their output
+            if (!stream->when_presented(executor_send_frame_callbacks))
+            {
+                frame_callback_executor->spawn(std::move(executor_send_frame_callbacks));
+            }
+
+            if (!state.presentation_feedbacks.empty())
+            {
+                stream->when_buffer_presented(executor_send_presentation_feedback);
+            }
+
             auto const new_buffer_size = stream->stream_size();
 
             if (!input_shape && std::make_optional(new_buffer_size) != buffer_size_)
@@ -392,7 +608,17 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     }
     else
     {
-        frame_callback_executor->spawn(std::move(executor_send_frame_callbacks));
+        if (!stream->when_presented(executor_send_frame_callbacks))
+        {
+            // The surface isn't on an output, so there is no frame to wait for
+            frame_callback_executor->spawn(std::move(executor_send_frame_callbacks));
+        }
+
+        // Without a new buffer, this commit is shown with the buffer we already have
+        if (!state.presentation_feedbacks.empty())
+        {
+            stream->when_buffer_presented(executor_send_presentation_feedback);
+        }
     }
 
     for (WlSubsurface* child: children)
@@ -412,6 +638,12 @@ void mf::WlSurface::commit()
     if (pending.input_shape && *pending.input_shape == input_shape)
         pending.input_shape = std::nullopt;
 
+    if (pending.opaque_region && *pending.opaque_region == opaque_region)
+        pending.opaque_region = std::nullopt;
+
+    if (pending.allow_tearing && *pending.allow_tearing == allow_tearing)
+        pending.allow_tearing = std::nullopt;
+
     // order is important
     auto const state = std::move(pending);
     pending = WlSurfaceState();
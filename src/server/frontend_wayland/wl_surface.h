@@ -22,10 +22,12 @@
 
 #include "wl_surface_role.h"
 
+#include "mir/graphics/scanout_candidate.h"
 #include "mir/geometry/displacement.h"
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
 
 #include <vector>
 #include <map>
@@ -54,6 +56,7 @@ namespace frontend
 {
 class WlSurface;
 class WlSubsurface;
+class PresentationFeedback;
 
 struct WlSurfaceState
 {
@@ -78,7 +81,15 @@ struct WlSurfaceState
     std::optional<int> scale;
     std::optional<geometry::Displacement> offset;
     std::optional<std::optional<std::vector<geometry::Rectangle>>> input_shape;
+    std::optional<std::optional<std::vector<geometry::Rectangle>>> opaque_region;
+    /// From the wp_tearing_control_v1 presentation hint
+    std::optional<bool> allow_tearing;
     std::vector<wayland::Weak<Callback>> frame_callbacks;
+    std::vector<wayland::Weak<PresentationFeedback>> presentation_feedbacks;
+    /// Damage in surface-local logical coordinates (from wl_surface.damage)
+    geometry::Rectangles surface_damage;
+    /// Damage in buffer coordinates (from wl_surface.damage_buffer)
+    geometry::Rectangles buffer_damage;
 
 private:
     // only set to true if invalidate_surface_data() is called
@@ -101,7 +112,7 @@ private:
     WlSurface* const surface;
 };
 
-class WlSurface : public wayland::Surface
+class WlSurface : public wayland::Surface, public graphics::ScanoutCandidate
 {
 public:
     WlSurface(wl_resource* new_resource,
@@ -132,6 +143,21 @@ public:
     void commit(WlSurfaceState const& state);
     auto confine_pointer_state() const -> MirPointerConfinementState;
 
+    /// Takes ownership of feedback, which reports when the next commit is shown
+    void add_presentation_feedback(PresentationFeedback* feedback);
+
+    /// Whether a wp_tearing_control_v1 extends this surface (there may only be one at a time)
+    auto has_tearing_control() const -> bool { return tearing_controlled; }
+    void set_has_tearing_control(bool has) { tearing_controlled = has; }
+    /// Sets whether, from the next commit, the content may tear to be shown sooner
+    void set_pending_allow_tearing(bool allow);
+
+    /// Set by the window role, when the window becomes (or stops being) fullscreen
+    void set_scanout_candidate(bool candidate);
+    auto is_scanout_candidate() const -> bool override;
+    void add_scanout_candidate_listener(void const* key, std::function<void()> const& on_change) override;
+    void remove_scanout_candidate_listener(void const* key) override;
+
     std::shared_ptr<scene::Session> const session;
     std::shared_ptr<compositor::BufferStream> const stream;
 
@@ -148,9 +174,17 @@ private:
 
     WlSurfaceState pending;
     geometry::Displacement offset_;
+    int scale{1};
     std::optional<geometry::Size> buffer_size_;
+    /// The last SHM buffer committed; it isn't kept alive, as that would delay its release
+    std::weak_ptr<graphics::Buffer> last_shm_buffer;
     std::vector<wayland::Weak<WlSurfaceState::Callback>> frame_callbacks;
     std::optional<std::vector<mir::geometry::Rectangle>> input_shape;
+    std::optional<std::vector<mir::geometry::Rectangle>> opaque_region;
+    bool allow_tearing{false};
+    bool tearing_controlled{false};
+    bool scanout_candidate{false};
+    std::map<void const*, std::function<void()>> scanout_candidate_listeners;
 
     void send_frame_callbacks();
 
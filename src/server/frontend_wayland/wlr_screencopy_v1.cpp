@@ -20,6 +20,7 @@
 #include "mir/graphics/graphic_buffer_allocator.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/graphics/buffer.h"
+#include "mir/graphics/dmabuf_buffer.h"
 #include "mir/scene/scene_change_notification.h"
 #include "mir/frontend/surface_stack.h"
 #include "mir/geometry/rectangles.h"
@@ -32,6 +33,7 @@
 #include "shm.h"
 
 #include <boost/throw_exception.hpp>
+#include <drm_fourcc.h>
 #include <mutex>
 #include <optional>
 
@@ -156,6 +158,7 @@ public:
 
 private:
     void prepare_target(wl_resource* buffer);
+    void prepare_dmabuf_target(wl_resource* buffer);
     void report_result(std::optional<time::Timestamp> captured_time, geom::Rectangle buffer_space_damage);
 
     /// From wayland::WlrScreencopyFrameV1
@@ -174,6 +177,8 @@ private:
     bool copy_has_been_called{false};
     bool should_send_damage{false};
     std::shared_ptr<renderer::software::WriteMappableBuffer> target;
+    /// Set instead of target when the client gives us a dmabuf to render into
+    std::shared_ptr<graphics::DMABufBuffer> dmabuf_target;
     /// @}
 };
 }
@@ -257,7 +262,10 @@ void mf::WlrScreencopyV1DamageTracker::create_change_notifier()
         };
     change_notifier = std::make_shared<ms::SceneChangeNotification>(
         [callback](){ callback(std::nullopt); },
-        [callback=std::move(callback)](int, geom::Rectangle const& damage){ callback(damage); });
+        [callback=std::move(callback)](int, mg::Renderable::ID, geom::Rectangles const& damage)
+        {
+            callback(damage.bounding_rectangle());
+        });
     surface_stack.add_observer(change_notifier);
 }
 
@@ -414,18 +422,22 @@ mf::WlrScreencopyFrameV1::WlrScreencopyFrameV1(
         params.buffer_size.width.as_uint32_t(),
         params.buffer_size.height.as_uint32_t(),
         stride.as_uint32_t());
+    send_linux_dmabuf_event_if_supported(
+        DRM_FORMAT_XRGB8888,
+        params.buffer_size.width.as_uint32_t(),
+        params.buffer_size.height.as_uint32_t());
     send_buffer_done_event_if_supported();
 }
 
 void mf::WlrScreencopyFrameV1::capture(geom::Rectangle buffer_space_damage)
 {
-    if (!target)
+    if (!target && !dmabuf_target)
     {
         fatal_error(
             "WlrScreencopyFrameV1::capture() called without a target, copy %s been called",
             copy_has_been_called ? "has" : "has not");
     }
-    ctx->screen_shooter->capture(std::move(target), params.output_space_area,
+    auto on_captured =
         [wayland_executor=ctx->wayland_executor, buffer_space_damage, self=mw::make_weak(this)]
             (std::optional<time::Timestamp> captured_time)
         {
@@ -436,7 +448,24 @@ void mf::WlrScreencopyFrameV1::capture(geom::Rectangle buffer_space_damage)
                         self.value().report_result(captured_time, buffer_space_damage);
                     }
                 });
-        });
+        };
+
+    if (dmabuf_target)
+    {
+        ctx->screen_shooter->capture(std::move(dmabuf_target), params.output_space_area, std::move(on_captured));
+        return;
+    }
+
+    // Mapping the damage back to the output lets the screen shooter redraw only what has changed
+    auto const output_space_damage = translate_and_scale(
+        buffer_space_damage,
+        {{}, params.buffer_size},
+        params.output_space_area);
+    ctx->screen_shooter->capture(
+        std::move(target),
+        params.output_space_area,
+        output_space_damage,
+        std::move(on_captured));
 }
 
 void mf::WlrScreencopyFrameV1::prepare_target(wl_resource* buffer)
@@ -452,14 +481,19 @@ void mf::WlrScreencopyFrameV1::prepare_target(wl_resource* buffer)
     auto shm_buffer = mf::ShmBuffer::from(buffer);
     if (!shm_buffer)
     {
-        BOOST_THROW_EXCEPTION(mw::ProtocolError(
-            resource,
-            Error::invalid_buffer,
-            "Copy target is not a wl_shm buffer"));
+        prepare_dmabuf_target(buffer);
+        return;
     }
     auto shm_data = shm_buffer->data();
-    if (shm_data->format() != mir_pixel_format_argb_8888)
+    switch (shm_data->format())
     {
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888:
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888:
+        break;
+
+    default:
         BOOST_THROW_EXCEPTION(mw::ProtocolError(
             resource,
             Error::invalid_buffer,
@@ -477,12 +511,12 @@ void mf::WlrScreencopyFrameV1::prepare_target(wl_resource* buffer)
             params.buffer_size.width.as_int(),
             params.buffer_size.height.as_int()));
     }
-    if (shm_data->stride() != stride)
+    if (shm_data->stride() < stride)
     {
         BOOST_THROW_EXCEPTION(mw::ProtocolError(
             resource,
             Error::invalid_buffer,
-            "Invalid stride %d, should be %d",
+            "Invalid stride %d, should be at least %d",
             shm_data->stride().as_int(),
             stride.as_int()));
     }
@@ -533,6 +567,41 @@ void mf::WlrScreencopyFrameV1::report_result(
     }
 }
 
+void mf::WlrScreencopyFrameV1::prepare_dmabuf_target(wl_resource* buffer)
+{
+    std::shared_ptr<mg::Buffer> mir_buffer;
+    try
+    {
+        mir_buffer = ctx->allocator->buffer_from_resource(buffer, [](){}, [](){});
+    }
+    catch (std::exception const&)
+    {
+        // Not a buffer the platform can import, which is reported below
+    }
+    auto const dmabuf = mir_buffer ? dynamic_cast<mg::DMABufBuffer*>(mir_buffer->native_buffer_base()) : nullptr;
+    if (!dmabuf)
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            resource,
+            Error::invalid_buffer,
+            "Copy target is neither a wl_shm nor a linux-dmabuf buffer"));
+    }
+    if (dmabuf->size() != params.buffer_size)
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            resource,
+            Error::invalid_buffer,
+            "Invalid buffer size %dx%d, should be %dx%d",
+            dmabuf->size().width.as_int(),
+            dmabuf->size().height.as_int(),
+            params.buffer_size.width.as_int(),
+            params.buffer_size.height.as_int()));
+    }
+
+    // The capture is rendered straight into the client's buffer, which keeps the mg::Buffer (and its import) alive
+    dmabuf_target = std::shared_ptr<mg::DMABufBuffer>{mir_buffer, dmabuf};
+}
+
 void mf::WlrScreencopyFrameV1::copy(wl_resource* buffer)
 {
     prepare_target(buffer);
@@ -17,7 +17,23 @@
 #include "scaled_buffer_stream.h"
 #include "mir/log.h"
 
+#include <cmath>
+
 namespace mf = mir::frontend;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// Scales a rectangle, rounding outwards so the result always covers the original area
+auto scale_rect(geom::Rectangle const& rect, float scale) -> geom::Rectangle
+{
+    auto const left = static_cast<int>(std::floor(rect.left().as_int() * scale));
+    auto const top = static_cast<int>(std::floor(rect.top().as_int() * scale));
+    auto const right = static_cast<int>(std::ceil(rect.right().as_int() * scale));
+    auto const bottom = static_cast<int>(std::ceil(rect.bottom().as_int() * scale));
+    return {{left, top}, {right - left, bottom - top}};
+}
+}
 
 mf::ScaledBufferStream::ScaledBufferStream(std::shared_ptr<compositor::BufferStream>&& inner, float scale)
     : inner{std::move(inner)},
@@ -30,10 +46,45 @@ void mf::ScaledBufferStream::submit_buffer(std::shared_ptr<graphics::Buffer> con
     inner->submit_buffer(buffer);
 }
 
-void mf::ScaledBufferStream::set_frame_posted_callback(std::function<void(geometry::Size const&)> const& callback)
+void mf::ScaledBufferStream::submit_buffer(
+    std::shared_ptr<graphics::Buffer> const& buffer,
+    geometry::Rectangles const& damage)
+{
+    // Damage is given in our (scaled) logical coordinates, so map it back to the inner stream's
+    geometry::Rectangles inner_damage;
+    for (auto const& rect : damage)
+    {
+        inner_damage.add(scale_rect(rect, 1.0f / inv_scale));
+    }
+    inner->submit_buffer(buffer, inner_damage);
+}
+
+void mf::ScaledBufferStream::set_frame_posted_callback(
+    std::function<void(geometry::Size const&, geometry::Rectangles const&)> const& callback)
 {
     // Does this need to be scaled? I don't ? think ? so? compositor::Stream seems to leave it unscaled.
-    inner->set_frame_posted_callback(callback);
+    // The damage, however, is in logical coordinates so does need scaling.
+    inner->set_frame_posted_callback(
+        [callback, inv_scale=inv_scale](geometry::Size const& size, geometry::Rectangles const& damage)
+        {
+            geometry::Rectangles scaled_damage;
+            for (auto const& rect : damage)
+            {
+                scaled_damage.add(scale_rect(rect, inv_scale));
+            }
+            callback(size, scaled_damage);
+        });
+}
+
+auto mf::ScaledBufferStream::when_presented(std::function<void()> const& callback) -> bool
+{
+    return inner->when_presented(callback);
+}
+
+void mf::ScaledBufferStream::when_buffer_presented(
+    std::function<void(std::optional<graphics::FramePresentation> const&)> const& callback)
+{
+    inner->when_buffer_presented(callback);
 }
 
 void mf::ScaledBufferStream::with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& exec)
@@ -36,7 +36,12 @@ public:
     /// Overrides from frontend::BufferStream
     /// @{
     void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer);
-    void set_frame_posted_callback(std::function<void(geometry::Size const&)> const& callback);
+    void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer, geometry::Rectangles const& damage);
+    void set_frame_posted_callback(
+        std::function<void(geometry::Size const&, geometry::Rectangles const&)> const& callback);
+    auto when_presented(std::function<void()> const& callback) -> bool;
+    void when_buffer_presented(
+        std::function<void(std::optional<graphics::FramePresentation> const&)> const& callback);
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& exec);
     MirPixelFormat pixel_format() const;
     void allow_framedropping(bool allow);
@@ -35,6 +35,7 @@
 #include "mir/emergency_cleanup.h"
 #include "mir/log.h"
 #include "mir/report_exception.h"
+#include "mir/startup_timeline.h"
 #include "mir/main_loop.h"
 
 #include <boost/throw_exception.hpp>
@@ -146,6 +147,7 @@ auto mir::DefaultServerConfiguration::the_display_platforms() -> std::vector<std
         {
             auto const& path = the_options()->get<std::string>(options::platform_path);
             auto platforms = mir::libraries_for_path(path, *the_shared_library_prober_report());
+            startup_timeline::phase_completed("platform modules loaded");
 
             if (platforms.empty())
             {
@@ -191,6 +193,7 @@ auto mir::DefaultServerConfiguration::the_display_platforms() -> std::vector<std
             {
                 platform_modules = mir::graphics::display_modules_for_device(platforms, dynamic_cast<mir::options::ProgramOption&>(*the_options()), the_console_services());
             }
+            startup_timeline::phase_completed("display platforms probed");
 
             for (auto const& [device, platform]: platform_modules)
             {
@@ -249,6 +252,7 @@ auto mir::DefaultServerConfiguration::the_rendering_platforms() ->
         {
             auto const& path = the_options()->get<std::string>(options::platform_path);
             auto platforms = mir::libraries_for_path(path, *the_shared_library_prober_report());
+            startup_timeline::phase_completed("platform modules loaded");
 
             if (platforms.empty())
             {
@@ -294,6 +298,7 @@ auto mir::DefaultServerConfiguration::the_rendering_platforms() ->
             {
                 platform_modules = mir::graphics::rendering_modules_for_device(platforms, dynamic_cast<mir::options::ProgramOption&>(*the_options()), the_console_services());
             }
+            startup_timeline::phase_completed("rendering platforms probed");
 
             for (auto const& [device, platform]: platform_modules)
             {
@@ -362,9 +367,11 @@ mir::DefaultServerConfiguration::the_display()
     return display(
         [this]() -> std::shared_ptr<mg::Display>
         {
-            return the_display_platforms().front()->create_display(
+            auto display = the_display_platforms().front()->create_display(
                 the_display_configuration_policy(),
                 the_gl_config());
+            startup_timeline::phase_completed("display configured");
+            return display;
         });
 }
 
@@ -15,35 +15,42 @@
  */
 
 #include "mir/log.h"
+#include "mir/console_services.h"
 #include "mir/graphics/platform.h"
 #include "platform_probe.h"
 
 #include <boost/throw_exception.hpp>
 
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <set>
+
 namespace mg = mir::graphics;
 
 namespace
 {
-auto probe_module(
-    mir::graphics::PlatformProbe const& probe,
-    mir::SharedLibrary& module,
-    char const* platform_type_name,
-    mir::options::ProgramOption const& options,
-    std::shared_ptr<mir::ConsoleServices> const& console) -> std::vector<mg::SupportedDevice>
+auto describe_module(mir::SharedLibrary& module) -> mir::ModuleProperties const*
 {
     auto describe = module.load_function<mir::graphics::DescribeModule>(
         "describe_graphics_module",
         MIR_SERVER_GRAPHICS_PLATFORM_VERSION);
 
-    auto desc = describe();
+    return describe();
+}
+
+void log_probe_result(
+    char const* platform_type_name,
+    mir::ModuleProperties const& desc,
+    std::vector<mg::SupportedDevice> const& supported_devices)
+{
     mir::log_info("Found %s driver: %s (version %d.%d.%d)",
                   platform_type_name,
-                  desc->name,
-                  desc->major_version,
-                  desc->minor_version,
-                  desc->micro_version);
+                  desc.name,
+                  desc.major_version,
+                  desc.minor_version,
+                  desc.micro_version);
 
-    auto supported_devices = probe(console, std::make_shared<mir::udev::Context>(), options);
     if (supported_devices.empty())
     {
         mir::log_info("(Unsupported by system environment)");
@@ -70,6 +77,18 @@ auto probe_module(
             mir::log_info("\t%s (priority %i)", device_name.c_str(), device.support_level);
         }
     }
+}
+
+auto probe_module(
+    mir::graphics::PlatformProbe const& probe,
+    mir::SharedLibrary& module,
+    char const* platform_type_name,
+    mir::options::ProgramOption const& options,
+    std::shared_ptr<mir::ConsoleServices> const& console) -> std::vector<mg::SupportedDevice>
+{
+    auto const desc = describe_module(module);
+    auto supported_devices = probe(console, std::make_shared<mir::udev::Context>(), options);
+    log_probe_result(platform_type_name, *desc, supported_devices);
     return supported_devices;
 }
 }
@@ -121,6 +140,127 @@ bool is_same_device(
     return *a == *b;
 }
 
+/**
+ * Lets several platform probes share the console while they run concurrently
+ *
+ * ConsoleServices implementations expect to be called from one thread at a time, so
+ * calls are serialised here. Probes also acquire the devices they are interested in,
+ * and two probes cannot hold the same device at once (nor, for DRM, both be master), so
+ * acquiring a device another probe holds waits until that probe releases it. Each probe
+ * holds at most one device at a time, so this cannot deadlock.
+ */
+class ProbingConsoleServices : public mir::ConsoleServices
+{
+public:
+    explicit ProbingConsoleServices(std::shared_ptr<mir::ConsoleServices> const& console)
+        : state{std::make_shared<State>(console)}
+    {
+    }
+
+    void register_switch_handlers(
+        mg::EventHandlerRegister& handlers,
+        std::function<bool()> const& switch_away,
+        std::function<bool()> const& switch_back) override
+    {
+        std::lock_guard lock{state->mutex};
+        state->console->register_switch_handlers(handlers, switch_away, switch_back);
+    }
+
+    void restore() override
+    {
+        std::lock_guard lock{state->mutex};
+        state->console->restore();
+    }
+
+    auto create_vt_switcher() -> std::unique_ptr<mir::VTSwitcher> override
+    {
+        std::lock_guard lock{state->mutex};
+        return state->console->create_vt_switcher();
+    }
+
+    auto acquire_device(int major, int minor, std::unique_ptr<mir::Device::Observer> observer)
+        -> std::future<std::unique_ptr<mir::Device>> override
+    {
+        std::unique_lock lock{state->mutex};
+        state->device_released.wait(lock, [&]() { return !state->held_devices.contains({major, minor}); });
+
+        auto device = state->console->acquire_device(major, minor, std::move(observer));
+        auto hold = std::make_unique<Hold>(state, major, minor);
+
+        // Deferred, so that if the caller drops the future without waiting on it the hold is released with it
+        return std::async(
+            std::launch::deferred,
+            [hold = std::move(hold), device = std::move(device)]() mutable -> std::unique_ptr<mir::Device>
+            {
+                return std::make_unique<HeldDevice>(device.get(), std::move(hold));
+            });
+    }
+
+private:
+    struct State
+    {
+        explicit State(std::shared_ptr<mir::ConsoleServices> const& console)
+            : console{console}
+        {
+        }
+
+        std::shared_ptr<mir::ConsoleServices> const console;
+        std::mutex mutex;
+        std::condition_variable device_released;
+        std::set<std::pair<int, int>> held_devices;
+    };
+
+    /// Reserves a device for one probe; expects the state mutex to be held on construction
+    class Hold
+    {
+    public:
+        Hold(std::shared_ptr<State> const& state, int major, int minor)
+            : state{state},
+              devnum{major, minor}
+        {
+            state->held_devices.insert(devnum);
+        }
+
+        ~Hold()
+        {
+            {
+                std::lock_guard lock{state->mutex};
+                state->held_devices.erase(devnum);
+            }
+            state->device_released.notify_all();
+        }
+
+        auto console_mutex() const -> std::mutex& { return state->mutex; }
+
+    private:
+        std::shared_ptr<State> const state;
+        std::pair<int, int> const devnum;
+    };
+
+    class HeldDevice : public mir::Device
+    {
+    public:
+        HeldDevice(std::unique_ptr<mir::Device> device, std::unique_ptr<Hold> hold)
+            : hold{std::move(hold)},
+              device{std::move(device)}
+        {
+        }
+
+        ~HeldDevice()
+        {
+            // Releasing the device calls back into the console, so serialise that too
+            std::lock_guard lock{hold->console_mutex()};
+            device.reset();
+        }
+
+    private:
+        std::unique_ptr<Hold> const hold;
+        std::unique_ptr<mir::Device> device;
+    };
+
+    std::shared_ptr<State> const state;
+};
+
 enum class ModuleType
 {
     Rendering,
@@ -134,21 +274,39 @@ auto modules_for_device(
     std::shared_ptr<mir::ConsoleServices> const& console)
 -> std::vector<std::pair<mg::SupportedDevice, std::shared_ptr<mir::SharedLibrary>>>
 {
+    auto const probe_symbol = type == ModuleType::Display ? "probe_display_platform" : "probe_rendering_platform";
+    auto const platform_type_name = type == ModuleType::Display ? "display" : "rendering";
+
+    /* Probing a module can take a while (it may set up an EGL context, or connect to a host
+     * display server), so probe all the modules at once. Each probe gets its own udev context,
+     * as libudev objects may not be used from more than one thread. The results are logged in
+     * module order once all the probes are done, so the log reads the same as a serial probe.
+     */
+    auto const probing_console = std::make_shared<ProbingConsoleServices>(console);
+    std::vector<std::future<std::vector<mg::SupportedDevice>>> probes;
+    for (auto const& module : modules)
+    {
+        probes.push_back(std::async(
+            std::launch::async,
+            [probe_symbol, &module, &options, probing_console]()
+            {
+                auto const probe = module->load_function<mg::PlatformProbe>(
+                    probe_symbol,
+                    MIR_SERVER_GRAPHICS_PLATFORM_VERSION);
+
+                return probe(probing_console, std::make_shared<mir::udev::Context>(), options);
+            }));
+    }
+
     std::vector<std::pair<mg::SupportedDevice, std::shared_ptr<mir::SharedLibrary>>> best_modules_so_far;
-    for (auto& module : modules)
+    for (auto i = 0u; i != modules.size(); ++i)
     {
+        auto const& module = modules[i];
         try
         {
-            std::vector<mg::SupportedDevice> supported_devices;
-            switch (type)
-            {
-            case ModuleType::Rendering:
-                supported_devices = mg::probe_rendering_module(*module, options, console);
-                break;
-            case ModuleType::Display:
-                supported_devices = mg::probe_display_module(*module, options, console);
-                break;
-            }
+            auto supported_devices = probes[i].get();
+            log_probe_result(platform_type_name, *describe_module(*module), supported_devices);
+
             for (auto& device : supported_devices)
             {
                 if (device.device)
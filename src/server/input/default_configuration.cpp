@@ -32,6 +32,7 @@
 #include "basic_seat.h"
 #include "seat_observer_multiplexer.h"
 #include "idle_poking_dispatcher.h"
+#include "pointer_motion_coalescing_dispatcher.h"
 
 #include "mir/input/touch_visualizer.h"
 #include "mir/input/input_probe.h"
@@ -151,8 +152,19 @@ mir::DefaultServerConfiguration::the_input_dispatcher()
             auto const keyboard_resync_dispatcher =
                 std::make_shared<mi::KeyboardResyncDispatcher>(idle_poking_dispatcher);
 
+            std::shared_ptr<mi::InputDispatcher> pointer_motion_dispatcher = keyboard_resync_dispatcher;
+            auto const max_pointer_motion_rate = options->get<int>(options::max_pointer_motion_rate_opt);
+            if (max_pointer_motion_rate > 0)
+            {
+                pointer_motion_dispatcher = std::make_shared<mi::PointerMotionCoalescingDispatcher>(
+                    keyboard_resync_dispatcher,
+                    *the_main_loop(),
+                    std::chrono::duration_cast<time::Duration>(std::chrono::seconds{1}) / max_pointer_motion_rate);
+            }
+
+            // the_default_input_device_hub() expects the KeyRepeatDispatcher to be outermost
             return std::make_shared<mi::KeyRepeatDispatcher>(
-                keyboard_resync_dispatcher, the_main_loop(), the_cookie_authority(),
+                pointer_motion_dispatcher, the_main_loop(), the_cookie_authority(),
                 enable_repeat, key_repeat_timeout, key_repeat_delay, false);
         });
 }
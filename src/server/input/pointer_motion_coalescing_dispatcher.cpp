@@ -0,0 +1,165 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pointer_motion_coalescing_dispatcher.h"
+
+#include "mir/events/pointer_event.h"
+#include "mir/time/alarm.h"
+#include "mir/time/alarm_factory.h"
+#include "mir/lockable_callback.h"
+
+namespace mi = mir::input;
+namespace mev = mir::events;
+
+namespace
+{
+/// Runs the alarm's work with the dispatcher's mutex locked, so it can't race with dispatch()
+class AlarmCallback : public mir::LockableCallback
+{
+public:
+    AlarmCallback(std::mutex& mutex, std::function<void()> const& func)
+        : mutex{mutex},
+          func{func}
+    {
+    }
+
+    void operator()() override
+    {
+        func();
+    }
+
+    void lock() override
+    {
+        mutex.lock();
+    }
+
+    void unlock() override
+    {
+        mutex.unlock();
+    }
+
+private:
+    std::mutex& mutex;
+    std::function<void()> const func;
+};
+
+/// Motion that says nothing but where the pointer has moved to, and so can be merged with other motion
+auto is_plain_motion(MirEvent const& event) -> MirPointerEvent const*
+{
+    if (event.type() != mir_event_type_input || event.to_input()->input_type() != mir_input_event_type_pointer)
+    {
+        return nullptr;
+    }
+
+    auto const pointer_event = event.to_input()->to_pointer();
+    if (pointer_event->action() != mir_pointer_action_motion ||
+        pointer_event->h_scroll() != mev::ScrollAxisH{} ||
+        pointer_event->v_scroll() != mev::ScrollAxisV{})
+    {
+        return nullptr;
+    }
+
+    return pointer_event;
+}
+
+auto can_merge(MirPointerEvent const& earlier, MirPointerEvent const& later) -> bool
+{
+    return earlier.device_id() == later.device_id() &&
+           earlier.buttons() == later.buttons() &&
+           earlier.modifiers() == later.modifiers();
+}
+}
+
+mi::PointerMotionCoalescingDispatcher::PointerMotionCoalescingDispatcher(
+    std::shared_ptr<InputDispatcher> const& next_dispatcher,
+    time::AlarmFactory& alarm_factory,
+    time::Duration interval)
+    : next_dispatcher{next_dispatcher},
+      interval{interval},
+      alarm{alarm_factory.create_alarm(std::make_unique<AlarmCallback>(mutex, [this]
+          {
+              if (pending)
+              {
+                  dispatch_pending();
+                  alarm->reschedule_in(std::chrono::ceil<std::chrono::milliseconds>(this->interval));
+              }
+              else
+              {
+                  holding = false;
+              }
+          }))}
+{
+}
+
+mi::PointerMotionCoalescingDispatcher::~PointerMotionCoalescingDispatcher()
+{
+    alarm->cancel();
+}
+
+bool mi::PointerMotionCoalescingDispatcher::dispatch(std::shared_ptr<MirEvent const> const& event)
+{
+    std::lock_guard lock{mutex};
+
+    auto const motion = is_plain_motion(*event);
+    if (!motion)
+    {
+        dispatch_pending();
+        return next_dispatcher->dispatch(event);
+    }
+
+    if (!holding)
+    {
+        holding = true;
+        alarm->reschedule_in(std::chrono::ceil<std::chrono::milliseconds>(interval));
+        return next_dispatcher->dispatch(event);
+    }
+
+    if (pending && can_merge(*pending, *motion))
+    {
+        auto const total_motion = pending->motion() + motion->motion();
+        pending.reset(motion->clone());
+        pending->set_motion(total_motion);
+    }
+    else
+    {
+        dispatch_pending();
+        pending.reset(motion->clone());
+    }
+    return true;
+}
+
+void mi::PointerMotionCoalescingDispatcher::start()
+{
+    next_dispatcher->start();
+}
+
+void mi::PointerMotionCoalescingDispatcher::stop()
+{
+    {
+        std::lock_guard lock{mutex};
+        dispatch_pending();
+    }
+    next_dispatcher->stop();
+}
+
+void mi::PointerMotionCoalescingDispatcher::dispatch_pending()
+{
+    if (pending)
+    {
+        std::shared_ptr<MirEvent const> const event{std::move(pending)};
+        next_dispatcher->dispatch(event);
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_INPUT_POINTER_MOTION_COALESCING_DISPATCHER_H_
+#define MIR_INPUT_POINTER_MOTION_COALESCING_DISPATCHER_H_
+
+#include "mir/input/input_dispatcher.h"
+#include "mir/time/types.h"
+
+#include <memory>
+#include <mutex>
+
+struct MirPointerEvent;
+
+namespace mir
+{
+namespace time
+{
+class AlarmFactory;
+class Alarm;
+}
+namespace input
+{
+/// Limits the rate at which pointer motion is passed on, merging motion that arrives faster than that.
+///
+/// After a motion event is passed on, further motion within the next interval is held back and
+/// merged into a single event. That event has the latest position, buttons and timestamp, and the
+/// sum of the relative motion, and is passed on when the interval ends. Any other event (buttons,
+/// scrolling, keys, etc.) is passed on straight away, after any motion held back before it.
+class PointerMotionCoalescingDispatcher : public InputDispatcher
+{
+public:
+    PointerMotionCoalescingDispatcher(
+        std::shared_ptr<InputDispatcher> const& next_dispatcher,
+        time::AlarmFactory& alarm_factory,
+        time::Duration interval);
+    ~PointerMotionCoalescingDispatcher();
+
+    /// InputDispatcher overrides
+    /// @{
+    bool dispatch(std::shared_ptr<MirEvent const> const& event) override;
+    void start() override;
+    void stop() override;
+    /// @}
+
+private:
+    /// Pass on any held back motion. mutex must be locked.
+    void dispatch_pending();
+
+    std::shared_ptr<InputDispatcher> const next_dispatcher;
+    time::Duration const interval;
+
+    std::mutex mutex;
+    std::unique_ptr<time::Alarm> const alarm;
+    /// Motion being held back until the alarm fires
+    std::shared_ptr<MirPointerEvent> pending;
+    /// Whether motion was passed on less than an interval ago
+    bool holding{false};
+};
+}
+}
+
+#endif // MIR_INPUT_POINTER_MOTION_COALESCING_DISPATCHER_H_
@@ -38,6 +38,10 @@ std::unique_ptr<mir::report::ReportFactory> mir::DefaultServerConfiguration::rep
     {
         return std::make_unique<report::LoggingReportFactory>(the_logger(), the_clock());
     }
+    else if (opt == options::async_log_opt_value)
+    {
+        return std::make_unique<report::LoggingReportFactory>(the_async_logger(), the_clock());
+    }
     else if (opt == options::lttng_opt_value)
     {
         return std::make_unique<report::LttngReportFactory>();
@@ -50,6 +54,7 @@ std::unique_ptr<mir::report::ReportFactory> mir::DefaultServerConfiguration::rep
     {
         throw AbnormalExit(std::string("Invalid ") + report_opt + " option: " + opt + " (valid options are: \"" +
             options::off_opt_value + "\" and \"" + options::log_opt_value +
+                           "\" and \"" + options::async_log_opt_value +
                            "\" and \"" + options::lttng_opt_value + "\")");
     }
 }
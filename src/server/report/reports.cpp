@@ -39,6 +39,7 @@ enum class ReportOutput
 {
     Discarded,
     Log,
+    AsyncLog,
     LTTNG
 };
 
@@ -52,6 +53,8 @@ std::unique_ptr<mr::ReportFactory> factory_for_type(
         return std::make_unique<mr::NullReportFactory>();
     case ReportOutput::Log:
         return std::make_unique<mr::LoggingReportFactory>(config.the_logger(), config.the_clock());
+    case ReportOutput::AsyncLog:
+        return std::make_unique<mr::LoggingReportFactory>(config.the_async_logger(), config.the_clock());
     case ReportOutput::LTTNG:
         return std::make_unique<mr::LttngReportFactory>();
     }
@@ -74,6 +77,10 @@ ReportOutput parse_report_option(std::string const& opt)
     {
         return ReportOutput::Log;
     }
+    else if (opt == mo::async_log_opt_value)
+    {
+        return ReportOutput::AsyncLog;
+    }
     else if (opt == mo::lttng_opt_value)
     {
         return ReportOutput::LTTNG;
@@ -87,6 +94,7 @@ ReportOutput parse_report_option(std::string const& opt)
         throw mir::AbnormalExit(
             std::string("Invalid report option: ") + opt + " (valid options are: \"" +
             mo::off_opt_value + "\" and \"" + mo::log_opt_value +
+            "\" and \"" + mo::async_log_opt_value +
             "\" and \"" + mo::lttng_opt_value + "\")");
     }
 }
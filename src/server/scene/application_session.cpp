@@ -316,7 +316,7 @@ void ms::ApplicationSession::configure_streams(
     for (auto& stream : streams)
     {
         if (auto const s = std::dynamic_pointer_cast<mc::BufferStream>(stream.stream.lock()))
-            list.emplace_back(ms::StreamInfo{s, stream.displacement, stream.size});
+            list.emplace_back(ms::StreamInfo{s, stream.displacement, stream.size, stream.opaque_region, stream.allow_tearing});
     }
     surface.set_streams(list); 
 }
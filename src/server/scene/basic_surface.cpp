@@ -23,6 +23,7 @@
 #include "mir/geometry/displacement.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/observer_multiplexer.h"
+#include "mir/recycling_allocator.h"
 
 #include "mir/scene/scene_report.h"
 #include "mir/scene/null_surface_observer.h"
@@ -31,6 +32,7 @@
 
 #include <stdexcept>
 #include <algorithm>
+#include <cmath>
 
 namespace mc = mir::compositor;
 namespace ms = mir::scene;
@@ -75,9 +77,13 @@ public:
         for_each_observer(&SurfaceObserver::hidden_set_to, surf, hide);
     }
 
-    void frame_posted(Surface const* surf, int frames_available, geometry::Rectangle const& damage) override
+    void frame_posted(
+        Surface const* surf,
+        int frames_available,
+        graphics::Renderable::ID source,
+        geometry::Rectangles const& damage) override
     {
-        for_each_observer(&SurfaceObserver::frame_posted, surf, frames_available, damage);
+        for_each_observer(&SurfaceObserver::frame_posted, surf, frames_available, source, damage);
     }
 
     void alpha_set_to(Surface const* surf, float alpha) override
@@ -158,6 +164,29 @@ std::shared_ptr<mc::BufferStream> default_stream(std::list<ms::StreamInfo> const
         return layers.front().stream;
 }
 
+/// Maps damage in stream-local logical coordinates onto a layer of the given size at the given position,
+/// rounding outwards so that scaled damage never shrinks
+auto scale_damage_to_layer(
+    geom::Rectangle const& damage,
+    geom::Size const& stream_size,
+    geom::Size const& layer_size,
+    geom::Point const& position) -> geom::Rectangle
+{
+    if (stream_size == layer_size ||
+        stream_size.width == geom::Width{} ||
+        stream_size.height == geom::Height{})
+    {
+        return {position + as_displacement(damage.top_left), damage.size};
+    }
+
+    auto const x_scale = static_cast<double>(layer_size.width.as_int()) / stream_size.width.as_int();
+    auto const y_scale = static_cast<double>(layer_size.height.as_int()) / stream_size.height.as_int();
+    auto const left = static_cast<int>(std::floor(damage.left().as_int() * x_scale));
+    auto const top = static_cast<int>(std::floor(damage.top().as_int() * y_scale));
+    auto const right = static_cast<int>(std::ceil(damage.right().as_int() * x_scale));
+    auto const bottom = static_cast<int>(std::ceil(damage.bottom().as_int() * y_scale));
+    return {position + geom::Displacement{left, top}, geom::Size{right - left, bottom - top}};
+}
 }
 
 ms::BasicSurface::BasicSurface(
@@ -188,7 +217,8 @@ ms::BasicSurface::BasicSurface(
     surface_buffer_stream(default_stream(layers)),
     report(report),
     parent_(parent),
-    wayland_surface_{wayland_surface}
+    wayland_surface_{wayland_surface},
+    renderable_pool{std::make_shared<RecyclingPool>()}
 {
     auto state = synchronised_state.lock();
     update_frame_posted_callbacks(*state);
@@ -683,6 +713,8 @@ public:
         std::optional<geom::Rectangle> const& clip_area,
         glm::mat4 const& transform,
         float alpha,
+        std::vector<geom::Rectangle> opaque_region,
+        bool allow_tearing,
         mg::Renderable::ID id)
     : underlying_buffer_stream{stream},
       compositor_id{compositor_id},
@@ -690,6 +722,8 @@ public:
       screen_position_(position),
       clip_area_(clip_area),
       transformation_(transform),
+      opaque_region_(std::move(opaque_region)),
+      allow_tearing_{allow_tearing},
       id_(id)
     {
     }
@@ -720,6 +754,12 @@ public:
     bool shaped() const override
     { return mg::contains_alpha(underlying_buffer_stream->pixel_format()); }
 
+    std::vector<geom::Rectangle> opaque_region() const override
+    { return opaque_region_; }
+
+    bool allow_tearing() const override
+    { return allow_tearing_; }
+
     mg::Renderable::ID id() const override
     { return id_; }
 private:
@@ -730,6 +770,8 @@ private:
     geom::Rectangle const screen_position_;
     std::optional<geom::Rectangle> const clip_area_;
     glm::mat4 const transformation_;
+    std::vector<geom::Rectangle> const opaque_region_;
+    bool const allow_tearing_;
     mg::Renderable::ID const id_;
 };
 }
@@ -776,13 +818,19 @@ void ms::BasicSurface::set_streams(std::list<scene::StreamInfo> const& s)
 
 mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) const
 {
-    auto state = synchronised_state.lock();
     mg::RenderableList list;
-    
+    append_renderables(list, id);
+    return list;
+}
+
+void ms::BasicSurface::append_renderables(mg::RenderableList& renderables, mc::CompositorID id) const
+{
+    auto state = synchronised_state.lock();
+
     if (state->clip_area)
     {
         if (!state->surface_rect.overlaps(state->clip_area.value()))
-            return list;
+            return;
     }
 
     auto const content_top_left_ = content_top_left(*state);
@@ -791,20 +839,35 @@ mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) c
     {
         if (info.stream->has_submitted_buffer())
         {
-            geom::Size size;
-            if (info.size.is_set())
-                size = info.size.value();
-            else
-                size = info.stream->stream_size();
+            auto const stream_size = info.stream->stream_size();
+            auto const size = info.size.is_set() ? info.size.value() : stream_size;
+            geom::Rectangle const position{content_top_left_ + info.displacement, size};
+
+            // The opaque region is in stream coordinates; if the stream is
+            // being scaled we (conservatively) ignore it.
+            std::vector<geom::Rectangle> opaque_region;
+            if (info.opaque_region && size == stream_size)
+            {
+                for (auto rect : info.opaque_region.value())
+                {
+                    rect.top_left = rect.top_left + as_displacement(position.top_left);
+                    if (rect.overlaps(position))
+                        opaque_region.push_back(intersection_of(rect, position));
+                }
+            }
 
-            list.emplace_back(std::make_shared<SurfaceSnapshot>(
+            // These are created for every frame, so avoid going to the heap each time
+            renderables.emplace_back(std::allocate_shared<SurfaceSnapshot>(
+                RecyclingAllocator<SurfaceSnapshot>{renderable_pool},
                 info.stream, id,
-                geom::Rectangle{content_top_left_ + info.displacement, std::move(size)},
+                position,
                 state->clip_area,
-                state->transformation_matrix, state->surface_alpha, info.stream.get()));
+                state->transformation_matrix, state->surface_alpha,
+                std::move(opaque_region),
+                info.allow_tearing,
+                info.stream.get()));
         }
     }
-    return list;
 }
 
 void ms::BasicSurface::set_confine_pointer_state(MirPointerConfinementState state)
@@ -940,7 +1003,7 @@ void mir::scene::BasicSurface::clear_frame_posted_callbacks(State& state)
 {
     for (auto& layer : state.layers)
     {
-        layer.stream->set_frame_posted_callback([](auto){});
+        layer.stream->set_frame_posted_callback([](auto, auto){});
     }
 }
 
@@ -951,12 +1014,18 @@ void mir::scene::BasicSurface::update_frame_posted_callbacks(State& state)
         auto const position = geom::Point{} + state.margins.left + state.margins.top + layer.displacement;
         layer.stream->set_frame_posted_callback(
             [this, observers=std::weak_ptr{observers}, position, explicit_size=layer.size, stream=layer.stream.get()]
-                (auto const&)
+                (auto const&, geom::Rectangles const& stream_damage)
             {
-                auto const logical_size = explicit_size ? explicit_size.value() : stream->stream_size();
+                auto const stream_size = stream->stream_size();
+                auto const logical_size = explicit_size ? explicit_size.value() : stream_size;
+                geom::Rectangles damage;
+                for (auto const& rect : stream_damage)
+                {
+                    damage.add(scale_damage_to_layer(rect, stream_size, logical_size, position));
+                }
                 if (auto const o = observers.lock())
                 {
-                    o->frame_posted(this, 1, geom::Rectangle{position, logical_size});
+                    o->frame_posted(this, 1, stream, damage);
                 }
             });
     }
@@ -33,6 +33,7 @@
 
 namespace mir
 {
+class RecyclingPool;
 namespace compositor
 {
 class BufferStream;
@@ -111,6 +112,7 @@ public:
     bool visible() const override;
 
     graphics::RenderableList generate_renderables(compositor::CompositorID id) const override;
+    void append_renderables(graphics::RenderableList& renderables, compositor::CompositorID id) const override;
     int buffers_ready_for_compositor(void const* compositor_id) const override;
 
     MirWindowType type() const override;
@@ -225,6 +227,9 @@ private:
     std::shared_ptr<SceneReport> const report;
     std::weak_ptr<Surface> const parent_;
     wayland::Weak<frontend::WlSurface> const wayland_surface_;
+
+    /// Recycles the (per-frame) renderables we generate
+    std::shared_ptr<RecyclingPool> const renderable_pool;
 };
 
 }
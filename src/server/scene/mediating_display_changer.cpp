@@ -400,10 +400,30 @@ void ms::MediatingDisplayChanger::apply_config(
         if (configuration_has_new_outputs_enabled(*display->configuration(), *conf) ||
             !display->apply_if_configuration_preserves_display_buffers(*conf))
         {
-            ApplyNowAndRevertOnScopeExit comp{
-                [this] { compositor->stop(); },
-                [this] { compositor->start(); }};
-            display->configure(*conf);
+            /*
+             * Preferably only the outputs that change stop compositing while
+             * they are reconfigured, so that (for example) plugging in a
+             * projector doesn't freeze every other screen.
+             */
+            bool sync_groups_changed{false};
+            auto const retire = [this, &sync_groups_changed](std::vector<mg::DisplaySyncGroup*> const& groups)
+                {
+                    compositor->stop_sync_groups(groups);
+                    sync_groups_changed = true;
+                };
+
+            if (display->configure_changed_sync_groups(*conf, retire))
+            {
+                if (sync_groups_changed)
+                    compositor->start_new_sync_groups();
+            }
+            else
+            {
+                ApplyNowAndRevertOnScopeExit comp{
+                    [this] { compositor->stop(); },
+                    [this] { compositor->start(); }};
+                display->configure(*conf);
+            }
         }
 
         observer->configuration_applied(conf);
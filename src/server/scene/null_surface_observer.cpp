@@ -24,7 +24,7 @@ void ms::NullSurfaceObserver::window_resized_to(Surface const*, geometry::Size c
 void ms::NullSurfaceObserver::content_resized_to(Surface const*, geometry::Size const&) {}
 void ms::NullSurfaceObserver::moved_to(Surface const*, geometry::Point const&) {}
 void ms::NullSurfaceObserver::hidden_set_to(Surface const*, bool) {}
-void ms::NullSurfaceObserver::frame_posted(Surface const*, int, geometry::Rectangle const&) {}
+void ms::NullSurfaceObserver::frame_posted(Surface const*, int, graphics::Renderable::ID, geometry::Rectangles const&) {}
 void ms::NullSurfaceObserver::alpha_set_to(Surface const*, float) {}
 void ms::NullSurfaceObserver::orientation_set_to(Surface const*, MirOrientation) {}
 void ms::NullSurfaceObserver::transformation_set_to(Surface const*, glm::mat4 const&) {}
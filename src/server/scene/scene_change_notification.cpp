@@ -23,11 +23,12 @@
 #include <boost/throw_exception.hpp>
 
 namespace ms = mir::scene;
+namespace mg = mir::graphics;
 namespace geom = mir::geometry;
 
 ms::SceneChangeNotification::SceneChangeNotification(
     std::function<void()> const& scene_notify_change,
-    std::function<void(int frames, geom::Rectangle const& damage)> const& damage_notify_change) :
+    std::function<void(int frames, mg::Renderable::ID source, geom::Rectangles const& damage)> const& damage_notify_change) :
     scene_notify_change(scene_notify_change),
     damage_notify_change(damage_notify_change)
 {
@@ -26,7 +26,7 @@ namespace geom = mir::geometry;
 ms::SurfaceChangeNotification::SurfaceChangeNotification(
     ms::Surface* surface,
     std::function<void()> const& notify_scene_change,
-    std::function<void(int, geom::Rectangle const&)> const& notify_buffer_change) :
+    std::function<void(int, mg::Renderable::ID, geom::Rectangles const&)> const& notify_buffer_change) :
     notify_scene_change(notify_scene_change),
     notify_buffer_change(notify_buffer_change)
 {
@@ -55,12 +55,18 @@ void ms::SurfaceChangeNotification::hidden_set_to(Surface const*, bool)
 void ms::SurfaceChangeNotification::frame_posted(
     Surface const*,
     int frames_available,
-    geometry::Rectangle const& damage)
+    mg::Renderable::ID source,
+    geometry::Rectangles const& damage)
 {
     std::unique_lock lock{mutex};
-    geom::Rectangle global_damage{top_left + as_displacement(damage.top_left), damage.size};
+    auto const offset = as_displacement(top_left);
     lock.unlock();
-    notify_buffer_change(frames_available, global_damage);
+    geom::Rectangles global_damage;
+    for (auto const& rect : damage)
+    {
+        global_damage.add({rect.top_left + offset, rect.size});
+    }
+    notify_buffer_change(frames_available, source, global_damage);
 }
 
 void ms::SurfaceChangeNotification::alpha_set_to(Surface const*, float)
@@ -23,6 +23,7 @@
 #include "mir/graphics/renderable.h"
 #include "mir/depth_layer.h"
 #include "mir/executor.h"
+#include "mir/recycling_allocator.h"
 
 #include <boost/throw_exception.hpp>
 
@@ -45,14 +46,12 @@ class SurfaceSceneElement : public mc::SceneElement
 {
 public:
     SurfaceSceneElement(
-        std::string name,
         std::shared_ptr<mg::Renderable> const& renderable,
         std::shared_ptr<ms::RenderingTracker> const& tracker,
         mc::CompositorID id)
         : renderable_{renderable},
           tracker{tracker},
-          cid{id},
-          surface_name(name)
+          cid{id}
     {
     }
 
@@ -75,7 +74,6 @@ private:
     std::shared_ptr<mg::Renderable> const renderable_;
     std::shared_ptr<ms::RenderingTracker> const tracker;
     mc::CompositorID cid;
-    std::string const surface_name;
 };
 
 //note: something different than a 2D/HWC overlay
@@ -130,6 +128,7 @@ private:
 ms::SurfaceStack::SurfaceStack(
     std::shared_ptr<SceneReport> const& report) :
     report{report},
+    scene_element_pool{std::make_shared<RecyclingPool>()},
     scene_changed{false},
     surface_observer{std::make_shared<SurfaceDepthLayerObserver>(this)}
 {
@@ -152,29 +151,42 @@ mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID i
     RecursiveReadLock lg(guard);
 
     scene_changed = false;
+
+    // Reuse the registered compositor's storage (unregistered callers, such as screenshots, are rare)
+    CompositorFrame unregistered;
+    auto const registered = compositor_frames.find(id);
+    auto& frame = registered != compositor_frames.end() ? registered->second : unregistered;
+
+    RecyclingAllocator<SurfaceSceneElement> const surface_elements{scene_element_pool};
+    RecyclingAllocator<OverlaySceneElement> const overlay_elements{scene_element_pool};
+
     mc::SceneElementSequence elements;
+    elements.reserve(frame.element_count);
     for (auto const& layer : surface_layers)
     {
         for (auto const& surface : layer)
         {
             if (surface->visible())
             {
-                for (auto& renderable : surface->generate_renderables(id))
+                surface->append_renderables(frame.renderables, id);
+
+                auto const& tracker = rendering_trackers[surface.get()];
+                for (auto& renderable : frame.renderables)
                 {
                     elements.emplace_back(
-                        std::make_shared<SurfaceSceneElement>(
-                            surface->name(),
-                            renderable,
-                            rendering_trackers[surface.get()],
-                            id));
+                        std::allocate_shared<SurfaceSceneElement>(surface_elements, renderable, tracker, id));
                 }
+
+                frame.renderables.clear();
             }
         }
     }
     for (auto const& renderable : overlays)
     {
-        elements.emplace_back(std::make_shared<OverlaySceneElement>(renderable));
+        elements.emplace_back(std::allocate_shared<OverlaySceneElement>(overlay_elements, renderable));
     }
+
+    frame.element_count = elements.size();
     return elements;
 }
 
@@ -210,6 +222,7 @@ void ms::SurfaceStack::register_compositor(mc::CompositorID cid)
     RecursiveWriteLock lg(guard);
 
     registered_compositors.insert(cid);
+    compositor_frames[cid];
 
     update_rendering_tracker_compositors();
 }
@@ -219,6 +232,7 @@ void ms::SurfaceStack::unregister_compositor(mc::CompositorID cid)
     RecursiveWriteLock lg(guard);
 
     registered_compositors.erase(cid);
+    compositor_frames.erase(cid);
 
     update_rendering_tracker_compositors();
 }
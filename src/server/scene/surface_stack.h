@@ -37,6 +37,7 @@
 
 namespace mir
 {
+class RecyclingPool;
 namespace graphics
 {
 class Renderable;
@@ -128,6 +129,16 @@ private:
     std::vector<std::vector<std::shared_ptr<Surface>>> surface_layers;
     std::map<Surface*,std::shared_ptr<RenderingTracker>> rendering_trackers;
     std::set<compositor::CompositorID> registered_compositors;
+
+    /// State each registered compositor reuses from frame to frame
+    struct CompositorFrame
+    {
+        std::vector<std::shared_ptr<graphics::Renderable>> renderables;
+        size_t element_count{0};
+    };
+    /// Each entry is only used by its own compositor (which only composites one frame at a time)
+    std::map<compositor::CompositorID, CompositorFrame> compositor_frames;
+    std::shared_ptr<RecyclingPool> const scene_element_pool;
     
     std::vector<std::shared_ptr<graphics::Renderable>> overlays;
 
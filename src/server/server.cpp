@@ -31,6 +31,7 @@
 #include "mir/main_loop.h"
 #include "mir/report_exception.h"
 #include "mir/run_mir.h"
+#include "mir/startup_timeline.h"
 #include "mir/cookie/authority.h"
 
 // TODO these are used to frig a stub renderer when running headless
@@ -376,8 +377,11 @@ void mir::Server::apply_settings()
 {
     if (self->server_config) return;
 
+    startup_timeline::begin();
+
     auto const options = configuration_options(self->argc, self->argv, self->command_line_hander, self->config_file);
     self->add_configuration_options(*options);
+    startup_timeline::phase_completed("options parsed");
 
     auto const config = std::make_shared<ServerConfiguration>(options, self);
     self->server_config = config;
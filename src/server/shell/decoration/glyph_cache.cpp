@@ -0,0 +1,47 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "glyph_cache.h"
+
+namespace geom = mir::geometry;
+namespace msd = mir::shell::decoration;
+
+msd::GlyphCache::GlyphCache(Rasterize rasterize, size_t max_glyphs)
+    : rasterize{std::move(rasterize)},
+      max_glyphs{max_glyphs}
+{
+}
+
+void msd::GlyphCache::trim()
+{
+    if (glyphs.size() > max_glyphs)
+        glyphs.clear();
+}
+
+auto msd::GlyphCache::glyph(char32_t code, geom::Height height) -> Glyph const&
+{
+    std::pair<int, char32_t> const key{height.as_int(), code};
+    auto const existing = glyphs.find(key);
+    if (existing != glyphs.end())
+        return existing->second;
+
+    return glyphs.emplace(key, rasterize(code, height)).first->second;
+}
+
+auto msd::GlyphCache::size() const -> size_t
+{
+    return glyphs.size();
+}
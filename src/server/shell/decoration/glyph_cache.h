@@ -0,0 +1,74 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SHELL_DECORATION_GLYPH_CACHE_H_
+#define MIR_SHELL_DECORATION_GLYPH_CACHE_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/displacement.h"
+
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace mir
+{
+namespace shell
+{
+namespace decoration
+{
+/// A rasterized glyph, positioned relative to the pen at the top left of the line
+struct Glyph
+{
+    geometry::Rectangle bounds;
+    std::vector<unsigned char> alpha;   ///< One value per pixel of bounds, row by row
+    geometry::Displacement advance;
+};
+
+/**
+ * The glyphs of a single face, cached by pixel height and character
+ *
+ * \note This is not threadsafe
+ */
+class GlyphCache
+{
+public:
+    using Rasterize = std::function<Glyph(char32_t code, geometry::Height height)>;
+
+    /// \param [in] max_glyphs  The cache is emptied once it grows past this, rather than growing without bound
+    GlyphCache(Rasterize rasterize, size_t max_glyphs);
+
+    /// Empties the cache if it has grown too big. References from glyph() stay valid until this is next called.
+    void trim();
+
+    /// The glyph for code at height, rasterizing it if it isn't cached
+    ///
+    /// \throws Whatever rasterizing throws. Nothing is cached in that case.
+    auto glyph(char32_t code, geometry::Height height) -> Glyph const&;
+
+    auto size() const -> size_t;
+
+private:
+    Rasterize const rasterize;
+    size_t const max_glyphs;
+    std::map<std::pair<int, char32_t>, Glyph> glyphs;
+};
+}
+}
+}
+
+#endif // MIR_SHELL_DECORATION_GLYPH_CACHE_H_
@@ -0,0 +1,97 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SHELL_DECORATION_PIXELS_H_
+#define MIR_SHELL_DECORATION_PIXELS_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/displacement.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mir
+{
+namespace shell
+{
+namespace decoration
+{
+inline auto area(geometry::Size size) -> size_t
+{
+    return (size.width > geometry::Width{} && size.height > geometry::Height{})
+        ? size.width.as_int() * size.height.as_int()
+        : 0;
+}
+
+/// x / 255, for x in [0, 255 * 255]
+inline auto div_255(uint32_t x) -> uint32_t
+{
+    return (x + 1 + (x >> 8)) >> 8;
+}
+
+/// Blends color over pixel with the given coverage (0-255), keeping the pixel's alpha
+///
+/// Red and blue are blended together, in the low and high 16 bits. This has no branches or
+/// byte-sized accesses, so loops over it can be vectorized by the compiler.
+inline auto blend(uint32_t pixel, uint32_t color, uint32_t coverage) -> uint32_t
+{
+    uint32_t const inverse = 255 - coverage;
+
+    uint32_t const rb = (pixel & 0x00FF00FF) * inverse + (color & 0x00FF00FF) * coverage;
+    uint32_t const blended_rb = ((rb + 0x00010001 + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+
+    uint32_t const g = ((pixel >> 8) & 0xFF) * inverse + ((color >> 8) & 0xFF) * coverage;
+
+    return (pixel & 0xFF000000) | (div_255(g) << 8) | blended_rb;
+}
+
+/// Draws an alpha mask (such as rasterized text) in color, offset by top_left
+inline void render_mask(
+    uint32_t* const data,
+    geometry::Size buf_size,
+    geometry::Rectangle mask_bounds,
+    unsigned char const* mask_alpha,
+    geometry::Point top_left,
+    uint32_t color)
+{
+    geometry::Rectangle const mask_rect{mask_bounds.top_left + as_displacement(top_left), mask_bounds.size};
+    auto const drawn = intersection_of(geometry::Rectangle{{}, buf_size}, mask_rect);
+    if (!area(drawn.size))
+        return;
+
+    uint32_t const color_alpha = color >> 24;
+    auto const mask_width = mask_bounds.size.width.as_int();
+    auto const drawn_width = drawn.size.width.as_int();
+
+    for (geometry::Y y = drawn.top(); y < drawn.bottom(); y += geometry::DeltaY{1})
+    {
+        unsigned char const* const mask_row =
+            mask_alpha +
+            (y - mask_rect.top()).as_int() * mask_width +
+            (drawn.left() - mask_rect.left()).as_int();
+        uint32_t* const buffer_row = data + y.as_int() * buf_size.width.as_int() + drawn.left().as_int();
+
+        for (int x = 0; x < drawn_width; x++)
+        {
+            buffer_row[x] = blend(buffer_row[x], color, div_255(mask_row[x] * color_alpha));
+        }
+    }
+}
+}
+}
+}
+
+#endif // MIR_SHELL_DECORATION_PIXELS_H_
@@ -18,6 +18,8 @@
 #include "renderer.h"
 #include "window.h"
 #include "input.h"
+#include "pixels.h"
+#include "glyph_cache.h"
 
 #include "mir/graphics/graphic_buffer_allocator.h"
 #include "mir/renderer/sw/pixel_source.h"
@@ -29,6 +31,7 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include <algorithm>
 #include <locale>
 #include <codecvt>
 
@@ -116,13 +119,6 @@ auto default_font() -> std::string
     return "";
 }
 
-inline auto area(geom::Size size) -> size_t
-{
-    return (size.width > geom::Width{} && size.height > geom::Height{})
-        ? size.width.as_int() * size.height.as_int()
-        : 0;
-}
-
 inline void render_row(
     uint32_t* const data,
     geom::Size buf_size,
@@ -136,8 +132,8 @@ inline void render_row(
     left.x = std::max(left.x, geom::X{});
     uint32_t* const start = data + (left.y.as_int() * buf_size.width.as_int()) + left.x.as_int();
     uint32_t* const end = start + right.as_int() - left.x.as_int();
-    for (uint32_t* i = start; i < end; i++)
-        *i = color;
+    if (start < end)
+        std::fill(start, end, color);
 }
 
 inline void render_close_icon(
@@ -204,27 +200,23 @@ public:
     Impl();
     ~Impl();
 
-    void render(
-        Pixel* buf,
-        geom::Size buf_size,
+    auto rasterize(
         std::string const& text,
-        geom::Point top_left,
-        geom::Height height_pixels,
-        Pixel color) override;
+        geom::Height height_pixels) -> TextMask override;
 
 private:
+    /// The cache is emptied once it grows past this, rather than growing without bound
+    static size_t constexpr max_cached_glyphs{4096};
+
     std::mutex mutex;
     FT_Library library;
     FT_Face face;
+    geom::Height char_size;
+    /// There is only one face, so it isn't part of the key
+    GlyphCache glyph_cache;
 
     void set_char_size(geom::Height height);
-    void rasterize_glyph(char32_t glyph);
-    void render_glyph(
-        Pixel* buf,
-        geom::Size buf_size,
-        FT_Bitmap const* glyph,
-        geom::Point top_left,
-        Pixel color);
+    auto rasterize_glyph(char32_t code, geom::Height height) -> Glyph;
 
     static auto font_path() -> std::string;
     static auto utf8_to_utf32(std::string const& text) -> std::u32string;
@@ -234,14 +226,11 @@ class msd::Renderer::Text::Null
     : public Text
 {
 public:
-    void render(
-        Pixel*,
-        geom::Size,
+    auto rasterize(
         std::string const&,
-        geom::Point,
-        geom::Height,
-        Pixel) override
+        geom::Height) -> TextMask override
     {
+        return {};
     }
 
 private:
@@ -271,6 +260,9 @@ auto msd::Renderer::Text::instance() -> std::shared_ptr<Text>
 }
 
 msd::Renderer::Text::Impl::Impl()
+    : glyph_cache{
+          [this](char32_t code, geom::Height height) { return rasterize_glyph(code, height); },
+          max_cached_glyphs}
 {
     if (auto const error = FT_Init_FreeType(&library))
         BOOST_THROW_EXCEPTION(std::runtime_error(
@@ -299,71 +291,94 @@ msd::Renderer::Text::Impl::~Impl()
     library = nullptr;
 }
 
-void msd::Renderer::Text::Impl::render(
-    Pixel* buf,
-    geom::Size buf_size,
+auto msd::Renderer::Text::Impl::rasterize(
     std::string const& text,
-    geom::Point top_left,
-    geom::Height height_pixels,
-    Pixel color)
+    geom::Height height_pixels) -> TextMask
 {
-    if (!area(buf_size) || height_pixels <= geom::Height{})
-        return;
+    if (height_pixels <= geom::Height{})
+        return {};
 
     std::lock_guard lock{mutex};
 
     if (!library || !face)
     {
         log_warning("FreeType not initialized");
-        return;
-    }
-
-    try
-    {
-        set_char_size(height_pixels);
-    }
-    catch (std::runtime_error const& error)
-    {
-        log_warning("%s", error.what());
-        return;
+        return {};
     }
 
-    auto const utf32 = utf8_to_utf32(text);
+    // Trimmed before looking any glyphs up, so the pointers below stay valid
+    glyph_cache.trim();
 
-    for (char32_t const glyph : utf32)
+    std::vector<std::pair<Glyph const*, geom::Point>> placed_glyphs;
+    geom::Point pen;
+    for (char32_t const code : utf8_to_utf32(text))
     {
         try
         {
-            rasterize_glyph(glyph);
-
-            geom::Point glyph_top_left =
-                top_left +
-                geom::Displacement{
-                    face->glyph->bitmap_left,
-                    height_pixels.as_int() - face->glyph->bitmap_top};
-            render_glyph(buf, buf_size, &face->glyph->bitmap, glyph_top_left, color);
-
-            top_left += geom::Displacement{
-                face->glyph->advance.x / 64,
-                face->glyph->advance.y / 64};
+            auto const& glyph = glyph_cache.glyph(code, height_pixels);
+            if (area(glyph.bounds.size))
+                placed_glyphs.emplace_back(&glyph, glyph.bounds.top_left + as_displacement(pen));
+            pen += glyph.advance;
         }
         catch (std::runtime_error const& error)
         {
             log_warning("%s", error.what());
         }
     }
+
+    if (placed_glyphs.empty())
+        return {};
+
+    geom::Point top_left = placed_glyphs.front().second;
+    geom::Point bottom_right = top_left;
+    for (auto const& [glyph, position] : placed_glyphs)
+    {
+        top_left = {std::min(top_left.x, position.x), std::min(top_left.y, position.y)};
+        bottom_right = {
+            std::max(bottom_right.x, position.x + as_delta(glyph->bounds.size.width)),
+            std::max(bottom_right.y, position.y + as_delta(glyph->bounds.size.height))};
+    }
+
+    TextMask mask{{top_left, as_size(bottom_right - top_left)}, {}};
+    auto const mask_width = mask.bounds.size.width.as_int();
+    mask.alpha.resize(area(mask.bounds.size));
+
+    for (auto const& [glyph, position] : placed_glyphs)
+    {
+        auto const glyph_width = glyph->bounds.size.width.as_int();
+        auto const offset = position - top_left;
+        for (int row = 0; row < glyph->bounds.size.height.as_int(); row++)
+        {
+            unsigned char const* const glyph_row = glyph->alpha.data() + row * glyph_width;
+            unsigned char* const mask_row =
+                mask.alpha.data() + (offset.dy.as_int() + row) * mask_width + offset.dx.as_int();
+
+            // Where glyphs overlap, keep the greater coverage
+            for (int x = 0; x < glyph_width; x++)
+                mask_row[x] = std::max(mask_row[x], glyph_row[x]);
+        }
+    }
+
+    return mask;
 }
 
 void msd::Renderer::Text::Impl::set_char_size(geom::Height height)
 {
+    if (height == char_size)
+        return;
+
     if (auto const error = FT_Set_Pixel_Sizes(face, 0, height.as_int()))
         BOOST_THROW_EXCEPTION(std::runtime_error(
             "Setting char size failed with error " + std::to_string(error)));
+
+    char_size = height;
 }
 
-void msd::Renderer::Text::Impl::rasterize_glyph(char32_t glyph)
+auto msd::Renderer::Text::Impl::rasterize_glyph(char32_t code, geom::Height height) -> Glyph
 {
-    auto const glyph_index = FT_Get_Char_Index(face, glyph);
+    set_char_size(height);
+
+    auto const glyph_index = FT_Get_Char_Index(face, code);
 
     if (auto const error = FT_Load_Glyph(face, glyph_index, 0))
         BOOST_THROW_EXCEPTION(std::runtime_error(
@@ -372,46 +387,22 @@ void msd::Renderer::Text::Impl::rasterize_glyph(char32_t glyph)
     if (auto const error = FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL))
         BOOST_THROW_EXCEPTION(std::runtime_error(
             "Failed to render glyph " + std::to_string(glyph_index)));
-}
-
-void msd::Renderer::Text::Impl::render_glyph(
-    Pixel* buf,
-    geom::Size buf_size,
-    FT_Bitmap const* glyph,
-    geom::Point top_left,
-    Pixel color)
-{
-    geom::X const buffer_left = std::max(top_left.x, geom::X{});
-    geom::X const buffer_right = std::min(top_left.x + geom::DeltaX{glyph->width}, as_x(buf_size.width));
-
-    geom::Y const buffer_top = std::max(top_left.y, geom::Y{});
-    geom::Y const buffer_bottom = std::min(top_left.y + geom::DeltaY{glyph->rows}, as_y(buf_size.height));
 
-    geom::Displacement const glyph_offset = as_displacement(top_left);
+    FT_Bitmap const& bitmap = face->glyph->bitmap;
+    auto const width = static_cast<int>(bitmap.width);
+    auto const rows = static_cast<int>(bitmap.rows);
 
-    unsigned char* const color_pixels = (unsigned char *)&color;
-    unsigned char const color_alpha = color_pixels[3];
+    Glyph glyph{
+        {{face->glyph->bitmap_left, height.as_int() - face->glyph->bitmap_top}, {width, rows}},
+        std::vector<unsigned char>(width * rows),
+        {face->glyph->advance.x / 64, face->glyph->advance.y / 64}};
 
-    for (geom::Y buffer_y = buffer_top; buffer_y < buffer_bottom; buffer_y += geom::DeltaY{1})
+    for (int row = 0; row < rows; row++)
     {
-        geom::Y const glyph_y = buffer_y - glyph_offset.dy;
-        unsigned char* const glyph_row = glyph->buffer + glyph_y.as_int() * glyph->pitch;
-        Pixel* const buffer_row = buf + buffer_y.as_int() * buf_size.width.as_int();
-
-        for (geom::X buffer_x = buffer_left; buffer_x < buffer_right; buffer_x += geom::DeltaX{1})
-        {
-            geom::X const glyph_x = buffer_x - glyph_offset.dx;
-            unsigned char const glyph_alpha = ((int)glyph_row[glyph_x.as_int()] * color_alpha) / 255;
-            unsigned char* const buffer_pixels = (unsigned char *)(buffer_row + buffer_x.as_int());
-            for (int i = 0; i < 3; i++)
-            {
-                // Blend color with the previous buffer color based on the glyph's alpha
-                buffer_pixels[i] =
-                    ((int)buffer_pixels[i] * (255 - glyph_alpha)) / 255 +
-                    ((int)color_pixels[i] * glyph_alpha) / 255;
-            }
-        }
+        std::copy_n(bitmap.buffer + row * bitmap.pitch, width, glyph.alpha.data() + row * width);
     }
+
+    return glyph;
 }
 
 auto msd::Renderer::Text::Impl::font_path() -> std::string
@@ -514,6 +505,7 @@ void msd::Renderer::update_state(WindowState const& window_state, InputState con
     if (window_state.window_name() != name)
     {
         name = window_state.window_name();
+        name_mask.reset();
         needs_titlebar_redraw = true;
     }
 
@@ -559,12 +551,17 @@ auto msd::Renderer::render_titlebar() -> std::optional<std::shared_ptr<mg::Buffe
                 current_theme->background_color);
         }
 
-        text->render(
+        if (!name_mask)
+        {
+            name_mask = text->rasterize(name, static_geometry->title_font_height);
+        }
+
+        render_mask(
             titlebar_pixels.get(),
             titlebar_size,
-            name,
+            name_mask->bounds,
+            name_mask->alpha.data(),
             static_geometry->title_font_top_left,
-            static_geometry->title_font_height,
             current_theme->text_color);
     }
 
@@ -23,6 +23,9 @@
 
 #include <memory>
 #include <map>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace mir
 {
@@ -58,6 +61,13 @@ public:
 private:
     using Pixel = uint32_t;
 
+    /// The coverage of some rendered text, which can be drawn in any color
+    struct TextMask
+    {
+        geometry::Rectangle bounds;         ///< Relative to the top left of the text
+        std::vector<unsigned char> alpha;   ///< One value per pixel of bounds, row by row
+    };
+
     class Text
     {
     public:
@@ -65,13 +75,9 @@ private:
 
         virtual ~Text() = default;
 
-        virtual void render(
-            Pixel* buf,
-            geometry::Size buf_size,
+        virtual auto rasterize(
             std::string const& text,
-            geometry::Point top_left,
-            geometry::Height height_pixels,
-            Pixel color) = 0;
+            geometry::Height height_pixels) -> TextMask = 0;
 
     private:
         class Impl;
@@ -123,6 +129,8 @@ private:
     bool needs_titlebar_redraw{true};
     bool needs_titlebar_buttons_redraw{true};
     std::string name;
+    /// The rasterized name, kept until the name changes so that redraws only need to blend it
+    std::optional<TextMask> name_mask;
     std::vector<ButtonInfo> buttons;
 
     std::shared_ptr<Text> const text;
@@ -0,0 +1,103 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/startup_timeline.h"
+#include "mir/log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+struct Phase
+{
+    std::string name;
+    Clock::time_point completed;
+};
+
+std::mutex timeline_mutex;
+Clock::time_point started;
+std::vector<Phase> phases;
+
+// Checked without the lock so that frame_posted() costs a single load once startup is over
+std::atomic<bool> timing{false};
+
+auto milliseconds(Clock::duration duration) -> double
+{
+    return std::chrono::duration<double, std::milli>{duration}.count();
+}
+}
+
+void mir::startup_timeline::begin()
+{
+    std::lock_guard lock{timeline_mutex};
+    started = Clock::now();
+    phases.clear();
+    timing = true;
+}
+
+void mir::startup_timeline::phase_completed(char const* phase)
+{
+    if (!timing.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    auto const now = Clock::now();
+
+    std::lock_guard lock{timeline_mutex};
+    if (!timing || std::any_of(phases.begin(), phases.end(), [&](auto const& p) { return p.name == phase; }))
+    {
+        return;
+    }
+    phases.push_back({phase, now});
+}
+
+void mir::startup_timeline::frame_posted()
+{
+    if (!timing.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    auto const now = Clock::now();
+
+    std::lock_guard lock{timeline_mutex};
+    if (!timing.exchange(false))
+    {
+        return;
+    }
+    phases.push_back({"first frame posted", now});
+
+    mir::log_info("Startup timeline:");
+    auto previous = started;
+    for (auto const& phase : phases)
+    {
+        mir::log_info(
+            "\t%-28s %8.1fms (+%.1fms)",
+            phase.name.c_str(),
+            milliseconds(phase.completed - started),
+            milliseconds(phase.completed - previous));
+        previous = phase.completed;
+    }
+    phases.clear();
+}
@@ -83,6 +83,26 @@ public:
         buf = b;
     }
 
+    void set_opaque_region(std::vector<geometry::Rectangle> const& region)
+    {
+        opaque = region;
+    }
+
+    std::vector<geometry::Rectangle> opaque_region() const override
+    {
+        return opaque;
+    }
+
+    void set_allow_tearing(bool allow)
+    {
+        tearing = allow;
+    }
+
+    bool allow_tearing() const override
+    {
+        return tearing;
+    }
+
     std::shared_ptr<graphics::Buffer> buffer() const override
     {
         return buf;
@@ -103,6 +123,8 @@ private:
     mir::geometry::Rectangle rect;
     float opacity;
     bool rectangular;
+    std::vector<geometry::Rectangle> opaque;
+    bool tearing{false};
 };
 
 } // namespace doubles
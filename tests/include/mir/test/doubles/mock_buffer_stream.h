@@ -30,7 +30,7 @@ namespace doubles
 struct MockBufferStream : public compositor::BufferStream
 {
     int buffers_ready_{0};
-    std::function<void(geometry::Size const&)> frame_posted_callback;
+    std::function<void(geometry::Size const&, geometry::Rectangles const&)> frame_posted_callback;
     int buffers_ready(void const*)
     {
         if (buffers_ready_)
@@ -60,7 +60,11 @@ struct MockBufferStream : public compositor::BufferStream
     MOCK_METHOD1(release_client_buffer, void(graphics::Buffer*));
     MOCK_METHOD1(lock_compositor_buffer,
                  std::shared_ptr<graphics::Buffer>(void const*));
-    MOCK_METHOD1(set_frame_posted_callback, void(std::function<void(geometry::Size const&)> const&));
+    MOCK_METHOD1(set_frame_posted_callback,
+                 void(std::function<void(geometry::Size const&, geometry::Rectangles const&)> const&));
+    MOCK_METHOD1(when_presented, bool(std::function<void()> const&));
+    MOCK_METHOD1(when_buffer_presented,
+                 void(std::function<void(std::optional<graphics::FramePresentation> const&)> const&));
 
     MOCK_METHOD0(get_stream_pixel_format, MirPixelFormat());
     MOCK_METHOD0(stream_size, geometry::Size());
@@ -73,6 +77,7 @@ struct MockBufferStream : public compositor::BufferStream
     MOCK_METHOD0(drop_client_requests, void());
 
     MOCK_METHOD1(submit_buffer, void(std::shared_ptr<graphics::Buffer> const&));
+    MOCK_METHOD2(submit_buffer, void(std::shared_ptr<graphics::Buffer> const&, geometry::Rectangles const&));
     MOCK_METHOD1(with_most_recent_buffer_do, void(std::function<void(graphics::Buffer&)> const&));
     MOCK_CONST_METHOD0(pixel_format, MirPixelFormat());
     MOCK_CONST_METHOD0(has_submitted_buffer, bool());
@@ -33,6 +33,8 @@ class MockCompositor : public compositor::Compositor
 public:
     MOCK_METHOD0(start, void());
     MOCK_METHOD0(stop, void());
+    MOCK_METHOD1(stop_sync_groups, void(std::vector<graphics::DisplaySyncGroup*> const&));
+    MOCK_METHOD0(start_new_sync_groups, void());
 };
 
 }
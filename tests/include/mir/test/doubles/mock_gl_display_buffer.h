@@ -19,6 +19,7 @@
 
 #include "mock_display_buffer.h"
 #include "mir/renderer/gl/render_target.h"
+#include "mir/geometry/rectangles.h"
 
 namespace mir
 {
@@ -35,6 +36,8 @@ public:
     MOCK_METHOD(void, make_current, (), (override));
     MOCK_METHOD(void, release_current, (), (override));
     MOCK_METHOD(void, swap_buffers, (), (override));
+    MOCK_METHOD(void, swap_buffers_with_damage, (geometry::Rectangles const&), (override));
+    MOCK_METHOD(int, buffer_age, (), (const, override));
     MOCK_METHOD(void, bind, (), (override));
 };
 
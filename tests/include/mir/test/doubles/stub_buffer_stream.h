@@ -63,12 +63,23 @@ public:
     {
         if (b) ++nready;
     }
+    void submit_buffer(std::shared_ptr<graphics::Buffer> const& b, geometry::Rectangles const&) override
+    {
+        if (b) ++nready;
+    }
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& fn) override
     {
         fn(*stub_compositor_buffer);
     }
     MirPixelFormat pixel_format() const override { return mir_pixel_format_abgr_8888; }
-    void set_frame_posted_callback(std::function<void(geometry::Size const&)> const&) override {}
+    void set_frame_posted_callback(
+        std::function<void(geometry::Size const&, geometry::Rectangles const&)> const&) override {}
+    bool when_presented(std::function<void()> const&) override { return false; }
+    void when_buffer_presented(
+        std::function<void(std::optional<graphics::FramePresentation> const&)> const& callback) override
+    {
+        callback(std::nullopt);
+    }
     bool has_submitted_buffer() const override { return true; }
     void set_scale(float) override {}
 
@@ -21,6 +21,7 @@
 #include "src/server/scene/basic_surface.h"
 #include "src/server/compositor/default_display_buffer_compositor_factory.h"
 #include "src/server/compositor/multi_threaded_compositor.h"
+#include "src/server/compositor/presentation_notifier.h"
 #include "src/server/compositor/stream.h"
 #include "mir/test/fake_shared.h"
 #include "mir/test/doubles/mock_buffer_stream.h"
@@ -171,6 +172,7 @@ TEST_F(SurfaceStackCompositor, composes_on_start_if_told_to_in_constructor)
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mc::PresentationNotifier>(),
         null_comp_report, default_delay, true);
     mt_compositor.start();
 
@@ -185,6 +187,7 @@ TEST_F(SurfaceStackCompositor, does_not_composes_on_start_if_told_not_to_in_cons
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mc::PresentationNotifier>(),
         null_comp_report, default_delay, false);
     mt_compositor.start();
 
@@ -199,6 +202,7 @@ TEST_F(SurfaceStackCompositor, swapping_a_surface_that_has_been_added_triggers_a
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mc::PresentationNotifier>(),
         null_comp_report, default_delay, false);
     mt_compositor.start();
 
@@ -212,7 +216,7 @@ TEST_F(SurfaceStackCompositor, swapping_a_surface_that_has_been_added_triggers_a
 //test associated with lp:1290306, 1293896, 1294048, 1294051, 1294053
 TEST_F(SurfaceStackCompositor, compositor_runs_until_all_surfaces_buffers_are_consumed)
 {
-    std::function<void(mir::geometry::Size const&)> frame_callback;
+    std::function<void(mir::geometry::Size const&, mir::geometry::Rectangles const&)> frame_callback;
     ON_CALL(*mock_buffer_stream, buffers_ready_for_compositor(_))
         .WillByDefault(Return(5));
     EXPECT_CALL(*mock_buffer_stream, set_frame_posted_callback(_))
@@ -225,12 +229,13 @@ TEST_F(SurfaceStackCompositor, compositor_runs_until_all_surfaces_buffers_are_co
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mc::PresentationNotifier>(),
         null_comp_report, default_delay, false);
     mt_compositor.start();
 
     stack.add_surface(stub_surface, mi::InputReceptionMode::normal);
     ASSERT_THAT(frame_callback, Ne(nullptr));
-    frame_callback({ 100, 100 });
+    frame_callback({ 100, 100 }, {{{}, { 100, 100 }}});
 
     EXPECT_TRUE(stub_primary_db.has_posted_at_least(5, timeout));
     EXPECT_TRUE(stub_secondary_db.has_posted_at_least(5, timeout));
@@ -238,7 +243,7 @@ TEST_F(SurfaceStackCompositor, compositor_runs_until_all_surfaces_buffers_are_co
 
 TEST_F(SurfaceStackCompositor, bypassed_compositor_runs_until_all_surfaces_buffers_are_consumed)
 {
-    std::function<void(mir::geometry::Size const&)> frame_callback;
+    std::function<void(mir::geometry::Size const&, mir::geometry::Rectangles const&)> frame_callback;
     ON_CALL(*mock_buffer_stream, buffers_ready_for_compositor(_))
         .WillByDefault(Return(5));
     ON_CALL(*mock_buffer_stream, lock_compositor_buffer(_))
@@ -255,12 +260,13 @@ TEST_F(SurfaceStackCompositor, bypassed_compositor_runs_until_all_surfaces_buffe
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mc::PresentationNotifier>(),
         null_comp_report, default_delay, false);
     mt_compositor.start();
 
     stack.add_surface(stub_surface, mi::InputReceptionMode::normal);
     ASSERT_THAT(frame_callback, Ne(nullptr));
-    frame_callback({ 100, 100 });
+    frame_callback({ 100, 100 }, {{{}, { 100, 100 }}});
 
     EXPECT_TRUE(stub_primary_db.has_posted_at_least(5, timeout));
     EXPECT_TRUE(stub_secondary_db.has_posted_at_least(5, timeout));
@@ -273,6 +279,7 @@ TEST_F(SurfaceStackCompositor, an_empty_scene_retriggers)
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mc::PresentationNotifier>(),
         null_comp_report, default_delay, false);
     mt_compositor.start();
 
@@ -298,6 +305,7 @@ TEST_F(SurfaceStackCompositor, moving_a_surface_triggers_composition)
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mc::PresentationNotifier>(),
         null_comp_report, default_delay, false);
 
     mt_compositor.start();
@@ -317,6 +325,7 @@ TEST_F(SurfaceStackCompositor, removing_a_surface_triggers_composition)
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mc::PresentationNotifier>(),
         null_comp_report, default_delay, false);
 
     mt_compositor.start();
@@ -336,6 +345,7 @@ TEST_F(SurfaceStackCompositor, buffer_updates_trigger_composition)
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
+        std::make_shared<mc::PresentationNotifier>(),
         null_comp_report, default_delay, false);
 
     mt_compositor.start();
@@ -407,3 +407,19 @@ TEST_F(StaticDisplayConfig, group_can_be_set)
 
     EXPECT_THAT(hdmi1.logical_group_id, Eq(mg::DisplayConfigurationLogicalGroupId{2}));
 }
+
+TEST_F(StaticDisplayConfig, vrr_can_be_enabled)
+{
+    std::istringstream stream{
+        "layouts:\n"
+        "  default:\n"
+        "    cards:\n"
+        "    - HDMI-A-1:\n"
+        "        vrr: true\n"};
+
+    sdc.load_config(stream, "");
+    sdc.apply_to(dc);
+
+    EXPECT_TRUE(hdmi1.vrr_enabled);
+    EXPECT_FALSE(vga1.vrr_enabled);
+}
@@ -0,0 +1,265 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/renderers/gl/renderer.h"
+#include "mir/renderer/gl/render_target.h"
+#include "mir/graphics/buffer_basic.h"
+#include "mir/graphics/texture.h"
+#include "mir/graphics/program_factory.h"
+#include "mir/geometry/size.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace mg = mir::graphics;
+namespace mrg = mir::renderer::gl;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Size const output_size{1920, 1080};
+
+/// A pbuffer of a surfaceless EGL display, so the renderer can run without any display hardware
+class PbufferRenderTarget : public mrg::RenderTarget
+{
+public:
+    PbufferRenderTarget()
+    {
+        auto const get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display)
+        {
+            display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+        {
+            display = EGL_NO_DISPLAY;
+            return;
+        }
+
+        EGLint const config_attribs[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_NONE};
+        EGLConfig config;
+        EGLint num_configs{0};
+        if (!eglChooseConfig(display, config_attribs, &config, 1, &num_configs) || num_configs < 1)
+        {
+            return;
+        }
+
+        EGLint const surface_attribs[] = {
+            EGL_WIDTH, output_size.width.as_int(),
+            EGL_HEIGHT, output_size.height.as_int(),
+            EGL_NONE};
+        surface = eglCreatePbufferSurface(display, config, surface_attribs);
+
+        EGLint const context_attribs[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+        eglBindAPI(EGL_OPENGL_ES_API);
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+    }
+
+    ~PbufferRenderTarget()
+    {
+        if (display != EGL_NO_DISPLAY)
+        {
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (context != EGL_NO_CONTEXT)
+                eglDestroyContext(display, context);
+            if (surface != EGL_NO_SURFACE)
+                eglDestroySurface(display, surface);
+            eglTerminate(display);
+        }
+    }
+
+    auto usable() const -> bool
+    {
+        return surface != EGL_NO_SURFACE && context != EGL_NO_CONTEXT;
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return output_size;
+    }
+
+    void make_current() override
+    {
+        eglMakeCurrent(display, surface, surface, context);
+    }
+
+    void release_current() override
+    {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
+    void swap_buffers() override
+    {
+        // Waiting for the GPU makes each frame's time include its draw calls, not just their submission
+        glFinish();
+    }
+
+    void bind() override
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+private:
+    EGLDisplay display{EGL_NO_DISPLAY};
+    EGLSurface surface{EGL_NO_SURFACE};
+    EGLContext context{EGL_NO_CONTEXT};
+};
+
+/// A 1x1 texture, so that the benchmark measures draw calls rather than texture sampling
+class SolidColourBuffer : public mg::BufferBasic, public mg::NativeBufferBase, public mg::gl::Texture
+{
+public:
+    ~SolidColourBuffer()
+    {
+        if (tex_id)
+            glDeleteTextures(1, &tex_id);
+    }
+
+    auto size() const -> geom::Size override { return {1, 1}; }
+    auto pixel_format() const -> MirPixelFormat override { return mir_pixel_format_argb_8888; }
+    auto native_buffer_base() -> mg::NativeBufferBase* override { return this; }
+
+    auto shader(mg::gl::ProgramFactory& factory) const -> mg::gl::Program const& override
+    {
+        static int shader_id{0};
+        return factory.compile_fragment_shader(
+            &shader_id,
+            "",
+            "uniform sampler2D tex;\n"
+            "vec4 sample_to_rgba(in vec2 texcoord)\n"
+            "{\n"
+            "    return texture2D(tex, texcoord);\n"
+            "}\n");
+    }
+
+    auto layout() const -> Layout override { return Layout::GL; }
+
+    void bind() override
+    {
+        if (!tex_id)
+        {
+            unsigned char const pixel[4]{0x40, 0x80, 0xc0, 0xff};
+            glGenTextures(1, &tex_id);
+            glBindTexture(GL_TEXTURE_2D, tex_id);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+        }
+        glBindTexture(GL_TEXTURE_2D, tex_id);
+    }
+
+    void add_syncpoint() override
+    {
+    }
+
+private:
+    GLuint tex_id{0};
+};
+
+class SyntheticRenderable : public mg::Renderable
+{
+public:
+    SyntheticRenderable(std::shared_ptr<mg::Buffer> buffer, geom::Rectangle const& position, bool translucent)
+        : buffer_{std::move(buffer)},
+          position{position},
+          translucent{translucent}
+    {
+    }
+
+    auto id() const -> ID override { return this; }
+    auto buffer() const -> std::shared_ptr<mg::Buffer> override { return buffer_; }
+    auto screen_position() const -> geom::Rectangle override { return position; }
+    auto clip_area() const -> std::optional<geom::Rectangle> override { return std::nullopt; }
+    auto alpha() const -> float override { return 1.0f; }
+    auto transformation() const -> glm::mat4 override { return glm::mat4{1}; }
+    auto shaped() const -> bool override { return translucent; }
+
+private:
+    std::shared_ptr<mg::Buffer> const buffer_;
+    geom::Rectangle const position;
+    bool const translucent;
+};
+
+struct GLRendererPerformance : testing::TestWithParam<int>
+{
+    void SetUp() override
+    {
+        if (!render_target.usable())
+        {
+            GTEST_SKIP() << "No surfaceless EGL display with pbuffer support";
+        }
+    }
+
+    PbufferRenderTarget render_target;
+};
+}
+
+TEST_P(GLRendererPerformance, draw_cost_of_many_renderables)
+{
+    using namespace std::chrono;
+
+    auto const renderable_count = GetParam();
+    int const frames{200};
+
+    mrg::Renderer renderer{render_target};
+    renderer.set_viewport({{0, 0}, output_size});
+
+    // Overlapping windows, alternately opaque and translucent, to exercise state changes
+    auto const buffer = std::make_shared<SolidColourBuffer>();
+    mg::RenderableList renderables;
+    for (auto i = 0; i != renderable_count; ++i)
+    {
+        geom::Rectangle const position{
+            {(i * 37) % (output_size.width.as_int() - 200), (i * 53) % (output_size.height.as_int() - 200)},
+            {200, 200}};
+        renderables.push_back(std::make_shared<SyntheticRenderable>(buffer, position, i % 2));
+    }
+
+    // Let the renderer compile its shaders and fill its caches
+    renderer.render(renderables);
+
+    auto const start = steady_clock::now();
+    for (auto i = 0; i != frames; ++i)
+    {
+        renderer.render(renderables);
+    }
+    auto const elapsed = duration_cast<duration<double, std::milli>>(steady_clock::now() - start);
+
+    auto const ms_per_frame = elapsed.count() / frames;
+    std::cout << renderable_count << " renderables: " << ms_per_frame << " ms/frame" << std::endl;
+    RecordProperty("ms_per_frame", std::to_string(ms_per_frame));
+    EXPECT_GT(ms_per_frame, 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    GLRenderer,
+    GLRendererPerformance,
+    testing::Values(10, 100, 1000));
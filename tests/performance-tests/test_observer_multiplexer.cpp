@@ -0,0 +1,140 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/observer_multiplexer.h"
+#include "mir/executor.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+class FrameObserver
+{
+public:
+    virtual ~FrameObserver() = default;
+
+    virtual void frame_posted(void const* surface, int frames) = 0;
+};
+
+class CountingObserver : public FrameObserver
+{
+public:
+    void frame_posted(void const*, int frames) override
+    {
+        count.fetch_add(frames, std::memory_order_relaxed);
+    }
+
+    std::atomic<long> count{0};
+};
+
+class FrameObserverMultiplexer : public mir::ObserverMultiplexer<FrameObserver>
+{
+public:
+    FrameObserverMultiplexer()
+        : ObserverMultiplexer{mir::immediate_executor}
+    {
+    }
+
+    void frame_posted(void const* surface, int frames) override
+    {
+        for_each_observer(&FrameObserver::frame_posted, surface, frames);
+    }
+};
+
+/// Runs work straight away like the immediate executor, but goes through spawn() as any other executor would
+class InlineExecutor : public mir::Executor
+{
+public:
+    void spawn(std::function<void()>&& work) override
+    {
+        work();
+    }
+};
+
+struct ObserverMultiplexerPerformance : testing::TestWithParam<int>
+{
+    auto ns_per_notification(mir::Executor& executor, int notifying_threads) -> double
+    {
+        using namespace std::chrono;
+
+        auto const observer_count = GetParam();
+        int const notifications{200000};
+
+        FrameObserverMultiplexer multiplexer;
+        std::vector<std::shared_ptr<CountingObserver>> observers;
+        for (auto i = 0; i != observer_count; ++i)
+        {
+            observers.push_back(std::make_shared<CountingObserver>());
+            multiplexer.register_interest(observers.back(), executor);
+        }
+
+        auto const start = steady_clock::now();
+        std::vector<std::thread> threads;
+        for (auto t = 0; t != notifying_threads; ++t)
+        {
+            threads.emplace_back([&multiplexer, notifications]
+                {
+                    for (auto i = 0; i != notifications; ++i)
+                    {
+                        multiplexer.frame_posted(&multiplexer, 1);
+                    }
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        auto const elapsed = duration_cast<duration<double, std::nano>>(steady_clock::now() - start);
+
+        for (auto const& observer : observers)
+        {
+            EXPECT_EQ(observer->count, long{notifications} * notifying_threads);
+        }
+
+        return elapsed.count() / (notifications * notifying_threads);
+    }
+
+    void report(std::string const& name, double ns)
+    {
+        std::cout << GetParam() << " observers, " << name << ": " << ns << " ns/notification" << std::endl;
+        RecordProperty(name, std::to_string(ns));
+        EXPECT_GT(ns, 0);
+    }
+};
+}
+
+TEST_P(ObserverMultiplexerPerformance, notification_throughput)
+{
+    InlineExecutor inline_executor;
+    auto const hardware_threads = static_cast<int>(std::max(2u, std::thread::hardware_concurrency()));
+
+    report("immediate_executor", ns_per_notification(mir::immediate_executor, 1));
+    report("spawned_executor", ns_per_notification(inline_executor, 1));
+    report("immediate_executor_contended", ns_per_notification(mir::immediate_executor, hardware_threads));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ObserverCounts,
+    ObserverMultiplexerPerformance,
+    testing::Values(1, 8, 32));
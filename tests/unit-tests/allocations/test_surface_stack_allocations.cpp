@@ -0,0 +1,163 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/scene/surface_stack.h"
+#include "src/server/scene/basic_surface.h"
+#include "src/server/report/null_report_factory.h"
+#include "mir/compositor/scene_element.h"
+#include "mir/test/doubles/stub_buffer_stream.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <new>
+
+namespace mc = mir::compositor;
+namespace ms = mir::scene;
+namespace mi = mir::input;
+namespace mr = mir::report;
+namespace mtd = mir::test::doubles;
+
+namespace
+{
+// Only allocations made on the thread under test while counting are counted
+thread_local bool counting_allocations{false};
+thread_local int allocation_count{0};
+
+class AllocationCounter
+{
+public:
+    AllocationCounter()
+    {
+        allocation_count = 0;
+        counting_allocations = true;
+    }
+
+    ~AllocationCounter()
+    {
+        counting_allocations = false;
+    }
+
+    auto count() const -> int
+    {
+        return allocation_count;
+    }
+};
+}
+
+// Replacing these is program-wide (hence this test executable of its own), so they do nothing other than count
+void* operator new(std::size_t size)
+{
+    if (counting_allocations)
+        ++allocation_count;
+
+    if (auto const block = std::malloc(size ? size : 1))
+        return block;
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+namespace
+{
+struct SurfaceStackAllocations : testing::Test
+{
+    SurfaceStackAllocations()
+    {
+        stack.register_compositor(compositor_id);
+    }
+
+    ~SurfaceStackAllocations()
+    {
+        stack.unregister_compositor(compositor_id);
+    }
+
+    void add_surfaces(int count)
+    {
+        for (auto i = 0; i != count; ++i)
+        {
+            auto const surface = std::make_shared<ms::BasicSurface>(
+                nullptr,
+                mir::wayland::Weak<mir::frontend::WlSurface>{},
+                "a surface with a name too long for the small string optimisation",
+                mir::geometry::Rectangle{{i, i}, {100, 100}},
+                mir_pointer_unconfined,
+                std::list<ms::StreamInfo>{{std::make_shared<mtd::StubBufferStream>(), {}, {}}},
+                nullptr,
+                mr::null_scene_report());
+            stack.add_surface(surface, mi::InputReceptionMode::normal);
+        }
+    }
+
+    ms::SurfaceStack stack{mr::null_scene_report()};
+    int const compositor_id_storage{0};
+    mc::CompositorID const compositor_id{&compositor_id_storage};
+};
+}
+
+TEST_F(SurfaceStackAllocations, steady_state_frame_allocates_only_the_element_sequence)
+{
+    using namespace testing;
+    int const surface_count{60};
+    add_surfaces(surface_count);
+
+    // The first frames fill the pools
+    for (auto i = 0; i != 2; ++i)
+        ASSERT_THAT(stack.scene_elements_for(compositor_id).size(), Eq(surface_count));
+
+    AllocationCounter const allocations;
+    {
+        auto const elements = stack.scene_elements_for(compositor_id);
+        EXPECT_THAT(elements.size(), Eq(surface_count));
+    }
+
+    EXPECT_THAT(allocations.count(), Eq(1));
+}
+
+TEST_F(SurfaceStackAllocations, frames_for_several_compositors_share_recycled_elements)
+{
+    using namespace testing;
+    int const other_storage{0};
+    mc::CompositorID const other_compositor{&other_storage};
+    stack.register_compositor(other_compositor);
+    add_surfaces(10);
+
+    for (auto i = 0; i != 2; ++i)
+    {
+        auto const elements = stack.scene_elements_for(compositor_id);
+        auto const other_elements = stack.scene_elements_for(other_compositor);
+    }
+
+    AllocationCounter const allocations;
+    {
+        auto const elements = stack.scene_elements_for(compositor_id);
+        auto const other_elements = stack.scene_elements_for(other_compositor);
+    }
+
+    EXPECT_THAT(allocations.count(), Eq(2));
+
+    stack.unregister_compositor(other_compositor);
+}
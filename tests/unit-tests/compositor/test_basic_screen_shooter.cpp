@@ -17,6 +17,7 @@
 #include "src/server/compositor/basic_screen_shooter.h"
 
 #include "mir/renderer/gl/buffer_render_target.h"
+#include "mir/graphics/dmabuf_buffer.h"
 #include "mir/test/fake_shared.h"
 #include "mir/test/doubles/mock_scene.h"
 #include "mir/test/doubles/mock_renderer.h"
@@ -47,6 +48,8 @@ class MockBufferRenderTarget: public mrg::BufferRenderTarget
 {
 public:
     MOCK_METHOD(void, set_buffer, (std::shared_ptr<mrs::WriteMappableBuffer> const& buffer), (override));
+    MOCK_METHOD(void, set_dmabuf, (std::shared_ptr<mg::DMABufBuffer> const& buffer), (override));
+    MOCK_METHOD(void, finish_copy, (), (override));
     MOCK_METHOD(geom::Size, size, (), (const, override));
     MOCK_METHOD(void, make_current, (), (override));
     MOCK_METHOD(void, release_current, (), (override));
@@ -54,6 +57,18 @@ public:
     MOCK_METHOD(void, bind, (), (override));
 };
 
+class StubDMABufBuffer: public mg::DMABufBuffer
+{
+public:
+    auto drm_fourcc() const -> uint32_t override { return 0; }
+    auto modifier() const -> std::optional<uint64_t> override { return std::nullopt; }
+    auto planes() const -> std::vector<PlaneDescriptor> const& override { return planes_; }
+    auto size() const -> geom::Size override { return {40, 50}; }
+
+private:
+    std::vector<PlaneDescriptor> const planes_;
+};
+
 struct BasicScreenShooter : Test
 {
     BasicScreenShooter()
@@ -148,10 +163,119 @@ TEST_F(BasicScreenShooter, sets_buffer_before_render)
     EXPECT_CALL(render_target, bind());
     EXPECT_CALL(renderer, render(_));
     EXPECT_CALL(render_target, release_current());
+    EXPECT_CALL(render_target, make_current());
+    EXPECT_CALL(render_target, finish_copy());
+    EXPECT_CALL(render_target, release_current());
+    EXPECT_CALL(callback, Call(std::make_optional(clock.now())));
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, redraws_only_damage_when_area_was_captured_last)
+{
+    geom::Rectangle const damage{{25, 35}, {5, 5}};
+    EXPECT_CALL(renderer, set_damage(_)).Times(0);
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, damage, [](auto){});
+    executor.execute();
+    Mock::VerifyAndClearExpectations(&renderer);
+
+    EXPECT_CALL(renderer, set_damage(Eq(geom::Rectangles{damage})));
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, damage, [](auto){});
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, redraws_everything_when_another_area_was_captured_last)
+{
+    geom::Rectangle const other_rect{{0, 0}, {40, 50}};
+    shooter.capture(mt::fake_shared(buffer), other_rect, [](auto){});
+    executor.execute();
+
+    EXPECT_CALL(renderer, set_damage(_)).Times(0);
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, {{25, 35}, {5, 5}}, [](auto){});
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, redraws_everything_after_failed_capture)
+{
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, [](auto){});
+    EXPECT_CALL(renderer, render(_)).WillOnce(Throw(std::runtime_error{"throw in render()!"}));
+    executor.execute();
+    Mock::VerifyAndClearExpectations(&renderer);
+
+    EXPECT_CALL(renderer, set_damage(_)).Times(0);
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, {{25, 35}, {5, 5}}, [](auto){});
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, fails_captures_beyond_in_flight_limit)
+{
+    for (auto i = 0; i != mc::BasicScreenShooter::max_captures_in_flight; ++i)
+    {
+        shooter.capture(mt::fake_shared(buffer), viewport_rect, [&](auto time)
+            {
+                callback.Call(time);
+            });
+    }
+    StrictMock<MockFunction<void(std::optional<mir::time::Timestamp>)>> rejected_callback;
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, [&](auto time)
+        {
+            rejected_callback.Call(time);
+        });
+
+    EXPECT_CALL(callback, Call(std::make_optional(clock.now()))).Times(mc::BasicScreenShooter::max_captures_in_flight);
+    EXPECT_CALL(rejected_callback, Call(nullopt_time));
+    executor.execute();
+    Mock::VerifyAndClearExpectations(&callback);
+
+    // Once the captures in flight have completed there is room for more
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    EXPECT_CALL(callback, Call(std::make_optional(clock.now())));
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, renders_straight_into_dmabuf)
+{
+    StubDMABufBuffer dmabuf;
+    shooter.capture(mt::fake_shared(dmabuf), viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    InSequence seq;
+    EXPECT_CALL(render_target, set_dmabuf(Eq(mt::fake_shared(dmabuf))));
+    EXPECT_CALL(renderer, render(_));
+    EXPECT_CALL(render_target, finish_copy());
     EXPECT_CALL(callback, Call(std::make_optional(clock.now())));
     executor.execute();
 }
 
+TEST_F(BasicScreenShooter, redraws_everything_after_capture_into_dmabuf)
+{
+    StubDMABufBuffer dmabuf;
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, [](auto){});
+    shooter.capture(mt::fake_shared(dmabuf), viewport_rect, [](auto){});
+    executor.execute();
+
+    EXPECT_CALL(renderer, set_damage(_)).Times(0);
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, {{25, 35}, {5, 5}}, [](auto){});
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, throw_in_finish_copy_causes_graceful_failure)
+{
+    ON_CALL(render_target, finish_copy()).WillByDefault(Invoke([]()
+        {
+            throw std::runtime_error{"throw in finish_copy()!"};
+        }));
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    EXPECT_CALL(callback, Call(nullopt_time));
+    executor.execute();
+}
+
 TEST_F(BasicScreenShooter, throw_in_scene_elements_for_causes_graceful_failure)
 {
     ON_CALL(scene, scene_elements_for(_)).WillByDefault(Invoke([](auto) -> mc::SceneElementSequence
@@ -0,0 +1,81 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/compositor/compositor.h"
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+namespace mg = mir::graphics;
+namespace mc = mir::compositor;
+
+namespace
+{
+/// Only overrides start() and stop(), so gets the default sync group handling
+struct StartStopCompositor : mc::Compositor
+{
+    MOCK_METHOD(void, start, (), (override));
+    MOCK_METHOD(void, stop, (), (override));
+};
+
+auto const group = reinterpret_cast<mg::DisplaySyncGroup*>(0xaa);
+}
+
+TEST(Compositor, restarts_by_default_when_sync_groups_change)
+{
+    StartStopCompositor compositor;
+
+    InSequence s;
+    EXPECT_CALL(compositor, stop());
+    EXPECT_CALL(compositor, start());
+
+    compositor.stop_sync_groups({group});
+    compositor.start_new_sync_groups();
+}
+
+TEST(Compositor, restarts_by_default_when_sync_groups_are_only_added)
+{
+    StartStopCompositor compositor;
+
+    InSequence s;
+    EXPECT_CALL(compositor, stop());
+    EXPECT_CALL(compositor, start());
+
+    compositor.stop_sync_groups({});
+    compositor.start_new_sync_groups();
+}
+
+TEST(Compositor, does_not_start_by_default_unless_stopped_for_sync_groups)
+{
+    StartStopCompositor compositor;
+
+    EXPECT_CALL(compositor, stop()).Times(0);
+    EXPECT_CALL(compositor, start()).Times(0);
+
+    compositor.start_new_sync_groups();
+}
+
+TEST(Compositor, restarts_by_default_only_once_per_change)
+{
+    StartStopCompositor compositor;
+
+    EXPECT_CALL(compositor, stop());
+    EXPECT_CALL(compositor, start());
+
+    compositor.stop_sync_groups({group});
+    compositor.start_new_sync_groups();
+    compositor.start_new_sync_groups();
+}
@@ -335,6 +335,55 @@ struct MockSceneElement : mc::SceneElement
 };
 }
 
+TEST_F(DefaultDisplayBufferCompositor, partly_occluded_surfaces_are_clipped_to_their_visible_part)
+{
+    using namespace testing;
+
+    auto below = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{0,0},{100,100}});
+    auto above = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{0,50},{100,50}});
+
+    mg::RenderableList rendered;
+    EXPECT_CALL(mock_renderer, render(_))
+        .WillOnce(SaveArg<0>(&rendered));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+    compositor.composite(make_scene_elements({below, above}));
+
+    ASSERT_THAT(rendered.size(), Eq(2u));
+    EXPECT_THAT(rendered[0]->id(), Eq(below->id()));
+    EXPECT_THAT(rendered[0]->screen_position(), Eq(below->screen_position()));
+    EXPECT_THAT(rendered[0]->clip_area(), Eq(std::make_optional(geom::Rectangle{{0,0},{100,50}})));
+    EXPECT_THAT(rendered[1], Eq(above));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, surfaces_with_non_rectangular_visible_parts_are_drawn_once_per_piece)
+{
+    using namespace testing;
+
+    auto below = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{0,0},{100,100}});
+    auto above = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{40,40},{60,60}});
+
+    mg::RenderableList rendered;
+    EXPECT_CALL(mock_renderer, render(_))
+        .WillOnce(SaveArg<0>(&rendered));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+    compositor.composite(make_scene_elements({below, above}));
+
+    ASSERT_THAT(rendered.size(), Eq(3u));
+    EXPECT_THAT(rendered[0]->id(), Eq(below->id()));
+    EXPECT_THAT(rendered[0]->clip_area(), Eq(std::make_optional(geom::Rectangle{{0,0},{100,40}})));
+    EXPECT_THAT(rendered[1]->id(), Eq(below->id()));
+    EXPECT_THAT(rendered[1]->clip_area(), Eq(std::make_optional(geom::Rectangle{{0,40},{40,60}})));
+    EXPECT_THAT(rendered[2], Eq(above));
+}
+
 TEST_F(DefaultDisplayBufferCompositor, marks_rendered_scene_elements)
 {
     using namespace testing;
@@ -378,3 +427,198 @@ TEST_F(DefaultDisplayBufferCompositor, marks_occluded_scene_elements)
     compositor.composite({element0_occluded, element1_rendered, element2_occluded});
 }
 
+
+TEST_F(DefaultDisplayBufferCompositor, first_frame_is_fully_damaged)
+{
+    using namespace testing;
+
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{screen})));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, unchanged_scene_has_no_damage)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({big, small}));
+
+    Mock::VerifyAndClearExpectations(&mock_renderer);
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{})));
+
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, damage_is_passed_on_clipped_to_output)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({big, small}));
+
+    Mock::VerifyAndClearExpectations(&mock_renderer);
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{
+        {{10, 20}, {16, 16}},
+        {{1350, 0}, {16, 16}}})));
+
+    compositor.add_damage(big->id(), {{{10, 20}, {16, 16}}, {{1350, -16}, {32, 32}}});
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, removed_and_added_renderables_are_damaged)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({big}));
+
+    Mock::VerifyAndClearExpectations(&mock_renderer);
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{small->screen_position()})));
+
+    compositor.composite(make_scene_elements({big, small}));
+
+    Mock::VerifyAndClearExpectations(&mock_renderer);
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{big->screen_position()})));
+
+    compositor.composite(make_scene_elements({small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, new_buffer_without_damage_damages_whole_renderable)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({big, small}));
+
+    Mock::VerifyAndClearExpectations(&mock_renderer);
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{small->screen_position()})));
+
+    small->set_buffer(std::make_shared<mtd::StubBuffer>());
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, new_buffer_with_damage_damages_only_that)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({big, small}));
+
+    geom::Rectangle const clock{{20, 30}, {16, 16}};
+
+    Mock::VerifyAndClearExpectations(&mock_renderer);
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{clock})));
+
+    small->set_buffer(std::make_shared<mtd::StubBuffer>());
+    compositor.add_damage(small->id(), {clock});
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, damage_from_another_renderable_does_not_cover_a_new_buffer)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({big, small}));
+
+    geom::Rectangle const under_small{small->screen_position().top_left, {4, 4}};
+
+    Mock::VerifyAndClearExpectations(&mock_renderer);
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{small->screen_position(), under_small})));
+
+    small->set_buffer(std::make_shared<mtd::StubBuffer>());
+    compositor.add_damage(big->id(), {under_small});
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, restacking_damages_everything)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    auto const left = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{0, 0}, {100, 100}});
+    auto const right = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{50, 0}, {100, 100}});
+
+    compositor.composite(make_scene_elements({left, right}));
+
+    Mock::VerifyAndClearExpectations(&mock_renderer);
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{screen})));
+
+    compositor.composite(make_scene_elements({right, left}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, frame_after_overlay_is_fully_damaged)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({big, small}));
+
+    EXPECT_CALL(display_buffer, overlay(_))
+        .WillOnce(Return(true))
+        .WillRepeatedly(Return(false));
+    compositor.composite(make_scene_elements({fullscreen}));
+
+    Mock::VerifyAndClearExpectations(&mock_renderer);
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{screen})));
+
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, renderables_the_display_buffer_overlays_are_not_rendered)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({big, small}));
+
+    Mock::VerifyAndClearExpectations(&mock_renderer);
+    EXPECT_CALL(display_buffer, overlay_topmost(_))
+        .WillOnce(Return(mg::RenderableList{big}));
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{small->screen_position()})));
+    EXPECT_CALL(mock_renderer, render(ElementsAre(big)));
+
+    compositor.composite(make_scene_elements({big, small}));
+}
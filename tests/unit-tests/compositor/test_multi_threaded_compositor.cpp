@@ -15,6 +15,7 @@
  */
 
 #include "src/server/compositor/multi_threaded_compositor.h"
+#include "src/server/compositor/presentation_notifier.h"
 #include "src/server/report/null_report_factory.h"
 
 #include "mir/compositor/display_listener.h"
@@ -25,6 +26,7 @@
 #include "mir/raii.h"
 
 #include "mir/test/current_thread_name.h"
+#include "mir/test/signal.h"
 #include "mir/test/doubles/null_display.h"
 #include "mir/test/doubles/null_display_buffer.h"
 #include "mir/test/doubles/mock_display_buffer.h"
@@ -36,6 +38,7 @@
 
 #include <boost/throw_exception.hpp>
 
+#include <atomic>
 #include <unordered_map>
 #include <unordered_set>
 #include <thread>
@@ -90,6 +93,49 @@ private:
     std::vector<StubDisplaySyncGroup> buffers;
 };
 
+class DisplayNotShowingFirstFrame : public mtd::NullDisplay
+{
+public:
+    void for_each_display_sync_group(std::function<void(mg::DisplaySyncGroup&)> const& f) override
+    {
+        f(group);
+    }
+
+    /// Raised once the frame in place of the one that wasn't shown has been posted
+    mt::Signal second_post;
+
+private:
+    struct SyncGroup : mg::DisplaySyncGroup
+    {
+        SyncGroup(mt::Signal& second_post)
+            : second_post{second_post}
+        {
+        }
+        void for_each_display_buffer(std::function<void(mg::DisplayBuffer&)> const& f) override
+        {
+            f(buffer);
+        }
+        void post() override
+        {
+            if (++posts == 2)
+                second_post.raise();
+        }
+        std::chrono::milliseconds recommended_sleep() const override
+        {
+            return std::chrono::milliseconds::zero();
+        }
+        bool needs_recomposite() const override
+        {
+            return posts == 1;
+        }
+        std::atomic<int> posts{0};
+        mt::Signal& second_post;
+        testing::NiceMock<mtd::MockDisplayBuffer> buffer;
+    };
+
+    SyncGroup group{second_post};
+};
+
 class StubScene : public mtd::StubScene
 {
 public:
@@ -372,7 +418,7 @@ TEST(MultiThreadedCompositor, compositing_happens_in_different_threads)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, std::make_shared<mc::PresentationNotifier>(), null_report, default_delay, true};
 
     compositor.start();
 
@@ -412,6 +458,7 @@ TEST(MultiThreadedCompositor, does_not_deadlock_itself)
         scene,
         std::make_shared<mtd::NullDisplayBufferCompositorFactory>(),
         std::make_shared<ReentrantDisplayListener>(scene),
+        std::make_shared<mc::PresentationNotifier>(),
         null_report,
         default_delay,
         true
@@ -437,6 +484,7 @@ TEST(MultiThreadedCompositor, reports_in_the_right_places)
     mc::MultiThreadedCompositor compositor{display, scene,
                                            db_compositor_factory,
                                            null_display_listener,
+                                           std::make_shared<mc::PresentationNotifier>(),
                                            mock_report,
                                            default_delay,
                                            true};
@@ -483,7 +531,7 @@ TEST(MultiThreadedCompositor, composites_only_on_demand)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, std::make_shared<mc::PresentationNotifier>(), null_report, default_delay, true};
 
     // Verify we're actually starting at zero frames
     EXPECT_TRUE(db_compositor_factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -544,7 +592,7 @@ TEST(MultiThreadedCompositor, schedules_enough_frames)
     auto scene = std::make_shared<StubScene>();
     auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
     mc::MultiThreadedCompositor compositor{display, scene, factory,
-                                           null_display_listener, null_report, default_delay, true};
+                                           null_display_listener, std::make_shared<mc::PresentationNotifier>(), null_report, default_delay, true};
 
     EXPECT_TRUE(factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
 
@@ -619,7 +667,7 @@ TEST(MultiThreadedCompositor, recommended_sleep_throttles_compositor_loop)
     auto scene = std::make_shared<StubScene>();
     auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
     mc::MultiThreadedCompositor compositor{display, scene, factory,
-                                           null_display_listener, null_report,
+                                           null_display_listener, std::make_shared<mc::PresentationNotifier>(), null_report,
                                            recommendation, false};
 
     EXPECT_TRUE(factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -659,6 +707,25 @@ TEST(MultiThreadedCompositor, recommended_sleep_throttles_compositor_loop)
     compositor.stop();
 }
 
+TEST(MultiThreadedCompositor, composites_again_when_the_display_could_not_show_a_frame)
+{
+    auto display = std::make_shared<DisplayNotShowingFirstFrame>();
+    auto scene = std::make_shared<StubScene>();
+    auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, std::make_shared<mc::PresentationNotifier>(), null_report, default_delay, false};
+
+    compositor.start();
+    scene->emit_change_event();
+
+    auto const posted_again = display->second_post.wait_for(std::chrono::seconds{10});
+    compositor.stop();
+
+    ASSERT_TRUE(posted_again);
+
+    // One frame for the change, and one more in place of the frame that wasn't shown
+    EXPECT_TRUE(db_compositor_factory->check_record_count_for_each_buffer(1, 2, 2));
+}
+
 TEST(MultiThreadedCompositor, when_no_initial_composite_is_needed_there_is_none)
 {
     using namespace testing;
@@ -668,7 +735,7 @@ TEST(MultiThreadedCompositor, when_no_initial_composite_is_needed_there_is_none)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, false};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, std::make_shared<mc::PresentationNotifier>(), null_report, default_delay, false};
 
     // Verify we're actually starting at zero frames
     ASSERT_TRUE(db_compositor_factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -691,7 +758,7 @@ TEST(MultiThreadedCompositor, when_no_initial_composite_is_needed_we_still_compo
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, false};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, std::make_shared<mc::PresentationNotifier>(), null_report, default_delay, false};
 
     compositor.start();
 
@@ -726,7 +793,7 @@ TEST(MultiThreadedCompositor, surface_update_from_render_doesnt_deadlock)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<SurfaceUpdatingDisplayBufferCompositorFactory>(scene);
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, std::make_shared<mc::PresentationNotifier>(), null_report, default_delay, true};
 
     compositor.start();
 
@@ -758,7 +825,7 @@ TEST(MultiThreadedCompositor, double_start_or_stop_ignored)
         .Times(AtLeast(0))
         .WillRepeatedly(Return(mc::SceneElementSequence{}));
 
-    mc::MultiThreadedCompositor compositor{display, mock_scene, db_compositor_factory, null_display_listener, mock_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, mock_scene, db_compositor_factory, null_display_listener, std::make_shared<mc::PresentationNotifier>(), mock_report, default_delay, true};
 
     compositor.start();
     compositor.start();
@@ -773,7 +840,7 @@ TEST(MultiThreadedCompositor, cleans_up_after_throw_in_start)
     auto display = std::make_shared<StubDisplayWithMockBuffers>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, std::make_shared<mc::PresentationNotifier>(), null_report, default_delay, true};
 
     scene->throw_on_add_observer(true);
 
@@ -827,7 +894,7 @@ TEST(MultiThreadedCompositor, DISABLED_names_compositor_threads)
     auto display = std::make_shared<StubDisplayWithMockBuffers>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<ThreadNameDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, std::make_shared<mc::PresentationNotifier>(), null_report, default_delay, true};
 
     compositor.start();
 
@@ -856,10 +923,50 @@ TEST(MultiThreadedCompositor, registers_and_unregisters_with_scene)
     EXPECT_CALL(*mock_scene, register_compositor(_))
         .Times(nbuffers);
     mc::MultiThreadedCompositor compositor{
-        display, mock_scene, db_compositor_factory, null_display_listener, mock_report, default_delay, true};
+        display, mock_scene, db_compositor_factory, null_display_listener, std::make_shared<mc::PresentationNotifier>(), mock_report, default_delay, true};
+
+    compositor.start();
+
+    Mock::VerifyAndClearExpectations(mock_scene.get());
+
+    EXPECT_CALL(*mock_scene, unregister_compositor(_))
+        .Times(nbuffers);
+
+    compositor.stop();
+}
+
+TEST(MultiThreadedCompositor, stopping_some_sync_groups_leaves_the_others_compositing)
+{
+    using namespace testing;
+    unsigned int const nbuffers{3};
+    auto display = std::make_shared<StubDisplayWithMockBuffers>(nbuffers);
+    auto mock_scene = std::make_shared<NiceMock<mtd::MockScene>>();
+    auto db_compositor_factory = std::make_shared<mtd::NullDisplayBufferCompositorFactory>();
+    auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
+
+    mc::MultiThreadedCompositor compositor{
+        display, mock_scene, db_compositor_factory, null_display_listener, std::make_shared<mc::PresentationNotifier>(), mock_report, default_delay, true};
 
     compositor.start();
 
+    mg::DisplaySyncGroup* first_group{nullptr};
+    display->for_each_display_sync_group(
+        [&](mg::DisplaySyncGroup& group)
+        {
+            if (!first_group)
+                first_group = &group;
+        });
+
+    EXPECT_CALL(*mock_scene, unregister_compositor(_))
+        .Times(1);
+
+    compositor.stop_sync_groups({first_group});
+    Mock::VerifyAndClearExpectations(mock_scene.get());
+
+    EXPECT_CALL(*mock_scene, register_compositor(_))
+        .Times(1);
+
+    compositor.start_new_sync_groups();
     Mock::VerifyAndClearExpectations(mock_scene.get());
 
     EXPECT_CALL(*mock_scene, unregister_compositor(_))
@@ -879,7 +986,7 @@ TEST(MultiThreadedCompositor, notifies_about_display_additions_and_removals)
     auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, std::make_shared<mc::PresentationNotifier>(), mock_report, default_delay, true};
 
     EXPECT_CALL(*mock_display_listener, add_display(_)).Times(nbuffers);
 
@@ -901,7 +1008,7 @@ TEST(MultiThreadedCompositor, when_compositor_thread_fails_start_reports_error)
     auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, std::make_shared<mc::PresentationNotifier>(), mock_report, default_delay, true};
 
     EXPECT_CALL(*mock_display_listener, add_display(_))
         .WillRepeatedly(Throw(std::runtime_error("Failed to add display")));
@@ -924,7 +1031,7 @@ TEST(MultiThreadedCompositor, can_schedule_from_display_observer_when_adding_dis
         .WillByDefault(InvokeWithoutArgs([&]{ stub_scene->emit_change_event(); }));
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, std::make_shared<mc::PresentationNotifier>(), mock_report, default_delay, true};
     compositor.start();
 }
 
@@ -942,6 +1049,6 @@ TEST(MultiThreadedCompositor, can_schedule_from_display_observer_when_removing_d
         .WillByDefault(InvokeWithoutArgs([&]{ stub_scene->emit_change_event(); }));
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, std::make_shared<mc::PresentationNotifier>(), mock_report, default_delay, true};
     compositor.start();
 }
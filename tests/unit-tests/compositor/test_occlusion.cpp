@@ -123,6 +123,33 @@ TEST_F(OcclusionFilterTest, shaped_window_occludes_nothing)
     EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
 }
 
+TEST_F(OcclusionFilterTest, opaque_region_of_shaped_window_occludes)
+{
+    auto top = std::make_shared<mtd::FakeRenderable>(Rectangle{{0, 0}, {100, 100}}, 1.0f, false);
+    top->set_opaque_region({{{10, 10}, {80, 80}}});
+    auto covered = std::make_shared<mtd::FakeRenderable>(20, 20, 50, 50);
+    auto uncovered = std::make_shared<mtd::FakeRenderable>(5, 5, 50, 50);
+    auto elements = scene_elements_from({uncovered, covered, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(covered));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(uncovered, top));
+}
+
+TEST_F(OcclusionFilterTest, opaque_region_of_translucent_window_occludes_nothing)
+{
+    auto top = std::make_shared<mtd::FakeRenderable>(Rectangle{{0, 0}, {100, 100}}, 0.5f, false);
+    top->set_opaque_region({{{0, 0}, {100, 100}}});
+    auto bottom = std::make_shared<mtd::FakeRenderable>(20, 20, 50, 50);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
+}
+
 TEST_F(OcclusionFilterTest, identical_window_occluded)
 {
     auto top = std::make_shared<mtd::FakeRenderable>(10, 10, 10, 10);
@@ -200,3 +227,47 @@ TEST_F(OcclusionFilterTest,
     EXPECT_THAT(renderables_from(occlusions), ElementsAre(partially_onscreen));
     EXPECT_THAT(renderables_from(elements), ElementsAre(covering));
 }
+
+TEST_F(OcclusionFilterTest, window_covered_by_several_windows_together_is_occluded)
+{
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(10, 10, 200, 100);
+    auto const left = std::make_shared<mtd::FakeRenderable>(0, 0, 110, 200);
+    auto const right = std::make_shared<mtd::FakeRenderable>(110, 0, 200, 200);
+    auto elements = scene_elements_from({
+        bottom,
+        left,
+        right
+    });
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(bottom));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(left, right));
+}
+
+TEST_F(OcclusionFilterTest, visible_regions_exclude_parts_hidden_by_windows_above)
+{
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(0, 0, 200, 100);
+    auto const middle = std::make_shared<mtd::FakeRenderable>(Rectangle{{100, 0}, {100, 100}}, 0.5f);
+    auto const top = std::make_shared<mtd::FakeRenderable>(0, 50, 200, 50);
+
+    auto const visible = visible_regions_of({bottom, middle, top}, monitor_rect);
+
+    Rectangle const upper_half{{0, 0}, {200, 50}};
+    Rectangle const upper_right{{100, 0}, {100, 50}};
+    ASSERT_THAT(visible.size(), Eq(3u));
+    EXPECT_THAT(visible[0], Eq(Region(upper_half)));
+    EXPECT_THAT(visible[1], Eq(Region(upper_right)));
+    EXPECT_THAT(visible[2], Eq(Region(top->screen_position())));
+}
+
+TEST_F(OcclusionFilterTest, visible_regions_are_clipped_to_area)
+{
+    auto const partially_onscreen = std::make_shared<mtd::FakeRenderable>(-50, 100, 150, 100);
+
+    auto const visible = visible_regions_of({partially_onscreen}, monitor_rect);
+
+    Rectangle const onscreen{{0, 100}, {100, 100}};
+    ASSERT_THAT(visible.size(), Eq(1u));
+    EXPECT_THAT(visible[0], Eq(Region(onscreen)));
+}
@@ -17,6 +17,7 @@
 #include "mir/test/doubles/stub_buffer.h"
 #include "mir/test/fake_shared.h"
 #include "src/server/compositor/stream.h"
+#include "src/server/compositor/presentation_notifier.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -48,6 +49,24 @@ struct Stream : Test
     mc::Stream stream{
         initial_size, construction_format};
 };
+
+struct StreamPresentation : Test
+{
+    StreamPresentation()
+    {
+        notifier->register_compositor(output, [this]{ ++frames_scheduled; });
+    }
+
+    MOCK_METHOD0(frame_done, void());
+    MOCK_METHOD1(buffer_presented, void(std::optional<mg::FramePresentation> const&));
+
+    int const output_storage{0};
+    mc::CompositorID const output{&output_storage};
+    int frames_scheduled{0};
+    std::shared_ptr<mg::Buffer> const buffer{std::make_shared<mtd::StubBuffer>(geom::Size{44, 2})};
+    std::shared_ptr<mc::PresentationNotifier> const notifier{std::make_shared<mc::PresentationNotifier>()};
+    mc::Stream stream{geom::Size{44, 2}, mir_pixel_format_abgr_8888, notifier};
+};
 }
 
 TEST_F(Stream, transitions_from_queuing_to_framedropping)
@@ -133,9 +152,9 @@ TEST_F(Stream, tracks_has_buffer)
 TEST_F(Stream, calls_frame_callback_after_scheduling_on_submissions)
 {
     int frame_count{0};
-    stream.set_frame_posted_callback([&frame_count](auto) { ++frame_count;});
+    stream.set_frame_posted_callback([&frame_count](auto, auto) { ++frame_count;});
     stream.submit_buffer(buffers[0]);
-    stream.set_frame_posted_callback([](auto) {});
+    stream.set_frame_posted_callback([](auto, auto) {});
     stream.submit_buffer(buffers[0]);
     EXPECT_THAT(frame_count, Eq(1));
 }
@@ -143,7 +162,7 @@ TEST_F(Stream, calls_frame_callback_after_scheduling_on_submissions)
 TEST_F(Stream, frame_callback_is_called_without_scheduling_lock)
 {
     stream.set_frame_posted_callback(
-        [this](auto)
+        [this](auto, auto)
         {
             EXPECT_THAT(stream.buffers_ready_for_compositor(this), Eq(1));
             EXPECT_TRUE(stream.has_submitted_buffer());
@@ -151,6 +170,33 @@ TEST_F(Stream, frame_callback_is_called_without_scheduling_lock)
     stream.submit_buffer(buffers[0]);
 }
 
+TEST_F(Stream, first_submission_is_fully_damaged)
+{
+    geom::Rectangles damage;
+    stream.set_frame_posted_callback([&damage](auto, geom::Rectangles const& d) { damage = d; });
+    stream.submit_buffer(buffers[0], geom::Rectangles{{{1, 1}, {2, 1}}});
+    EXPECT_THAT(damage, Eq(geom::Rectangles{{{}, initial_size}}));
+}
+
+TEST_F(Stream, frame_callback_is_given_submitted_damage_clipped_to_buffer)
+{
+    geom::Rectangles damage;
+    stream.submit_buffer(buffers[0]);
+    stream.set_frame_posted_callback([&damage](auto, geom::Rectangles const& d) { damage = d; });
+    stream.submit_buffer(buffers[1], geom::Rectangles{{{1, 0}, {2, 1}}, {{40, 1}, {10, 10}}, {{100, 100}, {1, 1}}});
+    EXPECT_THAT(damage, Eq(geom::Rectangles{{{1, 0}, {2, 1}}, {{40, 1}, {4, 1}}}));
+}
+
+TEST_F(Stream, resizing_buffer_damages_everything)
+{
+    geom::Size const new_size{20, 20};
+    geom::Rectangles damage;
+    stream.submit_buffer(buffers[0]);
+    stream.set_frame_posted_callback([&damage](auto, geom::Rectangles const& d) { damage = d; });
+    stream.submit_buffer(std::make_shared<mtd::StubBuffer>(new_size), geom::Rectangles{{{1, 1}, {1, 1}}});
+    EXPECT_THAT(damage, Eq(geom::Rectangles{{{}, new_size}}));
+}
+
 TEST_F(Stream, flattens_queue_out_when_told_to_drop)
 {
     for(auto& buffer : buffers)
@@ -180,7 +226,7 @@ TEST_F(Stream, forces_a_new_buffer_when_told_to_drop_buffers)
 
 TEST_F(Stream, throws_on_nullptr_submissions)
 {
-    stream.set_frame_posted_callback([](auto) { FAIL() << "frame-posted should not be called on null buffer"; });
+    stream.set_frame_posted_callback([](auto, auto) { FAIL() << "frame-posted should not be called on null buffer"; });
     EXPECT_THROW({
         stream.submit_buffer(nullptr);
     }, std::invalid_argument);
@@ -236,3 +282,97 @@ TEST_F(Stream, stream_remembers_scale_when_buffer_added)
     stream.submit_buffer(buffers[0]);
     ASSERT_THAT(stream.stream_size(), Eq(initial_size / 2));
 }
+
+TEST_F(StreamPresentation, callback_waits_for_presentation_of_the_output_showing_the_buffer)
+{
+    stream.submit_buffer(buffer);
+    EXPECT_TRUE(stream.when_presented([this]{ frame_done(); }));
+
+    EXPECT_CALL(*this, frame_done()).Times(0);
+    stream.lock_compositor_buffer(output);
+    Mock::VerifyAndClearExpectations(this);
+
+    EXPECT_CALL(*this, frame_done()).Times(1);
+    notifier->presented(output, mg::FramePresentation{});
+    notifier->presented(output, mg::FramePresentation{});
+}
+
+TEST_F(StreamPresentation, callback_runs_when_buffer_is_taken_by_something_that_presents_nothing)
+{
+    int const screenshot{0};
+    stream.submit_buffer(buffer);
+    stream.when_presented([this]{ frame_done(); });
+
+    EXPECT_CALL(*this, frame_done()).Times(1);
+    stream.lock_compositor_buffer(&screenshot);
+}
+
+TEST_F(StreamPresentation, without_a_new_buffer_callback_waits_for_a_frame_of_the_last_output)
+{
+    stream.submit_buffer(buffer);
+    stream.lock_compositor_buffer(output);
+
+    EXPECT_TRUE(stream.when_presented([this]{ frame_done(); }));
+    EXPECT_THAT(frames_scheduled, Eq(1));
+
+    EXPECT_CALL(*this, frame_done()).Times(1);
+    notifier->presented(output, mg::FramePresentation{});
+}
+
+TEST_F(StreamPresentation, stream_that_has_not_been_shown_has_no_presentation)
+{
+    EXPECT_CALL(*this, frame_done()).Times(0);
+    EXPECT_FALSE(stream.when_presented([this]{ frame_done(); }));
+    EXPECT_THAT(frames_scheduled, Eq(0));
+}
+
+TEST_F(StreamPresentation, removing_an_output_runs_its_callbacks)
+{
+    stream.submit_buffer(buffer);
+    stream.when_presented([this]{ frame_done(); });
+    stream.lock_compositor_buffer(output);
+
+    EXPECT_CALL(*this, frame_done()).Times(1);
+    notifier->unregister_compositor(output);
+
+    EXPECT_FALSE(stream.when_presented([this]{ frame_done(); }));
+}
+
+TEST_F(StreamPresentation, buffer_presentation_is_given_the_frame_that_showed_it)
+{
+    mg::FramePresentation shown;
+    shown.frame.msc = 42;
+    shown.vsync = true;
+
+    stream.submit_buffer(buffer);
+    stream.when_buffer_presented([this](auto const& presentation){ buffer_presented(presentation); });
+    stream.lock_compositor_buffer(output);
+
+    EXPECT_CALL(*this, buffer_presented(Optional(Field(&mg::FramePresentation::frame, Field(&mg::Frame::msc, Eq(42))))));
+    notifier->presented(output, shown);
+}
+
+TEST_F(StreamPresentation, buffer_replaced_before_it_is_shown_is_discarded)
+{
+    stream.allow_framedropping(true);
+    stream.submit_buffer(buffer);
+    stream.when_buffer_presented([this](auto const& presentation){ buffer_presented(presentation); });
+
+    EXPECT_CALL(*this, buffer_presented(Eq(std::nullopt)));
+    stream.submit_buffer(std::make_shared<mtd::StubBuffer>(geom::Size{44, 2}));
+}
+
+TEST_F(StreamPresentation, buffer_taken_by_something_that_presents_nothing_waits_for_an_output)
+{
+    int const screenshot{0};
+    stream.submit_buffer(buffer);
+    stream.when_buffer_presented([this](auto const& presentation){ buffer_presented(presentation); });
+
+    EXPECT_CALL(*this, buffer_presented(_)).Times(0);
+    stream.lock_compositor_buffer(&screenshot);
+    Mock::VerifyAndClearExpectations(this);
+
+    stream.lock_compositor_buffer(output);
+    EXPECT_CALL(*this, buffer_presented(Ne(std::nullopt)));
+    notifier->presented(output, mg::FramePresentation{});
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/keymap_file_cache.h"
+#include "mir/input/parameter_keymap.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mf = mir::frontend;
+namespace mi = mir::input;
+
+using namespace testing;
+
+namespace
+{
+auto us_keymap() -> std::shared_ptr<mi::Keymap>
+{
+    return std::make_shared<mi::ParameterKeymap>("pc105", "us", "", "");
+}
+
+struct KeymapFileCache : Test
+{
+    mf::KeymapFileCache cache;
+};
+}
+
+TEST_F(KeymapFileCache, matching_keymaps_share_a_file)
+{
+    auto const first = cache.file_for(us_keymap());
+    auto const second = cache.file_for(us_keymap());
+
+    EXPECT_THAT(second, Eq(first));
+}
+
+TEST_F(KeymapFileCache, different_keymaps_get_different_files)
+{
+    auto const us = cache.file_for(us_keymap());
+    auto const gb = cache.file_for(std::make_shared<mi::ParameterKeymap>("pc105", "gb", "", ""));
+
+    EXPECT_THAT(gb, Ne(us));
+    EXPECT_THAT(std::string{gb->data()}, Ne(std::string{us->data()}));
+}
+
+TEST_F(KeymapFileCache, file_holds_the_keymap_text_including_terminator)
+{
+    auto const file = cache.file_for(us_keymap());
+
+    EXPECT_THAT(file->size(), Eq(strlen(file->data()) + 1));
+    EXPECT_THAT(file->data(), HasSubstr("xkb_keymap"));
+}
+
+TEST_F(KeymapFileCache, sealed_file_can_be_mapped_privately_but_not_written)
+{
+    auto const file = cache.file_for(us_keymap());
+    if (file->sealed_fd() == mir::Fd::invalid)
+    {
+        GTEST_SKIP() << "The kernel can't seal files";
+    }
+
+    auto const mapping = mmap(nullptr, file->size(), PROT_READ, MAP_PRIVATE, file->sealed_fd(), 0);
+    ASSERT_THAT(mapping, Ne(MAP_FAILED));
+    EXPECT_THAT(memcmp(mapping, file->data(), file->size()), Eq(0));
+    munmap(mapping, file->size());
+
+    EXPECT_THAT(write(file->sealed_fd(), "x", 1), Eq(-1));
+}
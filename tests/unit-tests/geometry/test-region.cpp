@@ -0,0 +1,171 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace mir::geometry;
+using namespace testing;
+
+TEST(Region, default_region_is_empty)
+{
+    Region const region;
+
+    EXPECT_TRUE(region.empty());
+    EXPECT_THAT(region.rectangles(), IsEmpty());
+    EXPECT_THAT(region.bounding_rectangle(), Eq(Rectangle{}));
+}
+
+TEST(Region, region_of_empty_rectangle_is_empty)
+{
+    Region const no_width{Rectangle{{10, 10}, {0, 5}}};
+    Region const no_height{Rectangle{{10, 10}, {5, 0}}};
+
+    EXPECT_TRUE(no_width.empty());
+    EXPECT_TRUE(no_height.empty());
+}
+
+TEST(Region, region_of_rectangle_contains_it)
+{
+    Rectangle const rect{{10, 20}, {30, 40}};
+    Region const region{rect};
+
+    EXPECT_TRUE(region.contains(rect));
+    EXPECT_THAT(region.rectangles(), ElementsAre(rect));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(rect));
+}
+
+TEST(Region, contains_points_only_inside)
+{
+    Region const region{Rectangle{{10, 20}, {30, 40}}};
+
+    EXPECT_TRUE(region.contains(Point{10, 20}));
+    EXPECT_TRUE(region.contains(Point{39, 59}));
+    EXPECT_FALSE(region.contains(Point{40, 20}));
+    EXPECT_FALSE(region.contains(Point{10, 60}));
+    EXPECT_FALSE(region.contains(Point{9, 19}));
+}
+
+TEST(Region, side_by_side_rectangles_together_contain_a_rectangle_neither_does)
+{
+    Region const region{
+        Rectangle{{0, 0}, {50, 100}},
+        Rectangle{{50, 0}, {50, 100}}};
+    Rectangle const straddling{{25, 25}, {50, 50}};
+
+    EXPECT_TRUE(region.contains(straddling));
+    EXPECT_THAT(region.rectangles(), ElementsAre(Rectangle{{0, 0}, {100, 100}}));
+}
+
+TEST(Region, stacked_rectangles_together_contain_a_rectangle_neither_does)
+{
+    Region const region{
+        Rectangle{{0, 0}, {100, 50}},
+        Rectangle{{0, 50}, {100, 50}}};
+
+    EXPECT_TRUE(region.contains(Rectangle{{25, 25}, {50, 50}}));
+    EXPECT_THAT(region.rectangles(), ElementsAre(Rectangle{{0, 0}, {100, 100}}));
+}
+
+TEST(Region, does_not_contain_rectangle_with_part_outside)
+{
+    Region const region{
+        Rectangle{{0, 0}, {50, 100}},
+        Rectangle{{60, 0}, {50, 100}}};
+
+    EXPECT_FALSE(region.contains(Rectangle{{25, 25}, {50, 50}}));
+    EXPECT_TRUE(region.overlaps(Rectangle{{25, 25}, {50, 50}}));
+    EXPECT_FALSE(region.overlaps(Rectangle{{50, 0}, {10, 100}}));
+}
+
+TEST(Region, subtracting_a_hole_leaves_the_surround)
+{
+    Region region{Rectangle{{0, 0}, {30, 30}}};
+    region.subtract(Rectangle{{10, 10}, {10, 10}});
+
+    EXPECT_FALSE(region.contains(Point{15, 15}));
+    EXPECT_TRUE(region.contains(Point{5, 15}));
+    EXPECT_FALSE(region.contains(Rectangle{{0, 0}, {30, 30}}));
+    EXPECT_THAT(region.rectangles(), ElementsAre(
+        Rectangle{{0, 0}, {30, 10}},
+        Rectangle{{0, 10}, {10, 10}},
+        Rectangle{{20, 10}, {10, 10}},
+        Rectangle{{0, 20}, {30, 10}}));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(Rectangle{{0, 0}, {30, 30}}));
+}
+
+TEST(Region, subtracting_everything_leaves_nothing)
+{
+    Region region{Rectangle{{10, 10}, {30, 30}}};
+    region.subtract(Rectangle{{0, 0}, {100, 100}});
+
+    EXPECT_TRUE(region.empty());
+}
+
+TEST(Region, intersection_keeps_only_common_points)
+{
+    Region region{
+        Rectangle{{0, 0}, {50, 50}},
+        Rectangle{{100, 0}, {50, 50}}};
+    region.intersect(Rectangle{{25, 25}, {100, 100}});
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(
+        Rectangle{{25, 25}, {25, 25}},
+        Rectangle{{100, 25}, {25, 25}}));
+}
+
+TEST(Region, equal_sets_of_points_compare_equal_however_built)
+{
+    Region const whole{Rectangle{{0, 0}, {100, 100}}};
+
+    Region quarters;
+    quarters.add(Rectangle{{50, 50}, {50, 50}});
+    quarters.add(Rectangle{{0, 0}, {50, 50}});
+    quarters.add(Rectangle{{0, 50}, {50, 50}});
+    quarters.add(Rectangle{{50, 0}, {50, 50}});
+
+    Region overlapping{
+        Rectangle{{0, 0}, {80, 100}},
+        Rectangle{{20, 0}, {80, 100}}};
+
+    Region const nearly_whole{Rectangle{{0, 0}, {100, 99}}};
+
+    EXPECT_THAT(quarters, Eq(whole));
+    EXPECT_THAT(overlapping, Eq(whole));
+    EXPECT_THAT(nearly_whole, Ne(whole));
+}
+
+TEST(Region, union_of_overlapping_regions)
+{
+    Region region{Rectangle{{0, 0}, {20, 20}}};
+    region.add(Region{Rectangle{{10, 10}, {20, 20}}});
+
+    EXPECT_THAT(region.rectangles(), ElementsAre(
+        Rectangle{{0, 0}, {20, 10}},
+        Rectangle{{0, 10}, {30, 10}},
+        Rectangle{{10, 20}, {20, 10}}));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(Rectangle{{0, 0}, {30, 30}}));
+}
+
+TEST(Region, clear_empties_region)
+{
+    Region region{Rectangle{{0, 0}, {20, 20}}};
+    region.clear();
+
+    EXPECT_TRUE(region.empty());
+}
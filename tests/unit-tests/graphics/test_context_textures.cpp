@@ -0,0 +1,183 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platform/graphics/context_textures.h"
+#include "mir/graphics/egl_context_executor.h"
+#include "mir/renderer/gl/context.h"
+
+#include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_egl.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <future>
+#include <thread>
+
+namespace mg = mir::graphics;
+namespace mgc = mir::graphics::common;
+namespace mtd = mir::test::doubles;
+using namespace testing;
+
+namespace
+{
+EGLDisplay const dummy_dpy{reinterpret_cast<EGLDisplay>(0xaabbccdd)};
+
+class DumbGLContext : public mir::renderer::gl::Context
+{
+public:
+    DumbGLContext(EGLContext ctx)
+        : ctx{ctx}
+    {
+    }
+
+    void make_current() const override
+    {
+        eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx);
+    }
+
+    void release_current() const override
+    {
+        eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
+private:
+    EGLContext const ctx;
+};
+
+struct ContextTexturesTest : public testing::Test
+{
+    ContextTexturesTest()
+    {
+        ON_CALL(mock_gl, glGenTextures(1, _))
+            .WillByDefault(Invoke([this](GLsizei, GLuint* tex) { *tex = ++textures_generated; }));
+    }
+
+    void make_current(EGLContext ctx)
+    {
+        eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx);
+    }
+
+    NiceMock<mtd::MockEGL> mock_egl;
+    NiceMock<mtd::MockGL> mock_gl;
+
+    GLuint textures_generated{0};
+    EGLContext const ctx_a{reinterpret_cast<EGLContext>(0xa)};
+    EGLContext const ctx_b{reinterpret_cast<EGLContext>(0xb)};
+    std::shared_ptr<void const> const contexts_owner{std::make_shared<int>()};
+    std::shared_ptr<mgc::EGLContextExecutor> const egl_delegate{
+        std::make_shared<mgc::EGLContextExecutor>(std::make_unique<DumbGLContext>(ctx_a))};
+
+    mg::ContextTextures textures;
+};
+}
+
+TEST_F(ContextTexturesTest, first_use_in_a_context_creates_a_texture)
+{
+    make_current(ctx_a);
+
+    auto const [texture, existed] = textures.for_current_context(contexts_owner, egl_delegate);
+
+    EXPECT_FALSE(existed);
+    EXPECT_THAT(texture->tex, Eq(1u));
+}
+
+TEST_F(ContextTexturesTest, later_uses_in_the_same_context_reuse_its_texture)
+{
+    make_current(ctx_a);
+    auto const [first, first_existed] = textures.for_current_context(contexts_owner, egl_delegate);
+
+    EXPECT_CALL(mock_gl, glGenTextures(_, _)).Times(0);
+    auto const [second, second_existed] = textures.for_current_context(contexts_owner, egl_delegate);
+
+    EXPECT_TRUE(second_existed);
+    EXPECT_THAT(second, Eq(first));
+}
+
+TEST_F(ContextTexturesTest, each_context_has_a_texture_of_its_own)
+{
+    make_current(ctx_a);
+    auto const [texture_a, a_existed] = textures.for_current_context(contexts_owner, egl_delegate);
+    make_current(ctx_b);
+    auto const [texture_b, b_existed] = textures.for_current_context(contexts_owner, egl_delegate);
+
+    EXPECT_FALSE(b_existed);
+    EXPECT_THAT(texture_b->tex, Ne(texture_a->tex));
+
+    make_current(ctx_a);
+    auto const [texture_a_again, a_again_existed] = textures.for_current_context(contexts_owner, egl_delegate);
+
+    EXPECT_TRUE(a_again_existed);
+    EXPECT_THAT(texture_a_again, Eq(texture_a));
+}
+
+TEST_F(ContextTexturesTest, a_reused_context_handle_does_not_get_the_texture_of_a_destroyed_context)
+{
+    std::weak_ptr<mg::ContextTextures::Texture> old_texture;
+    {
+        auto const old_owner = std::make_shared<int>();
+        make_current(ctx_a);
+        old_texture = textures.for_current_context(old_owner, egl_delegate).first;
+    }
+
+    // The contexts of old_owner are gone, and a new one has been given the same handle
+    make_current(ctx_a);
+    auto const [texture, existed] = textures.for_current_context(contexts_owner, egl_delegate);
+
+    EXPECT_FALSE(existed);
+    EXPECT_THAT(texture->tex, Eq(2u));
+    EXPECT_TRUE(old_texture.expired());
+}
+
+TEST_F(ContextTexturesTest, textures_are_deleted_through_the_egl_delegate_once_unused)
+{
+    std::thread::id deleting_thread;
+    EXPECT_CALL(mock_gl, glDeleteTextures(_, _)).Times(AnyNumber());
+    EXPECT_CALL(mock_gl, glDeleteTextures(1, Pointee(Eq(1u))))
+        .WillOnce(InvokeWithoutArgs([&]() { deleting_thread = std::this_thread::get_id(); }));
+
+    {
+        auto const owner = std::make_shared<int>();
+        make_current(ctx_a);
+        textures.for_current_context(owner, egl_delegate);
+    }
+
+    // The next use drops the textures of contexts that have gone
+    make_current(ctx_b);
+    textures.for_current_context(contexts_owner, egl_delegate);
+
+    // Synchronise with the EGL delegate thread
+    std::promise<void> drained;
+    egl_delegate->spawn([&]() { drained.set_value(); });
+    drained.get_future().wait();
+
+    EXPECT_THAT(deleting_thread, Ne(std::thread::id{}));
+    EXPECT_THAT(deleting_thread, Ne(std::this_thread::get_id()));
+}
+
+TEST_F(ContextTexturesTest, texture_outlives_the_cache_while_in_use)
+{
+    std::shared_ptr<mg::ContextTextures::Texture> texture;
+    {
+        mg::ContextTextures local_textures;
+        make_current(ctx_a);
+        texture = local_textures.for_current_context(contexts_owner, egl_delegate).first;
+    }
+
+    EXPECT_CALL(mock_gl, glDeleteTextures(_, _)).Times(0);
+    EXPECT_THAT(texture->tex, Eq(1u));
+    Mock::VerifyAndClearExpectations(&mock_gl);
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platform/graphics/dmabuf_feedback.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <drm_fourcc.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/sysmacros.h>
+
+namespace mg = mir::graphics;
+using namespace testing;
+using FormatModifier = mg::DmaBufFeedback::FormatModifier;
+
+namespace
+{
+dev_t const render_device{makedev(226, 128)};
+dev_t const kms_device{makedev(226, 0)};
+
+std::vector<FormatModifier> const importable{
+    {DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_LINEAR},
+    {DRM_FORMAT_XRGB8888, I915_FORMAT_MOD_X_TILED},
+    {DRM_FORMAT_XRGB8888, I915_FORMAT_MOD_Y_TILED},
+    {DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_LINEAR},
+    {DRM_FORMAT_NV12, I915_FORMAT_MOD_Y_TILED},
+};
+
+/// The format table, as a client reads it
+auto table_of(mg::DmaBufFeedback const& feedback) -> std::vector<FormatModifier>
+{
+    auto const size = feedback.format_table_size();
+    EXPECT_THAT(size % sizeof(mg::DmaBufFeedback::TableEntry), Eq(0u));
+
+    auto const mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, feedback.format_table(), 0);
+    if (mapping == MAP_FAILED)
+    {
+        ADD_FAILURE() << "Failed to map format table: " << strerror(errno);
+        return {};
+    }
+
+    std::vector<FormatModifier> table;
+    auto const entries = static_cast<mg::DmaBufFeedback::TableEntry const*>(mapping);
+    for (auto i = 0u; i != size / sizeof(mg::DmaBufFeedback::TableEntry); ++i)
+    {
+        table.emplace_back(entries[i].format, entries[i].modifier);
+    }
+    munmap(mapping, size);
+    return table;
+}
+
+auto pairs_in(mg::DmaBufFeedback::Tranche const& tranche, std::vector<FormatModifier> const& table)
+    -> std::vector<FormatModifier>
+{
+    std::vector<FormatModifier> pairs;
+    for (auto const index : tranche.indices)
+    {
+        pairs.push_back(table.at(index));
+    }
+    return pairs;
+}
+}
+
+TEST(DmaBufFeedback, format_table_holds_every_importable_pair)
+{
+    mg::DmaBufFeedback const feedback{render_device, importable, 0, {}};
+
+    EXPECT_THAT(table_of(feedback), ElementsAreArray(importable));
+}
+
+TEST(DmaBufFeedback, format_table_is_sealed)
+{
+    mg::DmaBufFeedback const feedback{render_device, importable, 0, {}};
+
+    auto const seals = fcntl(feedback.format_table(), F_GET_SEALS);
+
+    EXPECT_THAT(seals & F_SEAL_WRITE, Ne(0));
+    EXPECT_THAT(seals & F_SEAL_SHRINK, Ne(0));
+    EXPECT_THAT(seals & F_SEAL_GROW, Ne(0));
+    EXPECT_THAT(seals & F_SEAL_SEAL, Ne(0));
+}
+
+TEST(DmaBufFeedback, main_device_is_the_render_device)
+{
+    mg::DmaBufFeedback const feedback{render_device, importable, kms_device, importable};
+
+    EXPECT_THAT(feedback.main_device(), Eq(render_device));
+}
+
+TEST(DmaBufFeedback, render_tranche_targets_the_main_device_with_every_pair)
+{
+    mg::DmaBufFeedback const feedback{render_device, importable, 0, {}};
+
+    auto const tranches = feedback.tranches(false);
+
+    ASSERT_THAT(tranches.size(), Eq(1u));
+    mg::DmaBufFeedback::Tranche const& render = tranches[0];
+    EXPECT_THAT(render.device, Eq(render_device));
+    EXPECT_FALSE(render.scanout);
+    EXPECT_THAT(pairs_in(render, table_of(feedback)), ElementsAreArray(importable));
+}
+
+TEST(DmaBufFeedback, scanout_candidate_is_offered_the_scanout_tranche_first)
+{
+    std::vector<FormatModifier> const scanout_formats{
+        {DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_LINEAR},
+        {DRM_FORMAT_XRGB8888, I915_FORMAT_MOD_X_TILED},
+    };
+    mg::DmaBufFeedback const feedback{render_device, importable, kms_device, scanout_formats};
+
+    auto const tranches = feedback.tranches(true);
+
+    ASSERT_THAT(tranches.size(), Eq(2u));
+    mg::DmaBufFeedback::Tranche const& scanout = tranches[0];
+    mg::DmaBufFeedback::Tranche const& render = tranches[1];
+    EXPECT_THAT(scanout.device, Eq(kms_device));
+    EXPECT_TRUE(scanout.scanout);
+    EXPECT_THAT(pairs_in(scanout, table_of(feedback)), ElementsAreArray(scanout_formats));
+    EXPECT_THAT(render.device, Eq(render_device));
+    EXPECT_FALSE(render.scanout);
+}
+
+TEST(DmaBufFeedback, surface_that_is_not_a_scanout_candidate_gets_only_the_render_tranche)
+{
+    mg::DmaBufFeedback const feedback{render_device, importable, kms_device, importable};
+
+    auto const tranches = feedback.tranches(false);
+
+    ASSERT_THAT(tranches.size(), Eq(1u));
+    EXPECT_FALSE(tranches[0].get().scanout);
+}
+
+TEST(DmaBufFeedback, scanout_tranche_leaves_out_pairs_that_cannot_be_imported)
+{
+    std::vector<FormatModifier> const scanout_formats{
+        {DRM_FORMAT_XRGB8888, I915_FORMAT_MOD_X_TILED},
+        {DRM_FORMAT_XRGB8888, I915_FORMAT_MOD_Yf_TILED},
+        {DRM_FORMAT_RGB565, DRM_FORMAT_MOD_LINEAR},
+    };
+    mg::DmaBufFeedback const feedback{render_device, importable, kms_device, scanout_formats};
+
+    auto const tranches = feedback.tranches(true);
+
+    ASSERT_THAT(tranches.size(), Eq(2u));
+    EXPECT_THAT(
+        pairs_in(tranches[0], table_of(feedback)),
+        ElementsAre(FormatModifier{DRM_FORMAT_XRGB8888, I915_FORMAT_MOD_X_TILED}));
+}
+
+TEST(DmaBufFeedback, no_scanout_tranche_when_nothing_scanout_capable_can_be_imported)
+{
+    std::vector<FormatModifier> const scanout_formats{
+        {DRM_FORMAT_RGB565, DRM_FORMAT_MOD_LINEAR},
+    };
+    mg::DmaBufFeedback const feedback{render_device, importable, kms_device, scanout_formats};
+
+    auto const tranches = feedback.tranches(true);
+
+    ASSERT_THAT(tranches.size(), Eq(1u));
+    EXPECT_FALSE(tranches[0].get().scanout);
+}
+
+TEST(DmaBufFeedback, format_table_is_limited_to_what_tranches_can_index)
+{
+    std::vector<FormatModifier> many;
+    for (uint64_t modifier = 0; modifier != 70000; ++modifier)
+    {
+        many.emplace_back(DRM_FORMAT_XRGB8888, modifier);
+    }
+    mg::DmaBufFeedback const feedback{render_device, many, 0, {}};
+
+    auto const table_entries = feedback.format_table_size() / sizeof(mg::DmaBufFeedback::TableEntry);
+
+    EXPECT_THAT(table_entries, Eq(65536u));
+    EXPECT_THAT(feedback.tranches(false)[0].get().indices.size(), Eq(65536u));
+}
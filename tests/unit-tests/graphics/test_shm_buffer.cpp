@@ -351,3 +351,273 @@ TEST_F(ShmBufferTest, texture_is_destroyed_on_thread_with_current_context)
         eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
     }
 }
+
+namespace
+{
+struct IncrementalUploadTest : ShmBufferTest
+{
+    IncrementalUploadTest()
+    {
+        ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+            .WillByDefault(Return("EGL_KHR_image EGL_KHR_fence_sync"));
+        eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, dummy);
+    }
+
+    ~IncrementalUploadTest()
+    {
+        eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
+    static auto pixel_offset(geom::Point point) -> ptrdiff_t
+    {
+        return point.y.as_int() * stride + point.x.as_int() * bytes_per_pixel;
+    }
+
+    EGLDisplay const dummy_dpy{reinterpret_cast<EGLDisplay>(0xaabbccdd)};
+    static int const bytes_per_pixel{4};
+    static int const stride{bytes_per_pixel * 245};
+    geom::Size const buffer_size{245, 553};
+    MirPixelFormat const format{mir_pixel_format_argb_8888};
+    PlatformlessShmBuffer first{buffer_size, format, egl_delegate};
+    PlatformlessShmBuffer second{buffer_size, format, egl_delegate};
+    PlatformlessShmBuffer third{buffer_size, format, egl_delegate};
+};
+}
+
+TEST_F(IncrementalUploadTest, replacement_buffer_uploads_only_its_damage)
+{
+    geom::Rectangle const damage{{10, 20}, {30, 40}};
+
+    first.bind();
+    second.replaces(first, geom::Rectangles{damage});
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(
+        GL_TEXTURE_2D, 0,
+        10, 20, 30, 40,
+        _, _,
+        second.pixel_buffer() + pixel_offset(damage.top_left)));
+
+    second.bind();
+}
+
+TEST_F(IncrementalUploadTest, damage_of_buffers_never_uploaded_is_also_uploaded)
+{
+    geom::Rectangle const first_damage{{10, 20}, {30, 40}};
+    geom::Rectangle const second_damage{{100, 200}, {5, 5}};
+
+    first.bind();
+    second.replaces(first, geom::Rectangles{first_damage});
+    third.replaces(second, geom::Rectangles{second_damage});
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, 10, 20, 30, 40, _, _, _));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, 100, 200, 5, 5, _, _, _));
+
+    third.bind();
+}
+
+TEST_F(IncrementalUploadTest, buffer_of_a_different_size_is_uploaded_in_full)
+{
+    PlatformlessShmBuffer bigger{{300, 600}, format, egl_delegate};
+
+    first.bind();
+    bigger.replaces(first, geom::Rectangles{geom::Rectangle{{10, 20}, {30, 40}}});
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, 300, 600, _, _, _, _));
+
+    bigger.bind();
+}
+
+TEST_F(IncrementalUploadTest, uploads_are_fenced_rather_than_finished)
+{
+    EXPECT_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _))
+        .WillOnce(Return(reinterpret_cast<EGLSyncKHR>(0xfe4ce)));
+    EXPECT_CALL(mock_gl, glFlush());
+    EXPECT_CALL(mock_gl, glFinish()).Times(0);
+
+    first.bind();
+}
+
+TEST_F(IncrementalUploadTest, uploads_are_finished_without_fence_sync)
+{
+    ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+        .WillByDefault(Return("EGL_KHR_image"));
+
+    EXPECT_CALL(mock_egl, eglCreateSyncKHR(_, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glFinish());
+
+    first.bind();
+}
+
+TEST_F(IncrementalUploadTest, older_buffer_drawn_after_a_newer_one_uses_a_texture_of_its_own)
+{
+    GLuint const shared_tex{7}, own_tex{8};
+    EXPECT_CALL(mock_gl, glGenTextures(1, _))
+        .WillOnce(SetArgPointee<1>(shared_tex));
+
+    first.bind();
+    second.replaces(first, geom::Rectangles{geom::Rectangle{{10, 20}, {30, 40}}});
+    second.bind();
+
+    Mock::VerifyAndClearExpectations(&mock_gl);
+
+    // The older buffer mustn't overwrite the newer one's pixels
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glGenTextures(1, _))
+        .WillOnce(SetArgPointee<1>(own_tex));
+    EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, own_tex));
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, first.pixel_buffer()));
+    EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, shared_tex));
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    first.bind();
+    second.bind();
+}
+
+TEST_F(IncrementalUploadTest, texture_is_updated_only_after_draws_from_it_in_other_contexts)
+{
+    auto const draw_fence = reinterpret_cast<EGLSyncKHR>(0xd4a3);
+    auto const upload_fence = reinterpret_cast<EGLSyncKHR>(0x4b10ad);
+    EGLContext const other_context{reinterpret_cast<EGLContext>(0x0c0e)};
+
+    EXPECT_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _))
+        .WillOnce(Return(upload_fence))
+        .WillOnce(Return(draw_fence))
+        .WillRepeatedly(Return(upload_fence));
+
+    first.bind();
+    first.add_syncpoint();
+    second.replaces(first, geom::Rectangles{geom::Rectangle{{10, 20}, {30, 40}}});
+
+    eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, other_context);
+
+    EXPECT_CALL(mock_egl, eglClientWaitSyncKHR(_, upload_fence, _, _)).Times(AnyNumber());
+    InSequence seq;
+    EXPECT_CALL(mock_egl, eglClientWaitSyncKHR(_, draw_fence, _, _));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, 10, 20, 30, 40, _, _, _));
+
+    second.bind();
+}
+
+TEST_F(IncrementalUploadTest, texture_is_not_updated_under_a_draw_in_another_context_that_is_not_fenced)
+{
+    EGLContext const other_context{reinterpret_cast<EGLContext>(0x0c0e)};
+
+    first.bind();
+    second.replaces(first, geom::Rectangles{geom::Rectangle{{10, 20}, {30, 40}}});
+
+    eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, other_context);
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, second.pixel_buffer()));
+
+    second.bind();
+}
+
+TEST_F(IncrementalUploadTest, without_fence_sync_a_texture_that_has_been_drawn_is_not_updated)
+{
+    ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+        .WillByDefault(Return("EGL_KHR_image"));
+
+    first.bind();
+    first.add_syncpoint();
+    second.replaces(first, geom::Rectangles{geom::Rectangle{{10, 20}, {30, 40}}});
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, second.pixel_buffer()));
+
+    second.bind();
+}
+
+TEST_F(IncrementalUploadTest, prepare_uploads_on_the_egl_thread)
+{
+    auto const test_thread = std::this_thread::get_id();
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _))
+        .WillOnce(InvokeWithoutArgs(
+            [test_thread]()
+            {
+                EXPECT_THAT(std::this_thread::get_id(), Ne(test_thread));
+            }));
+
+    first.prepare();
+    wait_for_egl_thread(*egl_delegate);
+
+    // The texture already holds the buffer, so there's nothing left to upload
+    first.bind();
+}
+
+TEST_F(IncrementalUploadTest, prepare_of_a_replaced_buffer_uploads_nothing)
+{
+    second.replaces(first, geom::Rectangles{geom::Rectangle{{10, 20}, {30, 40}}});
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    first.prepare();
+    wait_for_egl_thread(*egl_delegate);
+}
+
+TEST_F(IncrementalUploadTest, prepare_waits_for_frames_drawing_from_the_texture)
+{
+    auto const draw_fence = reinterpret_cast<EGLSyncKHR>(0xd4a3);
+    auto const upload_fence = reinterpret_cast<EGLSyncKHR>(0x4b10ad);
+    auto const upload_executor = std::make_shared<mgc::EGLContextExecutor>(
+        std::make_unique<DumbGLContext>(reinterpret_cast<EGLContext>(0x0c0e)));
+    PlatformlessShmBuffer drawn{buffer_size, format, upload_executor};
+    PlatformlessShmBuffer prepared{buffer_size, format, upload_executor};
+
+    EXPECT_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _))
+        .WillOnce(Return(upload_fence))
+        .WillOnce(Return(draw_fence))
+        .WillRepeatedly(Return(upload_fence));
+
+    drawn.bind();
+    drawn.add_syncpoint();
+    prepared.replaces(drawn, geom::Rectangles{geom::Rectangle{{10, 20}, {30, 40}}});
+
+    EXPECT_CALL(mock_egl, eglClientWaitSyncKHR(_, upload_fence, _, _)).Times(AnyNumber());
+    {
+        InSequence seq;
+        EXPECT_CALL(mock_egl, eglClientWaitSyncKHR(_, draw_fence, _, _));
+        EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, 10, 20, 30, 40, _, _, _));
+    }
+
+    prepared.prepare();
+    wait_for_egl_thread(*upload_executor);
+}
+
+TEST_F(IncrementalUploadTest, prepare_leaves_a_texture_with_a_draw_in_progress_alone)
+{
+    auto const upload_executor = std::make_shared<mgc::EGLContextExecutor>(
+        std::make_unique<DumbGLContext>(reinterpret_cast<EGLContext>(0x0c0e)));
+    PlatformlessShmBuffer drawn{buffer_size, format, upload_executor};
+    PlatformlessShmBuffer prepared{buffer_size, format, upload_executor};
+
+    drawn.bind();
+    prepared.replaces(drawn, geom::Rectangles{geom::Rectangle{{10, 20}, {30, 40}}});
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    prepared.prepare();
+    wait_for_egl_thread(*upload_executor);
+}
+
+TEST_F(IncrementalUploadTest, prepare_of_a_destroyed_buffer_uploads_nothing)
+{
+    std::promise<void> unblock;
+    egl_delegate->spawn([blocker = unblock.get_future().share()]() { blocker.wait(); });
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    {
+        PlatformlessShmBuffer doomed{buffer_size, format, egl_delegate};
+        doomed.prepare();
+    }
+
+    unblock.set_value();
+    wait_for_egl_thread(*egl_delegate);
+}
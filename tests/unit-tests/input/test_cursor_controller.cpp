@@ -173,7 +173,7 @@ struct StubInputSurface : public mtd::StubSurface
     {
         for (auto observer : observers)
         {
-            observer->frame_posted(this, 1, {});
+            observer->frame_posted(this, 1, nullptr, {});
         }
     }
 
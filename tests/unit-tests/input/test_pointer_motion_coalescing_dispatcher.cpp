@@ -0,0 +1,141 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/input/pointer_motion_coalescing_dispatcher.h"
+
+#include "mir/events/event_builders.h"
+#include "mir/events/keyboard_event.h"
+
+#include "mir/test/fake_shared.h"
+#include "mir/test/event_matchers.h"
+#include "mir/test/doubles/fake_alarm_factory.h"
+#include "mir/test/doubles/mock_input_dispatcher.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mi = mir::input;
+namespace mev = mir::events;
+namespace mt = mir::test;
+namespace mtd = mt::doubles;
+
+using namespace ::testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+auto const interval = 5ms;
+
+auto motion_ev(float x, float y, float dx, float dy) -> std::shared_ptr<MirEvent>
+{
+    return mev::make_pointer_event(
+        MirInputDeviceId{1}, {}, {}, mir_input_event_modifier_none,
+        mir_pointer_action_motion, 0, x, y, 0.0f, 0.0f, dx, dy);
+}
+
+auto button_down_ev(float x, float y) -> std::shared_ptr<MirEvent>
+{
+    return mev::make_pointer_event(
+        MirInputDeviceId{1}, {}, {}, mir_input_event_modifier_none,
+        mir_pointer_action_button_down, mir_pointer_button_primary, x, y, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+auto scroll_ev(float x, float y, float vscroll) -> std::shared_ptr<MirEvent>
+{
+    return mev::make_pointer_event(
+        MirInputDeviceId{1}, {}, {}, mir_input_event_modifier_none,
+        mir_pointer_action_motion, 0, x, y, 0.0f, vscroll, 0.0f, 0.0f);
+}
+
+struct PointerMotionCoalescingDispatcher : public testing::Test
+{
+    PointerMotionCoalescingDispatcher()
+        : dispatcher(mt::fake_shared(mock_next_dispatcher), alarm_factory, interval)
+    {
+    }
+
+    NiceMock<mtd::MockInputDispatcher> mock_next_dispatcher;
+    mtd::FakeAlarmFactory alarm_factory;
+    mi::PointerMotionCoalescingDispatcher dispatcher;
+};
+}
+
+TEST_F(PointerMotionCoalescingDispatcher, passes_on_first_motion_immediately)
+{
+    EXPECT_CALL(mock_next_dispatcher, dispatch(mt::PointerEventWithPosition(1, 1)));
+
+    dispatcher.dispatch(motion_ev(1, 1, 1, 1));
+}
+
+TEST_F(PointerMotionCoalescingDispatcher, merges_motion_within_interval_keeping_total_relative_motion)
+{
+    EXPECT_CALL(mock_next_dispatcher, dispatch(mt::PointerEventWithPosition(1, 1)));
+    dispatcher.dispatch(motion_ev(1, 1, 1, 1));
+    dispatcher.dispatch(motion_ev(3, 2, 2, 1));
+    dispatcher.dispatch(motion_ev(6, 3, 3, 1));
+    Mock::VerifyAndClearExpectations(&mock_next_dispatcher);
+
+    EXPECT_CALL(mock_next_dispatcher, dispatch(AllOf(mt::PointerEventWithPosition(6, 3), mt::PointerEventWithDiff(5, 2))));
+    alarm_factory.advance_by(interval + 1ms);
+}
+
+TEST_F(PointerMotionCoalescingDispatcher, passes_on_held_back_motion_before_other_events)
+{
+    dispatcher.dispatch(motion_ev(1, 1, 1, 1));
+
+    InSequence seq;
+    EXPECT_CALL(mock_next_dispatcher, dispatch(mt::PointerEventWithDiff(2, 2)));
+    EXPECT_CALL(mock_next_dispatcher, dispatch(mt::ButtonDownEvent(3, 3)));
+    EXPECT_CALL(mock_next_dispatcher, dispatch(mt::KeyDownEvent()));
+
+    dispatcher.dispatch(motion_ev(3, 3, 2, 2));
+    dispatcher.dispatch(button_down_ev(3, 3));
+
+    auto const key_ev = std::make_shared<MirKeyboardEvent>();
+    key_ev->set_action(mir_keyboard_action_down);
+    dispatcher.dispatch(key_ev);
+}
+
+TEST_F(PointerMotionCoalescingDispatcher, does_not_merge_scrolling)
+{
+    dispatcher.dispatch(motion_ev(1, 1, 1, 1));
+
+    EXPECT_CALL(mock_next_dispatcher, dispatch(mt::PointerAxisChange(mir_pointer_axis_vscroll, 1.0f))).Times(2);
+
+    dispatcher.dispatch(scroll_ev(1, 1, 1.0f));
+    dispatcher.dispatch(scroll_ev(1, 1, 1.0f));
+}
+
+TEST_F(PointerMotionCoalescingDispatcher, passes_on_motion_immediately_after_a_quiet_interval)
+{
+    dispatcher.dispatch(motion_ev(1, 1, 1, 1));
+    alarm_factory.advance_by(interval + 1ms);
+
+    EXPECT_CALL(mock_next_dispatcher, dispatch(mt::PointerEventWithPosition(2, 2)));
+    dispatcher.dispatch(motion_ev(2, 2, 1, 1));
+}
+
+TEST_F(PointerMotionCoalescingDispatcher, passes_on_held_back_motion_on_stop)
+{
+    dispatcher.dispatch(motion_ev(1, 1, 1, 1));
+    dispatcher.dispatch(motion_ev(2, 2, 1, 1));
+
+    InSequence seq;
+    EXPECT_CALL(mock_next_dispatcher, dispatch(mt::PointerEventWithPosition(2, 2)));
+    EXPECT_CALL(mock_next_dispatcher, stop());
+
+    dispatcher.stop();
+}
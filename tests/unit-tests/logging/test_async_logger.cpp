@@ -0,0 +1,160 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/logging/async_logger.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ml = mir::logging;
+
+using namespace testing;
+
+namespace
+{
+class RecordingLogger : public ml::Logger
+{
+public:
+    void log(ml::Severity, std::string const& message, std::string const& component) override
+    {
+        std::unique_lock lock{mutex};
+        blocked.wait(lock, [this] { return !block; });
+        messages.push_back(component + ": " + message);
+    }
+
+    void set_blocked(bool blocked_)
+    {
+        {
+            std::lock_guard lock{mutex};
+            block = blocked_;
+        }
+        blocked.notify_all();
+    }
+
+    auto logged() -> std::vector<std::string>
+    {
+        std::lock_guard lock{mutex};
+        return messages;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable blocked;
+    bool block{false};
+    std::vector<std::string> messages;
+};
+
+struct AsyncLogger : Test
+{
+    std::shared_ptr<RecordingLogger> const downstream{std::make_shared<RecordingLogger>()};
+};
+}
+
+TEST_F(AsyncLogger, writes_messages_to_downstream_logger)
+{
+    ml::AsyncLogger logger{downstream};
+
+    logger.log(ml::Severity::informational, "Hello", "test");
+    logger.log("test", ml::Severity::warning, "%d bottles", 99);
+    logger.flush();
+
+    EXPECT_THAT(downstream->logged(), ElementsAre("test: Hello", "test: 99 bottles"));
+}
+
+TEST_F(AsyncLogger, writes_queued_messages_on_destruction)
+{
+    {
+        ml::AsyncLogger logger{downstream};
+        logger.log(ml::Severity::informational, "Goodbye", "test");
+    }
+
+    EXPECT_THAT(downstream->logged(), ElementsAre("test: Goodbye"));
+}
+
+TEST_F(AsyncLogger, writes_messages_from_different_threads_in_order_logged)
+{
+    ml::AsyncLogger logger{downstream};
+
+    for (auto i = 0; i != 10; ++i)
+    {
+        std::thread{[&logger, i] { logger.log("test", ml::Severity::informational, "%d", i); }}.join();
+    }
+    logger.flush();
+
+    EXPECT_THAT(
+        downstream->logged(),
+        ElementsAre("test: 0", "test: 1", "test: 2", "test: 3", "test: 4",
+                    "test: 5", "test: 6", "test: 7", "test: 8", "test: 9"));
+}
+
+TEST_F(AsyncLogger, counts_and_reports_messages_dropped_while_writer_is_behind)
+{
+    ml::AsyncLogger logger{downstream};
+
+    // Hold the writer up on the first message, so the rest fill this thread's ring
+    downstream->set_blocked(true);
+    logger.log(ml::Severity::informational, "first", "test");
+    while (logger.dropped() == 0)
+    {
+        logger.log(ml::Severity::informational, "filler", "test");
+    }
+    downstream->set_blocked(false);
+    logger.flush();
+
+    EXPECT_THAT(logger.dropped(), Gt(0u));
+    EXPECT_THAT(downstream->logged(), Contains(HasSubstr("messages dropped")));
+}
+
+TEST_F(AsyncLogger, writes_messages_from_threads_that_have_exited)
+{
+    ml::AsyncLogger logger{downstream};
+
+    std::thread{[&logger] { logger.log(ml::Severity::informational, "before exit", "test"); }}.join();
+    logger.flush();
+    // Once drained, the exited thread's ring is freed; this must not lose anything
+    logger.flush();
+
+    EXPECT_THAT(downstream->logged(), ElementsAre("test: before exit"));
+}
+
+TEST_F(AsyncLogger, still_counts_messages_dropped_by_threads_that_have_exited)
+{
+    ml::AsyncLogger logger{downstream};
+
+    downstream->set_blocked(true);
+    std::thread{
+        [&logger]
+        {
+            logger.log(ml::Severity::informational, "first", "test");
+            while (logger.dropped() == 0)
+            {
+                logger.log(ml::Severity::informational, "filler", "test");
+            }
+        }}.join();
+    auto const dropped = logger.dropped();
+    downstream->set_blocked(false);
+    logger.flush();
+    logger.flush();
+
+    EXPECT_THAT(logger.dropped(), Eq(dropped));
+}
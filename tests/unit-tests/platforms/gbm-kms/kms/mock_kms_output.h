@@ -33,6 +33,7 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
     MOCK_METHOD2(configure, void(geometry::Displacement, size_t));
     MOCK_CONST_METHOD0(size, geometry::Size());
     MOCK_CONST_METHOD0(max_refresh_rate, int());
+    MOCK_CONST_METHOD0(refresh_interval, std::chrono::nanoseconds());
 
     bool set_crtc(graphics::gbm::FBHandle const& fb) override
     {
@@ -47,8 +48,34 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
         return schedule_page_flip_thunk(&fb);
     }
     MOCK_METHOD1(schedule_page_flip_thunk, bool(graphics::gbm::FBHandle const*));
+
+    bool schedule_async_page_flip(graphics::gbm::FBHandle const& fb) override
+    {
+        return schedule_async_page_flip_thunk(&fb);
+    }
+    MOCK_METHOD1(schedule_async_page_flip_thunk, bool(graphics::gbm::FBHandle const*));
     MOCK_METHOD0(wait_for_page_flip, void());
 
+    MOCK_CONST_METHOD0(overlay_plane_count, size_t());
+
+    bool test_overlays(
+        graphics::gbm::FBHandle const& fb,
+        std::vector<graphics::gbm::OverlayLayer> const& overlays) override
+    {
+        return test_overlays_thunk(&fb, overlays);
+    }
+    MOCK_METHOD2(test_overlays_thunk, bool(graphics::gbm::FBHandle const*, std::vector<graphics::gbm::OverlayLayer> const&));
+
+    bool schedule_page_flip_with_overlays(
+        graphics::gbm::FBHandle const& fb,
+        std::vector<graphics::gbm::OverlayLayer> const& overlays) override
+    {
+        return schedule_page_flip_with_overlays_thunk(&fb, overlays);
+    }
+    MOCK_METHOD2(
+        schedule_page_flip_with_overlays_thunk,
+        bool(graphics::gbm::FBHandle const*, std::vector<graphics::gbm::OverlayLayer> const&));
+
     MOCK_CONST_METHOD0(last_frame, graphics::Frame());
 
     MOCK_METHOD1(set_cursor, bool(gbm_bo*));
@@ -58,6 +85,8 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
 
     MOCK_METHOD1(set_power_mode, void(MirPowerMode));
     MOCK_METHOD1(set_gamma, void(mir::graphics::GammaCurves const&));
+    MOCK_METHOD1(set_vrr_enabled, void(bool));
+    MOCK_CONST_METHOD0(vrr_enabled, bool());
 
     MOCK_METHOD0(refresh_hardware_state, void());
     MOCK_CONST_METHOD1(update_from_hardware_state, void(graphics::DisplayConfigurationOutput&));
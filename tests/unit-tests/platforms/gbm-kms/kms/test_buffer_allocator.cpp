@@ -93,7 +93,7 @@ protected:
         display = platform->create_display(
             std::make_shared<mtd::NullDisplayConfigurationPolicy>(),
             std::make_shared<mtd::NullGLConfig>());
-        allocator.reset(new mgg::BufferAllocator(*display));
+        allocator.reset(new mgg::BufferAllocator(*display, mir::Fd{}));
     }
 
     // Defaults
@@ -265,3 +265,25 @@ TEST_F(BypassMatchTest, multimonitor_oversized_no_bypass)
     EXPECT_EQ(list.rend(), std::find_if(list.rbegin(), list.rend(), primary_matcher));
     EXPECT_EQ(list.rend(), std::find_if(list.rbegin(), list.rend(), secondary_matcher));
 }
+
+TEST_F(BypassMatchTest, translucent_window_cannot_go_on_an_overlay_plane)
+{
+    mtd::FakeRenderable const window{geom::Rectangle{{12, 34}, {56, 78}}, 0.5f};
+
+    EXPECT_EQ(nullptr, mgg::overlay_buffer_for(window, primary_monitor));
+}
+
+TEST_F(BypassMatchTest, shaped_window_cannot_go_on_an_overlay_plane)
+{
+    mtd::FakeRenderable const window{geom::Rectangle{{12, 34}, {56, 78}}, 1.0f, false};
+
+    EXPECT_EQ(nullptr, mgg::overlay_buffer_for(window, primary_monitor));
+}
+
+TEST_F(BypassMatchTest, window_spanning_monitors_cannot_go_on_an_overlay_plane)
+{
+    mtd::FakeRenderable const window{1900, 0, 56, 78};
+
+    EXPECT_EQ(nullptr, mgg::overlay_buffer_for(window, primary_monitor));
+    EXPECT_EQ(nullptr, mgg::overlay_buffer_for(window, secondary_monitor));
+}
@@ -124,6 +124,19 @@ public:
     }
 
 protected:
+    /// Rendering is fenced with fake_fence. Must be called before make_output_surface().
+    void provide_fence_sync()
+    {
+        ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+            .WillByDefault(Return(
+                "EGL_KHR_image "
+                "EGL_KHR_image_base "
+                "EGL_EXT_image_dma_buf_import "
+                "EGL_KHR_fence_sync"));
+        ON_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _))
+            .WillByDefault(Return(fake_fence));
+    }
+
     GBMOutputSurface make_output_surface()
     {
         helpers::EGLHelper egl{gl_config};
@@ -138,6 +151,7 @@ protected:
 
     int const width{56};
     int const height{78};
+    EGLSyncKHR const fake_fence{reinterpret_cast<EGLSyncKHR>(0xfe2ce)};
     mir::geometry::Rectangle const display_area{{12,34}, {width,height}};
     glm::mat2 const identity;
     NiceMock<MockGBM> mock_gbm;
@@ -216,7 +230,7 @@ TEST_F(MesaDisplayBufferTest, predictive_bypass_is_throttled)
     }
 }
 
-TEST_F(MesaDisplayBufferTest, frames_requiring_gl_are_not_throttled)
+TEST_F(MesaDisplayBufferTest, frames_requiring_gl_are_not_throttled_before_render_time_is_measured)
 {
     graphics::RenderableList non_bypassable_list{
         std::make_shared<FakeRenderable>(geometry::Rectangle{{12, 34}, {1, 1}})
@@ -240,6 +254,146 @@ TEST_F(MesaDisplayBufferTest, frames_requiring_gl_are_not_throttled)
     }
 }
 
+TEST_F(MesaDisplayBufferTest, frames_requiring_gl_are_throttled_once_render_time_is_measured)
+{
+    graphics::RenderableList non_bypassable_list{
+        std::make_shared<FakeRenderable>(geometry::Rectangle{{12, 34}, {1, 1}})
+    };
+
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    for (int frame = 0; frame < 64; ++frame)
+    {
+        ASSERT_FALSE(db.overlay(non_bypassable_list));
+        db.post();
+    }
+
+    // Rendering nothing is quick, so most of the frame can be spent waiting
+    int milliseconds_per_frame = 1000 / mock_refresh_rate;
+    EXPECT_THAT(db.recommended_sleep().count(), Ge(milliseconds_per_frame/2));
+}
+
+TEST_F(MesaDisplayBufferTest, frames_are_not_throttled_with_variable_refresh)
+{
+    graphics::RenderableList non_bypassable_list{
+        std::make_shared<FakeRenderable>(geometry::Rectangle{{12, 34}, {1, 1}})
+    };
+
+    ON_CALL(*mock_kms_output, vrr_enabled())
+        .WillByDefault(Return(true));
+
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    for (int frame = 0; frame < 64; ++frame)
+    {
+        ASSERT_FALSE(db.overlay(non_bypassable_list));
+        db.post();
+    }
+
+    // The output refreshes when we flip, so there is no refresh to wait for
+    EXPECT_THAT(db.recommended_sleep().count(), Eq(0));
+}
+
+TEST_F(MesaDisplayBufferTest, bypass_that_allows_tearing_flips_asynchronously)
+{
+    fake_bypassable_renderable->set_allow_tearing(true);
+
+    ON_CALL(*mock_kms_output, schedule_async_page_flip_thunk(_))
+        .WillByDefault(Return(true));
+
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, schedule_async_page_flip_thunk(_));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_)).Times(0);
+
+    ASSERT_TRUE(db.overlay(bypassable_list));
+    db.post();
+
+    EXPECT_THAT(db.recommended_sleep().count(), Eq(0));
+    ASSERT_TRUE(db.last_presentation());
+    EXPECT_FALSE(db.last_presentation()->vsync);
+}
+
+TEST_F(MesaDisplayBufferTest, bypass_that_allows_tearing_releases_each_frame_when_the_next_is_shown)
+{
+    auto const other_buffer = std::make_shared<NiceMock<MockBuffer>>();
+    ON_CALL(*other_buffer, size())
+        .WillByDefault(Return(display_area.size));
+    ON_CALL(*other_buffer, native_buffer_base())
+        .WillByDefault(Return(&mock_dmabuf_buffer));
+    auto const other_renderable = std::make_shared<FakeRenderable>(display_area);
+    other_renderable->set_buffer(other_buffer);
+    other_renderable->set_allow_tearing(true);
+    graphics::RenderableList const other_list{other_renderable};
+
+    fake_bypassable_renderable->set_allow_tearing(true);
+    ON_CALL(*mock_kms_output, schedule_async_page_flip_thunk(_))
+        .WillByDefault(Return(true));
+
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    auto const original_count = mock_bypassable_buffer.use_count();
+    auto const other_original_count = other_buffer.use_count();
+
+    // A client with two buffers needs each back before it can draw the frame after next
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        ASSERT_TRUE(db.overlay(bypassable_list));
+        db.post();
+        EXPECT_EQ(other_original_count, other_buffer.use_count());
+
+        ASSERT_TRUE(db.overlay(other_list));
+        db.post();
+        EXPECT_EQ(original_count, mock_bypassable_buffer.use_count());
+    }
+}
+
+TEST_F(MesaDisplayBufferTest, bypass_that_allows_tearing_falls_back_to_vsync)
+{
+    fake_bypassable_renderable->set_allow_tearing(true);
+
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    // The output can't flip asynchronously, so the frame is flipped as usual
+    EXPECT_CALL(*mock_kms_output, schedule_async_page_flip_thunk(_))
+        .WillOnce(Return(false));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_));
+    EXPECT_CALL(*mock_kms_output, wait_for_page_flip());
+
+    ASSERT_TRUE(db.overlay(bypassable_list));
+    db.post();
+}
+
 TEST_F(MesaDisplayBufferTest, bypass_buffer_only_referenced_once_by_db)
 {
     graphics::gbm::DisplayBuffer db(
@@ -464,6 +618,45 @@ TEST_F(MesaDisplayBufferTest, clone_mode_waits_for_page_flip_on_second_flip)
     db.post();
 }
 
+TEST_F(MesaDisplayBufferTest, single_mode_waits_for_rendering_to_measure_it)
+{
+    provide_fence_sync();
+    EXPECT_CALL(mock_egl, eglClientWaitSyncKHR(_, fake_fence, _, _))
+        .Times(1);
+
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, clone_mode_does_not_wait_for_rendering)
+{
+    // The render time is only used for a single output, so there's nothing to gain from blocking on the GPU
+    provide_fence_sync();
+    EXPECT_CALL(mock_egl, eglClientWaitSyncKHR(_, _, _, _))
+        .Times(0);
+
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.swap_buffers();
+    db.post();
+    db.swap_buffers();
+    db.post();
+}
+
 TEST_F(MesaDisplayBufferTest, skips_bypass_because_of_incompatible_list)
 {
     graphics::RenderableList list{
@@ -481,3 +674,112 @@ TEST_F(MesaDisplayBufferTest, skips_bypass_because_of_incompatible_list)
 
     EXPECT_FALSE(db.overlay(list));
 }
+
+namespace
+{
+MATCHER_P(OverlaysAt, positions, "")
+{
+    std::vector<geometry::Point> actual;
+    for (auto const& layer : arg)
+        actual.push_back(layer.top_left);
+    return actual == positions;
+}
+}
+
+struct MesaDisplayBufferOverlayTest : MesaDisplayBufferTest
+{
+    MesaDisplayBufferOverlayTest()
+    {
+        ON_CALL(*mock_kms_output, overlay_plane_count())
+            .WillByDefault(Return(2));
+        ON_CALL(*mock_kms_output, test_overlays_thunk(_, _))
+            .WillByDefault(Return(true));
+        ON_CALL(*mock_kms_output, schedule_page_flip_with_overlays_thunk(_, _))
+            .WillByDefault(Return(true));
+
+        ON_CALL(*overlayable_buffer, size())
+            .WillByDefault(Return(overlay_area.size));
+        ON_CALL(*overlayable_buffer, native_buffer_base())
+            .WillByDefault(Return(&mock_dmabuf_buffer));
+        overlayable_renderable->set_buffer(overlayable_buffer);
+    }
+
+    geometry::Rectangle const overlay_area{display_area.top_left + geometry::Displacement{5, 6}, {16, 16}};
+    std::shared_ptr<MockBuffer> const overlayable_buffer{std::make_shared<NiceMock<MockBuffer>>()};
+    std::shared_ptr<FakeRenderable> const overlayable_renderable{std::make_shared<FakeRenderable>(overlay_area)};
+};
+
+TEST_F(MesaDisplayBufferOverlayTest, bypass_can_put_small_surfaces_on_overlay_planes)
+{
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_with_overlays_thunk(_,
+        OverlaysAt(std::vector<geometry::Point>{{5, 6}})));
+
+    EXPECT_TRUE(db.overlay({fake_bypassable_renderable, overlayable_renderable}));
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferOverlayTest, overlays_rejected_by_the_hardware_prevent_bypass)
+{
+    ON_CALL(*mock_kms_output, test_overlays_thunk(_, _))
+        .WillByDefault(Return(false));
+
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_FALSE(db.overlay({fake_bypassable_renderable, overlayable_renderable}));
+}
+
+TEST_F(MesaDisplayBufferOverlayTest, overlay_topmost_leaves_only_what_needs_compositing)
+{
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    // There's nothing to test overlays against before the first frame
+    db.swap_buffers();
+    db.post();
+
+    RenderableList const list{fake_software_renderable, overlayable_renderable};
+    ASSERT_FALSE(db.overlay(list));
+    EXPECT_THAT(db.overlay_topmost(list), ElementsAre(fake_software_renderable));
+
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_with_overlays_thunk(_,
+        OverlaysAt(std::vector<geometry::Point>{{5, 6}})));
+
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferOverlayTest, overlay_topmost_does_nothing_in_clone_mode)
+{
+    graphics::gbm::DisplayBuffer db(
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.swap_buffers();
+    db.post();
+
+    RenderableList const list{fake_software_renderable, overlayable_renderable};
+    EXPECT_THAT(db.overlay_topmost(list), ElementsAreArray(list));
+}
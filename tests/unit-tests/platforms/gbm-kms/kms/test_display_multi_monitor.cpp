@@ -39,6 +39,7 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <algorithm>
 #include <unordered_set>
 #include <fcntl.h>
 
@@ -590,3 +591,100 @@ TEST_F(MesaDisplayMultiMonitorTest, resume_clears_unused_connected_outputs)
                         .Times(1);
     }
 }
+
+namespace
+{
+auto sync_groups_of(mg::Display& display) -> std::vector<mg::DisplaySyncGroup*>
+{
+    std::vector<mg::DisplaySyncGroup*> groups;
+    display.for_each_display_sync_group([&](mg::DisplaySyncGroup& group) { groups.push_back(&group); });
+    return groups;
+}
+
+/// Switches the rightmost output of a side by side configuration to another mode
+void change_mode_of_last_output(mg::DisplayConfiguration& conf)
+{
+    int max_x = -1;
+    conf.for_each_output(
+        [&](mg::UserDisplayConfigurationOutput& output)
+        {
+            if (output.used)
+                max_x = std::max(max_x, output.top_left.x.as_int());
+        });
+
+    conf.for_each_output(
+        [&](mg::UserDisplayConfigurationOutput& output)
+        {
+            if (output.used && output.top_left.x.as_int() == max_x)
+                output.current_mode_index = (output.current_mode_index + 1) % output.modes.size();
+        });
+}
+}
+
+TEST_F(MesaDisplayMultiMonitorTest, configuring_one_output_retires_only_its_sync_group)
+{
+    using namespace testing;
+
+    setup_outputs(3, 0);
+
+    auto display = create_display_side_by_side(create_platform());
+    auto const initial_groups = sync_groups_of(*display);
+    ASSERT_THAT(initial_groups.size(), Eq(3u));
+
+    auto conf = display->configuration();
+    change_mode_of_last_output(*conf);
+
+    std::vector<mg::DisplaySyncGroup*> retired;
+    EXPECT_TRUE(display->configure_changed_sync_groups(
+        *conf,
+        [&](std::vector<mg::DisplaySyncGroup*> const& groups) { retired = groups; }));
+
+    ASSERT_THAT(retired.size(), Eq(1u));
+    auto const groups = sync_groups_of(*display);
+    EXPECT_THAT(groups.size(), Eq(3u));
+    for (auto const group : initial_groups)
+    {
+        if (group != retired.front())
+            EXPECT_THAT(groups, Contains(group));
+    }
+}
+
+TEST_F(MesaDisplayMultiMonitorTest, configuring_unchanged_outputs_retires_nothing)
+{
+    using namespace testing;
+
+    setup_outputs(3, 0);
+
+    auto display = create_display_side_by_side(create_platform());
+    auto const initial_groups = sync_groups_of(*display);
+
+    bool retire_called{false};
+    EXPECT_TRUE(display->configure_changed_sync_groups(
+        *display->configuration(),
+        [&](std::vector<mg::DisplaySyncGroup*> const&) { retire_called = true; }));
+
+    EXPECT_FALSE(retire_called);
+    EXPECT_THAT(sync_groups_of(*display), ElementsAreArray(initial_groups));
+}
+
+TEST_F(MesaDisplayMultiMonitorTest, failing_to_configure_changed_outputs_leaves_sync_groups_in_place)
+{
+    using namespace testing;
+
+    setup_outputs(3, 0);
+
+    auto display = create_display_side_by_side(create_platform());
+    auto const initial_groups = sync_groups_of(*display);
+
+    auto conf = display->configuration();
+    change_mode_of_last_output(*conf);
+
+    ON_CALL(mock_gbm, gbm_surface_create(_, _, _, _, _))
+        .WillByDefault(Return(nullptr));
+
+    EXPECT_THROW(
+        display->configure_changed_sync_groups(*conf, [](std::vector<mg::DisplaySyncGroup*> const&) {}),
+        std::runtime_error);
+
+    EXPECT_THAT(sync_groups_of(*display), ElementsAreArray(initial_groups));
+}
@@ -83,6 +83,20 @@ TEST_F(KMSPageFlipperTest, schedule_flip_calls_drm_page_flip)
     page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
 }
 
+TEST_F(KMSPageFlipperTest, schedule_async_flip_asks_drm_not_to_wait_for_vblank)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const fb_id{101};
+    uint32_t const connector_id{345};
+
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_PAGE_FLIP_ASYNC, _))
+        .Times(1);
+
+    page_flipper.schedule_async_flip(crtc_id, fb_id, connector_id);
+}
+
 TEST_F(KMSPageFlipperTest, double_schedule_flip_throws)
 {
     using namespace testing;
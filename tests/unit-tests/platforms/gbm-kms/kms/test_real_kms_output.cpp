@@ -23,6 +23,9 @@
 #include "mir/test/doubles/mock_drm.h"
 #include "mir/test/doubles/mock_gbm.h"
 
+#include <cstring>
+#include <list>
+#include <optional>
 #include <stdexcept>
 
 #include <gtest/gtest.h>
@@ -44,6 +47,8 @@ class NullPageFlipper : public mgg::PageFlipper
 {
 public:
     bool schedule_flip(uint32_t,uint32_t,uint32_t) override { return true; }
+    bool schedule_async_flip(uint32_t,uint32_t,uint32_t) override { return true; }
+    bool schedule_atomic_flip(uint32_t, drmModeAtomicReq*, uint32_t) override { return true; }
     mg::Frame wait_for_flip(uint32_t) override { return {}; }
 };
 
@@ -51,6 +56,8 @@ class MockPageFlipper : public mgg::PageFlipper
 {
 public:
     MOCK_METHOD3(schedule_flip, bool(uint32_t,uint32_t,uint32_t));
+    MOCK_METHOD3(schedule_async_flip, bool(uint32_t,uint32_t,uint32_t));
+    MOCK_METHOD3(schedule_atomic_flip, bool(uint32_t,drmModeAtomicReq*,uint32_t));
     MOCK_METHOD1(wait_for_flip, mg::Frame(uint32_t));
 };
 
@@ -146,6 +153,53 @@ public:
         mock_drm.prepare(drm_device);
     }
 
+    struct FakePlane
+    {
+        uint32_t id;
+        uint64_t type;
+        std::optional<uint64_t> zpos;
+    };
+
+    // Planes usable by the first CRTC
+    void setup_planes(std::vector<FakePlane> const& planes)
+    {
+        for (auto const& plane : planes)
+        {
+            plane_ids.push_back(plane.id);
+
+            auto& kms_plane = kms_planes.emplace_back();
+            kms_plane.plane_id = plane.id;
+            kms_plane.possible_crtcs = 0x1;
+
+            auto& props = plane_props.emplace_back();
+            props.ids.push_back(type_prop.prop_id);
+            props.values.push_back(plane.type);
+            if (plane.zpos)
+            {
+                props.ids.push_back(zpos_prop.prop_id);
+                props.values.push_back(*plane.zpos);
+            }
+            props.props.count_props = props.ids.size();
+            props.props.props = props.ids.data();
+            props.props.prop_values = props.values.data();
+
+            ON_CALL(mock_drm, drmModeGetPlane(_, plane.id))
+                .WillByDefault(Return(&kms_plane));
+            ON_CALL(mock_drm, drmModeObjectGetProperties(_, plane.id, DRM_MODE_OBJECT_PLANE))
+                .WillByDefault(Return(&props.props));
+        }
+
+        plane_resources.count_planes = plane_ids.size();
+        plane_resources.planes = plane_ids.data();
+
+        ON_CALL(mock_drm, drmModeGetPlaneResources(_))
+            .WillByDefault(Return(&plane_resources));
+        ON_CALL(mock_drm, drmModeGetProperty(_, type_prop.prop_id))
+            .WillByDefault(Return(&type_prop));
+        ON_CALL(mock_drm, drmModeGetProperty(_, zpos_prop.prop_id))
+            .WillByDefault(Return(&zpos_prop));
+    }
+
     void append_fb_id(uint32_t fb_id)
     {
         EXPECT_CALL(mock_drm, drmModeAddFB2(_,_,_,_,_,_,_,_,_))
@@ -171,6 +225,27 @@ public:
     std::vector<uint32_t> const connector_ids;
     std::vector<uint32_t> possible_encoder_ids1;
     std::vector<uint32_t> possible_encoder_ids2;
+
+    static auto property(uint32_t id, char const* name) -> drmModePropertyRes
+    {
+        drmModePropertyRes prop{};
+        prop.prop_id = id;
+        strncpy(prop.name, name, sizeof(prop.name) - 1);
+        return prop;
+    }
+
+    struct PlaneProperties
+    {
+        std::vector<uint32_t> ids;
+        std::vector<uint64_t> values;
+        drmModeObjectProperties props{};
+    };
+    std::vector<uint32_t> plane_ids;
+    drmModePlaneRes plane_resources{};
+    std::list<drmModePlane> kms_planes;
+    std::list<PlaneProperties> plane_props;
+    drmModePropertyRes type_prop{property(90, "type")};
+    drmModePropertyRes zpos_prop{property(91, "zpos")};
 };
 
 }
@@ -207,7 +282,8 @@ TEST_F(RealKMSOutputTest, operations_use_existing_crtc)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     auto fb = output.fb_for(fake_bo);
 
@@ -249,7 +325,8 @@ TEST_F(RealKMSOutputTest, operations_use_possible_crtc)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     auto fb = output.fb_for(fake_bo);
 
@@ -258,6 +335,96 @@ TEST_F(RealKMSOutputTest, operations_use_possible_crtc)
     output.wait_for_page_flip();
 }
 
+TEST_F(RealKMSOutputTest, has_no_overlay_planes_without_atomic_modesetting)
+{
+    using namespace testing;
+
+    uint32_t const fb_id{67};
+
+    setup_outputs_connected_crtc();
+    append_fb_id(fb_id);
+
+    EXPECT_CALL(mock_page_flipper, schedule_atomic_flip(_, _, _)).Times(0);
+    EXPECT_CALL(mock_page_flipper, schedule_flip(crtc_ids[0], fb_id, connector_ids[0]))
+        .WillOnce(Return(true));
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper),
+        false};
+
+    auto fb = output.fb_for(fake_bo);
+
+    EXPECT_TRUE(output.set_crtc(*fb));
+    EXPECT_THAT(output.overlay_plane_count(), Eq(0u));
+    EXPECT_FALSE(output.test_overlays(*fb, {mgg::OverlayLayer{fb, {64, 64}, {10, 10}}}));
+    EXPECT_TRUE(output.schedule_page_flip(*fb));
+}
+
+TEST_F(RealKMSOutputTest, leaves_the_client_caps_of_the_device_alone)
+{
+    using namespace testing;
+
+    setup_outputs_connected_crtc();
+    setup_planes({
+        {40, DRM_PLANE_TYPE_PRIMARY, std::nullopt},
+        {41, DRM_PLANE_TYPE_OVERLAY, std::nullopt}});
+    append_fb_id(67);
+
+    // They're set once, for every output, when the device is opened
+    EXPECT_CALL(mock_drm, drmSetClientCap(_, _, _)).Times(0);
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper),
+        true};
+
+    EXPECT_TRUE(output.set_crtc(*output.fb_for(fake_bo)));
+    output.set_vrr_enabled(true);
+}
+
+TEST_F(RealKMSOutputTest, uses_the_overlay_planes_of_its_crtc)
+{
+    setup_outputs_connected_crtc();
+    setup_planes({
+        {40, DRM_PLANE_TYPE_PRIMARY, std::nullopt},
+        {41, DRM_PLANE_TYPE_OVERLAY, std::nullopt},
+        {42, DRM_PLANE_TYPE_CURSOR, std::nullopt},
+        {43, DRM_PLANE_TYPE_OVERLAY, std::nullopt}});
+    append_fb_id(67);
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper),
+        true};
+
+    EXPECT_TRUE(output.set_crtc(*output.fb_for(fake_bo)));
+    EXPECT_THAT(output.overlay_plane_count(), Eq(2u));
+}
+
+TEST_F(RealKMSOutputTest, ignores_overlay_planes_stacked_beneath_the_primary)
+{
+    setup_outputs_connected_crtc();
+    setup_planes({
+        {40, DRM_PLANE_TYPE_OVERLAY, 0},
+        {41, DRM_PLANE_TYPE_PRIMARY, 1},
+        {42, DRM_PLANE_TYPE_OVERLAY, 1},
+        {43, DRM_PLANE_TYPE_OVERLAY, 2}});
+    append_fb_id(67);
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper),
+        true};
+
+    EXPECT_TRUE(output.set_crtc(*output.fb_for(fake_bo)));
+    EXPECT_THAT(output.overlay_plane_count(), Eq(1u));
+}
+
 TEST_F(RealKMSOutputTest, set_crtc_failure_is_handled_gracefully)
 {
     mir::FatalErrorStrategy on_error{mir::fatal_error_except};
@@ -289,7 +456,8 @@ TEST_F(RealKMSOutputTest, set_crtc_failure_is_handled_gracefully)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     auto fb = output.fb_for(fake_bo);
 
@@ -312,7 +480,8 @@ TEST_F(RealKMSOutputTest, clear_crtc_gets_crtc_if_none_is_current)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     EXPECT_CALL(mock_drm, drmModeSetCrtc(_, crtc_ids[0], 0, 0, 0, nullptr, 0, nullptr))
         .Times(1)
@@ -349,7 +518,8 @@ TEST_F(RealKMSOutputTest, clear_crtc_does_not_throw_if_no_crtc_is_found)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     EXPECT_CALL(mock_drm, drmModeSetCrtc(_, _, 0, 0, 0, nullptr, 0, nullptr))
         .Times(0);
@@ -370,7 +540,8 @@ TEST_F(RealKMSOutputTest, cursor_move_permission_failure_is_non_fatal)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     auto fb = output.fb_for(fake_bo);
 
@@ -398,7 +569,8 @@ TEST_F(RealKMSOutputTest, cursor_set_permission_failure_is_non_fatal)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     auto fb = output.fb_for(fake_bo);
 
@@ -427,7 +599,8 @@ TEST_F(RealKMSOutputTest, has_no_cursor_if_no_hardware_support)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     auto fb = output.fb_for(fake_bo);
 
@@ -448,7 +621,8 @@ TEST_F(RealKMSOutputTest, clear_crtc_is_non_fatal_on_permission_error)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     EXPECT_CALL(mock_drm, drmModeSetCrtc(_, crtc_ids[0], 0, 0, 0, nullptr, 0, nullptr))
         .Times(2)
@@ -474,7 +648,8 @@ TEST_F(RealKMSOutputTest, clear_crtc_throws_if_drm_call_fails_for_non_permission
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     EXPECT_CALL(mock_drm, drmModeSetCrtc(_, crtc_ids[0], 0, 0, 0, nullptr, 0, nullptr))
         .Times(1)
@@ -496,7 +671,8 @@ TEST_F(RealKMSOutputTest, drm_set_gamma)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     mg::GammaCurves gamma{{1}, {2}, {3}};
 
@@ -527,7 +703,8 @@ TEST_F(RealKMSOutputTest, drm_set_gamma_failure_does_not_throw)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     mg::GammaCurves gamma{{1}, {2}, {3}};
 
@@ -546,3 +723,70 @@ TEST_F(RealKMSOutputTest, drm_set_gamma_failure_does_not_throw)
 
     EXPECT_NO_THROW(output.set_gamma(gamma););
 }
+
+TEST_F(RealKMSOutputTest, variable_refresh_is_not_enabled_without_driver_support)
+{
+    setup_outputs_connected_crtc();
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper),
+        true};
+
+    // The mock CRTC has no VRR_ENABLED property
+    output.set_vrr_enabled(true);
+
+    EXPECT_FALSE(output.vrr_enabled());
+}
+
+TEST_F(RealKMSOutputTest, async_page_flip_is_refused_without_driver_support)
+{
+    using namespace testing;
+
+    setup_outputs_connected_crtc();
+
+    uint32_t const fb_id{42};
+    append_fb_id(fb_id);
+
+    ON_CALL(mock_drm, drmGetCap(_, DRM_CAP_ASYNC_PAGE_FLIP, _))
+        .WillByDefault(DoAll(SetArgPointee<2>(0), Return(0)));
+    EXPECT_CALL(mock_page_flipper, schedule_async_flip(_, _, _)).Times(0);
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper),
+        true};
+
+    auto fb = output.fb_for(fake_bo);
+
+    EXPECT_TRUE(output.set_crtc(*fb));
+    EXPECT_FALSE(output.schedule_async_page_flip(*fb));
+}
+
+TEST_F(RealKMSOutputTest, async_page_flip_is_scheduled_with_driver_support)
+{
+    using namespace testing;
+
+    setup_outputs_connected_crtc();
+
+    uint32_t const fb_id{42};
+    append_fb_id(fb_id);
+
+    ON_CALL(mock_drm, drmGetCap(_, DRM_CAP_ASYNC_PAGE_FLIP, _))
+        .WillByDefault(DoAll(SetArgPointee<2>(1), Return(0)));
+    EXPECT_CALL(mock_page_flipper, schedule_async_flip(crtc_ids[0], fb_id, connector_ids[0]))
+        .WillOnce(Return(true));
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper),
+        true};
+
+    auto fb = output.fb_for(fake_bo);
+
+    EXPECT_TRUE(output.set_crtc(*fb));
+    EXPECT_TRUE(output.schedule_async_page_flip(*fb));
+}
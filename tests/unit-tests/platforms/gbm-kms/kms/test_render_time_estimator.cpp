@@ -0,0 +1,99 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/gbm-kms/server/kms/render_time_estimator.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mgg = mir::graphics::gbm;
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+auto const initial_estimate = std::chrono::nanoseconds{50ms};
+
+struct RenderTimeEstimator : Test
+{
+    void render_frames(int count, std::chrono::nanoseconds each)
+    {
+        for (auto i = 0; i != count; ++i)
+        {
+            estimator.frame_rendered(each);
+        }
+    }
+
+    mgg::RenderTimeEstimator estimator{initial_estimate};
+};
+}
+
+TEST_F(RenderTimeEstimator, uses_initial_estimate_until_a_few_frames_are_measured)
+{
+    render_frames(3, 2ms);
+
+    EXPECT_THAT(estimator.estimate(), Eq(initial_estimate));
+}
+
+TEST_F(RenderTimeEstimator, estimate_follows_measured_frames)
+{
+    render_frames(64, 2ms);
+
+    EXPECT_THAT(estimator.estimate(), Ge(std::chrono::nanoseconds{2ms}));
+    EXPECT_THAT(estimator.estimate(), Lt(std::chrono::nanoseconds{4ms}));
+}
+
+TEST_F(RenderTimeEstimator, ignores_a_rare_slow_frame)
+{
+    render_frames(63, 2ms);
+    estimator.frame_rendered(12ms);
+
+    EXPECT_THAT(estimator.estimate(), Lt(std::chrono::nanoseconds{4ms}));
+}
+
+TEST_F(RenderTimeEstimator, allows_for_regularly_slow_frames)
+{
+    for (auto i = 0; i != 16; ++i)
+    {
+        render_frames(3, 2ms);
+        estimator.frame_rendered(12ms);
+    }
+
+    EXPECT_THAT(estimator.estimate(), Ge(std::chrono::nanoseconds{12ms}));
+}
+
+TEST_F(RenderTimeEstimator, missed_deadlines_increase_the_estimate)
+{
+    render_frames(64, 2ms);
+    auto const before = estimator.estimate();
+
+    estimator.deadline_missed();
+    estimator.deadline_missed();
+
+    EXPECT_THAT(estimator.estimate(), Gt(before));
+}
+
+TEST_F(RenderTimeEstimator, margin_recovers_after_missed_deadlines)
+{
+    render_frames(64, 2ms);
+    auto const before = estimator.estimate();
+
+    estimator.deadline_missed();
+    estimator.deadline_missed();
+    render_frames(1000, 2ms);
+
+    EXPECT_THAT(estimator.estimate(), Eq(before));
+}
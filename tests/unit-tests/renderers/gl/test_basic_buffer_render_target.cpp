@@ -21,7 +21,11 @@
 #include "mir/test/doubles/stub_buffer.h"
 #include "mir/test/fake_shared.h"
 
+#include "mir/geometry/rectangles.h"
+
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
 #include <set>
 
 namespace mr = mir::renderer;
@@ -136,13 +140,114 @@ TEST_F(BasicBufferRenderTarget, reads_pixels)
     render_target.swap_buffers();
 }
 
+TEST_F(BasicBufferRenderTarget, reads_only_damage_once_it_has_a_frame)
+{
+    mrg::BasicBufferRenderTarget render_target{mt::fake_shared(ctx)};
+    render_target.set_buffer(mt::fake_shared(reasonable_buffer));
+    EXPECT_THAT(render_target.buffer_age(), Eq(0));
+    render_target.swap_buffers_with_damage(geom::Rectangles{{{2, 3}, {4, 5}}});
+    EXPECT_THAT(render_target.buffer_age(), Eq(1));
+
+    // GL rows count up from the bottom
+    EXPECT_CALL(mock_gl, glReadPixels(2, reasonable_height - 8, 4, 5, _, _, _));
+    render_target.swap_buffers_with_damage(geom::Rectangles{{{2, 3}, {4, 5}}});
+}
+
+TEST_F(BasicBufferRenderTarget, finish_copy_writes_whole_frame_to_buffer)
+{
+    // Fill each read with its own byte, so we can tell the frames apart
+    unsigned char fill{1};
+    ON_CALL(mock_gl, glReadPixels(_, _, _, _, _, _, _)).WillByDefault(Invoke(
+        [&](GLint, GLint, GLsizei width, GLsizei height, GLenum, GLenum, GLvoid* pixels)
+        {
+            std::memset(pixels, fill++, width * height * 4);
+        }));
+    auto const stride = reasonable_width * 4;
+
+    mrg::BasicBufferRenderTarget render_target{mt::fake_shared(ctx)};
+    render_target.set_buffer(mt::fake_shared(reasonable_buffer));
+    render_target.swap_buffers();
+    render_target.swap_buffers_with_damage(geom::Rectangles{{{2, 3}, {4, 5}}});
+
+    render_target.finish_copy();
+    EXPECT_THAT(reasonable_buffer.written_pixels, Each(Eq(1)));
+
+    render_target.finish_copy();
+    EXPECT_THAT(reasonable_buffer.written_pixels[0], Eq(1));
+    EXPECT_THAT(reasonable_buffer.written_pixels[(reasonable_height - 8) * stride + 2 * 4], Eq(2));
+    EXPECT_THAT(reasonable_buffer.written_pixels[(reasonable_height - 5) * stride + 5 * 4 + 3], Eq(2));
+    EXPECT_THAT(reasonable_buffer.written_pixels[(reasonable_height - 5) * stride + 6 * 4], Eq(1));
+    EXPECT_THAT(std::count(reasonable_buffer.written_pixels.begin(), reasonable_buffer.written_pixels.end(), 2),
+        Eq(4 * 5 * 4));
+}
+
+TEST_F(BasicBufferRenderTarget, writes_into_buffers_with_padded_stride)
+{
+    ON_CALL(mock_gl, glReadPixels(_, _, _, _, _, _, _)).WillByDefault(Invoke(
+        [&](GLint, GLint, GLsizei width, GLsizei height, GLenum, GLenum, GLvoid* pixels)
+        {
+            std::memset(pixels, 0xff, width * height * 4);
+        }));
+    auto const stride = reasonable_width * 4 + 16;
+    mtd::StubBuffer padded_buffer{
+        nullptr,
+        {reasonable_size, reasonable_pixel_format, mg::BufferUsage::software},
+        geom::Stride{stride}};
+
+    mrg::BasicBufferRenderTarget render_target{mt::fake_shared(ctx)};
+    render_target.set_buffer(mt::fake_shared(padded_buffer));
+    render_target.swap_buffers();
+    render_target.finish_copy();
+
+    for (auto row = 0; row != reasonable_height; ++row)
+    {
+        auto const begin = padded_buffer.written_pixels.begin() + row * stride;
+        EXPECT_THAT(std::count(begin, begin + reasonable_width * 4, 0xff), Eq(reasonable_width * 4));
+        EXPECT_THAT(std::count(begin + reasonable_width * 4, begin + stride, 0), Eq(16));
+    }
+}
+
+TEST_F(BasicBufferRenderTarget, swaps_red_and_blue_for_abgr_buffers)
+{
+    ON_CALL(mock_gl, glReadPixels(_, _, _, _, _, _, _)).WillByDefault(Invoke(
+        [&](GLint, GLint, GLsizei width, GLsizei height, GLenum, GLenum, GLvoid* pixels)
+        {
+            auto const bytes = static_cast<unsigned char*>(pixels);
+            for (auto i = 0; i != width * height * 4; i += 4)
+            {
+                bytes[i] = 0x11;     // Blue
+                bytes[i + 1] = 0x22; // Green
+                bytes[i + 2] = 0x33; // Red
+                bytes[i + 3] = 0x44; // Alpha
+            }
+        }));
+    mtd::StubBuffer abgr_buffer{{reasonable_size, mir_pixel_format_abgr_8888, mg::BufferUsage::software}};
+
+    mrg::BasicBufferRenderTarget render_target{mt::fake_shared(ctx)};
+    render_target.set_buffer(mt::fake_shared(abgr_buffer));
+    render_target.swap_buffers();
+    render_target.finish_copy();
+
+    EXPECT_THAT(abgr_buffer.written_pixels[0], Eq(0x33));
+    EXPECT_THAT(abgr_buffer.written_pixels[1], Eq(0x22));
+    EXPECT_THAT(abgr_buffer.written_pixels[2], Eq(0x11));
+    EXPECT_THAT(abgr_buffer.written_pixels[3], Eq(0x44));
+}
+
+TEST_F(BasicBufferRenderTarget, throws_on_finish_copy_without_copy_in_flight)
+{
+    mrg::BasicBufferRenderTarget render_target{mt::fake_shared(ctx)};
+    render_target.set_buffer(mt::fake_shared(reasonable_buffer));
+    EXPECT_THROW(render_target.finish_copy(), std::logic_error);
+}
+
 TEST_F(BasicBufferRenderTarget, throws_on_invalid_buffer)
 {
     mrg::BasicBufferRenderTarget render_target{mt::fake_shared(ctx)};
     EXPECT_THROW({
         mtd::StubBuffer buffer({
             reasonable_size,
-            mir_pixel_format_abgr_8888, // wrong format
+            mir_pixel_format_rgb_565, // wrong format
             mg::BufferUsage::software});
         render_target.set_buffer(mt::fake_shared(buffer));
         render_target.swap_buffers();
@@ -226,6 +226,34 @@ TEST_F(GLRenderer, avoids_src_alpha_for_rgbx_blending)  // LP: #1423462
     renderer.render(renderable_list);
 }
 
+TEST_F(GLRenderer, uploads_vertices_of_all_renderables_once_per_frame)
+{
+    renderable_list.push_back(renderable);
+
+    EXPECT_CALL(mock_gl, glBufferData(GL_ARRAY_BUFFER, 8 * sizeof(mgl::Vertex), _, GL_STREAM_DRAW));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, 0, 4));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, 4, 4));
+
+    mrg::Renderer renderer(display_buffer);
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, renderables_sharing_state_set_it_once)
+{
+    EXPECT_CALL(*renderable, shaped()).WillRepeatedly(Return(true));
+    renderable_list.push_back(renderable);
+    renderable_list.push_back(renderable);
+
+    EXPECT_CALL(mock_gl, glUseProgram(stub_program));
+    EXPECT_CALL(mock_gl, glVertexAttribPointer(_, _, _, _, _, _)).Times(2);
+    EXPECT_CALL(mock_gl, glEnable(GL_BLEND));
+    EXPECT_CALL(mock_gl, glBlendFuncSeparate(_, _, _, _));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _)).Times(3);
+
+    mrg::Renderer renderer(display_buffer);
+    renderer.render(renderable_list);
+}
+
 TEST_F(GLRenderer, clears_to_opaque_black)
 {
     InSequence seq;
@@ -315,13 +343,15 @@ TEST_F(GLRenderer, swaps_buffers_after_rendering)
 
 TEST_F(GLRenderer, sets_scissor_test)
 {
+    ON_CALL(mock_display_buffer, size())
+        .WillByDefault(Return(mir::geometry::Size{3, 4}));
     EXPECT_CALL(*renderable, clip_area())
         .WillRepeatedly(Return(std::optional<mir::geometry::Rectangle>({{0,1},{2,3}})));
     EXPECT_CALL(mock_gl, glEnable(GL_SCISSOR_TEST));
     EXPECT_CALL(mock_gl, glDisable(GL_SCISSOR_TEST));
     EXPECT_CALL(mock_gl, glScissor(-1, 2, 2, 3));
 
-    mrg::Renderer renderer(display_buffer);
+    mrg::Renderer renderer(mock_display_buffer);
     renderer.set_viewport({{1, 2}, {3, 4}});
 
     renderer.render(renderable_list);
@@ -338,6 +368,103 @@ TEST_F(GLRenderer, dont_set_scissor_test_when_unnecessary)
     renderer.render(renderable_list);
 }
 
+TEST_F(GLRenderer, scissor_follows_a_rotated_output)
+{
+    ON_CALL(mock_display_buffer, size())
+        .WillByDefault(Return(mir::geometry::Size{1920, 1080}));
+    EXPECT_CALL(*renderable, clip_area())
+        .WillRepeatedly(Return(std::optional<mir::geometry::Rectangle>({{0, 0}, {100, 50}})));
+
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.set_output_transform(glm::mat2{0, -1,
+                                            1,  0});
+    renderer.set_viewport({{0, 0}, {1080, 1920}});
+
+    // The top left of the (portrait) viewport is the top right of the render target
+    EXPECT_CALL(mock_gl, glScissor(1920 - 50, 1080 - 100, 50, 100));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, scissor_follows_a_scaled_output)
+{
+    ON_CALL(mock_display_buffer, size())
+        .WillByDefault(Return(mir::geometry::Size{1920, 1080}));
+    EXPECT_CALL(*renderable, clip_area())
+        .WillRepeatedly(Return(std::optional<mir::geometry::Rectangle>({{10, 20}, {30, 40}})));
+
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.set_viewport({{0, 0}, {960, 540}});
+
+    EXPECT_CALL(mock_gl, glScissor(20, 1080 - 2 * (20 + 40), 60, 80));
+
+    renderer.render(renderable_list);
+}
+
+
+TEST_F(GLRenderer, redraws_only_damage_when_buffer_age_is_known)
+{
+    mir::geometry::Rectangle const screen{{0, 0}, {1920, 1080}};
+    mir::geometry::Rectangle const damage{{10, 20}, {16, 16}};
+    ON_CALL(mock_display_buffer, size())
+        .WillByDefault(Return(screen.size));
+    ON_CALL(mock_display_buffer, buffer_age())
+        .WillByDefault(Return(1));
+
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.set_viewport(screen);
+    renderer.set_damage({damage});
+
+    EXPECT_CALL(mock_gl, glEnable(GL_SCISSOR_TEST));
+    EXPECT_CALL(mock_gl, glScissor(10, 1080 - 20 - 16, 16, 16));
+    EXPECT_CALL(mock_display_buffer, swap_buffers()).Times(0);
+    EXPECT_CALL(mock_display_buffer, swap_buffers_with_damage(testing::Eq(mir::geometry::Rectangles{damage})));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, redraws_damage_of_intervening_frames_for_older_buffers)
+{
+    mir::geometry::Rectangle const screen{{0, 0}, {1920, 1080}};
+    mir::geometry::Rectangle const first_damage{{10, 20}, {16, 16}};
+    mir::geometry::Rectangle const second_damage{{500, 600}, {32, 32}};
+    ON_CALL(mock_display_buffer, size())
+        .WillByDefault(Return(screen.size));
+    EXPECT_CALL(mock_display_buffer, buffer_age())
+        .WillOnce(Return(0))
+        .WillOnce(Return(2));
+
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.set_viewport(screen);
+
+    renderer.set_damage({first_damage});
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(mock_display_buffer, swap_buffers_with_damage(
+        testing::Eq(mir::geometry::Rectangles{first_damage, second_damage})));
+
+    renderer.set_damage({second_damage});
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, redraws_everything_when_buffer_age_is_unknown)
+{
+    mir::geometry::Rectangle const screen{{0, 0}, {1920, 1080}};
+    ON_CALL(mock_display_buffer, size())
+        .WillByDefault(Return(screen.size));
+    ON_CALL(mock_display_buffer, buffer_age())
+        .WillByDefault(Return(0));
+
+    mrg::Renderer renderer(mock_display_buffer);
+    renderer.set_viewport(screen);
+    renderer.set_damage({{{10, 20}, {16, 16}}});
+
+    EXPECT_CALL(mock_gl, glScissor(_, _, _, _)).Times(0);
+    EXPECT_CALL(mock_display_buffer, swap_buffers());
+    EXPECT_CALL(mock_display_buffer, swap_buffers_with_damage(_)).Times(0);
+
+    renderer.render(renderable_list);
+}
 
 TEST_F(GLRenderer, unchanged_viewport_avoids_gl_calls)
 {
@@ -67,7 +67,7 @@ public:
     MOCK_METHOD3(attrib_changed, void(ms::Surface const*, MirWindowAttrib, int));
     MOCK_METHOD2(window_resized_to, void(ms::Surface const*, geom::Size const&));
     MOCK_METHOD2(content_resized_to, void(ms::Surface const*, geom::Size const&));
-    MOCK_METHOD3(frame_posted, void(ms::Surface const*, int, geom::Rectangle const&));
+    MOCK_METHOD4(frame_posted, void(ms::Surface const*, int, mg::Renderable::ID, geom::Rectangles const&));
     MOCK_METHOD2(hidden_set_to, void(ms::Surface const*, bool));
     MOCK_METHOD2(renamed, void(ms::Surface const*, std::string const&));
     MOCK_METHOD1(client_surface_close_requested, void(ms::Surface const*));
@@ -107,7 +107,7 @@ struct BasicSurfaceTest : public testing::Test
         std::make_shared<ms::SurfaceChangeNotification>(
             &surface,
             mock_change_cb,
-            [this](int, geom::Rectangle const&){mock_change_cb();});
+            [this](int, mg::Renderable::ID, geom::Rectangles const&){mock_change_cb();});
 
     BasicSurfaceTest()
     {
@@ -1017,8 +1017,8 @@ TEST_F(BasicSurfaceTest, when_frame_is_posted_an_observer_is_notified_of_frame_w
     ON_CALL(*buffer_stream, stream_size())
         .WillByDefault(Return(rect.size));
 
-    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, mt::RectSizeEq(rect.size)));
-    buffer_stream->frame_posted_callback(rect.size);
+    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, _, Property(&geom::Rectangles::bounding_rectangle, mt::RectSizeEq(rect.size))));
+    buffer_stream->frame_posted_callback(rect.size, geom::Rectangles{{{}, rect.size}});
 }
 
 TEST_F(BasicSurfaceTest, when_stream_size_differs_from_buffer_size_an_observer_is_notified_of_frame_with_stream_size)
@@ -1027,15 +1027,14 @@ TEST_F(BasicSurfaceTest, when_stream_size_differs_from_buffer_size_an_observer_i
     geom::Size const stream_size{rect.size * 1.5};
 
     auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
-    std::function<void(geom::Size const&)> frame_posted_callback;
     ON_CALL(*buffer_stream, stream_size())
         .WillByDefault(Return(stream_size));
 
     surface.register_interest(mock_surface_observer, executor);
     surface.set_streams({ms::StreamInfo{buffer_stream, {}, {}}});
 
-    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, mt::RectSizeEq(stream_size)));
-    buffer_stream->frame_posted_callback(stream_size * 2);
+    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, _, Property(&geom::Rectangles::bounding_rectangle, mt::RectSizeEq(stream_size))));
+    buffer_stream->frame_posted_callback(stream_size * 2, geom::Rectangles{{{}, stream_size}});
 }
 
 TEST_F(BasicSurfaceTest, when_stream_info_has_explicit_size_an_observer_is_notified_of_frame_with_stream_info_size)
@@ -1045,15 +1044,14 @@ TEST_F(BasicSurfaceTest, when_stream_info_has_explicit_size_an_observer_is_notif
     geom::Size const stream_size{stream_info_size * 2};
 
     auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
-    std::function<void(geom::Size const&)> frame_posted_callback;
     ON_CALL(*buffer_stream, stream_size())
         .WillByDefault(Return(stream_size));
 
     surface.register_interest(mock_surface_observer, executor);
     surface.set_streams({ms::StreamInfo{buffer_stream, {}, stream_info_size}});
 
-    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, mt::RectSizeEq(stream_info_size)));
-    buffer_stream->frame_posted_callback(stream_size);
+    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, _, Property(&geom::Rectangles::bounding_rectangle, mt::RectSizeEq(stream_info_size))));
+    buffer_stream->frame_posted_callback(stream_size, geom::Rectangles{{{}, stream_size}});
 }
 
 TEST_F(BasicSurfaceTest, when_frame_is_posted_an_observer_is_notified_of_frame_at_origin)
@@ -1064,8 +1062,8 @@ TEST_F(BasicSurfaceTest, when_frame_is_posted_an_observer_is_notified_of_frame_a
     surface.register_interest(mock_surface_observer, executor);
     surface.set_streams({ms::StreamInfo{buffer_stream, {}, {}}});
 
-    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, mt::RectTopLeftEq(geom::Point{})));
-    buffer_stream->frame_posted_callback(rect.size);
+    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, _, Property(&geom::Rectangles::bounding_rectangle, mt::RectTopLeftEq(geom::Point{}))));
+    buffer_stream->frame_posted_callback(rect.size, geom::Rectangles{{{}, rect.size}});
 }
 
 TEST_F(BasicSurfaceTest, when_stream_info_has_offset_an_observer_is_notified_of_frame_with_correct_offset)
@@ -1074,13 +1072,12 @@ TEST_F(BasicSurfaceTest, when_stream_info_has_offset_an_observer_is_notified_of_
     geom::Displacement const stream_info_offset{7, 10};
 
     auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
-    std::function<void(geom::Size const&)> frame_posted_callback;
 
     surface.register_interest(mock_surface_observer, executor);
     surface.set_streams({ms::StreamInfo{buffer_stream, stream_info_offset, {}}});
 
-    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, mt::RectTopLeftEq(geom::Point{} + stream_info_offset)));
-    buffer_stream->frame_posted_callback(rect.size);
+    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, _, Property(&geom::Rectangles::bounding_rectangle, mt::RectTopLeftEq(geom::Point{} + stream_info_offset))));
+    buffer_stream->frame_posted_callback(rect.size, geom::Rectangles{{{}, rect.size}});
 }
 
 TEST_F(BasicSurfaceTest, when_surface_has_margins_an_observer_is_notified_of_frame_with_correct_offset)
@@ -1090,14 +1087,64 @@ TEST_F(BasicSurfaceTest, when_surface_has_margins_an_observer_is_notified_of_fra
     geom::DeltaX const margin_left{3}, margin_right{5};
 
     auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
-    std::function<void(geom::Size const&)> frame_posted_callback;
 
     surface.register_interest(mock_surface_observer, executor);
     surface.set_streams({ms::StreamInfo{buffer_stream, {}, {}}});
 
-    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, mt::RectTopLeftEq(geom::Point{} + margin_top + margin_left)));
+    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, _, Property(&geom::Rectangles::bounding_rectangle, mt::RectTopLeftEq(geom::Point{} + margin_top + margin_left))));
     surface.set_window_margins(margin_top, margin_left, margin_bottom, margin_right);
-    buffer_stream->frame_posted_callback({20, 30});
+    buffer_stream->frame_posted_callback(geom::Size{20, 30}, geom::Rectangles{{{}, geom::Size{20, 30}}});
+}
+
+TEST_F(BasicSurfaceTest, when_part_of_a_frame_is_damaged_an_observer_is_notified_of_only_that_damage)
+{
+    using namespace testing;
+    geom::Displacement const stream_info_offset{7, 10};
+    geom::Rectangle const damage{{3, 4}, {5, 6}};
+
+    auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    ON_CALL(*buffer_stream, stream_size())
+        .WillByDefault(Return(rect.size));
+
+    surface.register_interest(mock_surface_observer, executor);
+    surface.set_streams({ms::StreamInfo{buffer_stream, stream_info_offset, {}}});
+
+    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, _, Eq(geom::Rectangles{
+        {damage.top_left + stream_info_offset, damage.size}})));
+    buffer_stream->frame_posted_callback(rect.size, geom::Rectangles{damage});
+}
+
+TEST_F(BasicSurfaceTest, damage_is_scaled_to_explicit_stream_info_size)
+{
+    using namespace testing;
+    geom::Size const stream_size{40, 40};
+    geom::Size const stream_info_size{20, 20};
+
+    auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    ON_CALL(*buffer_stream, stream_size())
+        .WillByDefault(Return(stream_size));
+
+    surface.register_interest(mock_surface_observer, executor);
+    surface.set_streams({ms::StreamInfo{buffer_stream, {}, stream_info_size}});
+
+    // Odd edges are rounded outwards
+    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, _, Eq(geom::Rectangles{{{1, 2}, {3, 3}}})));
+    buffer_stream->frame_posted_callback(stream_size, geom::Rectangles{{{3, 4}, {4, 5}}});
+}
+
+TEST_F(BasicSurfaceTest, frame_posted_identifies_the_renderable_showing_the_frame)
+{
+    using namespace testing;
+
+    auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    surface.register_interest(mock_surface_observer, executor);
+    surface.set_streams({ms::StreamInfo{buffer_stream, {}, {}}});
+
+    auto const renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1u));
+
+    EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, Eq(renderables.front()->id()), _));
+    buffer_stream->frame_posted_callback(rect.size, geom::Rectangles{{{}, rect.size}});
 }
 
 TEST_F(BasicSurfaceTest, default_application_id)
@@ -1233,6 +1280,37 @@ TEST_F(BasicSurfaceTest, moving_surface_repositions_all_associated_streams)
     EXPECT_THAT(renderables[1], IsRenderableOfPosition(pt + d));
 }
 
+TEST_F(BasicSurfaceTest, renderables_have_opaque_region_in_screen_coordinates)
+{
+    using namespace testing;
+    geom::Displacement const d{3, 5};
+    auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    ON_CALL(*buffer_stream, stream_size())
+        .WillByDefault(Return(geom::Size{20, 20}));
+
+    surface.set_streams({ms::StreamInfo{buffer_stream, d, {}, std::vector<geom::Rectangle>{{{2, 2}, {10, 30}}}}});
+
+    auto renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(
+        renderables[0]->opaque_region(),
+        ElementsAre(geom::Rectangle{rect.top_left + d + geom::Displacement{2, 2}, {10, 18}}));
+}
+
+TEST_F(BasicSurfaceTest, opaque_region_of_scaled_stream_is_ignored)
+{
+    using namespace testing;
+    auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    ON_CALL(*buffer_stream, stream_size())
+        .WillByDefault(Return(geom::Size{20, 20}));
+
+    surface.set_streams({ms::StreamInfo{buffer_stream, {}, geom::Size{40, 40}, std::vector<geom::Rectangle>{{{}, {20, 20}}}}});
+
+    auto renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0]->opaque_region(), IsEmpty());
+}
+
 TEST_F(BasicSurfaceTest, can_remove_all_streams)
 {
     using namespace testing;
@@ -1573,7 +1651,7 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_original_stream_after_surfac
 
     auto local_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
     std::list<ms::StreamInfo> local_stream_list = { { local_stream, {}, {} } };
-    std::function<void(geom::Size const&)> callback = [](auto){};
+    std::function<void(geom::Size const&, geom::Rectangles const&)> callback = [](auto, auto){};
 
     EXPECT_CALL(*local_stream, set_frame_posted_callback(_))
         .Times(AtLeast(1))
@@ -1590,7 +1668,7 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_original_stream_after_surfac
         report);
 
     surface.reset();
-    callback({10, 10});
+    callback({10, 10}, {{{}, {10, 10}}});
 }
 
 TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_set_stream_after_surface_destroyed)
@@ -1599,7 +1677,7 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_set_stream_after_surface_des
 
     auto local_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
     std::list<ms::StreamInfo> local_stream_list = { { local_stream, {}, {} } };
-    std::function<void(geom::Size const&)> callback = [](auto){};
+    std::function<void(geom::Size const&, geom::Rectangles const&)> callback = [](auto, auto){};
 
     EXPECT_CALL(*local_stream, set_frame_posted_callback(_))
         .Times(AtLeast(1))
@@ -1618,5 +1696,5 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_set_stream_after_surface_des
     surface->set_streams(local_stream_list);
 
     surface.reset();
-    callback({10, 10});
+    callback({10, 10}, {{{}, {10, 10}}});
 }
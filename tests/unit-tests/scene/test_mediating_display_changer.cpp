@@ -311,6 +311,52 @@ TEST_F(MediatingDisplayChangerTest, handles_hardware_change_when_display_buffers
     changer->configure(mt::fake_shared(conf));
 }
 
+TEST_F(MediatingDisplayChangerTest, handles_hardware_change_by_recompositing_only_the_changed_sync_groups)
+{
+    mtd::NullDisplayConfiguration conf;
+    std::vector<mg::DisplaySyncGroup*> const changed_groups{reinterpret_cast<mg::DisplaySyncGroup*>(0xaa)};
+
+    ON_CALL(mock_display, apply_if_configuration_preserves_display_buffers(_))
+        .WillByDefault(Return(false));
+
+    InSequence s;
+    EXPECT_CALL(mock_conf_policy, apply_to(Ref(conf)));
+
+    EXPECT_CALL(mock_display, configure_changed_sync_groups(Ref(conf), _))
+        .WillOnce(Invoke([&](auto const&, auto const& retire)
+            {
+                retire(changed_groups);
+                return true;
+            }));
+    EXPECT_CALL(mock_compositor, stop_sync_groups(changed_groups));
+    EXPECT_CALL(mock_compositor, start_new_sync_groups());
+
+    EXPECT_CALL(mock_compositor, stop()).Times(0);
+    EXPECT_CALL(mock_display, configure(_)).Times(0);
+    EXPECT_CALL(mock_compositor, start()).Times(0);
+
+    changer->configure(mt::fake_shared(conf));
+}
+
+TEST_F(MediatingDisplayChangerTest, does_not_recomposite_when_the_sync_groups_are_unchanged)
+{
+    mtd::NullDisplayConfiguration conf;
+
+    ON_CALL(mock_display, apply_if_configuration_preserves_display_buffers(_))
+        .WillByDefault(Return(false));
+
+    EXPECT_CALL(mock_display, configure_changed_sync_groups(Ref(conf), _))
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(mock_compositor, stop_sync_groups(_)).Times(0);
+    EXPECT_CALL(mock_compositor, start_new_sync_groups()).Times(0);
+    EXPECT_CALL(mock_compositor, stop()).Times(0);
+    EXPECT_CALL(mock_display, configure(_)).Times(0);
+    EXPECT_CALL(mock_compositor, start()).Times(0);
+
+    changer->configure(mt::fake_shared(conf));
+}
+
 TEST_F(MediatingDisplayChangerTest, handles_hardware_change_when_display_buffers_are_preserved_but_new_outputs_are_enabled)
 {
     auto conf = changer->base_configuration();
@@ -35,7 +35,7 @@ struct MockSceneCallback
 };
 struct MockBufferCallback
 {
-    MOCK_METHOD2(invoke, void(int, mir::geometry::Rectangle const&));
+    MOCK_METHOD2(invoke, void(int, mir::geometry::Rectangles const&));
 };
 
 struct SceneChangeNotificationTest : public testing::Test
@@ -47,7 +47,8 @@ struct SceneChangeNotificationTest : public testing::Test
     }
     testing::NiceMock<MockSceneCallback> scene_callback;
     testing::NiceMock<MockBufferCallback> buffer_callback;
-    std::function<void(int, mir::geometry::Rectangle const&)> buffer_change_callback{[this](int arg, mir::geometry::Rectangle const& damage)
+    std::function<void(int, mir::graphics::Renderable::ID, mir::geometry::Rectangles const&)> buffer_change_callback{
+        [this](int arg, mir::graphics::Renderable::ID, mir::geometry::Rectangles const& damage)
         {
             buffer_callback.invoke(arg, damage);
         }};
@@ -97,7 +98,7 @@ TEST_F(SceneChangeNotificationTest, observes_surface_changes)
 
     ms::SceneChangeNotification observer(scene_change_callback, buffer_change_callback);
     observer.surface_added(surface);
-    surface_observer.lock()->frame_posted(surface.get(), buffer_num, {});
+    surface_observer.lock()->frame_posted(surface.get(), buffer_num, nullptr, {});
 }
 
 TEST_F(SceneChangeNotificationTest, redraws_on_rename)
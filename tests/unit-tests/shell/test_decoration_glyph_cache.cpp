@@ -0,0 +1,115 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/shell/decoration/glyph_cache.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+namespace geom = mir::geometry;
+namespace msd = mir::shell::decoration;
+
+using namespace testing;
+
+namespace
+{
+struct DecorationGlyphCache : Test
+{
+    MOCK_METHOD(msd::Glyph, rasterize, (char32_t code, geom::Height height));
+
+    DecorationGlyphCache()
+    {
+        ON_CALL(*this, rasterize(_, _))
+            .WillByDefault(Invoke(
+                [](char32_t code, geom::Height height)
+                {
+                    return msd::Glyph{
+                        {{0, 0}, {1, height.as_int()}},
+                        std::vector<unsigned char>(height.as_int(), static_cast<unsigned char>(code)),
+                        {1, 0}};
+                }));
+    }
+
+    size_t const max_glyphs{3};
+    msd::GlyphCache cache{
+        [this](char32_t code, geom::Height height) { return rasterize(code, height); },
+        max_glyphs};
+};
+}
+
+TEST_F(DecorationGlyphCache, rasterizes_each_glyph_once)
+{
+    EXPECT_CALL(*this, rasterize(U'a', geom::Height{12})).Times(1);
+
+    auto const& first = cache.glyph(U'a', geom::Height{12});
+    auto const& second = cache.glyph(U'a', geom::Height{12});
+
+    EXPECT_THAT(&second, Eq(&first));
+    EXPECT_THAT(first.alpha, ElementsAreArray(std::vector<unsigned char>(12, 'a')));
+}
+
+TEST_F(DecorationGlyphCache, rasterizes_a_character_again_at_each_height)
+{
+    EXPECT_CALL(*this, rasterize(U'a', geom::Height{12})).Times(1);
+    EXPECT_CALL(*this, rasterize(U'a', geom::Height{20})).Times(1);
+
+    cache.glyph(U'a', geom::Height{12});
+    auto const& tall = cache.glyph(U'a', geom::Height{20});
+    cache.glyph(U'a', geom::Height{12});
+
+    EXPECT_THAT(tall.bounds.size.height, Eq(geom::Height{20}));
+}
+
+TEST_F(DecorationGlyphCache, does_not_cache_glyphs_that_fail_to_rasterize)
+{
+    EXPECT_CALL(*this, rasterize(U'x', _))
+        .WillOnce(Throw(std::runtime_error{"Failed to load glyph"}))
+        .WillOnce(DoDefault());
+
+    EXPECT_THROW(cache.glyph(U'x', geom::Height{12}), std::runtime_error);
+    EXPECT_THAT(cache.size(), Eq(0u));
+    EXPECT_NO_THROW(cache.glyph(U'x', geom::Height{12}));
+}
+
+TEST_F(DecorationGlyphCache, trim_keeps_glyphs_while_under_the_limit)
+{
+    for (char32_t code = U'a'; code != U'a' + max_glyphs; code++)
+    {
+        cache.glyph(code, geom::Height{12});
+    }
+
+    cache.trim();
+
+    EXPECT_THAT(cache.size(), Eq(max_glyphs));
+    EXPECT_CALL(*this, rasterize(_, _)).Times(0);
+    cache.glyph(U'a', geom::Height{12});
+}
+
+TEST_F(DecorationGlyphCache, trim_empties_the_cache_once_past_the_limit)
+{
+    for (char32_t code = U'a'; code != U'a' + max_glyphs + 1; code++)
+    {
+        cache.glyph(code, geom::Height{12});
+    }
+
+    cache.trim();
+
+    EXPECT_THAT(cache.size(), Eq(0u));
+    EXPECT_CALL(*this, rasterize(U'a', geom::Height{12})).Times(1);
+    cache.glyph(U'a', geom::Height{12});
+}
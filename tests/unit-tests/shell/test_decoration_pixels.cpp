@@ -0,0 +1,155 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/shell/decoration/pixels.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace geom = mir::geometry;
+namespace msd = mir::shell::decoration;
+
+using namespace testing;
+
+namespace
+{
+auto channel(uint32_t pixel, int shift) -> uint32_t
+{
+    return (pixel >> shift) & 0xFF;
+}
+
+auto pixel(uint32_t a, uint32_t r, uint32_t g, uint32_t b) -> uint32_t
+{
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+}
+
+TEST(DecorationPixels, div_255_divides_exactly_over_its_whole_range)
+{
+    for (uint32_t x = 0; x <= 255 * 255; x++)
+    {
+        ASSERT_THAT(msd::div_255(x), Eq(x / 255)) << "x = " << x;
+    }
+}
+
+TEST(DecorationPixels, blend_with_no_coverage_leaves_pixel_unchanged)
+{
+    auto const under = pixel(0x80, 0x12, 0x34, 0x56);
+
+    EXPECT_THAT(msd::blend(under, pixel(0xFF, 0xFF, 0xFF, 0xFF), 0), Eq(under));
+}
+
+TEST(DecorationPixels, blend_with_full_coverage_gives_color_with_pixel_alpha)
+{
+    auto const under = pixel(0x80, 0x12, 0x34, 0x56);
+    auto const color = pixel(0xFF, 0xAB, 0xCD, 0xEF);
+
+    EXPECT_THAT(msd::blend(under, color, 255), Eq(pixel(0x80, 0xAB, 0xCD, 0xEF)));
+}
+
+TEST(DecorationPixels, blend_weights_each_channel_by_coverage)
+{
+    std::vector<uint32_t> const values{0x00, 0x01, 0x7F, 0x80, 0xC3, 0xFE, 0xFF};
+
+    for (uint32_t coverage = 0; coverage <= 255; coverage++)
+    {
+        for (auto const p : values)
+        {
+            for (auto const c : values)
+            {
+                // Each channel gets different values, so that any bleeding between them shows
+                auto const under = pixel(0xFF, p, 0xFF - p, p ^ 0x5A);
+                auto const color = pixel(0xFF, c, 0xFF - c, c ^ 0xA5);
+
+                auto const blended = msd::blend(under, color, coverage);
+
+                for (auto const shift : {0, 8, 16})
+                {
+                    auto const expected =
+                        (channel(under, shift) * (255 - coverage) + channel(color, shift) * coverage) / 255;
+                    ASSERT_THAT(channel(blended, shift), Eq(expected))
+                        << "channel " << shift << ", coverage " << coverage
+                        << ", pixel " << std::hex << under << ", color " << color;
+                }
+            }
+        }
+    }
+}
+
+TEST(DecorationPixels, blending_a_color_over_itself_leaves_it_unchanged)
+{
+    auto const color = pixel(0xFF, 0x01, 0x80, 0xFE);
+
+    for (uint32_t coverage = 0; coverage <= 255; coverage++)
+    {
+        ASSERT_THAT(msd::blend(color, color, coverage), Eq(color)) << "coverage " << coverage;
+    }
+}
+
+TEST(DecorationPixels, render_mask_blends_mask_at_its_position)
+{
+    geom::Size const buf_size{4, 3};
+    std::vector<uint32_t> buffer(4 * 3, pixel(0xFF, 0, 0, 0));
+    std::vector<unsigned char> const mask{
+        0xFF, 0x00,
+        0x00, 0xFF};
+    auto const white = pixel(0xFF, 0xFF, 0xFF, 0xFF);
+
+    msd::render_mask(buffer.data(), buf_size, {{0, 0}, {2, 2}}, mask.data(), {1, 1}, white);
+
+    auto const black = pixel(0xFF, 0, 0, 0);
+    EXPECT_THAT(buffer, ElementsAre(
+        black, black, black, black,
+        black, white, black, black,
+        black, black, white, black));
+}
+
+TEST(DecorationPixels, render_mask_scales_coverage_by_color_alpha)
+{
+    geom::Size const buf_size{1, 1};
+    std::vector<uint32_t> buffer{pixel(0xFF, 0, 0, 0)};
+    std::vector<unsigned char> const mask{0xFF};
+
+    msd::render_mask(buffer.data(), buf_size, {{0, 0}, {1, 1}}, mask.data(), {0, 0}, pixel(0x80, 0xFF, 0xFF, 0xFF));
+
+    EXPECT_THAT(buffer[0], Eq(pixel(0xFF, 0x80, 0x80, 0x80)));
+}
+
+TEST(DecorationPixels, render_mask_is_clipped_to_buffer)
+{
+    geom::Size const buf_size{2, 2};
+    auto const black = pixel(0xFF, 0, 0, 0);
+    auto const white = pixel(0xFF, 0xFF, 0xFF, 0xFF);
+    std::vector<unsigned char> const mask{
+        0x01, 0x02, 0x03,
+        0x04, 0xFF, 0x06,
+        0x07, 0x08, 0x09};
+
+    // Hanging off the top left: only the bottom right of the mask is drawn
+    std::vector<uint32_t> buffer(4, black);
+    msd::render_mask(buffer.data(), buf_size, {{0, 0}, {3, 3}}, mask.data(), {-1, -1}, white);
+    EXPECT_THAT(channel(buffer[0], 0), Eq(0xFFu));
+    EXPECT_THAT(channel(buffer[1], 0), Eq(0x06u));
+    EXPECT_THAT(channel(buffer[2], 0), Eq(0x08u));
+    EXPECT_THAT(channel(buffer[3], 0), Eq(0x09u));
+
+    // Entirely outside: nothing is drawn
+    std::vector<uint32_t> untouched(4, black);
+    msd::render_mask(untouched.data(), buf_size, {{0, 0}, {3, 3}}, mask.data(), {5, 0}, white);
+    EXPECT_THAT(untouched, Each(Eq(black)));
+}
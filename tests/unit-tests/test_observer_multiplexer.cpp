@@ -824,6 +824,29 @@ TEST(ObserverMultiplexer, addition_takes_effect_immediately_even_in_callback)
     executor.drain_work();
 }
 
+TEST(ObserverMultiplexer, observer_added_during_immediate_observation_receives_only_later_observations)
+{
+    using namespace testing;
+    constexpr char const* first_observation = "Diamonds Are Forever";
+    constexpr char const* second_observation = "Live and Let Die";
+
+    TestObserverMultiplexer multiplexer{mir::immediate_executor};
+
+    auto observer_one = std::make_shared<NiceMock<MockObserver>>();
+    auto observer_two = std::make_shared<NiceMock<MockObserver>>();
+
+    EXPECT_CALL(*observer_one, observation_made(StrEq(first_observation)))
+        .WillOnce(InvokeWithoutArgs([&multiplexer, observer_two]() { multiplexer.register_interest(observer_two); }));
+    EXPECT_CALL(*observer_one, observation_made(StrEq(second_observation)));
+    EXPECT_CALL(*observer_two, observation_made(StrEq(first_observation))).Times(0);
+    EXPECT_CALL(*observer_two, observation_made(StrEq(second_observation)));
+
+    multiplexer.register_interest(observer_one);
+
+    multiplexer.observation_made(first_observation);
+    multiplexer.observation_made(second_observation);
+}
+
 TEST(ObserverMultiplexer, observations_can_be_delegated_to_specified_executor)
 {
     using namespace testing;
@@ -0,0 +1,109 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/startup_timeline.h"
+#include "mir/logging/logger.h"
+#include "mir/logging/dumb_console_logger.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ml = mir::logging;
+using namespace testing;
+
+namespace
+{
+class RecordingLogger : public ml::Logger
+{
+public:
+    void log(ml::Severity, std::string const& message, std::string const&) override
+    {
+        std::lock_guard lock{mutex};
+        messages.push_back(message);
+    }
+
+    auto logged() -> std::vector<std::string>
+    {
+        std::lock_guard lock{mutex};
+        return messages;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::string> messages;
+};
+
+struct StartupTimeline : Test
+{
+    StartupTimeline()
+    {
+        ml::set_logger(logger);
+    }
+
+    ~StartupTimeline()
+    {
+        ml::set_logger(std::make_shared<ml::DumbConsoleLogger>());
+    }
+
+    std::shared_ptr<RecordingLogger> const logger{std::make_shared<RecordingLogger>()};
+};
+}
+
+TEST_F(StartupTimeline, logs_each_phase_once_when_the_first_frame_is_posted)
+{
+    mir::startup_timeline::begin();
+    mir::startup_timeline::phase_completed("options parsed");
+    mir::startup_timeline::phase_completed("display configured");
+    mir::startup_timeline::phase_completed("options parsed");
+
+    EXPECT_THAT(logger->logged(), IsEmpty());
+
+    mir::startup_timeline::frame_posted();
+
+    EXPECT_THAT(logger->logged(), ElementsAre(
+        HasSubstr("Startup timeline"),
+        HasSubstr("options parsed"),
+        HasSubstr("display configured"),
+        HasSubstr("first frame posted")));
+}
+
+TEST_F(StartupTimeline, logs_only_once)
+{
+    mir::startup_timeline::begin();
+    mir::startup_timeline::frame_posted();
+    auto const logged = logger->logged().size();
+
+    mir::startup_timeline::phase_completed("options parsed");
+    mir::startup_timeline::frame_posted();
+
+    EXPECT_THAT(logger->logged().size(), Eq(logged));
+}
+
+TEST_F(StartupTimeline, does_nothing_until_begun)
+{
+    // Finish off any timeline a previous test may have started
+    mir::startup_timeline::frame_posted();
+    auto const logged = logger->logged().size();
+
+    mir::startup_timeline::phase_completed("options parsed");
+    mir::startup_timeline::frame_posted();
+
+    EXPECT_THAT(logger->logged().size(), Eq(logged));
+}